@@ -5,11 +5,13 @@ F_DIGIT      = '2'
 F_NUMBER     = '4'
 F_LITERAL    = '8'
 F_CONTROL    = '16'
+F_STRING_END = '32'
 
 C_WHITESPACE = "\r\n\t "
 C_DIGIT      = "0123456789"
 C_NUMBER     = C_DIGIT+".eE-+"
 C_LITERAL    = "truefalsenull"
+C_STRING_END = "\"\\"
 
 for x in xrange(0,256):
     flags = []
@@ -19,6 +21,7 @@ for x in xrange(0,256):
     if c in C_NUMBER: flags.append(F_NUMBER)
     if c in C_LITERAL: flags.append(F_LITERAL)
     if x <= 0x1F: flags.append(F_CONTROL)
+    if c in C_STRING_END: flags.append(F_STRING_END)
     
     fs = '0'
     if len(flags): fs = '|'.join(flags)
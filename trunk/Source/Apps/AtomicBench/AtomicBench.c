@@ -0,0 +1,240 @@
+/*****************************************************************
+|
+|      Atomix Apps - AtomicBench
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|       includes
++---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Atomix.h"
+
+/*----------------------------------------------------------------------
+|       constants
++---------------------------------------------------------------------*/
+#define BENCH_DEFAULT_ROUNDS 1000000
+#define BENCH_MAX_THREADS    64
+
+/*----------------------------------------------------------------------
+|       types
++---------------------------------------------------------------------*/
+typedef enum {
+    BENCH_MODE_ATOMIC_ADD,
+    BENCH_MODE_MUTEX_ADD,
+    BENCH_MODE_SHARED_REFERENCE,
+    BENCH_MODE_PRIVATE_REFERENCE
+} BenchMode;
+
+typedef struct {
+    BenchMode        mode;
+    unsigned int     rounds;
+    ATX_Semaphore*   start;
+    ATX_AtomicInt    counter;
+    ATX_Mutex*       mutex;
+    ATX_Int32        locked_counter;
+    ATX_InputStream* shared_stream;
+} BenchContext;
+
+/*----------------------------------------------------------------------
+|       PrintUsageAndExit
++---------------------------------------------------------------------*/
+static void
+PrintUsageAndExit(void)
+{
+    fprintf(stderr, 
+            "usage: atomicbench [-t <max_threads>] [-n <rounds>]\n"
+            "  measures the cost of atomic increments, mutex-protected\n"
+            "  increments and object reference counting when 1 to max_threads\n"
+            "  threads (the number of processors by default) do it at once.\n");
+    exit(1);
+}
+
+/*----------------------------------------------------------------------
+|       GetElapsed
++---------------------------------------------------------------------*/
+static double
+GetElapsed(const ATX_TimeStamp* start)
+{
+    ATX_TimeStamp now;
+    
+    ATX_System_GetMonotonicTimeStamp(&now);
+    return (double)(now.seconds-start->seconds) + 
+           (double)(now.nanoseconds-start->nanoseconds)/1000000000.0;
+}
+
+/*----------------------------------------------------------------------
+|       BenchThread
++---------------------------------------------------------------------*/
+static void
+BenchThread(void* argument)
+{
+    BenchContext*     context = (BenchContext*)argument;
+    ATX_MemoryStream* memory = NULL;
+    ATX_InputStream*  stream = context->shared_stream;
+    unsigned int      i;
+    
+    /* each thread has its own object in the private mode */
+    if (context->mode == BENCH_MODE_PRIVATE_REFERENCE) {
+        ATX_MemoryStream_Create(0, &memory);
+        ATX_MemoryStream_GetInputStream(memory, &stream);
+    }
+    
+    ATX_Semaphore_Acquire(context->start);
+    switch (context->mode) {
+        case BENCH_MODE_ATOMIC_ADD:
+            for (i=0; i<context->rounds; i++) {
+                ATX_Atomic_Add(&context->counter, 1, ATX_ATOMIC_RELAXED);
+            }
+            break;
+            
+        case BENCH_MODE_MUTEX_ADD:
+            for (i=0; i<context->rounds; i++) {
+                ATX_Mutex_Lock(context->mutex);
+                ++context->locked_counter;
+                ATX_Mutex_Unlock(context->mutex);
+            }
+            break;
+            
+        case BENCH_MODE_SHARED_REFERENCE:
+        case BENCH_MODE_PRIVATE_REFERENCE:
+            for (i=0; i<context->rounds; i++) {
+                ATX_Referenceable* referenceable = ATX_CAST(stream, ATX_Referenceable);
+                ATX_Referenceable_AddReference(referenceable);
+                ATX_Referenceable_Release(referenceable);
+            }
+            break;
+    }
+    
+    if (memory) {
+        ATX_RELEASE_OBJECT(stream);
+        ATX_MemoryStream_Destroy(memory);
+    }
+}
+
+/*----------------------------------------------------------------------
+|       RunBenchmark
++---------------------------------------------------------------------*/
+static ATX_Result
+RunBenchmark(BenchContext* context, ATX_Cardinal thread_count, double* elapsed)
+{
+    ATX_Thread*   threads[BENCH_MAX_THREADS];
+    ATX_TimeStamp start;
+    ATX_Cardinal  started;
+    ATX_Result    result = ATX_SUCCESS;
+    
+    for (started=0; started<thread_count; started++) {
+        result = ATX_Thread_Create(BenchThread, context, &threads[started]);
+        if (ATX_FAILED(result)) break;
+    }
+    
+    /* let all the threads go at once */
+    ATX_System_GetMonotonicTimeStamp(&start);
+    ATX_Semaphore_Release(context->start, started);
+    while (started) {
+        ATX_Thread_Join(threads[--started]);
+    }
+    *elapsed = GetElapsed(&start);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|       main
++---------------------------------------------------------------------*/
+int
+main(int argc, char** argv)
+{
+    static const char* mode_names[] = {
+        "atomic add", "mutex add", "shared reference", "private reference"
+    };
+    char*             arg;
+    ATX_Cardinal      max_threads = ATX_System_GetProcessorCount();
+    unsigned int      rounds = BENCH_DEFAULT_ROUNDS;
+    BenchContext      context;
+    ATX_MemoryStream* memory = NULL;
+    ATX_Cardinal      threads;
+    int               mode;
+    ATX_Result        result = ATX_SUCCESS;
+
+    ATX_COMPILER_UNUSED(argc);
+
+    /* parse command line */
+    argv++;
+    while ((arg = *argv++)) {
+        if (!strcmp(arg, "-t") && *argv) {
+            max_threads = strtoul(*argv++, NULL, 10);
+        } else if (!strcmp(arg, "-n") && *argv) {
+            rounds = strtoul(*argv++, NULL, 10);
+        } else {
+            PrintUsageAndExit();
+        }
+    }
+    if (max_threads == 0 || max_threads > BENCH_MAX_THREADS || rounds == 0) {
+        PrintUsageAndExit();
+    }
+    
+    ATX_SetMemory(&context, 0, sizeof(context));
+    context.rounds = rounds;
+    ATX_Semaphore_Create(0, &context.start);
+    ATX_Mutex_Create(&context.mutex);
+    ATX_MemoryStream_Create(0, &memory);
+    ATX_MemoryStream_GetInputStream(memory, &context.shared_stream);
+    
+    /* run */
+    printf("%u rounds per thread, %d processors, ns per operation\n", 
+           rounds, (int)ATX_System_GetProcessorCount());
+    printf("%-18s", "threads");
+    for (threads=1; threads<=max_threads; threads++) printf("%8d", (int)threads);
+    printf("\n");
+    for (mode=BENCH_MODE_ATOMIC_ADD; mode<=BENCH_MODE_PRIVATE_REFERENCE; mode++) {
+        printf("%-18s", mode_names[mode]);
+        context.mode = (BenchMode)mode;
+        for (threads=1; threads<=max_threads; threads++) {
+            double elapsed = 0.0;
+            result = RunBenchmark(&context, threads, &elapsed);
+            if (ATX_FAILED(result)) break;
+            printf("%8.1f", elapsed*1000000000.0/((double)rounds*threads));
+            fflush(stdout);
+        }
+        printf("\n");
+        if (ATX_FAILED(result)) break;
+    }
+    if (ATX_FAILED(result)) {
+        fprintf(stderr, "ERROR: benchmark failed (%d)\n", result);
+    }
+    
+    ATX_RELEASE_OBJECT(context.shared_stream);
+    ATX_MemoryStream_Destroy(memory);
+    ATX_Mutex_Destroy(context.mutex);
+    ATX_Semaphore_Destroy(context.start);
+    return ATX_SUCCEEDED(result) ? 0 : 1;
+}
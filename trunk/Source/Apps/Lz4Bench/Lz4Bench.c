@@ -0,0 +1,324 @@
+/*****************************************************************
+|
+|      Atomix Apps - Lz4Bench
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|       includes
++---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Atomix.h"
+
+/*----------------------------------------------------------------------
+|       constants
++---------------------------------------------------------------------*/
+#define BENCH_DEFAULT_ITERATIONS 10
+#define BENCH_DEFAULT_DATA_SIZE  (16*1024*1024)
+#define BENCH_MAX_DATA_SIZE      (1024*1024*1024)
+#define BENCH_IO_CHUNK_SIZE      16384
+
+/*----------------------------------------------------------------------
+|       types
++---------------------------------------------------------------------*/
+typedef enum {
+    BENCH_MODE_RAW,
+    BENCH_MODE_LZ4
+} BenchMode;
+
+/*----------------------------------------------------------------------
+|       PrintUsageAndExit
++---------------------------------------------------------------------*/
+static void
+PrintUsageAndExit(void)
+{
+    fprintf(stderr, 
+            "usage: lz4bench [-b <block_size>] [-n <iterations>] [<input file>]\n"
+            "  compares copying data through a memory stream with\n"
+            "  compressing and decompressing it through LZ4 streams.\n"
+            "  without an input file, generated text-like data is used.\n");
+    exit(1);
+}
+
+/*----------------------------------------------------------------------
+|       GenerateData
++---------------------------------------------------------------------*/
+static void
+GenerateData(ATX_Byte* data, ATX_Size size)
+{
+    static const char* words[] = {
+        "stream ", "buffer ", "the ", "of ", "data ", "atomix ", "and ",
+        "compress ", "block ", "frame ", "a ", "to ", "in ", "read ", "write\n"
+    };
+    ATX_UInt32 seed = 1;
+    ATX_Size   offset = 0;
+    
+    while (offset < size) {
+        const char* word;
+        ATX_Size    length;
+        
+        /* mostly words, with some noise */
+        seed = seed*1103515245+12345;
+        if (((seed >> 16) & 15) == 0) {
+            data[offset++] = (ATX_Byte)(seed >> 8);
+            continue;
+        }
+        word   = words[(seed >> 16) % (sizeof(words)/sizeof(words[0]))];
+        length = (ATX_Size)strlen(word);
+        if (length > size-offset) length = size-offset;
+        ATX_CopyMemory(data+offset, word, length);
+        offset += length;
+    }
+}
+
+/*----------------------------------------------------------------------
+|       GetElapsed
++---------------------------------------------------------------------*/
+static double
+GetElapsed(const ATX_TimeStamp* start)
+{
+    ATX_TimeStamp now;
+    
+    ATX_System_GetCurrentTimeStamp(&now);
+    return (double)(now.seconds-start->seconds) + 
+           (double)(now.nanoseconds-start->nanoseconds)/1000000000.0;
+}
+
+/*----------------------------------------------------------------------
+|       WriteData
++---------------------------------------------------------------------*/
+static ATX_Result
+WriteData(BenchMode         mode,
+          const ATX_Byte*   data, 
+          ATX_Size          size, 
+          ATX_Size          block_size,
+          ATX_MemoryStream* sink)
+{
+    ATX_OutputStream* output = NULL;
+    ATX_OutputStream* stream = NULL;
+    ATX_Size          offset;
+    ATX_Result        result;
+    
+    ATX_CHECK(ATX_MemoryStream_GetOutputStream(sink, &output));
+    result = ATX_OutputStream_Seek(output, 0);
+    if (ATX_FAILED(result)) goto end;
+    if (mode == BENCH_MODE_LZ4) {
+        result = ATX_Lz4OutputStream_Create(output, block_size, &stream);
+        if (ATX_FAILED(result)) goto end;
+    } else {
+        stream = output;
+        ATX_REFERENCE_OBJECT(stream);
+    }
+    
+    for (offset=0; offset<size; offset += BENCH_IO_CHUNK_SIZE) {
+        ATX_Size chunk = size-offset;
+        if (chunk > BENCH_IO_CHUNK_SIZE) chunk = BENCH_IO_CHUNK_SIZE;
+        result = ATX_OutputStream_WriteFully(stream, data+offset, chunk);
+        if (ATX_FAILED(result)) break;
+    }
+
+end:
+    /* releasing the LZ4 stream ends the frame */
+    ATX_RELEASE_OBJECT(stream);
+    ATX_RELEASE_OBJECT(output);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|       ReadData
++---------------------------------------------------------------------*/
+static ATX_Result
+ReadData(BenchMode         mode,
+         ATX_MemoryStream* source,
+         ATX_Byte*         buffer,
+         ATX_LargeSize*    total)
+{
+    ATX_InputStream* input = NULL;
+    ATX_InputStream* stream = NULL;
+    ATX_Result       result;
+    
+    *total = 0;
+    ATX_CHECK(ATX_MemoryStream_GetInputStream(source, &input));
+    result = ATX_InputStream_Seek(input, 0);
+    if (ATX_FAILED(result)) goto end;
+    if (mode == BENCH_MODE_LZ4) {
+        result = ATX_Lz4InputStream_Create(input, &stream);
+        if (ATX_FAILED(result)) goto end;
+    } else {
+        stream = input;
+        ATX_REFERENCE_OBJECT(stream);
+    }
+    
+    for (;;) {
+        ATX_Size bytes_read = 0;
+        result = ATX_InputStream_Read(stream, buffer, BENCH_IO_CHUNK_SIZE, &bytes_read);
+        if (ATX_FAILED(result)) break;
+        *total += bytes_read;
+    }
+    if (result == ATX_ERROR_EOS) result = ATX_SUCCESS;
+
+end:
+    ATX_RELEASE_OBJECT(stream);
+    ATX_RELEASE_OBJECT(input);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|       RunBenchmark
++---------------------------------------------------------------------*/
+static ATX_Result
+RunBenchmark(BenchMode       mode,
+             const ATX_Byte* data,
+             ATX_Size        size,
+             ATX_Size        block_size,
+             unsigned int    iterations)
+{
+    ATX_MemoryStream* memory = NULL;
+    ATX_Byte          buffer[BENCH_IO_CHUNK_SIZE];
+    ATX_Position      stored = 0;
+    ATX_LargeSize     total = 0;
+    ATX_TimeStamp     start;
+    double            write_time;
+    double            read_time;
+    unsigned int      i;
+    ATX_Result        result;
+    
+    ATX_CHECK(ATX_MemoryStream_Create(ATX_Lz4_GetMaxCompressedSize(size)+64, &memory));
+    
+    /* write once to size the memory stream */
+    result = WriteData(mode, data, size, block_size, memory);
+    if (ATX_FAILED(result)) goto end;
+    
+    ATX_System_GetCurrentTimeStamp(&start);
+    for (i=0; i<iterations; i++) {
+        result = WriteData(mode, data, size, block_size, memory);
+        if (ATX_FAILED(result)) goto end;
+    }
+    write_time = GetElapsed(&start);
+    {
+        ATX_OutputStream* output = NULL;
+        ATX_MemoryStream_GetOutputStream(memory, &output);
+        ATX_OutputStream_Tell(output, &stored);
+        ATX_RELEASE_OBJECT(output);
+    }
+    
+    ATX_System_GetCurrentTimeStamp(&start);
+    for (i=0; i<iterations; i++) {
+        result = ReadData(mode, memory, buffer, &total);
+        if (ATX_FAILED(result)) goto end;
+        if (total != size) {
+            result = ATX_ERROR_INTERNAL;
+            goto end;
+        }
+    }
+    read_time = GetElapsed(&start);
+    
+    printf("%-5s %10.0f bytes -> %10.0f (%5.1f%%)  write %8.1f MB/s  read %8.1f MB/s\n",
+           mode == BENCH_MODE_LZ4 ? "lz4" : "raw",
+           (double)size,
+           (double)stored,
+           size ? 100.0*(double)stored/(double)size : 0.0,
+           write_time > 0.0 ? (double)size*iterations/(write_time*1000000.0) : 0.0,
+           read_time  > 0.0 ? (double)size*iterations/(read_time *1000000.0) : 0.0);
+
+end:
+    ATX_MemoryStream_Destroy(memory);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|       main
++---------------------------------------------------------------------*/
+int
+main(int argc, char** argv)
+{
+    char*           arg;
+    char*           filename = NULL;
+    ATX_Size        block_size = 0;
+    unsigned int    iterations = BENCH_DEFAULT_ITERATIONS;
+    ATX_FileView*   view = NULL;
+    ATX_DataBuffer* input = NULL;
+    const ATX_Byte* data;
+    ATX_Size        size;
+    ATX_Result      result;
+
+    ATX_COMPILER_UNUSED(argc);
+
+    /* parse command line */
+    argv++;
+    while ((arg = *argv++)) {
+        if (!strcmp(arg, "-b") && *argv) {
+            block_size = strtoul(*argv++, NULL, 10);
+        } else if (!strcmp(arg, "-n") && *argv) {
+            iterations = strtoul(*argv++, NULL, 10);
+        } else if (arg[0] == '-' || filename) {
+            PrintUsageAndExit();
+        } else {
+            filename = arg;
+        }
+    }
+    if (iterations == 0) PrintUsageAndExit();
+    
+    /* get the data */
+    if (filename) {
+        result = ATX_MapFile(filename, &view);
+        if (ATX_FAILED(result)) {
+            fprintf(stderr, "ERROR: cannot load %s (%d)\n", filename, result);
+            return 1;
+        }
+        if (ATX_FileView_GetSize(view) > BENCH_MAX_DATA_SIZE) {
+            fprintf(stderr, "ERROR: %s is too large\n", filename);
+            ATX_FileView_Destroy(view);
+            return 1;
+        }
+        data = ATX_FileView_GetData(view);
+        size = (ATX_Size)ATX_FileView_GetSize(view);
+    } else {
+        ATX_DataBuffer_Create(BENCH_DEFAULT_DATA_SIZE, &input);
+        GenerateData(ATX_DataBuffer_UseData(input), BENCH_DEFAULT_DATA_SIZE);
+        ATX_DataBuffer_SetDataSize(input, BENCH_DEFAULT_DATA_SIZE);
+        data = ATX_DataBuffer_GetData(input);
+        size = ATX_DataBuffer_GetDataSize(input);
+    }
+    
+    /* run */
+    result = RunBenchmark(BENCH_MODE_RAW, data, size, block_size, iterations);
+    if (ATX_SUCCEEDED(result)) {
+        result = RunBenchmark(BENCH_MODE_LZ4, data, size, block_size, iterations);
+    }
+    if (ATX_FAILED(result)) {
+        fprintf(stderr, "ERROR: benchmark failed (%d)\n", result);
+    }
+    
+    if (view)  ATX_FileView_Destroy(view);
+    if (input) ATX_DataBuffer_Destroy(input);
+    return ATX_SUCCEEDED(result) ? 0 : 1;
+}
@@ -581,16 +581,11 @@ main(int argc, char** argv)
     {
         ATX_InputStream*  in;
         ATX_OutputStream* out;
-        unsigned char*    buffer;
         ATX_Result        result;
-        unsigned long     offset = 0;
-
-        /* allocate buffer */
-        buffer = (unsigned char*)malloc(packet_size);
-        if (buffer == NULL) {
-            fprintf(stderr, "ERROR: out of memory\n");
-            exit(1);
-        }
+        ATX_LargeSize     offset = 0;
+        ATX_TimeStamp     start;
+        ATX_TimeStamp     now;
+        double            duration;
 
         /* get input stream */
         result = GetEndPointStreams(&in_endpoint, &in, NULL);
@@ -609,12 +604,11 @@ main(int argc, char** argv)
         }
 
         /* measure the current time */
-        /*if (bitrate) gettimeofday(&start, NULL);*/
+        ATX_System_GetCurrentTimeStamp(&start);
 
         /* loop */
         do {
-            ATX_Size bytes_read;
-            ATX_Size bytes_written;
+            ATX_LargeSize bytes_copied = 0;
 
 #if 0
             if (bitrate) {
@@ -662,19 +656,26 @@ main(int argc, char** argv)
 #endif
 
             /* send */
-            result = ATX_InputStream_Read(in, buffer, packet_size, &bytes_read);
-            fprintf(stderr, "[%d] read %d bytes\n", result, bytes_read);
-            if (result == ATX_SUCCESS && bytes_read) {
-                result = ATX_OutputStream_Write(out, buffer, bytes_read,
-                                                &bytes_written);
-                fprintf(stderr, "[%d] wrote %d bytes\n", 
-                        result, bytes_written);
-                offset += bytes_written;
-            } else {
-                printf("*******************\n");
-                exit(1);
-            }
+            result = ATX_Stream_Pump(in, out, packet_size, &bytes_copied);
+            offset += bytes_copied;
         } while (result == ATX_SUCCESS);
+        if (result != ATX_ERROR_EOS) {
+            fprintf(stderr, "ERROR: pump failed (%d)\n", result);
+        }
+
+        /* report the throughput */
+        ATX_System_GetCurrentTimeStamp(&now);
+        duration = (double)(now.seconds-start.seconds) + 
+                   (double)(now.nanoseconds-start.nanoseconds)/1000000000.0;
+        fprintf(stderr, ":: %.0f bytes in %.3f seconds", (double)offset, duration);
+        if (duration > 0.0) {
+            fprintf(stderr, " (%.2f MB/s)", (double)offset/(duration*1000000.0));
+        }
+        fprintf(stderr, "\n");
+
+        ATX_RELEASE_OBJECT(in);
+        ATX_RELEASE_OBJECT(out);
+        if (result != ATX_ERROR_EOS) return 1;
     }
     
     return 0;
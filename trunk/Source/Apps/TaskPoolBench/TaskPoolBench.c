@@ -0,0 +1,208 @@
+/*****************************************************************
+|
+|      Atomix Apps - TaskPoolBench
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|       includes
++---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Atomix.h"
+
+/*----------------------------------------------------------------------
+|       constants
++---------------------------------------------------------------------*/
+#define BENCH_DEFAULT_ITERATIONS 5
+#define BENCH_DEFAULT_ITEM_COUNT (4*1024*1024)
+#define BENCH_ROUNDS_PER_ITEM    64
+
+/*----------------------------------------------------------------------
+|       types
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_UInt32* items;
+    ATX_UInt32  rounds;
+} BenchWorkload;
+
+/*----------------------------------------------------------------------
+|       PrintUsageAndExit
++---------------------------------------------------------------------*/
+static void
+PrintUsageAndExit(void)
+{
+    fprintf(stderr, 
+            "usage: taskpoolbench [-t <max_threads>] [-n <iterations>] [-s <items>] [-g <grain>]\n"
+            "  runs a CPU-bound parallel loop on task pools of 1 to max_threads\n"
+            "  workers (the number of processors by default), and prints the\n"
+            "  time and speedup for each.\n");
+    exit(1);
+}
+
+/*----------------------------------------------------------------------
+|       GetElapsed
++---------------------------------------------------------------------*/
+static double
+GetElapsed(const ATX_TimeStamp* start)
+{
+    ATX_TimeStamp now;
+    
+    ATX_System_GetMonotonicTimeStamp(&now);
+    return (double)(now.seconds-start->seconds) + 
+           (double)(now.nanoseconds-start->nanoseconds)/1000000000.0;
+}
+
+/*----------------------------------------------------------------------
+|       HashRange
++---------------------------------------------------------------------*/
+static ATX_Result
+HashRange(void* argument, ATX_Size begin, ATX_Size end)
+{
+    BenchWorkload* workload = (BenchWorkload*)argument;
+    ATX_Size       i;
+    
+    /* a few rounds of integer mixing per item, no memory traffic to 
+       speak of, so the loop should scale with the number of cores */
+    for (i=begin; i<end; i++) {
+        ATX_UInt32 value = (ATX_UInt32)i;
+        ATX_UInt32 round;
+        for (round=0; round<workload->rounds; round++) {
+            value ^= value >> 16;
+            value *= 0x7feb352d;
+            value ^= value >> 15;
+            value *= 0x846ca68b;
+        }
+        workload->items[i] = value;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|       RunBenchmark
++---------------------------------------------------------------------*/
+static ATX_Result
+RunBenchmark(ATX_Cardinal   worker_count,
+             BenchWorkload* workload,
+             ATX_Size       item_count,
+             ATX_Size       grain_size,
+             unsigned int   iterations,
+             double*        elapsed)
+{
+    ATX_TaskPool* pool = NULL;
+    ATX_TimeStamp start;
+    unsigned int  i;
+    ATX_Result    result;
+    
+    ATX_CHECK(ATX_TaskPool_Create(worker_count, &pool));
+    
+    /* warm up */
+    result = ATX_TaskPool_ParallelFor(pool, 0, item_count, grain_size, HashRange, workload);
+    if (ATX_FAILED(result)) goto end;
+    
+    ATX_System_GetMonotonicTimeStamp(&start);
+    for (i=0; i<iterations; i++) {
+        result = ATX_TaskPool_ParallelFor(pool, 0, item_count, grain_size, HashRange, workload);
+        if (ATX_FAILED(result)) goto end;
+    }
+    *elapsed = GetElapsed(&start)/iterations;
+
+end:
+    ATX_TaskPool_Destroy(pool);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|       main
++---------------------------------------------------------------------*/
+int
+main(int argc, char** argv)
+{
+    char*         arg;
+    ATX_Cardinal  max_threads = ATX_System_GetProcessorCount();
+    unsigned int  iterations = BENCH_DEFAULT_ITERATIONS;
+    ATX_Size      item_count = BENCH_DEFAULT_ITEM_COUNT;
+    ATX_Size      grain_size = 0;
+    BenchWorkload workload;
+    double        baseline = 0.0;
+    ATX_Cardinal  threads;
+    ATX_Result    result = ATX_SUCCESS;
+
+    ATX_COMPILER_UNUSED(argc);
+
+    /* parse command line */
+    argv++;
+    while ((arg = *argv++)) {
+        if (!strcmp(arg, "-t") && *argv) {
+            max_threads = strtoul(*argv++, NULL, 10);
+        } else if (!strcmp(arg, "-n") && *argv) {
+            iterations = strtoul(*argv++, NULL, 10);
+        } else if (!strcmp(arg, "-s") && *argv) {
+            item_count = strtoul(*argv++, NULL, 10);
+        } else if (!strcmp(arg, "-g") && *argv) {
+            grain_size = strtoul(*argv++, NULL, 10);
+        } else {
+            PrintUsageAndExit();
+        }
+    }
+    if (max_threads == 0 || iterations == 0 || item_count == 0) PrintUsageAndExit();
+    
+    workload.items  = (ATX_UInt32*)ATX_AllocateMemory(item_count*sizeof(ATX_UInt32));
+    workload.rounds = BENCH_ROUNDS_PER_ITEM;
+    if (workload.items == NULL) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return 1;
+    }
+    
+    /* run */
+    printf("%lu items, %u rounds per item, %d processors\n", 
+           (unsigned long)item_count, 
+           (unsigned int)workload.rounds,
+           (int)ATX_System_GetProcessorCount());
+    for (threads=1; threads<=max_threads; threads++) {
+        double elapsed = 0.0;
+        result = RunBenchmark(threads, &workload, item_count, grain_size, iterations, &elapsed);
+        if (ATX_FAILED(result)) break;
+        if (threads == 1) baseline = elapsed;
+        printf("%3d workers  %10.2f ms  %8.1f Mitems/s  speedup %5.2f  efficiency %5.1f%%\n",
+               (int)threads,
+               elapsed*1000.0,
+               elapsed > 0.0 ? (double)item_count/(elapsed*1000000.0) : 0.0,
+               elapsed > 0.0 ? baseline/elapsed : 0.0,
+               elapsed > 0.0 ? 100.0*baseline/(elapsed*threads) : 0.0);
+    }
+    if (ATX_FAILED(result)) {
+        fprintf(stderr, "ERROR: benchmark failed (%d)\n", result);
+    }
+    
+    ATX_FreeMemory(workload.items);
+    return ATX_SUCCEEDED(result) ? 0 : 1;
+}
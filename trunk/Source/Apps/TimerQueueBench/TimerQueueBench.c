@@ -0,0 +1,162 @@
+/*****************************************************************
+|
+|      Atomix Apps - TimerQueueBench
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|       includes
++---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Atomix.h"
+
+/*----------------------------------------------------------------------
+|       constants
++---------------------------------------------------------------------*/
+#define BENCH_DEFAULT_TIMER_COUNT 200000
+#define BENCH_DEFAULT_MAX_DELAY   600000 /* milliseconds */
+
+/*----------------------------------------------------------------------
+|       PrintUsageAndExit
++---------------------------------------------------------------------*/
+static void
+PrintUsageAndExit(void)
+{
+    fprintf(stderr, 
+            "usage: timerqueuebench [-n <timers>] [-d <max_delay_ms>]\n"
+            "  measures the cost of scheduling, cancelling and expiring\n"
+            "  timers with random delays, advancing the queue by hand.\n");
+    exit(1);
+}
+
+/*----------------------------------------------------------------------
+|       GetElapsed
++---------------------------------------------------------------------*/
+static double
+GetElapsed(const ATX_TimeStamp* start)
+{
+    ATX_TimeStamp now;
+    
+    ATX_System_GetMonotonicTimeStamp(&now);
+    return (double)(now.seconds-start->seconds) + 
+           (double)(now.nanoseconds-start->nanoseconds)/1000000000.0;
+}
+
+/*----------------------------------------------------------------------
+|       BenchCallback
++---------------------------------------------------------------------*/
+static void
+BenchCallback(ATX_Timer* timer, void* argument)
+{
+    ATX_COMPILER_UNUSED(timer);
+    ++*(unsigned int*)argument;
+}
+
+/*----------------------------------------------------------------------
+|       main
++---------------------------------------------------------------------*/
+int
+main(int argc, char** argv)
+{
+    char*            arg;
+    unsigned int     timer_count = BENCH_DEFAULT_TIMER_COUNT;
+    unsigned int     max_delay   = BENCH_DEFAULT_MAX_DELAY;
+    unsigned int     expired     = 0;
+    unsigned int     i;
+    ATX_TimerQueue*  queue = NULL;
+    ATX_Timer**      timers;
+    ATX_TimeStamp    start;
+    ATX_TimeStamp    now;
+    ATX_TimeInterval step;
+    double           elapsed;
+    ATX_Result       result;
+
+    ATX_COMPILER_UNUSED(argc);
+
+    /* parse command line */
+    argv++;
+    while ((arg = *argv++)) {
+        if (!strcmp(arg, "-n") && *argv) {
+            timer_count = strtoul(*argv++, NULL, 10);
+        } else if (!strcmp(arg, "-d") && *argv) {
+            max_delay = strtoul(*argv++, NULL, 10);
+        } else {
+            PrintUsageAndExit();
+        }
+    }
+    if (timer_count == 0 || max_delay == 0) PrintUsageAndExit();
+    
+    timers = (ATX_Timer**)ATX_AllocateZeroMemory(timer_count*sizeof(ATX_Timer*));
+    result = timers ? ATX_TimerQueue_Create(0, 0, &queue) : ATX_ERROR_OUT_OF_MEMORY;
+    for (i=0; i<timer_count && ATX_SUCCEEDED(result); i++) {
+        result = ATX_Timer_Create(BenchCallback, &expired, &timers[i]);
+    }
+    if (ATX_FAILED(result)) {
+        fprintf(stderr, "ERROR: setup failed (%d)\n", result);
+        return 1;
+    }
+    ATX_System_SetRandomSeed(1);
+    printf("%u timers, delays up to %u ms, ns per timer\n", timer_count, max_delay);
+    
+    /* schedule */
+    ATX_System_GetMonotonicTimeStamp(&start);
+    for (i=0; i<timer_count; i++) {
+        ATX_TimerQueue_Schedule(queue, timers[i], ATX_System_GetRandomInteger()%max_delay, 0);
+    }
+    elapsed = GetElapsed(&start);
+    printf("%-10s%8.1f\n", "schedule", elapsed*1000000000.0/timer_count);
+    
+    /* cancel every other timer */
+    ATX_System_GetMonotonicTimeStamp(&now);
+    for (i=0; i<timer_count; i+=2) {
+        ATX_TimerQueue_Cancel(queue, timers[i]);
+    }
+    elapsed = GetElapsed(&now);
+    printf("%-10s%8.1f\n", "cancel", elapsed*2000000000.0/timer_count);
+    
+    /* expire the others, advancing 10 ms at a time */
+    ATX_TimeStamp_Set(step, 0, 10000000);
+    now = start;
+    ATX_System_GetMonotonicTimeStamp(&start);
+    while (expired < timer_count/2) {
+        ATX_TimeStamp_Add(now, now, step);
+        ATX_TimerQueue_Advance(queue, &now);
+    }
+    elapsed = GetElapsed(&start);
+    printf("%-10s%8.1f\n", "expire", elapsed*2000000000.0/timer_count);
+    
+    ATX_TimerQueue_Destroy(queue);
+    for (i=0; i<timer_count; i++) {
+        ATX_Timer_Destroy(timers[i]);
+    }
+    ATX_FreeMemory(timers);
+    return 0;
+}
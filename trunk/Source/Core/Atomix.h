@@ -65,5 +65,13 @@
 #include "AtxConsole.h"
 #include "AtxJson.h"
 #include "AtxThreads.h"
+#include "AtxLz4.h"
+#include "AtxChecksum.h"
+#include "AtxPipe.h"
+#include "AtxInstrumentedStreams.h"
+#include "AtxAtomic.h"
+#include "AtxTaskPool.h"
+#include "AtxLocks.h"
+#include "AtxTimerQueue.h"
 
 #endif /* _ATOMIX_H_ */
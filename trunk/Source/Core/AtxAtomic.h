@@ -0,0 +1,173 @@
+/*****************************************************************
+|
+|   Atomix - Atomic Operations
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_ATOMIC_H_
+#define _ATX_ATOMIC_H_
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTypes.h"
+
+#if defined(ATX_CONFIG_HAVE_MSC_INTERLOCKED)
+#include <intrin.h>
+#endif
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/**
+ * Variables that are accessed with the ATX_Atomic_XXX macros (32 bits), 
+ * ATX_Atomic_XXX64 macros, and ATX_Atomic_XXXPointer macros. 
+ * The 32-bit macros also accept any other 32-bit integer, such as an 
+ * ATX_Cardinal reference counter.
+ */
+typedef volatile ATX_Int32 ATX_AtomicInt;
+typedef volatile ATX_Int64 ATX_AtomicInt64;
+typedef void* volatile     ATX_AtomicPointer;
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+/**
+ * Memory orders, with the same meaning as in C11. Compilers that can 
+ * not express them use the strongest one.
+ */
+#if defined(ATX_CONFIG_HAVE_GCC_ATOMICS)
+#define ATX_ATOMIC_RELAXED __ATOMIC_RELAXED
+#define ATX_ATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+#define ATX_ATOMIC_RELEASE __ATOMIC_RELEASE
+#define ATX_ATOMIC_ACQ_REL __ATOMIC_ACQ_REL
+#define ATX_ATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+#else
+#define ATX_ATOMIC_RELAXED 0
+#define ATX_ATOMIC_ACQUIRE 2
+#define ATX_ATOMIC_RELEASE 3
+#define ATX_ATOMIC_ACQ_REL 4
+#define ATX_ATOMIC_SEQ_CST 5
+#endif
+
+/** 
+ * 1 if the operations below are atomic, 0 if they are plain memory 
+ * accesses, which is only correct for single-threaded programs.
+ */
+#if defined(ATX_CONFIG_HAVE_GCC_ATOMICS) || defined(ATX_CONFIG_HAVE_MSC_INTERLOCKED)
+#define ATX_ATOMIC_IS_LOCK_FREE 1
+#else
+#define ATX_ATOMIC_IS_LOCK_FREE 0
+#endif
+
+/*----------------------------------------------------------------------
+|   operations
+|
+|   Load, Store and Add take a memory order, and Add returns the new 
+|   value. CompareAndSwap sets *p to v if it was e, returns non-zero if 
+|   it did, and is always sequentially consistent.
++---------------------------------------------------------------------*/
+#if defined(ATX_CONFIG_HAVE_GCC_ATOMICS)
+
+#define ATX_Atomic_Load(p, o)                     __atomic_load_n((p), (o))
+#define ATX_Atomic_Store(p, v, o)                 __atomic_store_n((p), (v), (o))
+#define ATX_Atomic_Add(p, v, o)                   __atomic_add_fetch((p), (v), (o))
+#define ATX_Atomic_CompareAndSwap(p, e, v)        __sync_bool_compare_and_swap((p), (e), (v))
+#define ATX_Atomic_Load64(p, o)                   __atomic_load_n((p), (o))
+#define ATX_Atomic_Store64(p, v, o)               __atomic_store_n((p), (v), (o))
+#define ATX_Atomic_Add64(p, v, o)                 __atomic_add_fetch((p), (v), (o))
+#define ATX_Atomic_CompareAndSwap64(p, e, v)      __sync_bool_compare_and_swap((p), (e), (v))
+#define ATX_Atomic_LoadPointer(p, o)              __atomic_load_n((p), (o))
+#define ATX_Atomic_StorePointer(p, v, o)          __atomic_store_n((p), (v), (o))
+#define ATX_Atomic_CompareAndSwapPointer(p, e, v) __sync_bool_compare_and_swap((p), (e), (v))
+#define ATX_Atomic_Fence(o)                       __atomic_thread_fence(o)
+
+#elif defined(ATX_CONFIG_HAVE_MSC_INTERLOCKED)
+
+/* interlocked functions are full barriers, so the orders are ignored */
+#define ATX_Atomic_Load(p, o) \
+    _InterlockedOr((volatile long*)(p), 0)
+#define ATX_Atomic_Store(p, v, o) \
+    ((void)_InterlockedExchange((volatile long*)(p), (long)(v)))
+#define ATX_Atomic_Add(p, v, o) \
+    (_InterlockedExchangeAdd((volatile long*)(p), (long)(v))+(long)(v))
+#define ATX_Atomic_CompareAndSwap(p, e, v) \
+    (_InterlockedCompareExchange((volatile long*)(p), (long)(v), (long)(e)) == (long)(e))
+#define ATX_Atomic_Load64(p, o) \
+    _InterlockedCompareExchange64((p), 0, 0)
+#define ATX_Atomic_CompareAndSwap64(p, e, v) \
+    (_InterlockedCompareExchange64((p), (v), (e)) == (e))
+#if defined(_M_IX86)
+/* 32-bit x86 only has a 64-bit compare-and-swap */
+static __inline void 
+ATX_Atomic_CasStore64(ATX_AtomicInt64* p, ATX_Int64 v)
+{
+    ATX_Int64 old;
+    do { old = *p; } while (_InterlockedCompareExchange64(p, v, old) != old);
+}
+static __inline ATX_Int64 
+ATX_Atomic_CasAdd64(ATX_AtomicInt64* p, ATX_Int64 v)
+{
+    ATX_Int64 old;
+    do { old = *p; } while (_InterlockedCompareExchange64(p, old+v, old) != old);
+    return old+v;
+}
+#define ATX_Atomic_Store64(p, v, o) ATX_Atomic_CasStore64((p), (v))
+#define ATX_Atomic_Add64(p, v, o)   ATX_Atomic_CasAdd64((p), (v))
+#else
+#define ATX_Atomic_Store64(p, v, o) ((void)_InterlockedExchange64((p), (v)))
+#define ATX_Atomic_Add64(p, v, o)   (_InterlockedExchangeAdd64((p), (v))+(v))
+#endif
+#define ATX_Atomic_LoadPointer(p, o) \
+    _InterlockedCompareExchangePointer((void* volatile*)(p), NULL, NULL)
+#define ATX_Atomic_StorePointer(p, v, o) \
+    ((void)_InterlockedExchangePointer((void* volatile*)(p), (void*)(v)))
+#define ATX_Atomic_CompareAndSwapPointer(p, e, v) \
+    (_InterlockedCompareExchangePointer((void* volatile*)(p), (void*)(v), (void*)(e)) == (void*)(e))
+#define ATX_Atomic_Fence(o) \
+    do { long atx_fence_; (void)_InterlockedExchange(&atx_fence_, 0); } while (0)
+
+#else
+
+#define ATX_Atomic_Load(p, o)                     (*(p))
+#define ATX_Atomic_Store(p, v, o)                 ((void)(*(p) = (v)))
+#define ATX_Atomic_Add(p, v, o)                   (*(p) += (v))
+#define ATX_Atomic_CompareAndSwap(p, e, v)        (*(p) == (e) ? (*(p) = (v), 1) : 0)
+#define ATX_Atomic_Load64(p, o)                   (*(p))
+#define ATX_Atomic_Store64(p, v, o)               ((void)(*(p) = (v)))
+#define ATX_Atomic_Add64(p, v, o)                 (*(p) += (v))
+#define ATX_Atomic_CompareAndSwap64(p, e, v)      (*(p) == (e) ? (*(p) = (v), 1) : 0)
+#define ATX_Atomic_LoadPointer(p, o)              (*(p))
+#define ATX_Atomic_StorePointer(p, v, o)          ((void)(*(p) = (v)))
+#define ATX_Atomic_CompareAndSwapPointer(p, e, v) (*(p) == (e) ? (*(p) = (v), 1) : 0)
+#define ATX_Atomic_Fence(o)                       ((void)0)
+
+#endif
+
+#endif /* _ATX_ATOMIC_H_ */
@@ -0,0 +1,914 @@
+/*****************************************************************
+|
+|   Atomix - Checksums
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxUtils.h"
+#include "AtxStreams.h"
+#include "AtxChecksum.h"
+
+#if defined(ATX_CONFIG_HAVE_X86_CRC_INSTRUCTIONS)
+#include <emmintrin.h>
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(ATX_CONFIG_HAVE_ARM_CRC_INSTRUCTIONS)
+#include <arm_acle.h>
+#endif
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_CRC32_POLYNOMIAL  0xEDB88320 /* reflected */
+#define ATX_CRC32C_POLYNOMIAL 0x82F63B78 /* reflected */
+
+#define ATX_XXH3_STRIPE_SIZE        64
+#define ATX_XXH3_SECRET_SIZE        192
+#define ATX_XXH3_SECRET_CONSUME     8
+#define ATX_XXH3_STRIPES_PER_BLOCK  ((ATX_XXH3_SECRET_SIZE-ATX_XXH3_STRIPE_SIZE)/ATX_XXH3_SECRET_CONSUME)
+#define ATX_XXH3_BUFFER_SIZE        256
+#define ATX_XXH3_BUFFER_STRIPES     (ATX_XXH3_BUFFER_SIZE/ATX_XXH3_STRIPE_SIZE)
+#define ATX_XXH3_MID_SIZE_MAX       240
+
+#define ATX_XXH3_U64(hi, lo) (((ATX_UInt64)(hi) << 32) | (ATX_UInt64)(lo))
+#define ATX_XXH_PRIME32_1 0x9E3779B1U
+#define ATX_XXH_PRIME32_2 0x85EBCA77U
+#define ATX_XXH_PRIME32_3 0xC2B2AE3DU
+#define ATX_XXH_PRIME64_1 ATX_XXH3_U64(0x9E3779B1, 0x85EBCA87)
+#define ATX_XXH_PRIME64_2 ATX_XXH3_U64(0xC2B2AE3D, 0x27D4EB4F)
+#define ATX_XXH_PRIME64_3 ATX_XXH3_U64(0x165667B1, 0x9E3779F9)
+#define ATX_XXH_PRIME64_4 ATX_XXH3_U64(0x85EBCA77, 0xC2B2AE63)
+#define ATX_XXH_PRIME64_5 ATX_XXH3_U64(0x27D4EB2F, 0x165667C5)
+#define ATX_XXH_PRIME_MX1 ATX_XXH3_U64(0x16566791, 0x9E3779F9)
+#define ATX_XXH_PRIME_MX2 ATX_XXH3_U64(0x9FB21C65, 0x1E98DF25)
+
+/* default secret */
+static const ATX_Byte ATX_Xxh3_Secret[ATX_XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_UInt64    acc[8];
+    ATX_Byte      buffer[ATX_XXH3_BUFFER_SIZE];
+    ATX_Size      buffered;
+    ATX_Size      stripes; /* stripes consumed in the current block */
+    ATX_LargeSize total;
+} ATX_Xxh3State;
+
+struct ATX_Checksum {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_StreamTransformer);
+
+    /* members */
+    ATX_ChecksumType type;
+    ATX_UInt32       crc;
+    ATX_Xxh3State    xxh3;
+};
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_Checksum, ATX_StreamTransformer)
+
+/*----------------------------------------------------------------------
+|   globals
++---------------------------------------------------------------------*/
+/* slicing-by-8 tables, built on first use */
+static ATX_UInt32  ATX_Crc32_Table[8][256];
+static ATX_UInt32  ATX_Crc32c_Table[8][256];
+static ATX_Boolean ATX_Crc32_TableReady  = ATX_FALSE;
+static ATX_Boolean ATX_Crc32c_TableReady = ATX_FALSE;
+
+/*----------------------------------------------------------------------
+|   ATX_Crc_BuildTable
+|
+|   Building the same table twice from two threads is harmless, so
+|   there is no lock.
++---------------------------------------------------------------------*/
+static void
+ATX_Crc_BuildTable(ATX_UInt32 table[8][256], ATX_UInt32 polynomial)
+{
+    unsigned int n, k;
+    
+    for (n=0; n<256; n++) {
+        ATX_UInt32 crc = n;
+        for (k=0; k<8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+        }
+        table[0][n] = crc;
+    }
+    for (n=0; n<256; n++) {
+        for (k=1; k<8; k++) {
+            table[k][n] = (table[k-1][n] >> 8) ^ table[0][table[k-1][n] & 0xFF];
+        }
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Crc_Update
+|
+|   Slicing-by-8 on the inverted crc.
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Crc_Update(ATX_UInt32 table[8][256], ATX_UInt32 crc, const ATX_Byte* p, ATX_Size size)
+{
+    while (size >= 8) {
+        ATX_UInt32 one = crc ^ ((ATX_UInt32)p[0]        | ((ATX_UInt32)p[1] <<  8) | 
+                                ((ATX_UInt32)p[2] << 16) | ((ATX_UInt32)p[3] << 24));
+        ATX_UInt32 two =        ((ATX_UInt32)p[4]        | ((ATX_UInt32)p[5] <<  8) | 
+                                ((ATX_UInt32)p[6] << 16) | ((ATX_UInt32)p[7] << 24));
+        crc = table[7][ one        & 0xFF] ^ table[6][(one >>  8) & 0xFF] ^ 
+              table[5][(one >> 16) & 0xFF] ^ table[4][ one >> 24        ] ^
+              table[3][ two        & 0xFF] ^ table[2][(two >>  8) & 0xFF] ^ 
+              table[1][(two >> 16) & 0xFF] ^ table[0][ two >> 24        ];
+        p    += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+    }
+    
+    return crc;
+}
+
+#if defined(ATX_CONFIG_HAVE_X86_CRC_INSTRUCTIONS)
+/*----------------------------------------------------------------------
+|   CPU feature detection
++---------------------------------------------------------------------*/
+static int ATX_Crc_HaveSse42  = -1;
+static int ATX_Crc_HavePclmul = -1;
+
+static void
+ATX_Crc_DetectFeatures(void)
+{
+    __builtin_cpu_init();
+    ATX_Crc_HavePclmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1") ? 1 : 0;
+    ATX_Crc_HaveSse42  = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Crc32c_Sse42
++---------------------------------------------------------------------*/
+__attribute__((target("sse4.2")))
+static ATX_UInt32
+ATX_Crc32c_Sse42(ATX_UInt32 crc, const ATX_Byte* p, ATX_Size size)
+{
+    /* align the data */
+    while (size && ((ATX_UIntPtr)p & 7)) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --size;
+    }
+#if defined(__x86_64__)
+    {
+        ATX_UInt64 crc64 = crc;
+        while (size >= 8) {
+            crc64 = _mm_crc32_u64(crc64, *(const ATX_UInt64*)p);
+            p    += 8;
+            size -= 8;
+        }
+        crc = (ATX_UInt32)crc64;
+    }
+#endif
+    while (size >= 4) {
+        crc = _mm_crc32_u32(crc, *(const ATX_UInt32*)p);
+        p    += 4;
+        size -= 4;
+    }
+    while (size--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    
+    return crc;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Crc32_Pclmul
+|
+|   Folds 64 bytes at a time with carry-less multiplications, then 
+|   reduces to 32 bits with Barrett reduction (Intel, "Fast CRC 
+|   Computation for Generic Polynomials Using PCLMULQDQ Instruction").
+|   size must be a multiple of 16, and at least 64.
++---------------------------------------------------------------------*/
+__attribute__((target("pclmul,sse4.1")))
+static ATX_UInt32
+ATX_Crc32_Pclmul(ATX_UInt32 crc, const ATX_Byte* p, ATX_Size size)
+{
+    __m128i k1k2 = _mm_set_epi32(0x00000001, 0xC6E41596, 0x00000001, 0x54442BD4);
+    __m128i k3k4 = _mm_set_epi32(0x00000000, 0xCCAA009E, 0x00000001, 0x751997D0);
+    __m128i k5   = _mm_set_epi32(0x00000000, 0x00000000, 0x00000001, 0x63CD6124);
+    __m128i poly = _mm_set_epi32(0x00000001, 0xF7011641, 0x00000001, 0xDB710641);
+    __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i x1, x2, x3, x4, x5, x6, x7, x8;
+    
+    x1 = _mm_loadu_si128((const __m128i*)(p     ));
+    x2 = _mm_loadu_si128((const __m128i*)(p+0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(p+0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(p+0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    p    += 64;
+    size -= 64;
+    
+    /* fold 64 bytes at a time */
+    while (size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p     )));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p+0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p+0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p+0x30)));
+        p    += 64;
+        size -= 64;
+    }
+    
+    /* fold into 128 bits */
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+    
+    /* fold the remaining 16 byte blocks */
+    while (size >= 16) {
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)p)), x5);
+        p    += 16;
+        size -= 16;
+    }
+    
+    /* fold 128 bits to 64 bits */
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask);
+    x1 = _mm_clmulepi64_si128(x1, k5, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    /* Barrett reduction to 32 bits */
+    x2 = _mm_and_si128(x1, mask);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    return (ATX_UInt32)_mm_extract_epi32(x1, 1);
+}
+#endif /* ATX_CONFIG_HAVE_X86_CRC_INSTRUCTIONS */
+
+#if defined(ATX_CONFIG_HAVE_ARM_CRC_INSTRUCTIONS)
+/*----------------------------------------------------------------------
+|   ATX_Crc_Arm
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Crc_Arm(ATX_Boolean castagnoli, ATX_UInt32 crc, const ATX_Byte* p, ATX_Size size)
+{
+    /* align the data */
+    while (size && ((ATX_UIntPtr)p & 7)) {
+        crc = castagnoli ? __crc32cb(crc, *p) : __crc32b(crc, *p);
+        ++p;
+        --size;
+    }
+    if (castagnoli) {
+        for (; size >= 8; p += 8, size -= 8) crc = __crc32cd(crc, *(const ATX_UInt64*)p);
+    } else {
+        for (; size >= 8; p += 8, size -= 8) crc = __crc32d(crc, *(const ATX_UInt64*)p);
+    }
+    while (size--) {
+        crc = castagnoli ? __crc32cb(crc, *p) : __crc32b(crc, *p);
+        ++p;
+    }
+    
+    return crc;
+}
+#endif /* ATX_CONFIG_HAVE_ARM_CRC_INSTRUCTIONS */
+
+/*----------------------------------------------------------------------
+|   ATX_Crc32
++---------------------------------------------------------------------*/
+ATX_UInt32
+ATX_Crc32(ATX_UInt32 crc, ATX_AnyConst data, ATX_Size size)
+{
+    const ATX_Byte* p = (const ATX_Byte*)data;
+    
+    crc = ~crc;
+#if defined(ATX_CONFIG_HAVE_ARM_CRC_INSTRUCTIONS)
+    return ~ATX_Crc_Arm(ATX_FALSE, crc, p, size);
+#else
+#if defined(ATX_CONFIG_HAVE_X86_CRC_INSTRUCTIONS)
+    if (ATX_Crc_HavePclmul < 0) ATX_Crc_DetectFeatures();
+    if (ATX_Crc_HavePclmul && size >= 64) {
+        ATX_Size chunk = size & ~(ATX_Size)15;
+        crc   = ATX_Crc32_Pclmul(crc, p, chunk);
+        p    += chunk;
+        size -= chunk;
+    }
+#endif
+    if (!ATX_Crc32_TableReady) {
+        ATX_Crc_BuildTable(ATX_Crc32_Table, ATX_CRC32_POLYNOMIAL);
+        ATX_Crc32_TableReady = ATX_TRUE;
+    }
+    return ~ATX_Crc_Update(ATX_Crc32_Table, crc, p, size);
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Crc32c
++---------------------------------------------------------------------*/
+ATX_UInt32
+ATX_Crc32c(ATX_UInt32 crc, ATX_AnyConst data, ATX_Size size)
+{
+    const ATX_Byte* p = (const ATX_Byte*)data;
+    
+    crc = ~crc;
+#if defined(ATX_CONFIG_HAVE_ARM_CRC_INSTRUCTIONS)
+    return ~ATX_Crc_Arm(ATX_TRUE, crc, p, size);
+#else
+#if defined(ATX_CONFIG_HAVE_X86_CRC_INSTRUCTIONS)
+    if (ATX_Crc_HaveSse42 < 0) ATX_Crc_DetectFeatures();
+    if (ATX_Crc_HaveSse42) return ~ATX_Crc32c_Sse42(crc, p, size);
+#endif
+    if (!ATX_Crc32c_TableReady) {
+        ATX_Crc_BuildTable(ATX_Crc32c_Table, ATX_CRC32C_POLYNOMIAL);
+        ATX_Crc32c_TableReady = ATX_TRUE;
+    }
+    return ~ATX_Crc_Update(ATX_Crc32c_Table, crc, p, size);
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Read32
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Xxh3_Read32(const ATX_Byte* p)
+{
+#if ATX_CONFIG_CPU_BYTE_ORDER == ATX_CPU_LITTLE_ENDIAN
+    ATX_UInt32 value;
+    ATX_CopyMemory(&value, p, 4);
+    return value;
+#else
+    return ((ATX_UInt32)p[0]      ) | ((ATX_UInt32)p[1] <<  8) | 
+           ((ATX_UInt32)p[2] << 16) | ((ATX_UInt32)p[3] << 24);
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Read64
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_Read64(const ATX_Byte* p)
+{
+#if ATX_CONFIG_CPU_BYTE_ORDER == ATX_CPU_LITTLE_ENDIAN
+    ATX_UInt64 value;
+    ATX_CopyMemory(&value, p, 8);
+    return value;
+#else
+    return ((ATX_UInt64)ATX_Xxh3_Read32(p+4) << 32) | ATX_Xxh3_Read32(p);
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Swap32
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Xxh3_Swap32(ATX_UInt32 x)
+{
+    return (x << 24) | ((x << 8) & 0x00FF0000) | ((x >> 8) & 0x0000FF00) | (x >> 24);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Swap64
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_Swap64(ATX_UInt64 x)
+{
+    return ((ATX_UInt64)ATX_Xxh3_Swap32((ATX_UInt32)x) << 32) | ATX_Xxh3_Swap32((ATX_UInt32)(x >> 32));
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Mul128Fold64
+|
+|   Full 64x64 bit product, with the high and low halves xor-ed.
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_Mul128Fold64(ATX_UInt64 a, ATX_UInt64 b)
+{
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 product = (unsigned __int128)a*b;
+    return (ATX_UInt64)product ^ (ATX_UInt64)(product >> 64);
+#else
+    ATX_UInt64 lo_lo = (a & 0xFFFFFFFF)*(b & 0xFFFFFFFF);
+    ATX_UInt64 hi_lo = (a >> 32)*(b & 0xFFFFFFFF);
+    ATX_UInt64 lo_hi = (a & 0xFFFFFFFF)*(b >> 32);
+    ATX_UInt64 hi_hi = (a >> 32)*(b >> 32);
+    ATX_UInt64 cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    ATX_UInt64 upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    ATX_UInt64 lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return lower ^ upper;
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Avalanche
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_Avalanche(ATX_UInt64 h)
+{
+    h ^= h >> 37;
+    h *= ATX_XXH_PRIME_MX1;
+    return h ^ (h >> 32);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh64_Avalanche
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh64_Avalanche(ATX_UInt64 h)
+{
+    h ^= h >> 33;
+    h *= ATX_XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= ATX_XXH_PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Mix16
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_Mix16(const ATX_Byte* input, const ATX_Byte* secret)
+{
+    return ATX_Xxh3_Mul128Fold64(ATX_Xxh3_Read64(input  ) ^ ATX_Xxh3_Read64(secret  ),
+                                 ATX_Xxh3_Read64(input+8) ^ ATX_Xxh3_Read64(secret+8));
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_HashShort
+|
+|   Hash inputs of up to ATX_XXH3_MID_SIZE_MAX bytes.
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_HashShort(const ATX_Byte* input, ATX_Size size)
+{
+    const ATX_Byte* secret = ATX_Xxh3_Secret;
+    ATX_UInt64      acc;
+    ATX_Size        i;
+    
+    if (size == 0) {
+        return ATX_Xxh64_Avalanche(ATX_Xxh3_Read64(secret+56) ^ ATX_Xxh3_Read64(secret+64));
+    }
+    if (size <= 3) {
+        ATX_UInt32 combined = ((ATX_UInt32)input[0] << 16) | 
+                              ((ATX_UInt32)input[size >> 1] << 24) | 
+                              ((ATX_UInt32)input[size-1]) | 
+                              ((ATX_UInt32)size << 8);
+        ATX_UInt64 flip = ATX_Xxh3_Read32(secret) ^ ATX_Xxh3_Read32(secret+4);
+        return ATX_Xxh64_Avalanche((ATX_UInt64)combined ^ flip);
+    }
+    if (size <= 8) {
+        ATX_UInt64 flip  = ATX_Xxh3_Read64(secret+8) ^ ATX_Xxh3_Read64(secret+16);
+        ATX_UInt64 value = ATX_Xxh3_Read32(input+size-4) + ((ATX_UInt64)ATX_Xxh3_Read32(input) << 32);
+        ATX_UInt64 h = value ^ flip;
+        h ^= ((h << 49) | (h >> 15)) ^ ((h << 24) | (h >> 40));
+        h *= ATX_XXH_PRIME_MX2;
+        h ^= (h >> 35) + size;
+        h *= ATX_XXH_PRIME_MX2;
+        return h ^ (h >> 28);
+    }
+    if (size <= 16) {
+        ATX_UInt64 lo = ATX_Xxh3_Read64(input)        ^ (ATX_Xxh3_Read64(secret+24) ^ ATX_Xxh3_Read64(secret+32));
+        ATX_UInt64 hi = ATX_Xxh3_Read64(input+size-8) ^ (ATX_Xxh3_Read64(secret+40) ^ ATX_Xxh3_Read64(secret+48));
+        acc = size + ATX_Xxh3_Swap64(lo) + hi + ATX_Xxh3_Mul128Fold64(lo, hi);
+        return ATX_Xxh3_Avalanche(acc);
+    }
+    
+    acc = size*ATX_XXH_PRIME64_1;
+    if (size <= 128) {
+        if (size > 32) {
+            if (size > 64) {
+                if (size > 96) {
+                    acc += ATX_Xxh3_Mix16(input+48,      secret+96);
+                    acc += ATX_Xxh3_Mix16(input+size-64, secret+112);
+                }
+                acc += ATX_Xxh3_Mix16(input+32,      secret+64);
+                acc += ATX_Xxh3_Mix16(input+size-48, secret+80);
+            }
+            acc += ATX_Xxh3_Mix16(input+16,      secret+32);
+            acc += ATX_Xxh3_Mix16(input+size-32, secret+48);
+        }
+        acc += ATX_Xxh3_Mix16(input,         secret);
+        acc += ATX_Xxh3_Mix16(input+size-16, secret+16);
+        return ATX_Xxh3_Avalanche(acc);
+    }
+    
+    for (i=0; i<8; i++) {
+        acc += ATX_Xxh3_Mix16(input+16*i, secret+16*i);
+    }
+    acc = ATX_Xxh3_Avalanche(acc);
+    for (i=8; i<size/16; i++) {
+        acc += ATX_Xxh3_Mix16(input+16*i, secret+16*(i-8)+3);
+    }
+    acc += ATX_Xxh3_Mix16(input+size-16, secret+136-17);
+    return ATX_Xxh3_Avalanche(acc);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Accumulate
++---------------------------------------------------------------------*/
+static void
+ATX_Xxh3_Accumulate(ATX_UInt64*     acc, 
+                    const ATX_Byte* input, 
+                    const ATX_Byte* secret, 
+                    ATX_Size        stripes)
+{
+    ATX_Size     n;
+    unsigned int i;
+    
+    for (n=0; n<stripes; n++) {
+        for (i=0; i<8; i++) {
+            ATX_UInt64 value = ATX_Xxh3_Read64(input+8*i);
+            ATX_UInt64 key   = value ^ ATX_Xxh3_Read64(secret+8*i);
+            acc[i^1] += value;
+            acc[i]   += (key & 0xFFFFFFFF)*(key >> 32);
+        }
+        input  += ATX_XXH3_STRIPE_SIZE;
+        secret += ATX_XXH3_SECRET_CONSUME;
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Scramble
++---------------------------------------------------------------------*/
+static void
+ATX_Xxh3_Scramble(ATX_UInt64* acc)
+{
+    const ATX_Byte* secret = ATX_Xxh3_Secret+ATX_XXH3_SECRET_SIZE-ATX_XXH3_STRIPE_SIZE;
+    unsigned int    i;
+    
+    for (i=0; i<8; i++) {
+        ATX_UInt64 a = acc[i];
+        a ^= a >> 47;
+        a ^= ATX_Xxh3_Read64(secret+8*i);
+        acc[i] = a*ATX_XXH_PRIME32_1;
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_ConsumeStripes
+|
+|   Accumulate stripes, scrambling at the end of each block.
++---------------------------------------------------------------------*/
+static void
+ATX_Xxh3_ConsumeStripes(ATX_UInt64*     acc, 
+                        ATX_Size*       stripes_so_far, 
+                        const ATX_Byte* input, 
+                        ATX_Size        stripes)
+{
+    while (stripes) {
+        ATX_Size count = ATX_XXH3_STRIPES_PER_BLOCK-*stripes_so_far;
+        if (count > stripes) count = stripes;
+        ATX_Xxh3_Accumulate(acc, 
+                            input, 
+                            ATX_Xxh3_Secret+*stripes_so_far*ATX_XXH3_SECRET_CONSUME, 
+                            count);
+        input           += count*ATX_XXH3_STRIPE_SIZE;
+        stripes         -= count;
+        *stripes_so_far += count;
+        if (*stripes_so_far == ATX_XXH3_STRIPES_PER_BLOCK) {
+            ATX_Xxh3_Scramble(acc);
+            *stripes_so_far = 0;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_Merge
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3_Merge(const ATX_UInt64* acc, ATX_LargeSize total)
+{
+    const ATX_Byte* secret = ATX_Xxh3_Secret+11;
+    ATX_UInt64      result = total*ATX_XXH_PRIME64_1;
+    unsigned int    i;
+    
+    for (i=0; i<4; i++) {
+        result += ATX_Xxh3_Mul128Fold64(acc[2*i  ] ^ ATX_Xxh3_Read64(secret+16*i  ), 
+                                        acc[2*i+1] ^ ATX_Xxh3_Read64(secret+16*i+8));
+    }
+    
+    return ATX_Xxh3_Avalanche(result);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3State_Reset
++---------------------------------------------------------------------*/
+static void
+ATX_Xxh3State_Reset(ATX_Xxh3State* self)
+{
+    self->acc[0]   = ATX_XXH_PRIME32_3;
+    self->acc[1]   = ATX_XXH_PRIME64_1;
+    self->acc[2]   = ATX_XXH_PRIME64_2;
+    self->acc[3]   = ATX_XXH_PRIME64_3;
+    self->acc[4]   = ATX_XXH_PRIME64_4;
+    self->acc[5]   = ATX_XXH_PRIME32_2;
+    self->acc[6]   = ATX_XXH_PRIME64_5;
+    self->acc[7]   = ATX_XXH_PRIME32_1;
+    self->buffered = 0;
+    self->stripes  = 0;
+    self->total    = 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3State_Update
+|
+|   Input is consumed in whole stripes, always keeping at least one
+|   byte buffered, because the last stripe is hashed differently.
++---------------------------------------------------------------------*/
+static void
+ATX_Xxh3State_Update(ATX_Xxh3State* self, const ATX_Byte* input, ATX_Size size)
+{
+    const ATX_Byte* end = input+size;
+    
+    self->total += size;
+    if (size <= ATX_XXH3_BUFFER_SIZE-self->buffered) {
+        ATX_CopyMemory(self->buffer+self->buffered, input, size);
+        self->buffered += size;
+        return;
+    }
+    
+    /* complete and consume the buffer */
+    if (self->buffered) {
+        ATX_Size chunk = ATX_XXH3_BUFFER_SIZE-self->buffered;
+        ATX_CopyMemory(self->buffer+self->buffered, input, chunk);
+        input += chunk;
+        ATX_Xxh3_ConsumeStripes(self->acc, &self->stripes, self->buffer, ATX_XXH3_BUFFER_STRIPES);
+        self->buffered = 0;
+    }
+    
+    /* consume directly from the input */
+    if ((ATX_Size)(end-input) > ATX_XXH3_BUFFER_SIZE) {
+        ATX_Size stripes = ((ATX_Size)(end-input)-1)/ATX_XXH3_STRIPE_SIZE;
+        ATX_Xxh3_ConsumeStripes(self->acc, &self->stripes, input, stripes);
+        input += stripes*ATX_XXH3_STRIPE_SIZE;
+        
+        /* keep the last stripe for the digest */
+        ATX_CopyMemory(self->buffer+ATX_XXH3_BUFFER_SIZE-ATX_XXH3_STRIPE_SIZE, 
+                       input-ATX_XXH3_STRIPE_SIZE, 
+                       ATX_XXH3_STRIPE_SIZE);
+    }
+    
+    ATX_CopyMemory(self->buffer, input, (ATX_Size)(end-input));
+    self->buffered = (ATX_Size)(end-input);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3State_Digest
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Xxh3State_Digest(const ATX_Xxh3State* self)
+{
+    ATX_UInt64      acc[8];
+    ATX_Byte        last[ATX_XXH3_STRIPE_SIZE];
+    const ATX_Byte* last_stripe;
+    
+    if (self->total <= ATX_XXH3_MID_SIZE_MAX) {
+        return ATX_Xxh3_HashShort(self->buffer, (ATX_Size)self->total);
+    }
+    
+    ATX_CopyMemory(acc, self->acc, sizeof(acc));
+    if (self->buffered >= ATX_XXH3_STRIPE_SIZE) {
+        ATX_Size stripes_so_far = self->stripes;
+        ATX_Xxh3_ConsumeStripes(acc, 
+                                &stripes_so_far, 
+                                self->buffer, 
+                                (self->buffered-1)/ATX_XXH3_STRIPE_SIZE);
+        last_stripe = self->buffer+self->buffered-ATX_XXH3_STRIPE_SIZE;
+    } else {
+        /* the last stripe straddles the end and the start of the buffer */
+        ATX_Size catchup = ATX_XXH3_STRIPE_SIZE-self->buffered;
+        ATX_CopyMemory(last, self->buffer+ATX_XXH3_BUFFER_SIZE-catchup, catchup);
+        ATX_CopyMemory(last+catchup, self->buffer, self->buffered);
+        last_stripe = last;
+    }
+    ATX_Xxh3_Accumulate(acc, 
+                        last_stripe, 
+                        ATX_Xxh3_Secret+ATX_XXH3_SECRET_SIZE-ATX_XXH3_STRIPE_SIZE-7, 
+                        1);
+    
+    return ATX_Xxh3_Merge(acc, self->total);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Xxh3_64
++---------------------------------------------------------------------*/
+ATX_UInt64
+ATX_Xxh3_64(ATX_AnyConst data, ATX_Size size)
+{
+    const ATX_Byte* input = (const ATX_Byte*)data;
+    ATX_UInt64      acc[8];
+    ATX_Size        blocks;
+    ATX_Size        n;
+    ATX_Size        block_size = ATX_XXH3_STRIPES_PER_BLOCK*ATX_XXH3_STRIPE_SIZE;
+    
+    if (size <= ATX_XXH3_MID_SIZE_MAX) return ATX_Xxh3_HashShort(input, size);
+    
+    acc[0] = ATX_XXH_PRIME32_3;
+    acc[1] = ATX_XXH_PRIME64_1;
+    acc[2] = ATX_XXH_PRIME64_2;
+    acc[3] = ATX_XXH_PRIME64_3;
+    acc[4] = ATX_XXH_PRIME64_4;
+    acc[5] = ATX_XXH_PRIME32_2;
+    acc[6] = ATX_XXH_PRIME64_5;
+    acc[7] = ATX_XXH_PRIME32_1;
+    
+    blocks = (size-1)/block_size;
+    for (n=0; n<blocks; n++) {
+        ATX_Xxh3_Accumulate(acc, input+n*block_size, ATX_Xxh3_Secret, ATX_XXH3_STRIPES_PER_BLOCK);
+        ATX_Xxh3_Scramble(acc);
+    }
+    ATX_Xxh3_Accumulate(acc, 
+                        input+blocks*block_size, 
+                        ATX_Xxh3_Secret, 
+                        ((size-1)-blocks*block_size)/ATX_XXH3_STRIPE_SIZE);
+    ATX_Xxh3_Accumulate(acc, 
+                        input+size-ATX_XXH3_STRIPE_SIZE, 
+                        ATX_Xxh3_Secret+ATX_XXH3_SECRET_SIZE-ATX_XXH3_STRIPE_SIZE-7, 
+                        1);
+    
+    return ATX_Xxh3_Merge(acc, size);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Checksum_Create(ATX_ChecksumType type, ATX_Checksum** checksum)
+{
+    /* check parameters */
+    *checksum = NULL;
+    if (type != ATX_CHECKSUM_TYPE_CRC32  &&
+        type != ATX_CHECKSUM_TYPE_CRC32C &&
+        type != ATX_CHECKSUM_TYPE_XXH3_64) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    
+    /* allocate new object */
+    *checksum = (ATX_Checksum*)ATX_AllocateMemory(sizeof(ATX_Checksum));
+    if (*checksum == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    /* construct the object */
+    (*checksum)->type = type;
+    ATX_Checksum_Reset(*checksum);
+    
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(*checksum, ATX_Checksum, ATX_StreamTransformer);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Checksum_Destroy(ATX_Checksum* self)
+{
+    if (self) ATX_FreeMemory((void*)self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_Reset
++---------------------------------------------------------------------*/
+void
+ATX_Checksum_Reset(ATX_Checksum* self)
+{
+    self->crc = 0;
+    if (self->type == ATX_CHECKSUM_TYPE_XXH3_64) ATX_Xxh3State_Reset(&self->xxh3);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_Update
++---------------------------------------------------------------------*/
+void
+ATX_Checksum_Update(ATX_Checksum* self, ATX_AnyConst data, ATX_Size size)
+{
+    switch (self->type) {
+      case ATX_CHECKSUM_TYPE_CRC32:
+        self->crc = ATX_Crc32(self->crc, data, size);
+        break;
+        
+      case ATX_CHECKSUM_TYPE_CRC32C:
+        self->crc = ATX_Crc32c(self->crc, data, size);
+        break;
+        
+      case ATX_CHECKSUM_TYPE_XXH3_64:
+        ATX_Xxh3State_Update(&self->xxh3, (const ATX_Byte*)data, size);
+        break;
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_GetValue
++---------------------------------------------------------------------*/
+ATX_UInt64
+ATX_Checksum_GetValue(const ATX_Checksum* self)
+{
+    if (self->type == ATX_CHECKSUM_TYPE_XXH3_64) {
+        return ATX_Xxh3State_Digest(&self->xxh3);
+    }
+    return self->crc;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_GetTransformer
++---------------------------------------------------------------------*/
+ATX_StreamTransformer*
+ATX_Checksum_GetTransformer(ATX_Checksum* self)
+{
+    return &ATX_BASE(self, ATX_StreamTransformer);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_Transform
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Checksum_Transform(ATX_StreamTransformer* _self,
+                       ATX_AnyConst           buffer,
+                       ATX_Size               size)
+{
+    ATX_Checksum* self = ATX_SELF(ATX_Checksum, ATX_StreamTransformer);
+    
+    ATX_Checksum_Update(self, buffer, size);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Checksum_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_Checksum)
+    ATX_GET_INTERFACE_ACCEPT(ATX_Checksum, ATX_StreamTransformer)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_StreamTransformer interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_Checksum, ATX_StreamTransformer)
+    ATX_Checksum_Transform
+};
@@ -0,0 +1,104 @@
+/*****************************************************************
+|
+|   Atomix - Checksums
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_CHECKSUM_H_
+#define _ATX_CHECKSUM_H_
+
+/*----------------------------------------------------------------------
+|    includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxStreams.h"
+
+/*----------------------------------------------------------------------
+|    types
++---------------------------------------------------------------------*/
+typedef enum {
+    ATX_CHECKSUM_TYPE_CRC32,   /* IEEE 802.3 polynomial, as used by zlib and PNG */
+    ATX_CHECKSUM_TYPE_CRC32C,  /* Castagnoli polynomial, as used by iSCSI and ext4 */
+    ATX_CHECKSUM_TYPE_XXH3_64  /* 64-bit XXH3, with a seed of 0 */
+} ATX_ChecksumType;
+
+typedef struct ATX_Checksum ATX_Checksum;
+
+/*----------------------------------------------------------------------
+|    prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Update a CRC32 with more data. Start with a crc of 0.
+ * Uses the PCLMUL instruction or ARMv8 CRC instructions when 
+ * available.
+ */
+ATX_UInt32 ATX_Crc32(ATX_UInt32 crc, ATX_AnyConst data, ATX_Size size);
+
+/**
+ * Update a CRC32C with more data. Start with a crc of 0.
+ * Uses the SSE4.2 or ARMv8 CRC instructions when available.
+ */
+ATX_UInt32 ATX_Crc32c(ATX_UInt32 crc, ATX_AnyConst data, ATX_Size size);
+
+/**
+ * Compute the 64-bit XXH3 hash of a buffer.
+ */
+ATX_UInt64 ATX_Xxh3_64(ATX_AnyConst data, ATX_Size size);
+
+/**
+ * Create an object that computes a checksum incrementally.
+ */
+ATX_Result ATX_Checksum_Create(ATX_ChecksumType type, ATX_Checksum** checksum);
+ATX_Result ATX_Checksum_Destroy(ATX_Checksum* self);
+void       ATX_Checksum_Reset(ATX_Checksum* self);
+void       ATX_Checksum_Update(ATX_Checksum* self, ATX_AnyConst data, ATX_Size size);
+
+/**
+ * Get the checksum of the data so far. CRCs are returned in the low
+ * 32 bits. Data can still be added afterwards.
+ */
+ATX_UInt64 ATX_Checksum_GetValue(const ATX_Checksum* self);
+
+/**
+ * Get a stream transformer that adds the data going through a stream 
+ * to the checksum, for use with ATX_SubInputStream_Create and
+ * ATX_SubOutputStream_Create. The transformer belongs to the checksum
+ * object, which must outlive the streams that use it.
+ */
+ATX_StreamTransformer* ATX_Checksum_GetTransformer(ATX_Checksum* self);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _ATX_CHECKSUM_H_ */
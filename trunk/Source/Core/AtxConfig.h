@@ -70,6 +70,7 @@
 #define ATX_CONFIG_HAVE_MEMMOVE
 #define ATX_CONFIG_HAVE_MEMSET
 #define ATX_CONFIG_HAVE_MEMCMP
+#define ATX_CONFIG_HAVE_MEMCHR
 #define ATX_CONFIG_HAVE_ATEXIT
 #define ATX_CONFIG_HAVE_GETENV
 #endif /* ATX_CONFIG_HAS_STD_C */
@@ -116,6 +117,16 @@
 #define ATX_LocalFunctionName __FUNCTION__
 #define ATX_COMPILER_UNUSED(p) (void)p
 #define ATX_CONFIG_HAVE_STDINT_H
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define ATX_CONFIG_HAVE_X86_CRC_INSTRUCTIONS
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+#define ATX_CONFIG_HAVE_ARM_CRC_INSTRUCTIONS
+#endif
+#if defined(__clang__) || (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)
+#define ATX_CONFIG_HAVE_GCC_ATOMICS
+#endif
 #else
 #define ATX_COMPILER_UNUSED(p) 
 #endif
@@ -135,6 +146,7 @@
 #define ATX_INT64_PRINTF_FORMAT "I64"
 #define ATX_CONFIG_INT_PTR_TYPE intptr_t
 #define ATX_CONFIG_UINT_PTR_TYPE uintptr_t
+#define ATX_CONFIG_HAVE_MSC_INTERLOCKED
 #if (_MSC_VER >= 1400) && !defined(_WIN32_WCE)
 #define ATX_vsnprintf(s,c,f,a)  _vsnprintf_s(s,c,_TRUNCATE,f,a)
 #define ATX_snprintf(s,c,f,...) _snprintf_s(s,c,_TRUNCATE,f,__VA_ARGS__)
@@ -177,10 +189,25 @@
 
 #if defined(__linux__) 
 #define ATX_CONFIG_HAVE_GETADDRINFO
+#define ATX_CONFIG_HAVE_MMAP
+#define ATX_CONFIG_HAVE_SENDFILE
+#define ATX_CONFIG_HAVE_SPLICE
+#define ATX_CONFIG_HAVE_READV
+#define ATX_CONFIG_HAVE_FUTEX
+#define ATX_CONFIG_HAVE_PRCTL
+#define ATX_CONFIG_HAVE_CONDATTR_SETCLOCK
+#if !defined(ANDROID)
+#define ATX_CONFIG_HAVE_TLS
+#define ATX_CONFIG_HAVE_COPY_FILE_RANGE
+#define ATX_CONFIG_HAVE_MEMFD
+#endif
 #endif
 
 #if defined(__APPLE__)
 #define ATX_CONFIG_HAVE_GETADDRINFO
+#define ATX_CONFIG_HAVE_MMAP
+#define ATX_CONFIG_HAVE_READV
+#define ATX_CONFIG_HAVE_PTHREAD_SETNAME_NP
 #endif
 
 #if defined(ANDROID)
@@ -35,15 +35,37 @@
 #include "AtxDataBuffer.h"
 #include "AtxResults.h"
 #include "AtxUtils.h"
+#include "AtxThreads.h"
+#include "AtxAtomic.h"
 
 /*----------------------------------------------------------------------
 |   types
 +---------------------------------------------------------------------*/
+/* memory shared by a buffer, its slices and its clones */
+typedef struct {
+    ATX_AtomicInt reference_count;
+    ATX_Byte*     memory;
+} ATX_DataBufferStorage;
+
 struct ATX_DataBuffer {
-    ATX_Boolean buffer_is_local;
-    ATX_Byte*   buffer;
-    ATX_Size    buffer_size;
-    ATX_Size    data_size;
+    ATX_Boolean            buffer_is_local;
+    ATX_Byte*              buffer;
+    ATX_Size               buffer_size;
+    ATX_Size               data_size;
+    ATX_DataBufferStorage* storage; /* NULL unless the memory is shared */
+    ATX_DataBufferPool*    pool;    /* pool to return to when destroyed */
+    ATX_DataBuffer*        next;    /* next free buffer in the pool     */
+};
+
+struct ATX_DataBufferPool {
+    ATX_Mutex*      lock;          /* NULL if used by a single thread   */
+    ATX_Size        max_buffer_size;
+    ATX_Cardinal    max_cached;    /* free buffers kept per size class */
+    ATX_Cardinal    class_count;
+    ATX_DataBuffer* free_buffers[ATX_DATA_BUFFER_POOL_MAX_CLASS_COUNT];
+    ATX_Cardinal    free_counts[ATX_DATA_BUFFER_POOL_MAX_CLASS_COUNT];
+    ATX_Cardinal    buffer_count;  /* buffers created and not yet freed */
+    ATX_Boolean     destroyed;
 };
 
 /*----------------------------------------------------------------------
@@ -51,6 +73,25 @@ struct ATX_DataBuffer {
 +---------------------------------------------------------------------*/
 #define ATX_DATA_BUFFER_EXTRA_GROW_SPACE 256
 
+/*----------------------------------------------------------------------
+|   macros
++---------------------------------------------------------------------*/
+/* slices may be handed to other threads, so the storage reference 
+   count is updated atomically */
+#define ATX_DATA_BUFFER_STORAGE_ADD_REFERENCE(s) \
+    ATX_Atomic_Add(&(s)->reference_count, 1, ATX_ATOMIC_RELAXED)
+#define ATX_DATA_BUFFER_STORAGE_RELEASE(s) \
+    ATX_Atomic_Add(&(s)->reference_count, -1, ATX_ATOMIC_ACQ_REL)
+
+/* true if the memory can be replaced by a new allocation */
+#define ATX_DATA_BUFFER_CAN_REALLOCATE(b) ((b)->buffer_is_local || (b)->storage)
+
+/*----------------------------------------------------------------------
+|   globals
++---------------------------------------------------------------------*/
+/* created by the first call to ATX_DataBuffer_GetThreadScratch */
+static ATX_AtomicPointer atx_data_buffer_scratch = NULL;
+
 /*----------------------------------------------------------------------
 |   ATX_DataBuffer_Create
 +---------------------------------------------------------------------*/
@@ -82,6 +123,11 @@ ATX_DataBuffer_Create(ATX_Size size, ATX_DataBuffer** buffer)
 ATX_Result
 ATX_DataBuffer_Clone(const ATX_DataBuffer* self, ATX_DataBuffer** clone)
 {
+    /* share the memory if we own it, it is copied on the first write */
+    if (ATX_DATA_BUFFER_CAN_REALLOCATE(self) && self->data_size) {
+        return ATX_DataBuffer_CreateSlice(self, 0, self->data_size, clone);
+    }
+
     /* create a clone with a buffer of the same size */
     ATX_CHECK(ATX_DataBuffer_Create(self->data_size, clone));
 
@@ -92,14 +138,98 @@ ATX_DataBuffer_Clone(const ATX_DataBuffer* self, ATX_DataBuffer** clone)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_DataBuffer_ReleaseStorage
+|
+|   Stop using the shared memory, freeing it if this was the last user.
++---------------------------------------------------------------------*/
+static void
+ATX_DataBuffer_ReleaseStorage(ATX_DataBuffer* self)
+{
+    if (self->storage == NULL) return;
+    if (ATX_DATA_BUFFER_STORAGE_RELEASE(self->storage) == 0) {
+        ATX_FreeMemory((void*)self->storage->memory);
+        ATX_FreeMemory((void*)self->storage);
+    }
+    self->storage = NULL;
+    self->buffer  = NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBuffer_CreateSlice
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_DataBuffer_CreateSlice(const ATX_DataBuffer* parent, 
+                           ATX_Size              offset,
+                           ATX_Size              size,
+                           ATX_DataBuffer**      slice)
+{
+    ATX_DataBuffer* self = (ATX_DataBuffer*)parent;
+
+    /* default value */
+    *slice = NULL;
+
+    /* check parameters */
+    if (offset > parent->data_size || size > parent->data_size-offset) {
+        return ATX_ERROR_OUT_OF_RANGE;
+    }
+
+    /* turn a local buffer into shared storage the first time it is 
+       sliced (this does not change its contents, hence the const cast) */
+    if (self->buffer_is_local && self->buffer) {
+        ATX_DataBufferStorage* storage;
+        storage = (ATX_DataBufferStorage*)ATX_AllocateMemory(sizeof(ATX_DataBufferStorage));
+        if (storage == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+        storage->reference_count = 1;
+        storage->memory          = self->buffer;
+        self->storage            = storage;
+        self->buffer_is_local    = ATX_FALSE;
+    }
+
+    /* create the slice */
+    *slice = ATX_AllocateZeroMemory(sizeof(ATX_DataBuffer));
+    if (*slice == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    (*slice)->buffer_is_local = parent->buffer == NULL;
+    (*slice)->buffer          = parent->buffer ? parent->buffer+offset : NULL;
+    (*slice)->buffer_size     = size;
+    (*slice)->data_size       = size;
+    (*slice)->storage         = parent->storage;
+    if (parent->storage) ATX_DATA_BUFFER_STORAGE_ADD_REFERENCE(parent->storage);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBuffer_IsShared
++---------------------------------------------------------------------*/
+ATX_Boolean
+ATX_DataBuffer_IsShared(const ATX_DataBuffer* self)
+{
+    return (self->storage && 
+            ATX_Atomic_Load(&self->storage->reference_count, ATX_ATOMIC_ACQUIRE) > 1) ? 
+           ATX_TRUE : ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Recycle (forward declaration)
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_DataBufferPool_Recycle(ATX_DataBufferPool* self, ATX_DataBuffer* buffer);
+
 /*----------------------------------------------------------------------
 |   ATX_DataBuffer_Destroy
 +---------------------------------------------------------------------*/
 ATX_Result 
 ATX_DataBuffer_Destroy(ATX_DataBuffer* self)
 {
+    /* buffers from a pool go back to it if they can be reused */
+    if (self->pool && ATX_DataBufferPool_Recycle(self->pool, self)) {
+        return ATX_SUCCESS;
+    }
+
     /* free the buffer */
     if (self->buffer_is_local) ATX_FreeMemory((void*)self->buffer);
+    ATX_DataBuffer_ReleaseStorage(self);
 
     /* free the object */
     ATX_FreeMemory((void*)self);
@@ -132,7 +262,12 @@ ATX_DataBuffer_ReallocateBuffer(ATX_DataBuffer* self, ATX_Size size)
     }
 
     /* destroy the previous buffer */
-    ATX_FreeMemory((void*)self->buffer);
+    if (self->storage) {
+        ATX_DataBuffer_ReleaseStorage(self);
+        self->buffer_is_local = ATX_TRUE;
+    } else {
+        ATX_FreeMemory((void*)self->buffer);
+    }
 
     /* use the new buffer */
     self->buffer = new_buffer;
@@ -141,6 +276,19 @@ ATX_DataBuffer_ReallocateBuffer(ATX_DataBuffer* self, ATX_Size size)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_DataBuffer_Unshare
+|
+|   Make a private copy of the memory before it is modified, if other
+|   buffers use it.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_DataBuffer_Unshare(ATX_DataBuffer* self)
+{
+    if (!ATX_DataBuffer_IsShared(self)) return ATX_SUCCESS;
+    return ATX_DataBuffer_ReallocateBuffer(self, self->buffer_size);
+}
+
 /*----------------------------------------------------------------------
 |   ATX_DataBuffer_SetBuffer
 +---------------------------------------------------------------------*/
@@ -153,6 +301,7 @@ ATX_DataBuffer_SetBuffer(ATX_DataBuffer* self,
         /* destroy the local buffer */
         ATX_FreeMemory((void*)self->buffer);
     }
+    ATX_DataBuffer_ReleaseStorage(self);
 
     /* we're now using an external buffer */
     self->buffer_is_local = ATX_FALSE;
@@ -170,7 +319,7 @@ ATX_Result
 ATX_DataBuffer_SetBufferSize(ATX_DataBuffer* self,
                              ATX_Size        buffer_size)
 {
-    if (self->buffer_is_local) {
+    if (ATX_DATA_BUFFER_CAN_REALLOCATE(self)) {
         return ATX_DataBuffer_ReallocateBuffer(self, buffer_size);
     } else {
         /* cannot change an external buffer */
@@ -218,6 +367,8 @@ ATX_DataBuffer_GetData(const ATX_DataBuffer* self)
 ATX_Byte* 
 ATX_DataBuffer_UseData(ATX_DataBuffer* self)
 {
+    /* the caller may write, so stop sharing */
+    if (ATX_FAILED(ATX_DataBuffer_Unshare(self))) return NULL;
     return self->buffer;
 }
 
@@ -238,7 +389,7 @@ ATX_DataBuffer_SetDataSize(ATX_DataBuffer* self, ATX_Size size)
 {
     if (size > self->buffer_size) {
         /* the buffer is too small, we need to reallocate it */
-        if (self->buffer_is_local) {
+        if (ATX_DATA_BUFFER_CAN_REALLOCATE(self)) {
             ATX_CHECK(ATX_DataBuffer_ReallocateBuffer(self, size));
         } else { 
             /* we cannot reallocate an external buffer */
@@ -259,11 +410,13 @@ ATX_DataBuffer_SetData(ATX_DataBuffer* self,
                        ATX_Size        data_size)
 {
     if (data_size > self->buffer_size) {
-        if (self->buffer_is_local) {
+        if (ATX_DATA_BUFFER_CAN_REALLOCATE(self)) {
             ATX_CHECK(ATX_DataBuffer_ReallocateBuffer(self, data_size));
         } else {
             return ATX_ERROR_OUT_OF_RESOURCES;
         }
+    } else {
+        ATX_CHECK(ATX_DataBuffer_Unshare(self));
     }
     ATX_CopyMemory(self->buffer, data, data_size);
     self->data_size = data_size;
@@ -305,8 +458,275 @@ ATX_DataBuffer_AppendData(ATX_DataBuffer*   self,
     
     /* reserve the space and copy the appended data */
     ATX_CHECK(ATX_DataBuffer_Reserve(self, new_data_size));
+    ATX_CHECK(ATX_DataBuffer_Unshare(self));
     ATX_CopyMemory(self->buffer + self->data_size, data, data_size);
     self->data_size = new_data_size;
     
     return ATX_SUCCESS;
 }
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_DataBufferPool_Create(ATX_Size             max_buffer_size,
+                          ATX_Cardinal         max_cached,
+                          ATX_Flags            flags,
+                          ATX_DataBufferPool** pool)
+{
+    ATX_Result result;
+
+    /* defaults */
+    *pool = NULL;
+    if (max_buffer_size == 0) max_buffer_size = ATX_DATA_BUFFER_POOL_DEFAULT_MAX_BUFFER_SIZE;
+    if (max_cached == 0)      max_cached      = ATX_DATA_BUFFER_POOL_DEFAULT_MAX_CACHED;
+
+    /* allocate the object */
+    *pool = (ATX_DataBufferPool*)ATX_AllocateZeroMemory(sizeof(ATX_DataBufferPool));
+    if (*pool == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    if ((flags & ATX_DATA_BUFFER_POOL_FLAG_SINGLE_THREAD) == 0) {
+        result = ATX_Mutex_Create(&(*pool)->lock);
+        if (ATX_FAILED(result)) {
+            ATX_FreeMemory((void*)*pool);
+            *pool = NULL;
+            return result;
+        }
+    }
+
+    /* compute the size classes, rounding the largest one up */
+    (*pool)->max_cached  = max_cached;
+    (*pool)->class_count = 1;
+    (*pool)->max_buffer_size = ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE;
+    while ((*pool)->max_buffer_size < max_buffer_size &&
+           (*pool)->class_count < ATX_DATA_BUFFER_POOL_MAX_CLASS_COUNT) {
+        (*pool)->max_buffer_size *= 2;
+        ++(*pool)->class_count;
+    }
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Lock
++---------------------------------------------------------------------*/
+static void
+ATX_DataBufferPool_Lock(ATX_DataBufferPool* self)
+{
+    if (self->lock) ATX_Mutex_Lock(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Unlock
++---------------------------------------------------------------------*/
+static void
+ATX_DataBufferPool_Unlock(ATX_DataBufferPool* self)
+{
+    if (self->lock) ATX_Mutex_Unlock(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Free
+|
+|   Free the pool object once it is destroyed and no buffer refers to it.
++---------------------------------------------------------------------*/
+static void
+ATX_DataBufferPool_Free(ATX_DataBufferPool* self)
+{
+    if (self->lock) ATX_Mutex_Destroy(self->lock);
+    ATX_FreeMemory((void*)self);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Destroy
+|
+|   Buffers still in use stay valid, they are freed instead of going 
+|   back to the pool when destroyed.
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_DataBufferPool_Destroy(ATX_DataBufferPool* self)
+{
+    ATX_DataBuffer* free_buffers = NULL;
+    ATX_Boolean     unused;
+    ATX_Cardinal    i;
+
+    if (self == NULL) return ATX_SUCCESS;
+
+    /* detach the free buffers */
+    ATX_DataBufferPool_Lock(self);
+    self->destroyed = ATX_TRUE;
+    for (i=0; i<self->class_count; i++) {
+        while (self->free_buffers[i]) {
+            ATX_DataBuffer* buffer = self->free_buffers[i];
+            self->free_buffers[i] = buffer->next;
+            buffer->next = free_buffers;
+            free_buffers = buffer;
+            --self->buffer_count;
+        }
+        self->free_counts[i] = 0;
+    }
+    unused = (self->buffer_count == 0);
+    ATX_DataBufferPool_Unlock(self);
+
+    /* free them */
+    while (free_buffers) {
+        ATX_DataBuffer* buffer = free_buffers;
+        free_buffers = buffer->next;
+        buffer->pool = NULL;
+        ATX_DataBuffer_Destroy(buffer);
+    }
+    if (unused) ATX_DataBufferPool_Free(self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_GetClass
+|
+|   Returns the smallest size class that can hold a number of bytes.
++---------------------------------------------------------------------*/
+static ATX_Cardinal
+ATX_DataBufferPool_GetClass(ATX_Size size)
+{
+    ATX_Cardinal size_class = 0;
+    ATX_Size     class_size = ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE;
+
+    while (class_size < size) {
+        class_size *= 2;
+        ++size_class;
+    }
+    
+    return size_class;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Acquire
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_DataBufferPool_Acquire(ATX_DataBufferPool* self,
+                           ATX_Size            size,
+                           ATX_DataBuffer**    buffer)
+{
+    ATX_Cardinal size_class;
+    ATX_Result   result;
+
+    /* large buffers are not pooled */
+    if (size > self->max_buffer_size) return ATX_DataBuffer_Create(size, buffer);
+    size_class = ATX_DataBufferPool_GetClass(size);
+
+    /* reuse a free buffer if there is one */
+    ATX_DataBufferPool_Lock(self);
+    *buffer = self->free_buffers[size_class];
+    if (*buffer) {
+        self->free_buffers[size_class] = (*buffer)->next;
+        --self->free_counts[size_class];
+    } else {
+        ++self->buffer_count;
+    }
+    ATX_DataBufferPool_Unlock(self);
+    if (*buffer) {
+        (*buffer)->next      = NULL;
+        (*buffer)->data_size = 0;
+        return ATX_SUCCESS;
+    }
+
+    /* or create a new one */
+    result = ATX_DataBuffer_Create((ATX_Size)ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE<<size_class, buffer);
+    if (ATX_FAILED(result)) {
+        ATX_DataBufferPool_Lock(self);
+        --self->buffer_count;
+        ATX_DataBufferPool_Unlock(self);
+        return result;
+    }
+    (*buffer)->pool = self;
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBufferPool_Recycle
+|
+|   Called when a buffer that came from a pool is destroyed. Returns 
+|   ATX_TRUE if the pool kept it, or ATX_FALSE if the caller should free 
+|   it (in which case the pool no longer refers to it).
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_DataBufferPool_Recycle(ATX_DataBufferPool* self, ATX_DataBuffer* buffer)
+{
+    ATX_Cardinal size_class = ATX_DataBufferPool_GetClass(buffer->buffer_size);
+    ATX_Boolean  reusable;
+    ATX_Boolean  unused = ATX_FALSE;
+
+    /* the memory must still be ours, and exactly the size of a class 
+       (buffers that were grown or sliced are freed) */
+    reusable = buffer->buffer_is_local                          && 
+               buffer->buffer                                   &&
+               buffer->storage == NULL                          &&
+               buffer->buffer_size <= self->max_buffer_size     &&
+               buffer->buffer_size == (ATX_Size)ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE<<size_class;
+
+    ATX_DataBufferPool_Lock(self);
+    if (reusable && !self->destroyed && self->free_counts[size_class] < self->max_cached) {
+        buffer->next = self->free_buffers[size_class];
+        self->free_buffers[size_class] = buffer;
+        ++self->free_counts[size_class];
+        ATX_DataBufferPool_Unlock(self);
+        return ATX_TRUE;
+    }
+    --self->buffer_count;
+    unused = self->destroyed && self->buffer_count == 0;
+    ATX_DataBufferPool_Unlock(self);
+
+    /* the caller frees the buffer */
+    buffer->pool = NULL;
+    if (unused) ATX_DataBufferPool_Free(self);
+
+    return ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBuffer_DestroyThreadScratch
++---------------------------------------------------------------------*/
+static void
+ATX_DataBuffer_DestroyThreadScratch(void* buffer)
+{
+    ATX_DataBuffer_Destroy((ATX_DataBuffer*)buffer);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_DataBuffer_GetThreadScratch
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_DataBuffer_GetThreadScratch(ATX_Size size, ATX_DataBuffer** buffer)
+{
+    ATX_ThreadLocal* local;
+    ATX_DataBuffer*  scratch;
+    ATX_Result       result;
+    
+    *buffer = NULL;
+    
+    /* threads that race to create the thread local keep the first one */
+    local = (ATX_ThreadLocal*)ATX_Atomic_LoadPointer(&atx_data_buffer_scratch, ATX_ATOMIC_ACQUIRE);
+    if (local == NULL) {
+        ATX_CHECK(ATX_ThreadLocal_Create(ATX_DataBuffer_DestroyThreadScratch, &local));
+        if (!ATX_Atomic_CompareAndSwapPointer(&atx_data_buffer_scratch, NULL, (void*)local)) {
+            ATX_ThreadLocal_Destroy(local);
+            local = (ATX_ThreadLocal*)ATX_Atomic_LoadPointer(&atx_data_buffer_scratch, ATX_ATOMIC_ACQUIRE);
+        }
+    }
+    
+    scratch = (ATX_DataBuffer*)ATX_ThreadLocal_Get(local);
+    if (scratch == NULL) {
+        ATX_CHECK(ATX_DataBuffer_Create(size, &scratch));
+        result = ATX_ThreadLocal_Set(local, scratch);
+        if (ATX_FAILED(result)) {
+            ATX_DataBuffer_Destroy(scratch);
+            return result;
+        }
+    }
+    
+    scratch->data_size = 0;
+    ATX_CHECK(ATX_DataBuffer_Reserve(scratch, size));
+    *buffer = scratch;
+    
+    return ATX_SUCCESS;
+}
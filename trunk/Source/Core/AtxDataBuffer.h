@@ -43,6 +43,29 @@
 +---------------------------------------------------------------------*/
 typedef struct ATX_DataBuffer ATX_DataBuffer;
 
+/**
+ * A cache of data buffers in power-of-two size classes, from 
+ * ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE up to a maximum size. Buffers
+ * obtained with ATX_DataBufferPool_Acquire go back to the pool when 
+ * they are destroyed with ATX_DataBuffer_Destroy, so that steady-state
+ * traffic reuses memory instead of allocating it.
+ * A pool is thread-safe unless it is created with 
+ * ATX_DATA_BUFFER_POOL_FLAG_SINGLE_THREAD, in which case it should be
+ * used, and its buffers destroyed, by one thread only (a per-thread 
+ * cache, or a pool used under an existing lock).
+ */
+typedef struct ATX_DataBufferPool ATX_DataBufferPool;
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE         64
+#define ATX_DATA_BUFFER_POOL_MAX_CLASS_COUNT         24
+#define ATX_DATA_BUFFER_POOL_DEFAULT_MAX_BUFFER_SIZE 65536
+#define ATX_DATA_BUFFER_POOL_DEFAULT_MAX_CACHED      32
+
+#define ATX_DATA_BUFFER_POOL_FLAG_SINGLE_THREAD 0x01
+
 /*----------------------------------------------------------------------
 |   functions
 +---------------------------------------------------------------------*/
@@ -53,6 +76,61 @@ extern "C" {
 ATX_Result ATX_DataBuffer_Create(ATX_Size size, ATX_DataBuffer** buffer);
 ATX_Result ATX_DataBuffer_Clone(const ATX_DataBuffer* self,
                                 ATX_DataBuffer**      clone);
+
+/**
+ * Create a buffer whose data is a range of the data of a parent buffer,
+ * without copying it. The memory is reference counted: the parent and 
+ * its slices can be destroyed in any order, and a buffer makes a private
+ * copy of it before any modification (UseData, SetData, AppendData, ...)
+ * while it is shared. ATX_DataBuffer_Clone shares memory the same way.
+ * Pointers obtained with UseData before slicing may still modify the 
+ * shared memory.
+ * Slices of a buffer that uses external memory (ATX_DataBuffer_SetBuffer)
+ * are only valid as long as that memory.
+ */
+ATX_Result ATX_DataBuffer_CreateSlice(const ATX_DataBuffer* parent,
+                                     ATX_Size              offset,
+                                     ATX_Size              size,
+                                     ATX_DataBuffer**      slice);
+
+/**
+ * Returns ATX_TRUE if the memory of the buffer is also used by other
+ * buffers (slices or clones).
+ */
+ATX_Boolean ATX_DataBuffer_IsShared(const ATX_DataBuffer* self);
+
+/**
+ * Create a pool. max_buffer_size is rounded up to a power of two, 
+ * larger buffers are allocated and freed normally. max_cached is the 
+ * number of free buffers kept per size class. Pass 0 for defaults.
+ */
+ATX_Result ATX_DataBufferPool_Create(ATX_Size             max_buffer_size,
+                                     ATX_Cardinal         max_cached,
+                                     ATX_Flags            flags,
+                                     ATX_DataBufferPool** pool);
+
+/**
+ * Destroy a pool. Buffers that are still in use remain valid and are 
+ * freed when they are destroyed.
+ */
+ATX_Result ATX_DataBufferPool_Destroy(ATX_DataBufferPool* self);
+
+/**
+ * Get an empty buffer that can hold at least size bytes.
+ */
+ATX_Result ATX_DataBufferPool_Acquire(ATX_DataBufferPool* self,
+                                      ATX_Size            size,
+                                      ATX_DataBuffer**    buffer);
+
+/**
+ * Get an empty buffer that can hold at least size bytes, private to the
+ * calling thread. The buffer is created by the first call in a thread,
+ * reused by the next ones, and destroyed when the thread exits: it must
+ * not be destroyed by the caller, and its content only lasts until the
+ * next call in the same thread.
+ */
+ATX_Result ATX_DataBuffer_GetThreadScratch(ATX_Size         size,
+                                           ATX_DataBuffer** buffer);
 ATX_Result ATX_DataBuffer_Destroy(ATX_DataBuffer* self);
 ATX_Result ATX_DataBuffer_SetBuffer(ATX_DataBuffer* self,
                                     ATX_Byte*       buffer_memory, 
@@ -63,6 +141,13 @@ ATX_Size   ATX_DataBuffer_GetBufferSize(const ATX_DataBuffer* self);
 ATX_Result ATX_DataBuffer_Reserve(ATX_DataBuffer* self,
                                   ATX_Size        buffer_size);
 const ATX_Byte*  ATX_DataBuffer_GetData(const ATX_DataBuffer* self);
+
+/**
+ * Returns a pointer to the data, for the caller to modify. If the memory
+ * is shared with other buffers, a private copy is made first, and NULL 
+ * is returned if that copy can't be allocated. NULL is also returned for
+ * a buffer that has no memory yet.
+ */
 ATX_Byte*  ATX_DataBuffer_UseData(ATX_DataBuffer* self);
 ATX_Size   ATX_DataBuffer_GetDataSize(const ATX_DataBuffer* self);
 ATX_Result ATX_DataBuffer_SetDataSize(ATX_DataBuffer* self, ATX_Size size);
@@ -32,12 +32,51 @@
 /*----------------------------------------------------------------------
 |   includes
 +---------------------------------------------------------------------*/
+#define _LARGEFILE_SOURCE
+#define _LARGEFILE_SOURCE64
+#define _FILE_OFFSET_BITS 64
+
+#include "AtxConfig.h"
 #include "AtxFile.h"
 #include "AtxResults.h"
 #include "AtxTypes.h"
+#include "AtxUtils.h"
 #include "AtxReferenceable.h"
+#include "AtxAtomic.h"
 #include "AtxDestroyable.h"
 
+#if defined(ATX_CONFIG_HAVE_MMAP)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+struct ATX_FileView {
+    ATX_Cardinal    reference_count;
+    const ATX_Byte* data;
+    ATX_LargeSize   size;
+    void*           mapping;      /* NULL when the data was loaded */
+    ATX_LargeSize   mapping_size;
+    ATX_DataBuffer* buffer;       /* NULL when the data is mapped  */
+};
+
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_MappedInputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal  reference_count;
+    ATX_FileView* view;
+    ATX_Position  position;
+} ATX_FileViewStream;
+
 /*----------------------------------------------------------------------
 |   interface stubs
 +---------------------------------------------------------------------*/
@@ -171,3 +210,397 @@ ATX_SaveFile(ATX_CString filename, ATX_DataBuffer* buffer)
 
     return result;
 }
+
+/*----------------------------------------------------------------------
+|   ATX_MapFile
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_MapFile(ATX_CString filename, ATX_FileView** view)
+{
+    ATX_File*  file;
+    ATX_Result result;
+
+    /* open the file */
+    ATX_CHECK(ATX_File_Create(filename, &file));
+    result = ATX_File_Open(file, ATX_FILE_OPEN_MODE_READ);
+    if (ATX_FAILED(result)) {
+        ATX_DESTROY_OBJECT(file);
+        return result;
+    }
+
+    /* map the whole file, the view outlives the file */
+    result = ATX_File_Map(file, 0, 0, view);
+
+    /* close and destroy the file */
+    ATX_File_Close(file);
+    ATX_DESTROY_OBJECT(file);
+
+    return result;
+}
+
+#if defined(ATX_CONFIG_HAVE_MMAP)
+/*----------------------------------------------------------------------
+|   ATX_FileView_Map
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_FileView_Map(ATX_FileView*    self, 
+                 ATX_InputStream* input, 
+                 ATX_Position     offset, 
+                 ATX_LargeSize    size)
+{
+    ATX_DescriptorStream* descriptor = ATX_CAST(input, ATX_DescriptorStream);
+    struct stat           info;
+    ATX_Position          page_offset;
+    void*                 mapping;
+    int                   fd;
+
+    /* only regular files can be mapped */
+    if (descriptor == NULL) return ATX_ERROR_NOT_SUPPORTED;
+    ATX_CHECK(ATX_DescriptorStream_GetDescriptor(descriptor, &fd));
+    if (fstat(fd, &info) || !S_ISREG(info.st_mode)) return ATX_ERROR_NOT_SUPPORTED;
+    
+    /* clip to the end of the file */
+    if (offset > (ATX_Position)info.st_size) return ATX_ERROR_OUT_OF_RANGE;
+    if (size == 0 || size > (ATX_LargeSize)info.st_size-offset) {
+        size = (ATX_LargeSize)info.st_size-offset;
+    }
+    
+    /* empty ranges can't be mapped */
+    if (size == 0) return ATX_ERROR_NOT_SUPPORTED;
+
+    /* mappings must start on a page boundary */
+    page_offset = offset%(ATX_Position)sysconf(_SC_PAGESIZE);
+    if (size+page_offset > (ATX_LargeSize)((size_t)-1)) {
+        return ATX_ERROR_OUT_OF_RANGE;
+    }
+    mapping = mmap(NULL, 
+                   (size_t)(size+page_offset), 
+                   PROT_READ, 
+                   MAP_PRIVATE, 
+                   fd, 
+                   (off_t)(offset-page_offset));
+    if (mapping == MAP_FAILED) {
+        return errno == ENOMEM ? ATX_ERROR_OUT_OF_MEMORY : ATX_ERROR_NOT_SUPPORTED;
+    }
+    
+    self->mapping      = mapping;
+    self->mapping_size = size+page_offset;
+    self->data         = (const ATX_Byte*)mapping+page_offset;
+    self->size         = size;
+    
+    /* the hint is only advice, the view is usable without it */
+    ATX_FileView_Advise(self, ATX_FILE_VIEW_ADVICE_SEQUENTIAL);
+    
+    return ATX_SUCCESS;
+}
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_FileView_Load
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_FileView_Load(ATX_FileView*    self, 
+                  ATX_InputStream* input, 
+                  ATX_Position     offset, 
+                  ATX_LargeSize    size)
+{
+    ATX_Position position = 0;
+    
+    /* the data has to fit in a data buffer */
+    if (size > 0xFFFFFFFF) return ATX_ERROR_OUT_OF_RANGE;
+    
+    /* read from the offset */
+    ATX_InputStream_Tell(input, &position);
+    if (position != offset) ATX_CHECK(ATX_InputStream_Seek(input, offset));
+    ATX_CHECK(ATX_InputStream_Load(input, (ATX_Size)size, &self->buffer));
+    
+    self->data = ATX_DataBuffer_GetData(self->buffer);
+    self->size = ATX_DataBuffer_GetDataSize(self->buffer);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_File_Map
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_File_Map(ATX_File*      file, 
+             ATX_Position   offset, 
+             ATX_LargeSize  size, 
+             ATX_FileView** view)
+{
+    ATX_InputStream* input = NULL;
+    ATX_Result       result;
+
+    /* default return value */
+    *view = NULL;
+    
+    /* get the input stream for the file */
+    ATX_CHECK(ATX_File_GetInputStream(file, &input));
+
+    /* create the view */
+    *view = (ATX_FileView*)ATX_AllocateZeroMemory(sizeof(ATX_FileView));
+    if (*view == NULL) {
+        result = ATX_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    (*view)->reference_count = 1;
+    
+    /* map the file if we can, read it otherwise */
+    result = ATX_ERROR_NOT_SUPPORTED;
+#if defined(ATX_CONFIG_HAVE_MMAP)
+    result = ATX_FileView_Map(*view, input, offset, size);
+#endif
+    if (result == ATX_ERROR_NOT_SUPPORTED) {
+        result = ATX_FileView_Load(*view, input, offset, size);
+    }
+    if (ATX_FAILED(result)) {
+        ATX_FileView_Destroy(*view);
+        *view = NULL;
+    }
+    
+end:
+    ATX_RELEASE_OBJECT(input);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileView_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_FileView_Destroy(ATX_FileView* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL)) return ATX_SUCCESS;
+    
+#if defined(ATX_CONFIG_HAVE_MMAP)
+    if (self->mapping) munmap(self->mapping, (size_t)self->mapping_size);
+#endif
+    if (self->buffer) ATX_DataBuffer_Destroy(self->buffer);
+    ATX_FreeMemory((void*)self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileView_GetData
++---------------------------------------------------------------------*/
+const ATX_Byte*
+ATX_FileView_GetData(const ATX_FileView* self)
+{
+    return self->data;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileView_GetSize
++---------------------------------------------------------------------*/
+ATX_LargeSize
+ATX_FileView_GetSize(const ATX_FileView* self)
+{
+    return self->size;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileView_Advise
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_FileView_Advise(ATX_FileView* self, ATX_FileViewAdvice advice)
+{
+#if defined(ATX_CONFIG_HAVE_MMAP)
+    int hint;
+    int result;
+    
+    /* only mapped pages can be advised */
+    if (self->mapping == NULL) return ATX_SUCCESS;
+    
+    switch (advice) {
+      case ATX_FILE_VIEW_ADVICE_SEQUENTIAL: hint = POSIX_MADV_SEQUENTIAL; break;
+      case ATX_FILE_VIEW_ADVICE_RANDOM:     hint = POSIX_MADV_RANDOM;     break;
+      case ATX_FILE_VIEW_ADVICE_WILL_NEED:  hint = POSIX_MADV_WILLNEED;   break;
+      case ATX_FILE_VIEW_ADVICE_DONT_NEED:  hint = POSIX_MADV_DONTNEED;   break;
+      default:                              hint = POSIX_MADV_NORMAL;     break;
+    }
+    result = posix_madvise(self->mapping, (size_t)self->mapping_size, hint);
+    if (result) return ATX_ERROR_ERRNO(result);
+#else
+    ATX_COMPILER_UNUSED(self);
+    ATX_COMPILER_UNUSED(advice);
+#endif
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_FileViewStream, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_FileViewStream, ATX_MappedInputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_FileViewStream, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_FileView_GetInputStream
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_FileView_GetInputStream(ATX_FileView* self, ATX_InputStream** stream)
+{
+    ATX_FileViewStream* view_stream;
+    
+    /* allocate the object */
+    view_stream = (ATX_FileViewStream*)ATX_AllocateMemory(sizeof(ATX_FileViewStream));
+    if (view_stream == NULL) {
+        *stream = NULL;
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* construct the object, it keeps the view alive */
+    view_stream->reference_count = 1;
+    view_stream->view            = self;
+    view_stream->position        = 0;
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(view_stream, ATX_FileViewStream, ATX_InputStream);
+    ATX_SET_INTERFACE(view_stream, ATX_FileViewStream, ATX_MappedInputStream);
+    ATX_SET_INTERFACE(view_stream, ATX_FileViewStream, ATX_Referenceable);
+    *stream = &ATX_BASE(view_stream, ATX_InputStream);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_FileViewStream_Destroy(ATX_FileViewStream* self)
+{
+    ATX_FileView_Destroy(self->view);
+    ATX_FreeMemory((void*)self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_ReadPointer
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_FileViewStream_ReadPointer(ATX_MappedInputStream* _self,
+                               ATX_Size               max_bytes,
+                               const ATX_Byte**       data,
+                               ATX_Size*              bytes_read)
+{
+    ATX_FileViewStream* self = ATX_SELF(ATX_FileViewStream, ATX_MappedInputStream);
+    ATX_LargeSize       available = self->view->size-self->position;
+    
+    /* clip to what's available */
+    if (max_bytes > available) max_bytes = (ATX_Size)available;
+    *data = self->view->data+self->position;
+    if (bytes_read) *bytes_read = max_bytes;
+    self->position += max_bytes;
+
+    return available ? ATX_SUCCESS : ATX_ERROR_EOS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_Read
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_FileViewStream_Read(ATX_InputStream* _self,
+                        ATX_Any          buffer, 
+                        ATX_Size         bytes_to_read, 
+                        ATX_Size*        bytes_read)
+{
+    ATX_FileViewStream* self = ATX_SELF(ATX_FileViewStream, ATX_InputStream);
+    const ATX_Byte*     data;
+    ATX_Size            size = 0;
+    ATX_Result          result;
+    
+    result = ATX_FileViewStream_ReadPointer(&ATX_BASE(self, ATX_MappedInputStream), 
+                                            bytes_to_read, 
+                                            &data, 
+                                            &size);
+    if (size) ATX_CopyMemory(buffer, data, size);
+    if (bytes_read) *bytes_read = size;
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_FileViewStream_Seek(ATX_InputStream* _self, ATX_Position where)
+{
+    ATX_FileViewStream* self = ATX_SELF(ATX_FileViewStream, ATX_InputStream);
+    
+    if (where > self->view->size) return ATX_ERROR_INVALID_PARAMETERS;
+    self->position = where;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_FileViewStream_Tell(ATX_InputStream* _self, ATX_Position* where)
+{
+    ATX_FileViewStream* self = ATX_SELF(ATX_FileViewStream, ATX_InputStream);
+    
+    if (where) *where = self->position;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_GetSize
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_FileViewStream_GetSize(ATX_InputStream* _self, ATX_LargeSize* size)
+{
+    ATX_FileViewStream* self = ATX_SELF(ATX_FileViewStream, ATX_InputStream);
+    
+    if (size) *size = self->view->size;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_FileViewStream_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_FileViewStream_GetAvailable(ATX_InputStream* _self, ATX_LargeSize* available)
+{
+    ATX_FileViewStream* self = ATX_SELF(ATX_FileViewStream, ATX_InputStream);
+    
+    if (available) *available = self->view->size-self->position;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   GetInterface implementation
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_FileViewStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_FileViewStream, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_FileViewStream, ATX_MappedInputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_FileViewStream, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_FileViewStream, ATX_InputStream)
+    ATX_FileViewStream_Read,
+    ATX_FileViewStream_Seek,
+    ATX_FileViewStream_Tell,
+    ATX_FileViewStream_GetSize,
+    ATX_FileViewStream_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_MappedInputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_FileViewStream, ATX_MappedInputStream)
+    ATX_FileViewStream_ReadPointer
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_FileViewStream, reference_count)
@@ -42,12 +42,20 @@
 /*----------------------------------------------------------------------
 |   constants
 +---------------------------------------------------------------------*/
-#define ATX_FILE_OPEN_MODE_READ       0x01
-#define ATX_FILE_OPEN_MODE_WRITE      0x02
-#define ATX_FILE_OPEN_MODE_CREATE     0x04
-#define ATX_FILE_OPEN_MODE_TRUNCATE   0x08
-#define ATX_FILE_OPEN_MODE_APPEND     0x10
-#define ATX_FILE_OPEN_MODE_UNBUFFERED 0x20
+/* ATX_FILE_OPEN_MODE_UNBUFFERED turns off any buffering done by the      */
+/* platform's file API (stdio on most back ends).                         */
+/* ATX_FILE_OPEN_MODE_BUFFERED_OUTPUT makes ATX_File_GetOutputStream wrap */
+/* the file in an ATX_BufferedOutputStream, which holds writes until the  */
+/* buffer fills or the stream is flushed. All back ends honour it on its  */
+/* own, whether or not ATX_FILE_OPEN_MODE_UNBUFFERED is also set.         */
+#define ATX_FILE_OPEN_MODE_READ            0x01
+#define ATX_FILE_OPEN_MODE_WRITE           0x02
+#define ATX_FILE_OPEN_MODE_CREATE          0x04
+#define ATX_FILE_OPEN_MODE_TRUNCATE        0x08
+#define ATX_FILE_OPEN_MODE_APPEND          0x10
+#define ATX_FILE_OPEN_MODE_UNBUFFERED      0x20
+#define ATX_FILE_OPEN_MODE_BUFFERED_OUTPUT 0x40
+#define ATX_FILE_OPEN_MODE_READ_AHEAD      0x80 /* read on a helper thread */
 
 #define ATX_ERROR_NO_SUCH_FILE       (ATX_ERROR_BASE_FILE - 0)
 #define ATX_ERROR_FILE_NOT_OPEN      (ATX_ERROR_BASE_FILE - 1)
@@ -60,6 +68,24 @@
 #define ATX_FILE_STANDARD_OUTPUT "@STDOUT"
 #define ATX_FILE_STANDARD_ERROR  "@STDERR"
 
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/**
+ * A read-only view of a range of a file, mapped in memory when the
+ * platform supports it (mmap) or loaded into memory otherwise.
+ * The view stays valid after the file is closed.
+ */
+typedef struct ATX_FileView ATX_FileView;
+
+typedef enum {
+    ATX_FILE_VIEW_ADVICE_NORMAL,
+    ATX_FILE_VIEW_ADVICE_SEQUENTIAL,
+    ATX_FILE_VIEW_ADVICE_RANDOM,
+    ATX_FILE_VIEW_ADVICE_WILL_NEED,
+    ATX_FILE_VIEW_ADVICE_DONT_NEED
+} ATX_FileViewAdvice;
+
 /*----------------------------------------------------------------------
 |   ATX_File
 +---------------------------------------------------------------------*/
@@ -97,12 +123,38 @@ extern "C" {
 #endif /* __cplusplus */
 
 extern ATX_Result ATX_File_Create(ATX_CString name, ATX_File** file);
+/**
+ * Remove a file from the filesystem. Returns ATX_ERROR_NO_SUCH_FILE if
+ * there is no file with that name.
+ */
+extern ATX_Result ATX_File_DeleteFile(ATX_CString name);
 extern ATX_Result ATX_File_Load(ATX_File* file, ATX_DataBuffer** buffer);
 extern ATX_Result ATX_File_Save(ATX_File* file, ATX_DataBuffer* buffer);
 
+/**
+ * Create a view of size bytes of the file, starting at offset. A size
+ * of 0, or one past the end of the file, means up to the end of the
+ * file. Views are mapped with ATX_FILE_VIEW_ADVICE_SEQUENTIAL.
+ */
+extern ATX_Result ATX_File_Map(ATX_File*      file, 
+                               ATX_Position   offset, 
+                               ATX_LargeSize  size, 
+                               ATX_FileView** view);
+
+extern const ATX_Byte* ATX_FileView_GetData(const ATX_FileView* self);
+extern ATX_LargeSize   ATX_FileView_GetSize(const ATX_FileView* self);
+extern ATX_Result      ATX_FileView_Advise(ATX_FileView* self, ATX_FileViewAdvice advice);
+/**
+ * The returned stream also implements ATX_MappedInputStream, and keeps
+ * the view alive until it is released.
+ */
+extern ATX_Result      ATX_FileView_GetInputStream(ATX_FileView* self, ATX_InputStream** stream);
+extern ATX_Result      ATX_FileView_Destroy(ATX_FileView* self);
+
 /* helper functions */
 extern ATX_Result ATX_LoadFile(ATX_CString filename, ATX_DataBuffer** buffer);
 extern ATX_Result ATX_SaveFile(ATX_CString filename, ATX_DataBuffer* buffer);
+extern ATX_Result ATX_MapFile(ATX_CString filename, ATX_FileView** view);
 
 #ifdef __cplusplus
 }
@@ -324,6 +324,7 @@ ATX_HttpClient_SendRequestOnce(ATX_HttpClient*    self,
 {
     ATX_SocketAddress address;
     ATX_Socket*       connection = NULL;
+    ATX_InputStream*  socket_stream = NULL;
     ATX_InputStream*  input_stream = NULL;
     ATX_OutputStream* output_stream = NULL;
     ATX_Result        result;
@@ -355,7 +356,7 @@ ATX_HttpClient_SendRequestOnce(ATX_HttpClient*    self,
                               ATX_HTTP_HEADER_DEFAULT_AGENT);
 
     /* create a socket to connect to the server */
-    result = ATX_TcpClientSocket_Create(&connection);
+    result = ATX_TcpClientSocket_CreateEx(ATX_SOCKET_FLAG_BUFFERED_OUTPUT, &connection);
     if (ATX_FAILED(result)) return result;
 
     /* connect to the server */
@@ -369,9 +370,14 @@ ATX_HttpClient_SendRequestOnce(ATX_HttpClient*    self,
     if (ATX_FAILED(result)) goto end;
     result = ATX_HttpRequest_Emit(request, output_stream);
     if (ATX_FAILED(result)) goto end;
+    result = ATX_OutputStream_Flush(output_stream);
+    if (ATX_FAILED(result)) goto end;
 
-    /* create a response from the connection's input stream */
-    result = ATX_Socket_GetInputStream(connection, &input_stream);
+    /* create a response from the connection's input stream, buffered */
+    /* so that the status line and headers aren't read byte by byte    */
+    result = ATX_Socket_GetInputStream(connection, &socket_stream);
+    if (ATX_FAILED(result)) goto end;
+    result = ATX_BufferedInputStream_Create(socket_stream, 0, &input_stream);
     if (ATX_FAILED(result)) goto end;
     result = ATX_HttpResponse_CreateFromStream(input_stream, response);
     if (ATX_FAILED(result)) {
@@ -386,6 +392,7 @@ end:
         }
     }
     ATX_RELEASE_OBJECT(input_stream);
+    ATX_RELEASE_OBJECT(socket_stream);
     ATX_RELEASE_OBJECT(output_stream);
     ATX_DESTROY_OBJECT(connection);
     return result;
@@ -706,9 +713,16 @@ ATX_HttpMessage_Emit(const ATX_HttpMessage* message, ATX_OutputStream* stream)
         if (header && 
             !ATX_String_IsEmpty(&header->name) && 
             !ATX_String_IsEmpty(&header->value)) {
-            ATX_OutputStream_WriteString(stream, ATX_CSTR(header->name));
-            ATX_OutputStream_Write(stream, ": ", 2, NULL);
-            ATX_OutputStream_WriteLine(stream, ATX_CSTR(header->value));
+            ATX_IoVec line[4];
+            line[0].buffer = ATX_CSTR(header->name);
+            line[0].size   = ATX_String_GetLength(&header->name);
+            line[1].buffer = ": ";
+            line[1].size   = 2;
+            line[2].buffer = ATX_CSTR(header->value);
+            line[2].size   = ATX_String_GetLength(&header->value);
+            line[3].buffer = "\r\n";
+            line[3].size   = 2;
+            ATX_OutputStream_WriteVFully(stream, line, 4);
             ATX_LOG_FINE_2("ATX_HttpMessage::Emit - %s: %s", ATX_CSTR(header->name), ATX_CSTR(header->value));
         }
         item = ATX_ListItem_GetNext(item);
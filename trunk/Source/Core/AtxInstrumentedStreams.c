@@ -0,0 +1,770 @@
+/*****************************************************************
+|
+|   Atomix - Instrumented Streams
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxUtils.h"
+#include "AtxString.h"
+#include "AtxSystem.h"
+#include "AtxThreads.h"
+#include "AtxStreams.h"
+#include "AtxProperties.h"
+#include "AtxReferenceable.h"
+#include "AtxInstrumentedStreams.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+/* latencies are counted in nanoseconds, in buckets of 4 sub-ranges per
+   power of two, up to about 68 seconds (2^36 ns) */
+#define ATX_LATENCY_HISTOGRAM_SUB_BITS     2
+#define ATX_LATENCY_HISTOGRAM_SUB_COUNT    (1<<ATX_LATENCY_HISTOGRAM_SUB_BITS)
+#define ATX_LATENCY_HISTOGRAM_LINEAR_COUNT (2*ATX_LATENCY_HISTOGRAM_SUB_COUNT)
+#define ATX_LATENCY_HISTOGRAM_MAX_EXPONENT 34
+#define ATX_LATENCY_HISTOGRAM_BUCKET_COUNT       \
+    (ATX_LATENCY_HISTOGRAM_LINEAR_COUNT+         \
+     ATX_LATENCY_HISTOGRAM_MAX_EXPONENT*ATX_LATENCY_HISTOGRAM_SUB_COUNT)
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_UInt64 count;
+    ATX_UInt64 bytes;
+    ATX_UInt64 total_time;   /* nanoseconds */
+    ATX_UInt64 max_latency;  /* nanoseconds */
+    ATX_UInt32 histogram[ATX_LATENCY_HISTOGRAM_BUCKET_COUNT];
+} ATX_OperationStats;
+
+/* operations recorded by the wrappers, indexes in the stats arrays */
+typedef enum {
+    ATX_INSTRUMENTED_READ,
+    ATX_INSTRUMENTED_WRITE,
+    ATX_INSTRUMENTED_SEEK,
+    ATX_INSTRUMENTED_FLUSH,
+    ATX_INSTRUMENTED_OPERATION_COUNT
+} ATX_InstrumentedOperation;
+
+/* statistics are updated by the thread using the stream and may be 
+   queried from any thread, so they are protected by a lock */
+typedef struct {
+    ATX_Mutex*         lock;
+    ATX_OperationStats operations[ATX_INSTRUMENTED_OPERATION_COUNT];
+} ATX_StreamStats;
+
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_Properties);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal     reference_count;
+    ATX_InputStream* source;
+    ATX_StreamStats  stats;
+} ATX_InstrumentedInputStream;
+
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_VectoredOutputStream);
+    ATX_IMPLEMENTS(ATX_Properties);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal      reference_count;
+    ATX_OutputStream* sink;
+    ATX_StreamStats   stats;
+} ATX_InstrumentedOutputStream;
+
+/*----------------------------------------------------------------------
+|   globals
++---------------------------------------------------------------------*/
+static const char* const ATX_InstrumentedOperationNames[ATX_INSTRUMENTED_OPERATION_COUNT] = {
+    "Read", "Write", "Seek", "Flush"
+};
+
+/* -1 until the environment has been checked */
+static int ATX_StreamInstrumentationEnabled = -1;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedInputStream, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedInputStream, ATX_Properties)
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedInputStream, ATX_Referenceable)
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedOutputStream, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedOutputStream, ATX_VectoredOutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedOutputStream, ATX_Properties)
+ATX_DECLARE_INTERFACE_MAP(ATX_InstrumentedOutputStream, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_LatencyHistogram_GetBucket
++---------------------------------------------------------------------*/
+static unsigned int
+ATX_LatencyHistogram_GetBucket(ATX_UInt64 latency)
+{
+    unsigned int exponent = 0;
+    unsigned int bucket;
+
+    if (latency < ATX_LATENCY_HISTOGRAM_LINEAR_COUNT) return (unsigned int)latency;
+
+    /* shift until only the leading bit and the sub-range bits remain */
+    while (latency >= ATX_LATENCY_HISTOGRAM_LINEAR_COUNT) {
+        latency >>= 1;
+        ++exponent;
+    }
+    bucket = ATX_LATENCY_HISTOGRAM_LINEAR_COUNT + 
+             (exponent-1)*ATX_LATENCY_HISTOGRAM_SUB_COUNT +
+             (unsigned int)(latency-ATX_LATENCY_HISTOGRAM_SUB_COUNT);
+    if (bucket >= ATX_LATENCY_HISTOGRAM_BUCKET_COUNT) {
+        bucket = ATX_LATENCY_HISTOGRAM_BUCKET_COUNT-1;
+    }
+    
+    return bucket;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_LatencyHistogram_GetBucketLimit
+|
+|   Returns the largest latency that falls in a bucket.
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_LatencyHistogram_GetBucketLimit(unsigned int bucket)
+{
+    unsigned int exponent;
+    ATX_UInt64   leading;
+
+    if (bucket < ATX_LATENCY_HISTOGRAM_LINEAR_COUNT) return bucket;
+    bucket  -= ATX_LATENCY_HISTOGRAM_LINEAR_COUNT;
+    exponent = bucket/ATX_LATENCY_HISTOGRAM_SUB_COUNT+1;
+    leading  = ATX_LATENCY_HISTOGRAM_SUB_COUNT+bucket%ATX_LATENCY_HISTOGRAM_SUB_COUNT;
+    
+    return ((leading+1)<<exponent)-1;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_OperationStats_GetPercentile
+|
+|   Returns, in nanoseconds, the latency under which the given fraction 
+|   (in 1/1000) of the operations completed.
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_OperationStats_GetPercentile(const ATX_OperationStats* self, 
+                                 unsigned int              per_mille)
+{
+    ATX_UInt64   threshold;
+    ATX_UInt64   cumulated = 0;
+    ATX_UInt64   limit;
+    unsigned int i;
+
+    if (self->count == 0) return 0;
+    threshold = (self->count*per_mille+999)/1000;
+    if (threshold == 0) threshold = 1;
+    for (i=0; i<ATX_LATENCY_HISTOGRAM_BUCKET_COUNT; i++) {
+        cumulated += self->histogram[i];
+        if (cumulated >= threshold) break;
+    }
+    limit = ATX_LatencyHistogram_GetBucketLimit(i);
+    
+    return limit < self->max_latency ? limit : self->max_latency;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamStats_Construct
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_StreamStats_Construct(ATX_StreamStats* self)
+{
+    ATX_SetMemory(self->operations, 0, sizeof(self->operations));
+    return ATX_Mutex_Create(&self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamStats_Destruct
++---------------------------------------------------------------------*/
+static void
+ATX_StreamStats_Destruct(ATX_StreamStats* self)
+{
+    if (self->lock) ATX_Mutex_Destroy(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamStats_GetElapsed
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_StreamStats_GetElapsed(const ATX_TimeStamp* start)
+{
+    ATX_TimeStamp now;
+    ATX_Int64     elapsed;
+
+    ATX_System_GetMonotonicTimeStamp(&now);
+    elapsed = (ATX_Int64)(now.seconds-start->seconds)*1000000000+
+              (now.nanoseconds-start->nanoseconds);
+              
+    return elapsed > 0 ? (ATX_UInt64)elapsed : 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamStats_Record
++---------------------------------------------------------------------*/
+static void
+ATX_StreamStats_Record(ATX_StreamStats*          self,
+                       ATX_InstrumentedOperation operation,
+                       const ATX_TimeStamp*      start,
+                       ATX_Size                  bytes)
+{
+    ATX_UInt64          latency = ATX_StreamStats_GetElapsed(start);
+    unsigned int        bucket  = ATX_LatencyHistogram_GetBucket(latency);
+    ATX_OperationStats* stats   = &self->operations[operation];
+
+    ATX_Mutex_Lock(self->lock);
+    ++stats->count;
+    stats->bytes      += bytes;
+    stats->total_time += latency;
+    if (latency > stats->max_latency) stats->max_latency = latency;
+    ++stats->histogram[bucket];
+    ATX_Mutex_Unlock(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamStats_GetProperty
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_StreamStats_GetProperty(ATX_StreamStats*   self,
+                            const ATX_Boolean* supported,
+                            ATX_CString        name,
+                            ATX_PropertyValue* value)
+{
+    const ATX_OperationStats* stats = NULL;
+    ATX_CString               stat  = NULL;
+    ATX_Result                result = ATX_SUCCESS;
+    unsigned int              i;
+
+    /* split the name into an operation and a statistic */
+    for (i=0; i<ATX_INSTRUMENTED_OPERATION_COUNT; i++) {
+        ATX_Size length = ATX_StringLength(ATX_InstrumentedOperationNames[i]);
+        if (supported[i] &&
+            ATX_StringsEqualN(name, ATX_InstrumentedOperationNames[i], length) &&
+            name[length] == '.') {
+            stats = &self->operations[i];
+            stat  = name+length+1;
+            break;
+        }
+    }
+    if (stats == NULL) return ATX_ERROR_NO_SUCH_PROPERTY;
+
+    value->type = ATX_PROPERTY_VALUE_TYPE_FLOAT;
+    ATX_Mutex_Lock(self->lock);
+    if (ATX_StringsEqual(stat, ATX_INSTRUMENTED_STREAM_STAT_COUNT)) {
+        value->type = ATX_PROPERTY_VALUE_TYPE_INTEGER;
+        value->data.integer = stats->count > 0x7FFFFFFF ? 
+                              0x7FFFFFFF : (ATX_Int32)stats->count;
+    } else if (ATX_StringsEqual(stat, ATX_INSTRUMENTED_STREAM_STAT_BYTES)) {
+        value->type = ATX_PROPERTY_VALUE_TYPE_LARGE_INTEGER;
+        value->data.large_integer = (ATX_Int64)stats->bytes;
+    } else if (ATX_StringsEqual(stat, ATX_INSTRUMENTED_STREAM_STAT_TOTAL_TIME)) {
+        value->data.fp = (ATX_Float)stats->total_time/1000.0f;
+    } else if (ATX_StringsEqual(stat, ATX_INSTRUMENTED_STREAM_STAT_LATENCY_P50)) {
+        value->data.fp = (ATX_Float)ATX_OperationStats_GetPercentile(stats, 500)/1000.0f;
+    } else if (ATX_StringsEqual(stat, ATX_INSTRUMENTED_STREAM_STAT_LATENCY_P99)) {
+        value->data.fp = (ATX_Float)ATX_OperationStats_GetPercentile(stats, 990)/1000.0f;
+    } else if (ATX_StringsEqual(stat, ATX_INSTRUMENTED_STREAM_STAT_LATENCY_MAX)) {
+        value->data.fp = (ATX_Float)stats->max_latency/1000.0f;
+    } else {
+        result = ATX_ERROR_NO_SUCH_PROPERTY;
+    }
+    ATX_Mutex_Unlock(self->lock);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_InstrumentedInputStream_Create(ATX_InputStream*  source,
+                                   ATX_InputStream** object)
+{
+    ATX_InstrumentedInputStream* stream;
+    ATX_Result                   result;
+
+    /* default value */
+    *object = NULL;
+    if (source == NULL) return ATX_ERROR_INVALID_PARAMETERS;
+
+    /* allocate new object */
+    stream = (ATX_InstrumentedInputStream*)ATX_AllocateZeroMemory(sizeof(ATX_InstrumentedInputStream));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    result = ATX_StreamStats_Construct(&stream->stats);
+    if (ATX_FAILED(result)) {
+        ATX_FreeMemory((void*)stream);
+        return result;
+    }
+
+    /* construct object */
+    stream->reference_count = 1;
+    stream->source          = source;
+    ATX_REFERENCE_OBJECT(source);
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedInputStream, ATX_InputStream);
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedInputStream, ATX_Properties);
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedInputStream, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_InputStream);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_InstrumentedInputStream_Destroy(ATX_InstrumentedInputStream* self)
+{
+    ATX_RELEASE_OBJECT(self->source);
+    ATX_StreamStats_Destruct(&self->stats);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_Read
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedInputStream_Read(ATX_InputStream* _self,
+                                 ATX_Any          buffer,
+                                 ATX_Size         bytes_to_read,
+                                 ATX_Size*        bytes_read)
+{
+    ATX_InstrumentedInputStream* self = ATX_SELF(ATX_InstrumentedInputStream, ATX_InputStream);
+    ATX_Size                     local_bytes_read = 0;
+    ATX_TimeStamp                start;
+    ATX_Result                   result;
+
+    ATX_System_GetMonotonicTimeStamp(&start);
+    result = ATX_InputStream_Read(self->source, buffer, bytes_to_read, &local_bytes_read);
+    ATX_StreamStats_Record(&self->stats, ATX_INSTRUMENTED_READ, &start, local_bytes_read);
+    if (bytes_read) *bytes_read = local_bytes_read;
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedInputStream_Seek(ATX_InputStream* _self, ATX_Position where)
+{
+    ATX_InstrumentedInputStream* self = ATX_SELF(ATX_InstrumentedInputStream, ATX_InputStream);
+    ATX_TimeStamp                start;
+    ATX_Result                   result;
+
+    ATX_System_GetMonotonicTimeStamp(&start);
+    result = ATX_InputStream_Seek(self->source, where);
+    ATX_StreamStats_Record(&self->stats, ATX_INSTRUMENTED_SEEK, &start, 0);
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedInputStream_Tell(ATX_InputStream* _self, ATX_Position* where)
+{
+    ATX_InstrumentedInputStream* self = ATX_SELF(ATX_InstrumentedInputStream, ATX_InputStream);
+    return ATX_InputStream_Tell(self->source, where);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_GetSize
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedInputStream_GetSize(ATX_InputStream* _self, ATX_LargeSize* size)
+{
+    ATX_InstrumentedInputStream* self = ATX_SELF(ATX_InstrumentedInputStream, ATX_InputStream);
+    return ATX_InputStream_GetSize(self->source, size);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedInputStream_GetAvailable(ATX_InputStream* _self, 
+                                         ATX_LargeSize*   available)
+{
+    ATX_InstrumentedInputStream* self = ATX_SELF(ATX_InstrumentedInputStream, ATX_InputStream);
+    return ATX_InputStream_GetAvailable(self->source, available);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_GetProperty
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedInputStream_GetProperty(ATX_Properties*    _self,
+                                        ATX_CString        name,
+                                        ATX_PropertyValue* value)
+{
+    static const ATX_Boolean supported[ATX_INSTRUMENTED_OPERATION_COUNT] = {
+        ATX_TRUE, ATX_FALSE, ATX_TRUE, ATX_FALSE
+    };
+    ATX_InstrumentedInputStream* self = ATX_SELF(ATX_InstrumentedInputStream, ATX_Properties);
+    return ATX_StreamStats_GetProperty(&self->stats, supported, name, value);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedInputStream_GetInterface
+|
+|   Other interfaces of the source (ATX_DescriptorStream, ...) are 
+|   returned as is, so that the wrapper does not hide them. Calls made
+|   through them are not recorded.
++---------------------------------------------------------------------*/
+static ATX_Object*
+ATX_InstrumentedInputStream_GetInterface(ATX_InstrumentedInputStream* self,
+                                         const ATX_InterfaceId*       id)
+{
+    if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_Object)) {
+        return (ATX_Object*)self;
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_InputStream)) {
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_InputStream);
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_Properties)) {
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_Properties);
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_Referenceable)) {
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_Referenceable);
+    } else {
+        return ATX_INTERFACE(self->source)->GetInterface(self->source, id);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_InstrumentedInputStream, ATX_InputStream)
+    ATX_InstrumentedInputStream_Read,
+    ATX_InstrumentedInputStream_Seek,
+    ATX_InstrumentedInputStream_Tell,
+    ATX_InstrumentedInputStream_GetSize,
+    ATX_InstrumentedInputStream_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Properties interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_STATIC_PROPERTIES_INTERFACE(ATX_InstrumentedInputStream)
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_InstrumentedInputStream, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_InstrumentedOutputStream_Create(ATX_OutputStream*  sink,
+                                    ATX_OutputStream** object)
+{
+    ATX_InstrumentedOutputStream* stream;
+    ATX_Result                    result;
+
+    /* default value */
+    *object = NULL;
+    if (sink == NULL) return ATX_ERROR_INVALID_PARAMETERS;
+
+    /* allocate new object */
+    stream = (ATX_InstrumentedOutputStream*)ATX_AllocateZeroMemory(sizeof(ATX_InstrumentedOutputStream));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    result = ATX_StreamStats_Construct(&stream->stats);
+    if (ATX_FAILED(result)) {
+        ATX_FreeMemory((void*)stream);
+        return result;
+    }
+
+    /* construct object */
+    stream->reference_count = 1;
+    stream->sink            = sink;
+    ATX_REFERENCE_OBJECT(sink);
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedOutputStream, ATX_OutputStream);
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedOutputStream, ATX_VectoredOutputStream);
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedOutputStream, ATX_Properties);
+    ATX_SET_INTERFACE(stream, ATX_InstrumentedOutputStream, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_OutputStream);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_InstrumentedOutputStream_Destroy(ATX_InstrumentedOutputStream* self)
+{
+    ATX_RELEASE_OBJECT(self->sink);
+    ATX_StreamStats_Destruct(&self->stats);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_Write
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedOutputStream_Write(ATX_OutputStream* _self,
+                                   ATX_AnyConst      buffer,
+                                   ATX_Size          bytes_to_write,
+                                   ATX_Size*         bytes_written)
+{
+    ATX_InstrumentedOutputStream* self = ATX_SELF(ATX_InstrumentedOutputStream, ATX_OutputStream);
+    ATX_Size                      local_bytes_written = 0;
+    ATX_TimeStamp                 start;
+    ATX_Result                    result;
+
+    ATX_System_GetMonotonicTimeStamp(&start);
+    result = ATX_OutputStream_Write(self->sink, buffer, bytes_to_write, &local_bytes_written);
+    ATX_StreamStats_Record(&self->stats, ATX_INSTRUMENTED_WRITE, &start, local_bytes_written);
+    if (bytes_written) *bytes_written = local_bytes_written;
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_WriteV
+|
+|   Recorded as a single Write.
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedOutputStream_WriteV(ATX_VectoredOutputStream* _self,
+                                    const ATX_IoVec*          buffers,
+                                    ATX_Cardinal              buffer_count,
+                                    ATX_Size*                 bytes_written)
+{
+    ATX_InstrumentedOutputStream* self = ATX_SELF(ATX_InstrumentedOutputStream, ATX_VectoredOutputStream);
+    ATX_VectoredOutputStream*     sink = ATX_CAST(self->sink, ATX_VectoredOutputStream);
+    ATX_Size                      local_bytes_written = 0;
+    ATX_TimeStamp                 start;
+    ATX_Result                    result;
+
+    if (sink == NULL) return ATX_ERROR_NOT_SUPPORTED;
+    
+    ATX_System_GetMonotonicTimeStamp(&start);
+    result = ATX_VectoredOutputStream_WriteV(sink, buffers, buffer_count, &local_bytes_written);
+    ATX_StreamStats_Record(&self->stats, ATX_INSTRUMENTED_WRITE, &start, local_bytes_written);
+    if (bytes_written) *bytes_written = local_bytes_written;
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedOutputStream_Seek(ATX_OutputStream* _self, ATX_Position where)
+{
+    ATX_InstrumentedOutputStream* self = ATX_SELF(ATX_InstrumentedOutputStream, ATX_OutputStream);
+    ATX_TimeStamp                 start;
+    ATX_Result                    result;
+
+    ATX_System_GetMonotonicTimeStamp(&start);
+    result = ATX_OutputStream_Seek(self->sink, where);
+    ATX_StreamStats_Record(&self->stats, ATX_INSTRUMENTED_SEEK, &start, 0);
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedOutputStream_Tell(ATX_OutputStream* _self, ATX_Position* where)
+{
+    ATX_InstrumentedOutputStream* self = ATX_SELF(ATX_InstrumentedOutputStream, ATX_OutputStream);
+    return ATX_OutputStream_Tell(self->sink, where);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_Flush
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedOutputStream_Flush(ATX_OutputStream* _self)
+{
+    ATX_InstrumentedOutputStream* self = ATX_SELF(ATX_InstrumentedOutputStream, ATX_OutputStream);
+    ATX_TimeStamp                 start;
+    ATX_Result                    result;
+
+    ATX_System_GetMonotonicTimeStamp(&start);
+    result = ATX_OutputStream_Flush(self->sink);
+    ATX_StreamStats_Record(&self->stats, ATX_INSTRUMENTED_FLUSH, &start, 0);
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_GetProperty
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_InstrumentedOutputStream_GetProperty(ATX_Properties*    _self,
+                                         ATX_CString        name,
+                                         ATX_PropertyValue* value)
+{
+    static const ATX_Boolean supported[ATX_INSTRUMENTED_OPERATION_COUNT] = {
+        ATX_FALSE, ATX_TRUE, ATX_TRUE, ATX_TRUE
+    };
+    ATX_InstrumentedOutputStream* self = ATX_SELF(ATX_InstrumentedOutputStream, ATX_Properties);
+    return ATX_StreamStats_GetProperty(&self->stats, supported, name, value);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InstrumentedOutputStream_GetInterface
+|
+|   ATX_VectoredOutputStream is only exposed if the sink implements it.
+|   Other interfaces of the sink are returned as is.
++---------------------------------------------------------------------*/
+static ATX_Object*
+ATX_InstrumentedOutputStream_GetInterface(ATX_InstrumentedOutputStream* self,
+                                          const ATX_InterfaceId*        id)
+{
+    if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_Object)) {
+        return (ATX_Object*)self;
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_OutputStream)) {
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_OutputStream);
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_VectoredOutputStream)) {
+        if (ATX_CAST(self->sink, ATX_VectoredOutputStream) == NULL) return NULL;
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_VectoredOutputStream);
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_Properties)) {
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_Properties);
+    } else if (ATX_INTERFACE_IDS_EQUAL(id, &ATX_INTERFACE_ID__ATX_Referenceable)) {
+        return (ATX_Object*)(void*)&ATX_BASE(self, ATX_Referenceable);
+    } else {
+        return ATX_INTERFACE(self->sink)->GetInterface(self->sink, id);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_OutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_InstrumentedOutputStream, ATX_OutputStream)
+    ATX_InstrumentedOutputStream_Write,
+    ATX_InstrumentedOutputStream_Seek,
+    ATX_InstrumentedOutputStream_Tell,
+    ATX_InstrumentedOutputStream_Flush
+};
+
+/*----------------------------------------------------------------------
+|   ATX_VectoredOutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_InstrumentedOutputStream, ATX_VectoredOutputStream)
+    ATX_InstrumentedOutputStream_WriteV
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Properties interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_STATIC_PROPERTIES_INTERFACE(ATX_InstrumentedOutputStream)
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_InstrumentedOutputStream, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_StreamInstrumentation_SetEnabled
++---------------------------------------------------------------------*/
+void
+ATX_StreamInstrumentation_SetEnabled(ATX_Boolean enabled)
+{
+    ATX_StreamInstrumentationEnabled = enabled ? 1 : 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamInstrumentation_IsEnabled
++---------------------------------------------------------------------*/
+ATX_Boolean
+ATX_StreamInstrumentation_IsEnabled(void)
+{
+    if (ATX_StreamInstrumentationEnabled < 0) {
+        ATX_String env = ATX_EMPTY_STRING;
+        int        enabled = 0;
+        if (ATX_SUCCEEDED(ATX_GetEnvironment(ATX_CONFIG_STREAM_INSTRUMENTATION_ENV, &env))) {
+            enabled = ATX_String_Equals(&env, "1",    ATX_FALSE) ||
+                      ATX_String_Equals(&env, "true", ATX_TRUE)  ||
+                      ATX_String_Equals(&env, "yes",  ATX_TRUE);
+            ATX_String_Destruct(&env);
+        }
+        ATX_StreamInstrumentationEnabled = enabled;
+    }
+
+    return ATX_StreamInstrumentationEnabled ? ATX_TRUE : ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamInstrumentation_WrapInputStream
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_StreamInstrumentation_WrapInputStream(ATX_InputStream** stream)
+{
+    ATX_InputStream* wrapper = NULL;
+    ATX_Result       result;
+
+    if (*stream == NULL || !ATX_StreamInstrumentation_IsEnabled()) return ATX_SUCCESS;
+
+    result = ATX_InstrumentedInputStream_Create(*stream, &wrapper);
+    ATX_RELEASE_OBJECT(*stream);
+    *stream = wrapper;
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_StreamInstrumentation_WrapOutputStream
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_StreamInstrumentation_WrapOutputStream(ATX_OutputStream** stream)
+{
+    ATX_OutputStream* wrapper = NULL;
+    ATX_Result        result;
+
+    if (*stream == NULL || !ATX_StreamInstrumentation_IsEnabled()) return ATX_SUCCESS;
+
+    result = ATX_InstrumentedOutputStream_Create(*stream, &wrapper);
+    ATX_RELEASE_OBJECT(*stream);
+    *stream = wrapper;
+
+    return result;
+}
@@ -0,0 +1,119 @@
+/*****************************************************************
+|
+|   Atomix - Instrumented Streams
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_INSTRUMENTED_STREAMS_H_
+#define _ATX_INSTRUMENTED_STREAMS_H_
+
+/*----------------------------------------------------------------------
+|    includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxStreams.h"
+#include "AtxProperties.h"
+
+/*----------------------------------------------------------------------
+|    constants
++---------------------------------------------------------------------*/
+/**
+ * Name of the environment variable that turns instrumentation on for 
+ * the streams returned by files and sockets, when set to "1" or "true".
+ * ATX_StreamInstrumentation_SetEnabled overrides it.
+ */
+#define ATX_CONFIG_STREAM_INSTRUMENTATION_ENV "ATX_STREAM_INSTRUMENTATION"
+
+/**
+ * Statistics are exposed through the ATX_Properties interface of an
+ * instrumented stream, under "<Operation>.<Statistic>" names, where the 
+ * operation is Read or Seek (input streams), or Write, Seek or Flush 
+ * (output streams). Count is an integer, Bytes a large (64-bit) integer,
+ * and the other values are floats. Latencies are in microseconds, 
+ * percentiles are accurate to within about 20%.
+ */
+#define ATX_INSTRUMENTED_STREAM_STAT_COUNT       "Count"
+#define ATX_INSTRUMENTED_STREAM_STAT_BYTES       "Bytes"
+#define ATX_INSTRUMENTED_STREAM_STAT_TOTAL_TIME  "TotalTime"
+#define ATX_INSTRUMENTED_STREAM_STAT_LATENCY_P50 "LatencyP50"
+#define ATX_INSTRUMENTED_STREAM_STAT_LATENCY_P99 "LatencyP99"
+#define ATX_INSTRUMENTED_STREAM_STAT_LATENCY_MAX "LatencyMax"
+
+/*----------------------------------------------------------------------
+|    prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create an input stream that forwards to a source stream and records,
+ * for Read and Seek, the number of calls, the number of bytes and the 
+ * latency distribution. The returned stream implements ATX_Properties,
+ * use ATX_CAST to query the statistics. Other interfaces of the source,
+ * such as ATX_DescriptorStream, remain reachable through ATX_CAST, but 
+ * calls made through them are not recorded. The stream keeps a reference 
+ * to the source.
+ */
+ATX_Result ATX_InstrumentedInputStream_Create(ATX_InputStream*  source,
+                                              ATX_InputStream** stream);
+
+/**
+ * Create an output stream that forwards to a sink stream and records the
+ * same statistics as ATX_InstrumentedInputStream_Create, for Write, Seek
+ * and Flush.
+ */
+ATX_Result ATX_InstrumentedOutputStream_Create(ATX_OutputStream*  sink,
+                                               ATX_OutputStream** stream);
+
+/**
+ * Turn instrumentation of file and socket streams on or off for the 
+ * whole process. Only streams obtained after the call are affected.
+ */
+void ATX_StreamInstrumentation_SetEnabled(ATX_Boolean enabled);
+
+/**
+ * Returns ATX_TRUE if file and socket streams should be instrumented.
+ */
+ATX_Boolean ATX_StreamInstrumentation_IsEnabled(void);
+
+/**
+ * Replace a stream with an instrumented wrapper if instrumentation is
+ * enabled, otherwise leave it as is. The wrapper takes over the caller's
+ * reference to the original stream. On failure, the stream is released
+ * and set to NULL.
+ */
+ATX_Result ATX_StreamInstrumentation_WrapInputStream(ATX_InputStream** stream);
+ATX_Result ATX_StreamInstrumentation_WrapOutputStream(ATX_OutputStream** stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ATX_INSTRUMENTED_STREAMS_H_ */
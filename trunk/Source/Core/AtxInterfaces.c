@@ -52,3 +52,9 @@ const ATX_InterfaceId ATX_INTERFACE_ID__ATX_Iterator         = {0x000C,0x0001};
 const ATX_InterfaceId ATX_INTERFACE_ID__ATX_File             = {0x000D,0x0001};
 const ATX_InterfaceId ATX_INTERFACE_ID__ATX_StreamTransformer= {0x000E,0x0001};
 const ATX_InterfaceId ATX_INTERFACE_ID__ATX_MulticastSocket  = {0x000F,0x0001};
+const ATX_InterfaceId ATX_INTERFACE_ID__ATX_BufferedInputStream = {0x0010,0x0001};
+const ATX_InterfaceId ATX_INTERFACE_ID__ATX_VectoredOutputStream = {0x0011,0x0001};
+const ATX_InterfaceId ATX_INTERFACE_ID__ATX_DescriptorStream = {0x0012,0x0001};
+const ATX_InterfaceId ATX_INTERFACE_ID__ATX_MappedInputStream = {0x0013,0x0001};
+const ATX_InterfaceId ATX_INTERFACE_ID__ATX_PipeInputStream = {0x0014,0x0001};
+const ATX_InterfaceId ATX_INTERFACE_ID__ATX_PipeOutputStream = {0x0015,0x0001};
@@ -35,6 +35,32 @@
 #include "AtxJson.h"
 #include "AtxDebug.h"
 
+/*----------------------------------------------------------------------
+|    constants
++---------------------------------------------------------------------*/
+#define ATX_JSON_PARSER_INLINE_FRAMES 16
+#define ATX_JSON_REPLACEMENT_CHAR     0xFFFD
+
+/* tape words: 8-bit tag in the top byte, 56-bit payload below it */
+#define ATX_JSON_TAPE_TAG_SHIFT       56
+#define ATX_JSON_TAPE_PAYLOAD_MASK    0x00FFFFFFFFFFFFFFULL
+#define ATX_JSON_TAPE_MAX_CHILD_COUNT 0xFFFFFF
+#define ATX_JSON_TAPE_TAG_OBJECT      '{'
+#define ATX_JSON_TAPE_TAG_OBJECT_END  '}'
+#define ATX_JSON_TAPE_TAG_ARRAY       '['
+#define ATX_JSON_TAPE_TAG_ARRAY_END   ']'
+#define ATX_JSON_TAPE_TAG_KEY         'k'
+#define ATX_JSON_TAPE_TAG_STRING      '"'
+#define ATX_JSON_TAPE_TAG_NUMBER      'd'
+#define ATX_JSON_TAPE_TAG_TRUE        't'
+#define ATX_JSON_TAPE_TAG_FALSE       'f'
+#define ATX_JSON_TAPE_TAG_NULL        'n'
+
+#define ATX_JSON_TAPE_WORD(_tag, _payload) \
+    ((((ATX_UInt64)(_tag))<<ATX_JSON_TAPE_TAG_SHIFT) | ((ATX_UInt64)(_payload) & ATX_JSON_TAPE_PAYLOAD_MASK))
+#define ATX_JSON_TAPE_WORD_TAG(_word)     ((unsigned int)((_word)>>ATX_JSON_TAPE_TAG_SHIFT))
+#define ATX_JSON_TAPE_WORD_PAYLOAD(_word) ((_word) & ATX_JSON_TAPE_PAYLOAD_MASK)
+
 /*----------------------------------------------------------------------
 |    types
 +---------------------------------------------------------------------*/
@@ -65,17 +91,94 @@ struct ATX_Json {
 };
 
 typedef struct {
-    ATX_JsonParser_State state;
-    ATX_Boolean          in_escape;
-    ATX_Boolean          in_unicode;
-    ATX_Cardinal         unicode_chars;
-    ATX_UInt32           unicode;
-    ATX_String           name;
-    ATX_String           value;
-    ATX_Json*            context;
-    ATX_Json*            root;
+    ATX_JsonType      type;
+    double            number;
+    ATX_Boolean       boolean;
+    const ATX_String* string;
+} ATX_JsonParserValue;
+
+typedef struct {
+    ATX_Result (*OnValue)(void*                      listener, 
+                          const ATX_String*          name,
+                          const ATX_JsonParserValue* value);
+    ATX_Result (*OnEnd)(void*        listener, 
+                        ATX_JsonType type, 
+                        ATX_Cardinal child_count);
+} ATX_JsonParserHandler;
+
+typedef struct {
+    ATX_JsonType type;
+    ATX_Cardinal child_count;
+} ATX_JsonParserFrame;
+
+typedef struct {
+    ATX_JsonParser_State         state;
+    ATX_Boolean                  in_escape;
+    ATX_Boolean                  in_unicode;
+    ATX_Cardinal                 unicode_chars;
+    ATX_UInt32                   unicode;
+    ATX_UInt32                   high_surrogate;
+    ATX_String                   name;
+    ATX_String                   value;
+    const ATX_JsonParserHandler* handler;
+    void*                        listener;
+    ATX_JsonParserFrame*         frames;
+    ATX_Cardinal                 frames_allocated;
+    ATX_Cardinal                 depth;
+    ATX_JsonParserFrame          inline_frames[ATX_JSON_PARSER_INLINE_FRAMES];
 } ATX_JsonParser;
 
+typedef struct {
+    ATX_Json* context;
+    ATX_Json* root;
+} ATX_JsonTreeBuilder;
+
+struct ATX_JsonTape {
+    const ATX_UInt64* words;
+    ATX_Cardinal      word_count;
+    const char*       strings;
+};
+
+typedef struct {
+    ATX_DataBuffer* words;
+    ATX_DataBuffer* strings;
+    ATX_Ordinal     open;
+} ATX_JsonTapeBuilder;
+
+typedef struct ATX_JsonSchemaObject ATX_JsonSchemaObject;
+
+typedef struct {
+    ATX_UInt32                  hash;
+    ATX_Size                    name_length;
+    const ATX_JsonField*        field;
+    const ATX_JsonSchemaObject* object;
+} ATX_JsonSchemaEntry;
+
+struct ATX_JsonSchemaObject {
+    const ATX_JsonSchemaEntry* entries;
+    ATX_Cardinal               entry_count;
+};
+
+struct ATX_JsonSchema {
+    ATX_JsonSchemaObject* objects;
+    ATX_Cardinal          object_count;
+    ATX_JsonSchemaEntry*  entries;
+    ATX_Cardinal          entry_count;
+};
+
+typedef struct {
+    const ATX_JsonSchemaObject* object;
+    ATX_Byte*                   base;
+} ATX_JsonBinderFrame;
+
+typedef struct {
+    const ATX_JsonSchema* schema;
+    ATX_Byte*             root;
+    ATX_Cardinal          depth;
+    ATX_Cardinal          skip_depth;
+    ATX_JsonBinderFrame   frames[ATX_JSON_SCHEMA_MAX_DEPTH];
+} ATX_JsonBinder;
+
 /*----------------------------------------------------------------------
 |    constants
 +---------------------------------------------------------------------*/
@@ -90,6 +193,7 @@ static ATX_Json ATX_Json_Null;
 | 4  --> number char
 | 8  --> literal
 | 16 --> control
+| 32 --> string end (quote or backslash)
 +---------------------------------------------------------------------*/
 static const unsigned char ATX_JsonCharMap[256] = {
     /*   0 0x00     */       16,   /*   1 0x01     */       16,   /*   2 0x02     */       16,   /*   3 0x03     */       16,   
@@ -100,7 +204,7 @@ static const unsigned char ATX_JsonCharMap[256] = {
     /*  20 0x14     */       16,   /*  21 0x15     */       16,   /*  22 0x16     */       16,   /*  23 0x17     */       16,   
     /*  24 0x18     */       16,   /*  25 0x19     */       16,   /*  26 0x1a     */       16,   /*  27 0x1b     */       16,   
     /*  28 0x1c     */       16,   /*  29 0x1d     */       16,   /*  30 0x1e     */       16,   /*  31 0x1f     */       16,   
-    /*  32 0x20 ' ' */        1,   /*  33 0x21 '!' */        0,   /*  34 0x22 '"' */        0,   /*  35 0x23 '#' */        0,   
+    /*  32 0x20 ' ' */        1,   /*  33 0x21 '!' */        0,   /*  34 0x22 '"' */       32,   /*  35 0x23 '#' */        0,   
     /*  36 0x24 '$' */        0,   /*  37 0x25 '%' */        0,   /*  38 0x26 '&' */        0,   /*  39 0x27 ''' */        0,   
     /*  40 0x28 '(' */        0,   /*  41 0x29 ')' */        0,   /*  42 0x2a '*' */        0,   /*  43 0x2b '+' */        4,   
     /*  44 0x2c ',' */        0,   /*  45 0x2d '-' */        4,   /*  46 0x2e '.' */        4,   /*  47 0x2f '/' */        0,   
@@ -115,7 +219,7 @@ static const unsigned char ATX_JsonCharMap[256] = {
     /*  80 0x50 'P' */        0,   /*  81 0x51 'Q' */        0,   /*  82 0x52 'R' */        0,   /*  83 0x53 'S' */        0,   
     /*  84 0x54 'T' */        0,   /*  85 0x55 'U' */        0,   /*  86 0x56 'V' */        0,   /*  87 0x57 'W' */        0,   
     /*  88 0x58 'X' */        0,   /*  89 0x59 'Y' */        0,   /*  90 0x5a 'Z' */        0,   /*  91 0x5b '[' */        0,   
-    /*  92 0x5c '\' */        0,   /*  93 0x5d ']' */        0,   /*  94 0x5e '^' */        0,   /*  95 0x5f '_' */        0,   
+    /*  92 0x5c '\' */       32,   /*  93 0x5d ']' */        0,   /*  94 0x5e '^' */        0,   /*  95 0x5f '_' */        0,   
     /*  96 0x60 '`' */        0,   /*  97 0x61 'a' */        8,   /*  98 0x62 'b' */        0,   /*  99 0x63 'c' */        0,   
     /* 100 0x64 'd' */        0,   /* 101 0x65 'e' */      4|8,   /* 102 0x66 'f' */        8,   /* 103 0x67 'g' */        0,   
     /* 104 0x68 'h' */        0,   /* 105 0x69 'i' */        0,   /* 106 0x6a 'j' */        0,   /* 107 0x6b 'k' */        0,   
@@ -163,6 +267,7 @@ static const unsigned char ATX_JsonCharMap[256] = {
 #define ATX_JSON_CHAR_IS_NUMBER(c)     (ATX_JsonCharMap[c]&4)
 #define ATX_JSON_CHAR_IS_LITERAL(c)    (ATX_JsonCharMap[c]&8)
 #define ATX_JSON_CHAR_IS_CONTROL(c)    (ATX_JsonCharMap[c]&16)
+#define ATX_JSON_CHAR_ENDS_SPAN(c)     (ATX_JsonCharMap[c]&(16|32))
 
 /*----------------------------------------------------------------------
 |    ATX_Json_Create
@@ -414,15 +519,21 @@ ATX_Json_AsString(ATX_Json* self)
 |   ATX_JsonParser_Construct
 +---------------------------------------------------------------------*/
 static void
-ATX_JsonParser_Construct(ATX_JsonParser* self)
-{
-    self->state         = ATX_JSON_PARSER_STATE_VALUE;
-    self->in_escape     = ATX_FALSE;
-    self->in_unicode    = ATX_FALSE;
-    self->unicode_chars = 0;
-    self->unicode       = 0;
-    self->context       = NULL;
-    self->root          = NULL;
+ATX_JsonParser_Construct(ATX_JsonParser*              self, 
+                         const ATX_JsonParserHandler* handler,
+                         void*                        listener)
+{
+    self->state            = ATX_JSON_PARSER_STATE_VALUE;
+    self->in_escape        = ATX_FALSE;
+    self->in_unicode       = ATX_FALSE;
+    self->unicode_chars    = 0;
+    self->unicode          = 0;
+    self->high_surrogate   = 0;
+    self->handler          = handler;
+    self->listener         = listener;
+    self->frames           = self->inline_frames;
+    self->frames_allocated = ATX_JSON_PARSER_INLINE_FRAMES;
+    self->depth            = 0;
     ATX_String_Construct(&self->name);
     ATX_String_Construct(&self->value);
 }
@@ -433,58 +544,162 @@ ATX_JsonParser_Construct(ATX_JsonParser* self)
 static void
 ATX_JsonParser_Destruct(ATX_JsonParser* self)
 {
-    if (self->context) ATX_Json_Destroy(self->context);
+    if (self->frames != self->inline_frames) ATX_FreeMemory(self->frames);
     ATX_String_Destruct(&self->name);
     ATX_String_Destruct(&self->value);
 }
 
+/*----------------------------------------------------------------------
+|   ATX_JsonParser_GetContext
++---------------------------------------------------------------------*/
+static ATX_JsonParserFrame*
+ATX_JsonParser_GetContext(ATX_JsonParser* self)
+{
+    return self->depth?&self->frames[self->depth-1]:NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonParser_PushContext
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonParser_PushContext(ATX_JsonParser* self, ATX_JsonType type)
+{
+    /* grow the frame stack if needed */
+    if (self->depth == self->frames_allocated) {
+        ATX_JsonParserFrame* frames;
+        frames = (ATX_JsonParserFrame*)ATX_AllocateMemory(2*self->frames_allocated*sizeof(ATX_JsonParserFrame));
+        if (frames == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+        ATX_CopyMemory(frames, self->frames, self->depth*sizeof(ATX_JsonParserFrame));
+        if (self->frames != self->inline_frames) ATX_FreeMemory(self->frames);
+        self->frames = frames;
+        self->frames_allocated *= 2;
+    }
+    
+    self->frames[self->depth].type        = type;
+    self->frames[self->depth].child_count = 0;
+    ++self->depth;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonParser_PopContext
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonParser_PopContext(ATX_JsonParser* self)
+{
+    ATX_JsonParserFrame* context = ATX_JsonParser_GetContext(self);
+    
+    ATX_ASSERT(context != NULL);
+    --self->depth;
+    return self->handler->OnEnd(self->listener, context->type, context->child_count);
+}
+
 /*----------------------------------------------------------------------
 |   ATX_JsonParser_OnNewValue
 +---------------------------------------------------------------------*/
-static void
-ATX_JsonParser_OnNewValue(ATX_JsonParser* self, ATX_Json* value)
+static ATX_Result
+ATX_JsonParser_OnNewValue(ATX_JsonParser* self, const ATX_JsonParserValue* value)
 {
-    if (self->context) {
-        const char* name = NULL;
-        if (!ATX_String_IsEmpty(&self->name)) {
-            name = ATX_String_GetChars(&self->name);
-        }
-        ATX_Json_AddChild(self->context, name, value);
-        if (name) ATX_String_SetLength(&self->name, 0);
-    } else {
-        ATX_ASSERT(self->root == NULL);
-        self->root = value;
+    ATX_JsonParserFrame* context = ATX_JsonParser_GetContext(self);
+    const ATX_String*    name    = NULL;
+    ATX_Result           result;
+    
+    if (context) {
+        /* only children of Objects have names, even if they may be empty */
+        if (context->type == ATX_JSON_TYPE_OBJECT) name = &self->name;
+        ++context->child_count;
     }
+    result = self->handler->OnValue(self->listener, name, value);
     
-    /* reset the value buffer */
+    /* reset the name and value buffers */
+    if (name) ATX_String_SetLength(&self->name, 0);
     ATX_String_SetLength(&self->value, 0);
+    if (ATX_FAILED(result)) return result;
+    
+    /* objects and arrays become the new context */
+    if (value->type == ATX_JSON_TYPE_OBJECT || value->type == ATX_JSON_TYPE_ARRAY) {
+        return ATX_JsonParser_PushContext(self, value->type);
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonParser_OnNewSimpleValue
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonParser_OnNewSimpleValue(ATX_JsonParser* self, ATX_JsonType type)
+{
+    ATX_JsonParserValue value;
+    
+    value.type    = type;
+    value.number  = 0.0;
+    value.boolean = ATX_FALSE;
+    value.string  = NULL;
+    
+    return ATX_JsonParser_OnNewValue(self, &value);
 }
 
 /*----------------------------------------------------------------------
 |   ATX_JsonParser_AppendUTF8
 +---------------------------------------------------------------------*/
-static void
+static ATX_Result
 ATX_JsonParser_AppendUTF8(ATX_String* dest, unsigned int c)
 {
+    char     utf8[4];
+    ATX_Size size = 0;
+    
     if (c <= 0x7F) {
         /* 000000-00007F -> 1 char = 0xxxxxxx */
-        ATX_String_AppendChar(dest,(char)c);
+        utf8[size++] = (char)c;
     } else if (c <= 0x7FF) {
         /* 000080-0007FF -> 2 chars = 110zzzzx 10xxxxxx */
-        ATX_String_AppendChar(dest, 0xC0|(c>>6));
-        ATX_String_AppendChar(dest, 0x80|(c&0x3F));
+        utf8[size++] = (char)(0xC0|(c>>6));
+        utf8[size++] = (char)(0x80|(c&0x3F));
     } else if (c <= 0xFFFF) {
         /* 000800-00FFFF -> 3 chars = 1110zzzz 10zxxxxx 10xxxxxx */
-        ATX_String_AppendChar(dest, 0xE0| (c>>12      ));
-        ATX_String_AppendChar(dest, 0x80|((c&0xFC0)>>6));
-        ATX_String_AppendChar(dest, 0x80| (c&0x3F     ));
+        utf8[size++] = (char)(0xE0| (c>>12      ));
+        utf8[size++] = (char)(0x80|((c&0xFC0)>>6));
+        utf8[size++] = (char)(0x80| (c&0x3F     ));
     } else if (c <= 0x10FFFF) {
         /* 010000-10FFFF -> 4 chars = 11110zzz 10zzxxxx 10xxxxxx 10xxxxxx */
-        ATX_String_AppendChar(dest, 0xF0| (c>>18         ));
-        ATX_String_AppendChar(dest, 0x80|((c&0x3F000)>>12));
-        ATX_String_AppendChar(dest, 0x80|((c&0xFC0  )>> 6));
-        ATX_String_AppendChar(dest, 0x80| (c&0x3F        ));
+        utf8[size++] = (char)(0xF0| (c>>18         ));
+        utf8[size++] = (char)(0x80|((c&0x3F000)>>12));
+        utf8[size++] = (char)(0x80|((c&0xFC0  )>> 6));
+        utf8[size++] = (char)(0x80| (c&0x3F        ));
+    }
+    
+    return ATX_String_AppendSubString(dest, utf8, size);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonParser_AppendCodeUnit
+|
+|   Append a UTF-16 code unit from a \uXXXX escape, combining surrogate
+|   pairs. Unpaired surrogates are replaced with U+FFFD so that the 
+|   result is always valid UTF-8.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonParser_AppendCodeUnit(ATX_JsonParser* self, ATX_String* dest, ATX_UInt32 unit)
+{
+    if (self->high_surrogate) {
+        ATX_UInt32 high = self->high_surrogate;
+        self->high_surrogate = 0;
+        if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            return ATX_JsonParser_AppendUTF8(dest, 0x10000+((high-0xD800)<<10)+(unit-0xDC00));
+        }
+        ATX_CHECK(ATX_JsonParser_AppendUTF8(dest, ATX_JSON_REPLACEMENT_CHAR));
     }
+    if (unit >= 0xD800 && unit <= 0xDBFF) {
+        /* wait for the low surrogate */
+        self->high_surrogate = unit;
+        return ATX_SUCCESS;
+    } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+        return ATX_JsonParser_AppendUTF8(dest, ATX_JSON_REPLACEMENT_CHAR);
+    }
+    
+    return ATX_JsonParser_AppendUTF8(dest, unit);
 }
 
 /*----------------------------------------------------------------------
@@ -493,6 +708,10 @@ ATX_JsonParser_AppendUTF8(ATX_String* dest, unsigned int c)
 static ATX_Result   
 ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size)
 {
+    ATX_JsonParserFrame* context;
+    ATX_JsonParserValue  value;
+    ATX_String*          string;
+    
     /* parse chars one by one */
     while (size) {
         unsigned char c = *serialized;
@@ -501,17 +720,14 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
             if (ATX_JSON_CHAR_IS_WHITESPACE(c)) break;
             if (c == '\0') break;
             if (c == '{') {
-                ATX_Json* object = ATX_Json_CreateObject();
-                ATX_JsonParser_OnNewValue(self, object);
-                self->context = object;
+                ATX_CHECK(ATX_JsonParser_OnNewSimpleValue(self, ATX_JSON_TYPE_OBJECT));
                 self->state = ATX_JSON_PARSER_STATE_NAMED_VALUE;
             } else if (c == '[') {
-                ATX_Json* array = ATX_Json_CreateArray();
-                ATX_JsonParser_OnNewValue(self, array);
-                self->context = array;
+                ATX_CHECK(ATX_JsonParser_OnNewSimpleValue(self, ATX_JSON_TYPE_ARRAY));
                 self->state = ATX_JSON_PARSER_STATE_VALUE;
             } else if (c == ']') {
-                if (self->context == NULL || self->context->child_count) {
+                context = ATX_JsonParser_GetContext(self);
+                if (context == NULL || context->child_count) {
                     return ATX_ERROR_INVALID_SYNTAX;
                 }
                 self->state = ATX_JSON_PARSER_STATE_DELIMITER;
@@ -534,7 +750,8 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
             if (c == '"') {
                 self->state = ATX_JSON_PARSER_STATE_NAME;
             } else if (c == '}') {
-                if (self->context == NULL || self->context->child_count) {
+                context = ATX_JsonParser_GetContext(self);
+                if (context == NULL || context->child_count) {
                     return ATX_ERROR_INVALID_SYNTAX;
                 }
                 self->state = ATX_JSON_PARSER_STATE_DELIMITER;
@@ -546,20 +763,21 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
             
           case ATX_JSON_PARSER_STATE_DELIMITER:
             if (ATX_JSON_CHAR_IS_WHITESPACE(c)) break;
-            if (self->context == NULL) {
+            context = ATX_JsonParser_GetContext(self);
+            if (context == NULL) {
                 if (c == '\0') {
                     break;
                 } else {
                     return ATX_ERROR_INVALID_SYNTAX;
                 }
             }
-            if ((c == '}' && self->context->type == ATX_JSON_TYPE_OBJECT) ||
-                (c == ']' && self->context->type == ATX_JSON_TYPE_ARRAY)) {
-                self->context = self->context->parent;
+            if ((c == '}' && context->type == ATX_JSON_TYPE_OBJECT) ||
+                (c == ']' && context->type == ATX_JSON_TYPE_ARRAY)) {
+                ATX_CHECK(ATX_JsonParser_PopContext(self));
                 break;
             }
             if (c != ',') return ATX_ERROR_INVALID_SYNTAX;
-            if (self->context->type == ATX_JSON_TYPE_OBJECT) {
+            if (context->type == ATX_JSON_TYPE_OBJECT) {
                 self->state = ATX_JSON_PARSER_STATE_NAMED_VALUE;
             } else {
                 self->state = ATX_JSON_PARSER_STATE_VALUE;
@@ -577,22 +795,27 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
             
           case ATX_JSON_PARSER_STATE_NAME:
           case ATX_JSON_PARSER_STATE_STRING:
+            string = (self->state == ATX_JSON_PARSER_STATE_NAME)?&self->name:&self->value;
             if (self->in_unicode) {
                 int nibble = ATX_HexToNibble(c);
                 if (nibble < 0) return ATX_ERROR_INVALID_SYNTAX;
                 self->unicode = (self->unicode<<4) | nibble;
                 if (++self->unicode_chars == 4) {
-                    if (self->state == ATX_JSON_PARSER_STATE_NAME) {
-                        ATX_JsonParser_AppendUTF8(&self->name, self->unicode);
-                    } else {
-                        ATX_JsonParser_AppendUTF8(&self->value, self->unicode);
-                    }
+                    ATX_CHECK(ATX_JsonParser_AppendCodeUnit(self, string, self->unicode));
                     self->in_unicode = ATX_FALSE;
                     self->unicode_chars = 0;
                     self->unicode = 0;
                 }
                 break;
-            } else if (self->in_escape) {
+            }
+            
+            /* a high surrogate must be followed by a \uXXXX escape */
+            if (self->high_surrogate && !(self->in_escape ? c == 'u' : c == '\\')) {
+                self->high_surrogate = 0;
+                ATX_CHECK(ATX_JsonParser_AppendUTF8(string, ATX_JSON_REPLACEMENT_CHAR));
+            }
+            
+            if (self->in_escape) {
                 self->in_escape = ATX_FALSE;
                 switch (c) {
                   case '"':
@@ -609,18 +832,18 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
                   default: return ATX_ERROR_INVALID_SYNTAX;
                 }
                 if (self->in_unicode) break;
-                if (self->state == ATX_JSON_PARSER_STATE_NAME) {
-                    ATX_JsonParser_AppendUTF8(&self->name, c);
-                } else {
-                    ATX_JsonParser_AppendUTF8(&self->value, c);
-                }
+                ATX_CHECK(ATX_String_AppendChar(string, c));
                 break;
             }
             if (c == '"') {
                 if (self->state == ATX_JSON_PARSER_STATE_NAME) {
                     self->state = ATX_JSON_PARSER_STATE_COLON;
                 } else {
-                    ATX_JsonParser_OnNewValue(self, ATX_Json_CreateString(ATX_CSTR(self->value)));
+                    value.type    = ATX_JSON_TYPE_STRING;
+                    value.number  = 0.0;
+                    value.boolean = ATX_FALSE;
+                    value.string  = &self->value;
+                    ATX_CHECK(ATX_JsonParser_OnNewValue(self, &value));
                     self->state = ATX_JSON_PARSER_STATE_DELIMITER;
                 }
                 break;
@@ -631,12 +854,22 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
             } else if (c == '\0' || ATX_JSON_CHAR_IS_CONTROL(c)) {
                 return ATX_ERROR_INVALID_SYNTAX;
             }
-            if (self->state == ATX_JSON_PARSER_STATE_NAME) {
-                ATX_String_AppendChar(&self->name, c);
-            } else {
-                ATX_String_AppendChar(&self->value, c);
+            
+            /* copy the whole span up to the next quote, escape or control 
+               char at once, checking that it is valid UTF-8 */
+            {
+                ATX_Size span = 1;
+                while (span < size && !ATX_JSON_CHAR_ENDS_SPAN((unsigned char)serialized[span])) {
+                    ++span;
+                }
+                if (ATX_FAILED(ATX_Utf8_Validate(serialized, span))) {
+                    return ATX_ERROR_INVALID_SYNTAX;
+                }
+                ATX_CHECK(ATX_String_AppendSubString(string, serialized, span));
+                serialized += span;
+                size       -= span;
             }
-            break;
+            continue;
           
           case ATX_JSON_PARSER_STATE_NUMBER:
             if (ATX_JSON_CHAR_IS_NUMBER(c)) {
@@ -657,7 +890,11 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
                 /* parse the number */
                 result = ATX_ParseDouble(ATX_CSTR(self->value), &number, ATX_FALSE);
                 if (ATX_FAILED(result)) return ATX_ERROR_INVALID_SYNTAX;
-                ATX_JsonParser_OnNewValue(self, ATX_Json_CreateNumber(number));
+                value.type    = ATX_JSON_TYPE_NUMBER;
+                value.number  = number;
+                value.boolean = ATX_FALSE;
+                value.string  = NULL;
+                ATX_CHECK(ATX_JsonParser_OnNewValue(self, &value));
                 self->state = ATX_JSON_PARSER_STATE_DELIMITER;
                 continue;
             }
@@ -667,15 +904,20 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
             if (ATX_JSON_CHAR_IS_LITERAL(c)) {
                 ATX_String_AppendChar(&self->value, c);
             } else {
+                value.number  = 0.0;
+                value.boolean = ATX_FALSE;
+                value.string  = NULL;
                 if (ATX_String_Equals(&self->value, "true", ATX_FALSE)) {
-                    ATX_JsonParser_OnNewValue(self, ATX_Json_CreateBoolean(ATX_TRUE));
+                    value.type    = ATX_JSON_TYPE_BOOLEAN;
+                    value.boolean = ATX_TRUE;
                 } else if (ATX_String_Equals(&self->value, "false", ATX_FALSE)) {
-                    ATX_JsonParser_OnNewValue(self, ATX_Json_CreateBoolean(ATX_FALSE));
+                    value.type    = ATX_JSON_TYPE_BOOLEAN;
                 } else if (ATX_String_Equals(&self->value, "null", ATX_FALSE)) {
-                    ATX_JsonParser_OnNewValue(self, ATX_Json_CreateNull());
+                    value.type    = ATX_JSON_TYPE_NULL;
                 } else {
                     return ATX_ERROR_INVALID_SYNTAX;
                 }
+                ATX_CHECK(ATX_JsonParser_OnNewValue(self, &value));
                 self->state = ATX_JSON_PARSER_STATE_DELIMITER;
                 continue;
             } 
@@ -689,21 +931,21 @@ ATX_JsonParser_Parse(ATX_JsonParser* self, const char* serialized, ATX_Size size
 }
 
 /*----------------------------------------------------------------------
-|   ATX_Json_ParseBuffer
+|   ATX_JsonParser_ParseBuffer
 +---------------------------------------------------------------------*/
-ATX_Result   
-ATX_Json_ParseBuffer(const char* serialized, ATX_Size size, ATX_Json** json)
+static ATX_Result   
+ATX_JsonParser_ParseBuffer(const ATX_JsonParserHandler* handler,
+                           void*                        listener,
+                           const char*                  serialized, 
+                           ATX_Size                     size)
 {
     ATX_JsonParser parser;
     ATX_Result     result;
     char           termination = '\0';
     
     /* construct the parser */
-    ATX_JsonParser_Construct(&parser);
+    ATX_JsonParser_Construct(&parser, handler, listener);
     
-    /* start empty */
-    *json = NULL;
-
     /* parse the buffer */
     result = ATX_JsonParser_Parse(&parser, serialized, size);
     if (ATX_FAILED(result)) goto end;
@@ -712,15 +954,8 @@ ATX_Json_ParseBuffer(const char* serialized, ATX_Size size, ATX_Json** json)
     result = ATX_JsonParser_Parse(&parser, &termination, 1);
     if (ATX_FAILED(result)) goto end;
 
-    /* return the root object produced by the parser */
-    if (ATX_SUCCEEDED(result)) {
-        if (parser.context) {
-            result = ATX_ERROR_INVALID_SYNTAX;
-        } else {
-            *json = parser.root;
-            parser.root = NULL;
-        }
-    }
+    /* check that all objects and arrays were closed */
+    if (parser.depth) result = ATX_ERROR_INVALID_SYNTAX;
     
 end:
     /* destruct the parser */
@@ -729,6 +964,95 @@ end:
     return result;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_JsonTreeBuilder_OnValue
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonTreeBuilder_OnValue(void*                      listener, 
+                            const ATX_String*          name,
+                            const ATX_JsonParserValue* value)
+{
+    ATX_JsonTreeBuilder* self = (ATX_JsonTreeBuilder*)listener;
+    ATX_Json*            json = NULL;
+    
+    switch (value->type) {
+      case ATX_JSON_TYPE_OBJECT:  json = ATX_Json_CreateObject(); break;
+      case ATX_JSON_TYPE_ARRAY:   json = ATX_Json_CreateArray();  break;
+      case ATX_JSON_TYPE_STRING:  json = ATX_Json_CreateString(ATX_String_GetChars(value->string)); break;
+      case ATX_JSON_TYPE_NUMBER:  json = ATX_Json_CreateNumber(value->number); break;
+      case ATX_JSON_TYPE_BOOLEAN: json = ATX_Json_CreateBoolean(value->boolean); break;
+      case ATX_JSON_TYPE_NULL:    json = ATX_Json_CreateNull(); break;
+    }
+    if (json == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    if (self->context) {
+        ATX_Json_AddChild(self->context, name?ATX_String_GetChars(name):NULL, json);
+    } else {
+        ATX_ASSERT(self->root == NULL);
+        self->root = json;
+    }
+    
+    /* objects and arrays become the new context */
+    if (value->type == ATX_JSON_TYPE_OBJECT || value->type == ATX_JSON_TYPE_ARRAY) {
+        self->context = json;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonTreeBuilder_OnEnd
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonTreeBuilder_OnEnd(void*        listener, 
+                          ATX_JsonType type, 
+                          ATX_Cardinal child_count)
+{
+    ATX_JsonTreeBuilder* self = (ATX_JsonTreeBuilder*)listener;
+    
+    ATX_COMPILER_UNUSED(type);
+    ATX_COMPILER_UNUSED(child_count);
+    
+    self->context = self->context->parent;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonTreeBuilder handler
++---------------------------------------------------------------------*/
+static const ATX_JsonParserHandler ATX_JsonTreeBuilder_Handler = {
+    ATX_JsonTreeBuilder_OnValue,
+    ATX_JsonTreeBuilder_OnEnd
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Json_ParseBuffer
++---------------------------------------------------------------------*/
+ATX_Result   
+ATX_Json_ParseBuffer(const char* serialized, ATX_Size size, ATX_Json** json)
+{
+    ATX_JsonTreeBuilder builder;
+    ATX_Result          result;
+    
+    /* start empty */
+    *json = NULL;
+    builder.context = NULL;
+    builder.root    = NULL;
+
+    /* parse the buffer */
+    result = ATX_JsonParser_ParseBuffer(&ATX_JsonTreeBuilder_Handler, &builder, serialized, size);
+
+    /* return the root object produced by the parser */
+    if (ATX_SUCCEEDED(result)) {
+        *json = builder.root;
+    } else if (builder.root) {
+        ATX_Json_Destroy(builder.root);
+    }
+    
+    return result;
+}
+
 /*----------------------------------------------------------------------
 |    ATX_Json_Parse
 +---------------------------------------------------------------------*/
@@ -739,110 +1063,589 @@ ATX_Json_Parse(const char* serialized, ATX_Json** json)
 }
 
 /*----------------------------------------------------------------------
-|    ATX_Json_EmitString
+|   ATX_JsonTapeBuilder_AppendWord
 +---------------------------------------------------------------------*/
-static void
-ATX_Json_EmitString(ATX_String* string, ATX_String* buffer)
+static ATX_Result
+ATX_JsonTapeBuilder_AppendWord(ATX_JsonTapeBuilder* self, ATX_UInt64 word)
 {
-    const char* s = ATX_CSTR(*string);
-    char        c;
+    return ATX_DataBuffer_AppendData(self->words, (const ATX_Byte*)&word, sizeof(word));
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonTapeBuilder_AppendString
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonTapeBuilder_AppendString(ATX_JsonTapeBuilder* self, 
+                                 unsigned int         tag, 
+                                 const ATX_String*    string)
+{
+    /* strings are stored in the arena as a 32-bit length followed by */
+    /* the null-terminated characters                                  */
+    ATX_UInt32 length = ATX_String_GetLength(string);
+    ATX_Size   offset = ATX_DataBuffer_GetDataSize(self->strings);
     
-    ATX_String_AppendChar(buffer, '"');
-    while ((c = *s++)) {
-        char escape = '\0';
-        switch (c) {
-          case '"':  escape = '"';  break;
-          case '\\': escape = '\\'; break;
-          case '\b': escape = 'b';  break;
-          case '\f': escape = 'f';  break;
-          case '\n': escape = 'n';  break;
-          case '\r': escape = 'r';  break;
-          case '\t': escape = 't';  break;
-        }
-        if (escape) {
-            ATX_String_AppendChar(buffer, '\\');
-            ATX_String_AppendChar(buffer, escape);
-        } else {
-            ATX_String_AppendChar(buffer, c);
-        }
-    }
-    ATX_String_AppendChar(buffer, '"');
+    ATX_CHECK(ATX_DataBuffer_AppendData(self->strings, (const ATX_Byte*)&length, sizeof(length)));
+    ATX_CHECK(ATX_DataBuffer_AppendData(self->strings, 
+                                        (const ATX_Byte*)ATX_String_GetChars(string), 
+                                        length+1));
+    
+    return ATX_JsonTapeBuilder_AppendWord(self, ATX_JSON_TAPE_WORD(tag, offset));
 }
 
 /*----------------------------------------------------------------------
-|    ATX_Json_Emit
+|   ATX_JsonTapeBuilder_OnValue
 +---------------------------------------------------------------------*/
-static ATX_Result   
-ATX_Json_Emit(ATX_Json*   self, 
-              ATX_String* prefix, 
-              ATX_String* buffer, 
-              ATX_Boolean in_object,
-              ATX_Boolean pretty)
+static ATX_Result
+ATX_JsonTapeBuilder_OnValue(void*                      listener, 
+                            const ATX_String*          name,
+                            const ATX_JsonParserValue* value)
 {
-    char      workspace[256];
-    ATX_Json* child;
+    ATX_JsonTapeBuilder* self = (ATX_JsonTapeBuilder*)listener;
+    ATX_Ordinal          position;
+    ATX_UInt64           number;
     
-    if (pretty) ATX_String_Append(buffer, ATX_CSTR(*prefix));
-    if (in_object) {
-        ATX_Json_EmitString(&self->name, buffer);
-        ATX_String_Append(buffer, ": ");
+    /* object members are preceded by their key */
+    if (name) {
+        ATX_CHECK(ATX_JsonTapeBuilder_AppendString(self, ATX_JSON_TAPE_TAG_KEY, name));
     }
-    switch (self->type) {
-      case ATX_JSON_TYPE_NUMBER:
-        if (self->value.number == (ATX_Int32)self->value.number) {
-            ATX_IntegerToString((ATX_Int32)self->value.number, workspace, sizeof(workspace));
-        } else {
-            double abs_val = self->value.number>=0.0?self->value.number:-self->value.number;
-            if (abs_val < 1E-6 || abs_val > 1E9) {
-                ATX_FormatStringN(workspace, sizeof(workspace), "%e", (float)self->value.number); 
-            } else {
-                ATX_FormatStringN(workspace, sizeof(workspace), "%f", (float)self->value.number); 
-            }
-        }
-        ATX_String_Append(buffer, workspace);
-        break;
+    
+    switch (value->type) {
+      case ATX_JSON_TYPE_OBJECT:
+      case ATX_JSON_TYPE_ARRAY:
+        /* until the container is closed, its payload links to the */
+        /* enclosing open container                                 */
+        position = ATX_DataBuffer_GetDataSize(self->words)/sizeof(ATX_UInt64);
+        ATX_CHECK(ATX_JsonTapeBuilder_AppendWord(self, 
+            ATX_JSON_TAPE_WORD(value->type == ATX_JSON_TYPE_OBJECT ? 
+                               ATX_JSON_TAPE_TAG_OBJECT : 
+                               ATX_JSON_TAPE_TAG_ARRAY, 
+                               self->open)));
+        self->open = position+1;
+        return ATX_SUCCESS;
         
       case ATX_JSON_TYPE_STRING:
-        ATX_Json_EmitString(&self->value.string, buffer);
-        break;
+        return ATX_JsonTapeBuilder_AppendString(self, ATX_JSON_TAPE_TAG_STRING, value->string);
+        
+      case ATX_JSON_TYPE_NUMBER:
+        ATX_CHECK(ATX_JsonTapeBuilder_AppendWord(self, ATX_JSON_TAPE_WORD(ATX_JSON_TAPE_TAG_NUMBER, 0)));
+        ATX_CopyMemory(&number, &value->number, sizeof(number));
+        return ATX_JsonTapeBuilder_AppendWord(self, number);
         
       case ATX_JSON_TYPE_BOOLEAN:
-        ATX_String_Append(buffer, self->value.boolean?"true":"false");
-        break;
+        return ATX_JsonTapeBuilder_AppendWord(self, 
+            ATX_JSON_TAPE_WORD(value->boolean?ATX_JSON_TAPE_TAG_TRUE:ATX_JSON_TAPE_TAG_FALSE, 0));
         
       case ATX_JSON_TYPE_NULL:
-        ATX_String_Append(buffer, "null");
-        break;
+        return ATX_JsonTapeBuilder_AppendWord(self, ATX_JSON_TAPE_WORD(ATX_JSON_TAPE_TAG_NULL, 0));
+    }
+    
+    return ATX_ERROR_INTERNAL;
+}
 
-      case ATX_JSON_TYPE_ARRAY:
-        if (self->child_count == 0) {
-            ATX_String_Append(buffer, "[]");
-            break;
-        }
-        ATX_String_AppendChar(buffer, '[');
-        if (pretty) {
-            ATX_String_Append(prefix, "    ");
-            ATX_String_Append(buffer, "\n");
-        }
-        child = self->child;
-        while (child && child->next) child = child->next;
-        while (child) {
-            ATX_Json_Emit(child, prefix, buffer, ATX_FALSE, pretty);
-            child = child->prev;
-            if (child) {
-                ATX_String_Append(buffer, pretty?",\n":", ");
-            } else {
-                if (pretty) ATX_String_Append(buffer, "\n");
-            }
-        }
-        if (pretty) {
-            ATX_String_SetLength(prefix, ATX_String_GetLength(prefix)-4);
-            ATX_String_Append(buffer, ATX_CSTR(*prefix));
-        }
-        ATX_String_AppendChar(buffer, ']');
-        break;
+/*----------------------------------------------------------------------
+|   ATX_JsonTapeBuilder_OnEnd
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonTapeBuilder_OnEnd(void*        listener, 
+                          ATX_JsonType type, 
+                          ATX_Cardinal child_count)
+{
+    ATX_JsonTapeBuilder* self = (ATX_JsonTapeBuilder*)listener;
+    ATX_Ordinal          start;
+    ATX_Ordinal          end;
+    ATX_UInt64*          words;
+    
+    ATX_ASSERT(self->open != 0);
+    start = self->open-1;
+    end   = ATX_DataBuffer_GetDataSize(self->words)/sizeof(ATX_UInt64);
+    
+    /* the end word points back to the start word */
+    ATX_CHECK(ATX_JsonTapeBuilder_AppendWord(self, 
+        ATX_JSON_TAPE_WORD(type == ATX_JSON_TYPE_OBJECT ? 
+                           ATX_JSON_TAPE_TAG_OBJECT_END : 
+                           ATX_JSON_TAPE_TAG_ARRAY_END, 
+                           start)));
+    
+    /* the start word gets the child count and the position past the end */
+    words = (ATX_UInt64*)ATX_DataBuffer_UseData(self->words);
+    if (words == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    self->open = (ATX_Ordinal)ATX_JSON_TAPE_WORD_PAYLOAD(words[start]);
+    if (child_count > ATX_JSON_TAPE_MAX_CHILD_COUNT) {
+        child_count = ATX_JSON_TAPE_MAX_CHILD_COUNT;
+    }
+    words[start] = ATX_JSON_TAPE_WORD(ATX_JSON_TAPE_WORD_TAG(words[start]), 
+                                      (((ATX_UInt64)child_count)<<32) | (end+1));
+    
+    return ATX_SUCCESS;
+}
 
-      case ATX_JSON_TYPE_OBJECT:
+/*----------------------------------------------------------------------
+|   ATX_JsonTapeBuilder handler
++---------------------------------------------------------------------*/
+static const ATX_JsonParserHandler ATX_JsonTapeBuilder_Handler = {
+    ATX_JsonTapeBuilder_OnValue,
+    ATX_JsonTapeBuilder_OnEnd
+};
+
+/*----------------------------------------------------------------------
+|   ATX_JsonTape_ParseBuffer
++---------------------------------------------------------------------*/
+ATX_Result   
+ATX_JsonTape_ParseBuffer(const char* serialized, ATX_Size size, ATX_JsonTape** tape)
+{
+    ATX_JsonTapeBuilder builder;
+    ATX_Size            words_size;
+    ATX_Size            strings_size;
+    ATX_Size            header_size;
+    ATX_Byte*           memory;
+    ATX_Result          result;
+    
+    /* start empty */
+    *tape = NULL;
+    builder.words   = NULL;
+    builder.strings = NULL;
+    builder.open    = 0;
+    
+    /* start with about one word per 8 bytes of input */
+    result = ATX_DataBuffer_Create(size, &builder.words);
+    if (ATX_FAILED(result)) goto end;
+    result = ATX_DataBuffer_Create(size/2, &builder.strings);
+    if (ATX_FAILED(result)) goto end;
+    
+    /* parse the buffer */
+    result = ATX_JsonParser_ParseBuffer(&ATX_JsonTapeBuilder_Handler, &builder, serialized, size);
+    if (ATX_FAILED(result)) goto end;
+    
+    /* pack the tape and the string arena into a single block */
+    header_size  = (sizeof(ATX_JsonTape)+sizeof(ATX_UInt64)-1) & ~(sizeof(ATX_UInt64)-1);
+    words_size   = ATX_DataBuffer_GetDataSize(builder.words);
+    strings_size = ATX_DataBuffer_GetDataSize(builder.strings);
+    memory = (ATX_Byte*)ATX_AllocateMemory(header_size+words_size+strings_size);
+    if (memory == NULL) {
+        result = ATX_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    if (words_size) {
+        ATX_CopyMemory(memory+header_size, ATX_DataBuffer_GetData(builder.words), words_size);
+    }
+    if (strings_size) {
+        ATX_CopyMemory(memory+header_size+words_size, ATX_DataBuffer_GetData(builder.strings), strings_size);
+    }
+    *tape = (ATX_JsonTape*)memory;
+    (*tape)->words      = (const ATX_UInt64*)(memory+header_size);
+    (*tape)->word_count = words_size/sizeof(ATX_UInt64);
+    (*tape)->strings    = (const char*)(memory+header_size+words_size);
+    
+end:
+    if (builder.words)   ATX_DataBuffer_Destroy(builder.words);
+    if (builder.strings) ATX_DataBuffer_Destroy(builder.strings);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_Parse
++---------------------------------------------------------------------*/
+ATX_Result   
+ATX_JsonTape_Parse(const char* serialized, ATX_JsonTape** tape)
+{
+    return ATX_JsonTape_ParseBuffer(serialized, ATX_StringLength(serialized), tape);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_Destroy
++---------------------------------------------------------------------*/
+void
+ATX_JsonTape_Destroy(ATX_JsonTape* self)
+{
+    /* the words and strings are part of the same block */
+    ATX_FreeMemory(self);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_GetValuePosition
++---------------------------------------------------------------------*/
+static ATX_Ordinal
+ATX_JsonTape_GetValuePosition(const ATX_JsonTapeCursor* cursor)
+{
+    /* object members are positioned on their key, the value follows */
+    if (ATX_JSON_TAPE_WORD_TAG(cursor->tape->words[cursor->position]) == ATX_JSON_TAPE_TAG_KEY) {
+        return cursor->position+1;
+    } else {
+        return cursor->position;
+    }
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_GetStringAt
++---------------------------------------------------------------------*/
+static const char*
+ATX_JsonTape_GetStringAt(const ATX_JsonTape* self, ATX_Ordinal position, ATX_Size* length)
+{
+    const char* record = self->strings+(ATX_Size)ATX_JSON_TAPE_WORD_PAYLOAD(self->words[position]);
+    if (length) {
+        ATX_UInt32 record_length;
+        ATX_CopyMemory(&record_length, record, sizeof(record_length));
+        *length = record_length;
+    }
+    return record+sizeof(ATX_UInt32);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_Get
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonTape_Get(const ATX_JsonTape* self, ATX_JsonTapeCursor* cursor)
+{
+    cursor->tape     = self;
+    cursor->position = 0;
+    
+    return self->word_count?ATX_SUCCESS:ATX_ERROR_NO_SUCH_ITEM;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_Next
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonTape_Next(ATX_JsonTapeCursor* self)
+{
+    const ATX_UInt64* words    = self->tape->words;
+    ATX_Ordinal       position = ATX_JsonTape_GetValuePosition(self);
+    unsigned int      tag;
+    
+    /* skip over the value */
+    switch (ATX_JSON_TAPE_WORD_TAG(words[position])) {
+      case ATX_JSON_TAPE_TAG_OBJECT:
+      case ATX_JSON_TAPE_TAG_ARRAY:
+        position = (ATX_Ordinal)(words[position] & 0xFFFFFFFF);
+        break;
+        
+      case ATX_JSON_TAPE_TAG_NUMBER:
+        position += 2;
+        break;
+        
+      default:
+        ++position;
+        break;
+    }
+    
+    /* stop at the end of the enclosing object or array */
+    if (position >= self->tape->word_count) return ATX_ERROR_NO_SUCH_ITEM;
+    tag = ATX_JSON_TAPE_WORD_TAG(words[position]);
+    if (tag == ATX_JSON_TAPE_TAG_OBJECT_END || tag == ATX_JSON_TAPE_TAG_ARRAY_END) {
+        return ATX_ERROR_NO_SUCH_ITEM;
+    }
+    self->position = position;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_GetFirstChild
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonTape_GetFirstChild(const ATX_JsonTapeCursor* self, ATX_JsonTapeCursor* child)
+{
+    const ATX_UInt64* words    = self->tape->words;
+    ATX_Ordinal       position = ATX_JsonTape_GetValuePosition(self);
+    unsigned int      tag      = ATX_JSON_TAPE_WORD_TAG(words[position]);
+    
+    if (tag != ATX_JSON_TAPE_TAG_OBJECT && tag != ATX_JSON_TAPE_TAG_ARRAY) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    
+    /* empty objects and arrays are immediately followed by their end */
+    tag = ATX_JSON_TAPE_WORD_TAG(words[position+1]);
+    if (tag == ATX_JSON_TAPE_TAG_OBJECT_END || tag == ATX_JSON_TAPE_TAG_ARRAY_END) {
+        return ATX_ERROR_NO_SUCH_ITEM;
+    }
+    child->tape     = self->tape;
+    child->position = position+1;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_Find
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonTape_Find(const ATX_JsonTapeCursor* self, 
+                  const char*               name, 
+                  ATX_JsonTapeCursor*       child)
+{
+    ATX_JsonTapeCursor cursor;
+    ATX_Size           name_length = ATX_StringLength(name);
+    
+    if (ATX_JsonTape_GetType(self) != ATX_JSON_TYPE_OBJECT) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    
+    /* walk the keys in order */
+    ATX_CHECK(ATX_JsonTape_GetFirstChild(self, &cursor));
+    do {
+        ATX_Size    length;
+        const char* key = ATX_JsonTape_GetStringAt(cursor.tape, cursor.position, &length);
+        if (length == name_length && ATX_MemoryEqual(key, name, length)) {
+            *child = cursor;
+            return ATX_SUCCESS;
+        }
+    } while (ATX_SUCCEEDED(ATX_JsonTape_Next(&cursor)));
+    
+    return ATX_ERROR_NO_SUCH_ITEM;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_GetType
++---------------------------------------------------------------------*/
+ATX_JsonType
+ATX_JsonTape_GetType(const ATX_JsonTapeCursor* self)
+{
+    switch (ATX_JSON_TAPE_WORD_TAG(self->tape->words[ATX_JsonTape_GetValuePosition(self)])) {
+      case ATX_JSON_TAPE_TAG_OBJECT: return ATX_JSON_TYPE_OBJECT;
+      case ATX_JSON_TAPE_TAG_ARRAY:  return ATX_JSON_TYPE_ARRAY;
+      case ATX_JSON_TAPE_TAG_STRING: return ATX_JSON_TYPE_STRING;
+      case ATX_JSON_TAPE_TAG_NUMBER: return ATX_JSON_TYPE_NUMBER;
+      case ATX_JSON_TAPE_TAG_TRUE:
+      case ATX_JSON_TAPE_TAG_FALSE:  return ATX_JSON_TYPE_BOOLEAN;
+      default:                       return ATX_JSON_TYPE_NULL;
+    }
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_GetChildCount
++---------------------------------------------------------------------*/
+ATX_Cardinal
+ATX_JsonTape_GetChildCount(const ATX_JsonTapeCursor* self)
+{
+    ATX_UInt64         word = self->tape->words[ATX_JsonTape_GetValuePosition(self)];
+    ATX_Cardinal       count;
+    ATX_JsonTapeCursor cursor;
+    
+    switch (ATX_JSON_TAPE_WORD_TAG(word)) {
+      case ATX_JSON_TAPE_TAG_OBJECT:
+      case ATX_JSON_TAPE_TAG_ARRAY:
+        count = (ATX_Cardinal)(ATX_JSON_TAPE_WORD_PAYLOAD(word)>>32);
+        if (count < ATX_JSON_TAPE_MAX_CHILD_COUNT) return count;
+        break;
+        
+      default:
+        return 0;
+    }
+    
+    /* the count saturated, so count the children one by one */
+    count = 0;
+    if (ATX_SUCCEEDED(ATX_JsonTape_GetFirstChild(self, &cursor))) {
+        do {
+            ++count;
+        } while (ATX_SUCCEEDED(ATX_JsonTape_Next(&cursor)));
+    }
+    
+    return count;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_GetName
++---------------------------------------------------------------------*/
+const char*
+ATX_JsonTape_GetName(const ATX_JsonTapeCursor* self)
+{
+    /* only children of Objects have names, even if they may be empty */
+    if (ATX_JSON_TAPE_WORD_TAG(self->tape->words[self->position]) == ATX_JSON_TAPE_TAG_KEY) {
+        return ATX_JsonTape_GetStringAt(self->tape, self->position, NULL);
+    } else {
+        return NULL;
+    }
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_AsInteger
++---------------------------------------------------------------------*/
+ATX_Int32
+ATX_JsonTape_AsInteger(const ATX_JsonTapeCursor* self)
+{
+    return (ATX_Int32)ATX_JsonTape_AsDouble(self);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_AsDouble
++---------------------------------------------------------------------*/
+double
+ATX_JsonTape_AsDouble(const ATX_JsonTapeCursor* self)
+{
+    ATX_Ordinal position = ATX_JsonTape_GetValuePosition(self);
+    double      number;
+    
+    if (ATX_JSON_TAPE_WORD_TAG(self->tape->words[position]) == ATX_JSON_TAPE_TAG_NUMBER) {
+        ATX_CopyMemory(&number, &self->tape->words[position+1], sizeof(number));
+        return number;
+    } else {
+        return 0.0;
+    }
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_AsBoolean
++---------------------------------------------------------------------*/
+ATX_Boolean
+ATX_JsonTape_AsBoolean(const ATX_JsonTapeCursor* self)
+{
+    ATX_Ordinal position = ATX_JsonTape_GetValuePosition(self);
+    
+    if (ATX_JSON_TAPE_WORD_TAG(self->tape->words[position]) == ATX_JSON_TAPE_TAG_TRUE) {
+        return ATX_TRUE;
+    } else {
+        return ATX_FALSE;
+    }
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonTape_AsString
++---------------------------------------------------------------------*/
+const char*
+ATX_JsonTape_AsString(const ATX_JsonTapeCursor* self, ATX_Size* length)
+{
+    ATX_Ordinal position = ATX_JsonTape_GetValuePosition(self);
+    
+    if (ATX_JSON_TAPE_WORD_TAG(self->tape->words[position]) == ATX_JSON_TAPE_TAG_STRING) {
+        return ATX_JsonTape_GetStringAt(self->tape, position, length);
+    } else {
+        if (length) *length = 0;
+        return ATX_String_EmptyString;
+    }
+}
+
+/*----------------------------------------------------------------------
+|    ATX_Json_EmitString
++---------------------------------------------------------------------*/
+static void
+ATX_Json_EmitString(const char* s, ATX_String* buffer)
+{
+    char c;
+    
+    ATX_String_AppendChar(buffer, '"');
+    while ((c = *s++)) {
+        char escape = '\0';
+        switch (c) {
+          case '"':  escape = '"';  break;
+          case '\\': escape = '\\'; break;
+          case '\b': escape = 'b';  break;
+          case '\f': escape = 'f';  break;
+          case '\n': escape = 'n';  break;
+          case '\r': escape = 'r';  break;
+          case '\t': escape = 't';  break;
+        }
+        if (escape) {
+            ATX_String_AppendChar(buffer, '\\');
+            ATX_String_AppendChar(buffer, escape);
+        } else {
+            ATX_String_AppendChar(buffer, c);
+        }
+    }
+    ATX_String_AppendChar(buffer, '"');
+}
+
+/*----------------------------------------------------------------------
+|    ATX_Json_IsInteger
+|
+|   Returns ATX_TRUE if a number is a whole number that fits in an
+|   ATX_Int32 (NaN fails all the comparisons).
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_Json_IsInteger(double number)
+{
+    if (!(number >= -2147483648.0 && number <= 2147483647.0)) return ATX_FALSE;
+    return (double)(ATX_Int32)number == number;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_Json_EmitNumber
++---------------------------------------------------------------------*/
+static void
+ATX_Json_EmitNumber(double number, ATX_String* buffer)
+{
+    char workspace[256];
+    
+    if (ATX_Json_IsInteger(number)) {
+        ATX_IntegerToString((ATX_Int32)number, workspace, sizeof(workspace));
+    } else {
+        /* use the fewest digits that parse back to the same value, 
+           17 are always enough */
+        int precision;
+        for (precision=15; precision<=17; precision++) {
+            double parsed = 0.0;
+            ATX_FormatStringN(workspace, sizeof(workspace), "%.*g", precision, number);
+            if (ATX_SUCCEEDED(ATX_ParseDouble(workspace, &parsed, ATX_FALSE)) &&
+                parsed == number) {
+                break;
+            }
+        }
+    }
+    ATX_String_Append(buffer, workspace);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_Json_Emit
++---------------------------------------------------------------------*/
+static ATX_Result   
+ATX_Json_Emit(ATX_Json*   self, 
+              ATX_String* prefix, 
+              ATX_String* buffer, 
+              ATX_Boolean in_object,
+              ATX_Boolean pretty)
+{
+    ATX_Json* child;
+    
+    if (pretty) ATX_String_Append(buffer, ATX_CSTR(*prefix));
+    if (in_object) {
+        ATX_Json_EmitString(ATX_CSTR(self->name), buffer);
+        ATX_String_Append(buffer, ": ");
+    }
+    switch (self->type) {
+      case ATX_JSON_TYPE_NUMBER:
+        ATX_Json_EmitNumber(self->value.number, buffer);
+        break;
+        
+      case ATX_JSON_TYPE_STRING:
+        ATX_Json_EmitString(ATX_CSTR(self->value.string), buffer);
+        break;
+        
+      case ATX_JSON_TYPE_BOOLEAN:
+        ATX_String_Append(buffer, self->value.boolean?"true":"false");
+        break;
+        
+      case ATX_JSON_TYPE_NULL:
+        ATX_String_Append(buffer, "null");
+        break;
+
+      case ATX_JSON_TYPE_ARRAY:
+        if (self->child_count == 0) {
+            ATX_String_Append(buffer, "[]");
+            break;
+        }
+        ATX_String_AppendChar(buffer, '[');
+        if (pretty) {
+            ATX_String_Append(prefix, "    ");
+            ATX_String_Append(buffer, "\n");
+        }
+        child = self->child;
+        while (child && child->next) child = child->next;
+        while (child) {
+            ATX_Json_Emit(child, prefix, buffer, ATX_FALSE, pretty);
+            child = child->prev;
+            if (child) {
+                ATX_String_Append(buffer, pretty?",\n":", ");
+            } else {
+                if (pretty) ATX_String_Append(buffer, "\n");
+            }
+        }
+        if (pretty) {
+            ATX_String_SetLength(prefix, ATX_String_GetLength(prefix)-4);
+            ATX_String_Append(buffer, ATX_CSTR(*prefix));
+        }
+        ATX_String_AppendChar(buffer, ']');
+        break;
+
+      case ATX_JSON_TYPE_OBJECT:
         if (self->child_count == 0) {
             ATX_String_Append(buffer, "{}");
             break;
@@ -890,3 +1693,332 @@ ATX_Json_Serialize(ATX_Json* self, ATX_String* buffer, ATX_Boolean pretty)
     
     return result;
 }
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Hash
+|
+|    32-bit FNV-1a hash of a member name
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_JsonSchema_Hash(const char* name, ATX_Size length)
+{
+    ATX_UInt32 hash = 0x811C9DC5;
+    
+    while (length--) {
+        hash ^= (unsigned char)*name++;
+        hash *= 0x01000193;
+    }
+    
+    return hash;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Count
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonSchema_Count(const ATX_JsonField* fields, 
+                     ATX_Cardinal         depth,
+                     ATX_Cardinal*        object_count,
+                     ATX_Cardinal*        entry_count)
+{
+    if (fields == NULL) return ATX_ERROR_INVALID_PARAMETERS;
+    if (depth > ATX_JSON_SCHEMA_MAX_DEPTH) return ATX_ERROR_NOT_SUPPORTED;
+    
+    ++*object_count;
+    for (; fields->name; fields++) {
+        ++*entry_count;
+        if (fields->type == ATX_JSON_FIELD_TYPE_OBJECT) {
+            ATX_CHECK(ATX_JsonSchema_Count(fields->fields, depth+1, object_count, entry_count));
+        }
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Build
++---------------------------------------------------------------------*/
+static const ATX_JsonSchemaObject*
+ATX_JsonSchema_Build(ATX_JsonSchema* self, const ATX_JsonField* fields)
+{
+    ATX_JsonSchemaObject* object  = &self->objects[self->object_count++];
+    ATX_JsonSchemaEntry*  entries = &self->entries[self->entry_count];
+    ATX_Cardinal          count   = 0;
+    ATX_Cardinal          i;
+    
+    /* reserve the entries of this object before recursing */
+    while (fields[count].name) ++count;
+    self->entry_count += count;
+    object->entries     = entries;
+    object->entry_count = count;
+    
+    for (i=0; i<count; i++) {
+        entries[i].name_length = ATX_StringLength(fields[i].name);
+        entries[i].hash        = ATX_JsonSchema_Hash(fields[i].name, entries[i].name_length);
+        entries[i].field       = &fields[i];
+        if (fields[i].type == ATX_JSON_FIELD_TYPE_OBJECT) {
+            entries[i].object = ATX_JsonSchema_Build(self, fields[i].fields);
+        } else {
+            entries[i].object = NULL;
+        }
+    }
+    
+    return object;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonSchema_Create(const ATX_JsonField* fields, ATX_JsonSchema** schema)
+{
+    ATX_Cardinal object_count = 0;
+    ATX_Cardinal entry_count  = 0;
+    
+    /* default value */
+    *schema = NULL;
+    
+    /* count the objects and entries of the whole tree */
+    ATX_CHECK(ATX_JsonSchema_Count(fields, 1, &object_count, &entry_count));
+    
+    /* allocate everything in one block */
+    *schema = (ATX_JsonSchema*)ATX_AllocateMemory(sizeof(ATX_JsonSchema)+
+                                                  object_count*sizeof(ATX_JsonSchemaObject)+
+                                                  entry_count*sizeof(ATX_JsonSchemaEntry));
+    if (*schema == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    (*schema)->objects      = (ATX_JsonSchemaObject*)(*schema+1);
+    (*schema)->object_count = 0;
+    (*schema)->entries      = (ATX_JsonSchemaEntry*)((*schema)->objects+object_count);
+    (*schema)->entry_count  = 0;
+    
+    /* the root object is the first one */
+    ATX_JsonSchema_Build(*schema, fields);
+    ATX_ASSERT((*schema)->object_count == object_count);
+    ATX_ASSERT((*schema)->entry_count  == entry_count);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Destroy
++---------------------------------------------------------------------*/
+void
+ATX_JsonSchema_Destroy(ATX_JsonSchema* self)
+{
+    if (self) ATX_FreeMemory(self);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchemaObject_Find
++---------------------------------------------------------------------*/
+static const ATX_JsonSchemaEntry*
+ATX_JsonSchemaObject_Find(const ATX_JsonSchemaObject* self, const ATX_String* name)
+{
+    ATX_Size   length = ATX_String_GetLength(name);
+    ATX_UInt32 hash   = ATX_JsonSchema_Hash(ATX_String_GetChars(name), length);
+    ATX_Cardinal i;
+    
+    for (i=0; i<self->entry_count; i++) {
+        const ATX_JsonSchemaEntry* entry = &self->entries[i];
+        if (entry->hash        == hash   &&
+            entry->name_length == length &&
+            ATX_MemoryEqual(entry->field->name, ATX_String_GetChars(name), length)) {
+            return entry;
+        }
+    }
+    
+    return NULL;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonBinder_OnValue
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonBinder_OnValue(void*                      listener, 
+                       const ATX_String*          name,
+                       const ATX_JsonParserValue* value)
+{
+    ATX_JsonBinder*            self = (ATX_JsonBinder*)listener;
+    ATX_JsonBinderFrame*       frame;
+    const ATX_JsonSchemaEntry* entry;
+    ATX_Byte*                  field;
+    ATX_Boolean                is_container = (value->type == ATX_JSON_TYPE_OBJECT ||
+                                               value->type == ATX_JSON_TYPE_ARRAY);
+    
+    /* values inside of unbound containers are skipped */
+    if (self->skip_depth) {
+        if (is_container) ++self->skip_depth;
+        return ATX_SUCCESS;
+    }
+    
+    /* the root must be an object */
+    if (self->depth == 0) {
+        if (value->type != ATX_JSON_TYPE_OBJECT) return ATX_ERROR_INVALID_FORMAT;
+        self->frames[0].object = &self->schema->objects[0];
+        self->frames[0].base   = self->root;
+        self->depth = 1;
+        return ATX_SUCCESS;
+    }
+    
+    /* look for a matching field (bound frames are always objects) */
+    frame = &self->frames[self->depth-1];
+    ATX_ASSERT(name != NULL);
+    entry = ATX_JsonSchemaObject_Find(frame->object, name);
+    if (entry == NULL) {
+        if (is_container) ++self->skip_depth;
+        return ATX_SUCCESS;
+    }
+    if (value->type == ATX_JSON_TYPE_NULL) return ATX_SUCCESS;
+    
+    /* store the value */
+    field = frame->base+entry->field->offset;
+    switch (entry->field->type) {
+      case ATX_JSON_FIELD_TYPE_INTEGER:
+        if (value->type != ATX_JSON_TYPE_NUMBER) return ATX_ERROR_INVALID_FORMAT;
+        if (!ATX_Json_IsInteger(value->number)) return ATX_ERROR_INVALID_FORMAT;
+        *(ATX_Int32*)field = (ATX_Int32)value->number;
+        break;
+
+      case ATX_JSON_FIELD_TYPE_DOUBLE:
+        if (value->type != ATX_JSON_TYPE_NUMBER) return ATX_ERROR_INVALID_FORMAT;
+        *(double*)field = value->number;
+        break;
+
+      case ATX_JSON_FIELD_TYPE_BOOLEAN:
+        if (value->type != ATX_JSON_TYPE_BOOLEAN) return ATX_ERROR_INVALID_FORMAT;
+        *(ATX_Boolean*)field = value->boolean;
+        break;
+
+      case ATX_JSON_FIELD_TYPE_STRING:
+        if (value->type != ATX_JSON_TYPE_STRING) return ATX_ERROR_INVALID_FORMAT;
+        return ATX_String_AssignN((ATX_String*)field, 
+                                  ATX_String_GetChars(value->string), 
+                                  ATX_String_GetLength(value->string));
+
+      case ATX_JSON_FIELD_TYPE_OBJECT:
+        if (value->type != ATX_JSON_TYPE_OBJECT) return ATX_ERROR_INVALID_FORMAT;
+        ATX_ASSERT(self->depth < ATX_JSON_SCHEMA_MAX_DEPTH);
+        self->frames[self->depth].object = entry->object;
+        self->frames[self->depth].base   = field;
+        ++self->depth;
+        break;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonBinder_OnEnd
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_JsonBinder_OnEnd(void*        listener, 
+                     ATX_JsonType type, 
+                     ATX_Cardinal child_count)
+{
+    ATX_JsonBinder* self = (ATX_JsonBinder*)listener;
+    
+    ATX_COMPILER_UNUSED(type);
+    ATX_COMPILER_UNUSED(child_count);
+    
+    if (self->skip_depth) {
+        --self->skip_depth;
+    } else {
+        ATX_ASSERT(self->depth != 0);
+        --self->depth;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_JsonBinder handler
++---------------------------------------------------------------------*/
+static const ATX_JsonParserHandler ATX_JsonBinder_Handler = {
+    ATX_JsonBinder_OnValue,
+    ATX_JsonBinder_OnEnd
+};
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_DecodeBuffer
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonSchema_DecodeBuffer(const ATX_JsonSchema* self, 
+                            const char*           serialized, 
+                            ATX_Size              size, 
+                            void*                 object)
+{
+    ATX_JsonBinder binder;
+    
+    binder.schema     = self;
+    binder.root       = (ATX_Byte*)object;
+    binder.depth      = 0;
+    binder.skip_depth = 0;
+    
+    return ATX_JsonParser_ParseBuffer(&ATX_JsonBinder_Handler, &binder, serialized, size);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Decode
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonSchema_Decode(const ATX_JsonSchema* self, const char* serialized, void* object)
+{
+    return ATX_JsonSchema_DecodeBuffer(self, serialized, ATX_StringLength(serialized), object);
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_EmitObject
++---------------------------------------------------------------------*/
+static void
+ATX_JsonSchema_EmitObject(const ATX_JsonSchemaObject* self, 
+                          const ATX_Byte*             base,
+                          ATX_String*                 buffer)
+{
+    char         workspace[16];
+    ATX_Cardinal i;
+    
+    ATX_String_AppendChar(buffer, '{');
+    for (i=0; i<self->entry_count; i++) {
+        const ATX_JsonField* field = self->entries[i].field;
+        const ATX_Byte*      value = base+field->offset;
+        
+        if (i) ATX_String_Append(buffer, ", ");
+        ATX_Json_EmitString(field->name, buffer);
+        ATX_String_Append(buffer, ": ");
+        switch (field->type) {
+          case ATX_JSON_FIELD_TYPE_INTEGER:
+            ATX_IntegerToString(*(const ATX_Int32*)value, workspace, sizeof(workspace));
+            ATX_String_Append(buffer, workspace);
+            break;
+            
+          case ATX_JSON_FIELD_TYPE_DOUBLE:
+            ATX_Json_EmitNumber(*(const double*)value, buffer);
+            break;
+            
+          case ATX_JSON_FIELD_TYPE_BOOLEAN:
+            ATX_String_Append(buffer, *(const ATX_Boolean*)value?"true":"false");
+            break;
+            
+          case ATX_JSON_FIELD_TYPE_STRING:
+            ATX_Json_EmitString(ATX_String_GetChars((const ATX_String*)value), buffer);
+            break;
+            
+          case ATX_JSON_FIELD_TYPE_OBJECT:
+            ATX_JsonSchema_EmitObject(self->entries[i].object, value, buffer);
+            break;
+        }
+    }
+    ATX_String_AppendChar(buffer, '}');
+}
+
+/*----------------------------------------------------------------------
+|    ATX_JsonSchema_Encode
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_JsonSchema_Encode(const ATX_JsonSchema* self, const void* object, ATX_String* buffer)
+{
+    ATX_String_SetLength(buffer, 0);
+    ATX_JsonSchema_EmitObject(&self->objects[0], (const ATX_Byte*)object, buffer);
+    
+    return ATX_SUCCESS;
+}
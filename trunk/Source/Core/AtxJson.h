@@ -46,6 +46,29 @@
 +---------------------------------------------------------------------*/
 typedef struct ATX_Json ATX_Json;
 
+/**
+ * Compact, read-only representation of a parsed JSON document.
+ * Values are stored as a flat array of 64-bit words, in document order,
+ * and strings are stored in a separate arena. 
+ */
+typedef struct ATX_JsonTape ATX_JsonTape;
+
+/**
+ * Position of a value in an ATX_JsonTape.
+ * Cursors are plain values that can be copied freely, and remain valid 
+ * as long as the tape they point to is not destroyed.
+ */
+typedef struct {
+    const ATX_JsonTape* tape;
+    ATX_Ordinal         position;
+} ATX_JsonTapeCursor;
+
+/**
+ * Precomputed form of an ATX_JsonField descriptor table, used to
+ * decode JSON objects directly into C structs and encode them back.
+ */
+typedef struct ATX_JsonSchema ATX_JsonSchema;
+
 /*----------------------------------------------------------------------
 |   constants
 +---------------------------------------------------------------------*/
@@ -58,6 +81,38 @@ typedef enum {
     ATX_JSON_TYPE_NULL
 } ATX_JsonType;
 
+typedef enum {
+    ATX_JSON_FIELD_TYPE_INTEGER = 0, /** ATX_Int32                      */
+    ATX_JSON_FIELD_TYPE_DOUBLE,      /** double                         */
+    ATX_JSON_FIELD_TYPE_BOOLEAN,     /** ATX_Boolean                    */
+    ATX_JSON_FIELD_TYPE_STRING,      /** ATX_String                     */
+    ATX_JSON_FIELD_TYPE_OBJECT       /** struct described by `fields`   */
+} ATX_JsonFieldType;
+
+/*----------------------------------------------------------------------
+|   ATX_JsonField
++---------------------------------------------------------------------*/
+/**
+ * Entry of a descriptor table that maps a JSON object member to a field
+ * of a C struct. Tables are terminated by an entry with a NULL name
+ * (see ATX_JSON_FIELDS_END).
+ */
+typedef struct ATX_JsonField {
+    const char*                 name;
+    ATX_JsonFieldType           type;
+    ATX_Size                    offset;
+    const struct ATX_JsonField* fields; /* for ATX_JSON_FIELD_TYPE_OBJECT */
+} ATX_JsonField;
+
+#define ATX_JSON_FIELD(_name, _type, _struct, _member) \
+    { (_name), ATX_JSON_FIELD_TYPE_##_type, (ATX_Size)ATX_OFFSET_OF(_member, _struct), NULL }
+#define ATX_JSON_OBJECT_FIELD(_name, _struct, _member, _fields) \
+    { (_name), ATX_JSON_FIELD_TYPE_OBJECT, (ATX_Size)ATX_OFFSET_OF(_member, _struct), (_fields) }
+#define ATX_JSON_FIELDS_END \
+    { NULL, ATX_JSON_FIELD_TYPE_INTEGER, 0, NULL }
+
+#define ATX_JSON_SCHEMA_MAX_DEPTH 16
+
 /*----------------------------------------------------------------------
 |    prototypes
 +---------------------------------------------------------------------*/
@@ -87,6 +142,37 @@ ATX_Result        ATX_Json_Parse(const char* serialized, ATX_Json** json);
 ATX_Result        ATX_Json_ParseBuffer(const char* serialized, ATX_Size size, ATX_Json** json);
 ATX_Result        ATX_Json_Serialize(ATX_Json* self, ATX_String* buffer, ATX_Boolean pretty);
 
+ATX_Result        ATX_JsonTape_Parse(const char* serialized, ATX_JsonTape** tape);
+ATX_Result        ATX_JsonTape_ParseBuffer(const char* serialized, ATX_Size size, ATX_JsonTape** tape);
+void              ATX_JsonTape_Destroy(ATX_JsonTape* self);
+ATX_Result        ATX_JsonTape_Get(const ATX_JsonTape* self, ATX_JsonTapeCursor* root);
+ATX_Result        ATX_JsonTape_Next(ATX_JsonTapeCursor* self);
+ATX_Result        ATX_JsonTape_GetFirstChild(const ATX_JsonTapeCursor* self, ATX_JsonTapeCursor* child);
+ATX_Result        ATX_JsonTape_Find(const ATX_JsonTapeCursor* self, const char* name, ATX_JsonTapeCursor* child);
+ATX_JsonType      ATX_JsonTape_GetType(const ATX_JsonTapeCursor* self);
+ATX_Cardinal      ATX_JsonTape_GetChildCount(const ATX_JsonTapeCursor* self);
+const char*       ATX_JsonTape_GetName(const ATX_JsonTapeCursor* self);
+ATX_Int32         ATX_JsonTape_AsInteger(const ATX_JsonTapeCursor* self);
+double            ATX_JsonTape_AsDouble(const ATX_JsonTapeCursor* self);
+ATX_Boolean       ATX_JsonTape_AsBoolean(const ATX_JsonTapeCursor* self);
+const char*       ATX_JsonTape_AsString(const ATX_JsonTapeCursor* self, ATX_Size* length);
+
+/**
+ * Decoding only assigns the fields that are present in the input: the
+ * object must be initialized beforehand (all zeros is a valid initial
+ * state for every field type), and the caller is responsible for
+ * destructing its ATX_String fields. Members that are not described
+ * in the schema, as well as null values, are ignored. INTEGER fields
+ * only accept whole numbers in the ATX_Int32 range.
+ * Fields are assigned as they are parsed, so when decoding fails the
+ * fields that came before the error have already been updated.
+ */
+ATX_Result        ATX_JsonSchema_Create(const ATX_JsonField* fields, ATX_JsonSchema** schema);
+void              ATX_JsonSchema_Destroy(ATX_JsonSchema* self);
+ATX_Result        ATX_JsonSchema_Decode(const ATX_JsonSchema* self, const char* serialized, void* object);
+ATX_Result        ATX_JsonSchema_DecodeBuffer(const ATX_JsonSchema* self, const char* serialized, ATX_Size size, void* object);
+ATX_Result        ATX_JsonSchema_Encode(const ATX_JsonSchema* self, const void* object, ATX_String* buffer);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
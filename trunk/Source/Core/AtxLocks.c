@@ -0,0 +1,483 @@
+/*****************************************************************
+|
+|   Atomix - Locks
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxLocks.h"
+#include "AtxAtomic.h"
+#include "AtxSystem.h"
+#include "AtxTime.h"
+#include "AtxUtils.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_RW_LOCK_WRITER        0x40000000 /* added to the reader count */
+#define ATX_SPIN_MUTEX_MAX_SPINS  100
+#define ATX_SPIN_MUTEX_UNLOCKED   0
+#define ATX_SPIN_MUTEX_LOCKED     1
+#define ATX_SPIN_MUTEX_CONTENDED  2          /* locked, threads may be sleeping */
+
+/*----------------------------------------------------------------------
+|   macros
++---------------------------------------------------------------------*/
+/* tell the CPU that we are spinning */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ATX_SPIN_MUTEX_PAUSE() __builtin_ia32_pause()
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define ATX_SPIN_MUTEX_PAUSE() __asm__ __volatile__("yield")
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define ATX_SPIN_MUTEX_PAUSE() _mm_pause()
+#else
+#define ATX_SPIN_MUTEX_PAUSE() ((void)0)
+#endif
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/* the state is changed with atomic operations, and threads that have 
+   to wait do it under the mutex, so that they can not miss the 
+   broadcast of a thread that unlocks after seeing them waiting */
+struct ATX_RwLock {
+    ATX_AtomicInt  state;           /* number of readers, or ATX_RW_LOCK_WRITER */
+    ATX_AtomicInt  waiting_readers;
+    ATX_AtomicInt  waiting_writers; /* only changed under the mutex */
+    ATX_Flags      flags;
+    ATX_Mutex*     mutex;
+    ATX_Condition* readers_may_enter;
+    ATX_Condition* writers_may_enter;
+};
+
+struct ATX_SpinMutex {
+    ATX_AtomicInt  state;
+    ATX_AtomicInt  spins;     /* average number of spins that were needed */
+    ATX_Int32      max_spins; /* 0 if spinning can not help */
+    ATX_Semaphore* wakeup;
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Locks_GetDeadline
++---------------------------------------------------------------------*/
+static void
+ATX_Locks_GetDeadline(ATX_Timeout timeout, ATX_TimeStamp* deadline)
+{
+    ATX_TimeStamp duration;
+    
+    if (timeout <= 0) return;
+    ATX_System_GetMonotonicTimeStamp(deadline);
+    ATX_TimeStamp_Set(duration, timeout/1000, (timeout%1000)*1000000);
+    ATX_TimeStamp_Add(*deadline, *deadline, duration);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Locks_GetRemainingTime
+|
+|   Returns the number of milliseconds left until the deadline (at 
+|   least 1 while it has not passed), 0 after, or ATX_TIMEOUT_INFINITE.
++---------------------------------------------------------------------*/
+static ATX_Timeout
+ATX_Locks_GetRemainingTime(ATX_Timeout timeout, const ATX_TimeStamp* deadline)
+{
+    ATX_TimeStamp now;
+    ATX_TimeStamp remaining;
+    
+    if (timeout < 0) return ATX_TIMEOUT_INFINITE;
+    if (timeout == 0) return 0;
+    ATX_System_GetMonotonicTimeStamp(&now);
+    if (ATX_TimeStamp_IsLaterOrEqual(now, *deadline)) return 0;
+    ATX_TimeStamp_Sub(remaining, *deadline, now);
+    return (ATX_Timeout)(remaining.seconds*1000+(remaining.nanoseconds+999999)/1000000);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_Create(ATX_Flags flags, ATX_RwLock** lock)
+{
+    ATX_RwLock* self;
+    ATX_Result  result;
+    
+    *lock = NULL;
+#if !ATX_ATOMIC_IS_LOCK_FREE
+    ATX_COMPILER_UNUSED(self);
+    ATX_COMPILER_UNUSED(result);
+    ATX_COMPILER_UNUSED(flags);
+    return ATX_ERROR_NOT_SUPPORTED;
+#else
+    self = (ATX_RwLock*)ATX_AllocateZeroMemory(sizeof(ATX_RwLock));
+    if (self == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    self->flags = flags;
+    
+    result = ATX_Mutex_Create(&self->mutex);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&self->readers_may_enter);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&self->writers_may_enter);
+    if (ATX_FAILED(result)) goto fail;
+    
+    *lock = self;
+    return ATX_SUCCESS;
+    
+fail:
+    ATX_RwLock_Destroy(self);
+    return result;
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_Destroy(ATX_RwLock* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    
+    if (self->mutex)             ATX_Mutex_Destroy(self->mutex);
+    if (self->readers_may_enter) ATX_Condition_Destroy(self->readers_may_enter);
+    if (self->writers_may_enter) ATX_Condition_Destroy(self->writers_may_enter);
+    ATX_FreeMemory(self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_EnterRead
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_RwLock_EnterRead(ATX_RwLock* self)
+{
+    for (;;) {
+        ATX_Int32 state = ATX_Atomic_Load(&self->state, ATX_ATOMIC_SEQ_CST);
+        if (state & ATX_RW_LOCK_WRITER) return ATX_FALSE;
+        if ((self->flags & ATX_RW_LOCK_FLAG_PREFER_WRITERS) &&
+            ATX_Atomic_Load(&self->waiting_writers, ATX_ATOMIC_SEQ_CST)) {
+            return ATX_FALSE;
+        }
+        if (ATX_Atomic_CompareAndSwap(&self->state, state, state+1)) {
+            return ATX_TRUE;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_TimedLockRead
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_TimedLockRead(ATX_RwLock* self, ATX_Timeout timeout)
+{
+    ATX_TimeStamp deadline = {0, 0};
+    ATX_Result    result = ATX_SUCCESS;
+    
+    /* fast path */
+    if (ATX_RwLock_EnterRead(self)) return ATX_SUCCESS;
+    if (timeout == 0) return ATX_ERROR_TIMEOUT;
+    
+    ATX_Locks_GetDeadline(timeout, &deadline);
+    ATX_Mutex_Lock(self->mutex);
+    ATX_Atomic_Add(&self->waiting_readers, 1, ATX_ATOMIC_SEQ_CST);
+    while (!ATX_RwLock_EnterRead(self)) {
+        ATX_Timeout remaining = ATX_Locks_GetRemainingTime(timeout, &deadline);
+        if (remaining == 0) {
+            result = ATX_ERROR_TIMEOUT;
+            break;
+        }
+        ATX_Condition_TimedWait(self->readers_may_enter, self->mutex, remaining);
+    }
+    ATX_Atomic_Add(&self->waiting_readers, -1, ATX_ATOMIC_SEQ_CST);
+    ATX_Mutex_Unlock(self->mutex);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_LockRead
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_LockRead(ATX_RwLock* self)
+{
+    return ATX_RwLock_TimedLockRead(self, ATX_TIMEOUT_INFINITE);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_TryLockRead
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_TryLockRead(ATX_RwLock* self)
+{
+    return ATX_RwLock_TimedLockRead(self, 0);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_UnlockRead
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_UnlockRead(ATX_RwLock* self)
+{
+    /* the last reader lets the writers in */
+    if (ATX_Atomic_Add(&self->state, -1, ATX_ATOMIC_SEQ_CST) == 0 &&
+        ATX_Atomic_Load(&self->waiting_writers, ATX_ATOMIC_SEQ_CST)) {
+        ATX_Mutex_Lock(self->mutex);
+        ATX_Condition_Broadcast(self->writers_may_enter);
+        ATX_Mutex_Unlock(self->mutex);
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_TimedLockWrite
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_TimedLockWrite(ATX_RwLock* self, ATX_Timeout timeout)
+{
+    ATX_TimeStamp deadline = {0, 0};
+    ATX_Result    result = ATX_SUCCESS;
+    
+    /* fast path */
+    if (ATX_Atomic_CompareAndSwap(&self->state, 0, ATX_RW_LOCK_WRITER)) {
+        return ATX_SUCCESS;
+    }
+    if (timeout == 0) return ATX_ERROR_TIMEOUT;
+    
+    ATX_Locks_GetDeadline(timeout, &deadline);
+    ATX_Mutex_Lock(self->mutex);
+    ATX_Atomic_Add(&self->waiting_writers, 1, ATX_ATOMIC_SEQ_CST);
+    while (!ATX_Atomic_CompareAndSwap(&self->state, 0, ATX_RW_LOCK_WRITER)) {
+        ATX_Timeout remaining = ATX_Locks_GetRemainingTime(timeout, &deadline);
+        if (remaining == 0) {
+            result = ATX_ERROR_TIMEOUT;
+            break;
+        }
+        ATX_Condition_TimedWait(self->writers_may_enter, self->mutex, remaining);
+    }
+    
+    /* readers held back for us may go on if we were the last writer */
+    if (ATX_Atomic_Add(&self->waiting_writers, -1, ATX_ATOMIC_SEQ_CST) == 0 && 
+        ATX_FAILED(result) &&
+        ATX_Atomic_Load(&self->waiting_readers, ATX_ATOMIC_SEQ_CST)) {
+        ATX_Condition_Broadcast(self->readers_may_enter);
+    }
+    ATX_Mutex_Unlock(self->mutex);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_LockWrite
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_LockWrite(ATX_RwLock* self)
+{
+    return ATX_RwLock_TimedLockWrite(self, ATX_TIMEOUT_INFINITE);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_TryLockWrite
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_TryLockWrite(ATX_RwLock* self)
+{
+    return ATX_RwLock_TimedLockWrite(self, 0);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_RwLock_UnlockWrite
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RwLock_UnlockWrite(ATX_RwLock* self)
+{
+    ATX_Int32 waiting_readers;
+    ATX_Int32 waiting_writers;
+    
+    ATX_Atomic_Add(&self->state, -ATX_RW_LOCK_WRITER, ATX_ATOMIC_SEQ_CST);
+    waiting_readers = ATX_Atomic_Load(&self->waiting_readers, ATX_ATOMIC_SEQ_CST);
+    waiting_writers = ATX_Atomic_Load(&self->waiting_writers, ATX_ATOMIC_SEQ_CST);
+    if (waiting_readers || waiting_writers) {
+        ATX_Mutex_Lock(self->mutex);
+        if (waiting_writers) ATX_Condition_Broadcast(self->writers_may_enter);
+        if (waiting_readers) ATX_Condition_Broadcast(self->readers_may_enter);
+        ATX_Mutex_Unlock(self->mutex);
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_SpinMutex_Create(ATX_SpinMutex** mutex)
+{
+    ATX_SpinMutex* self;
+    ATX_Result     result;
+    
+    *mutex = NULL;
+#if !ATX_ATOMIC_IS_LOCK_FREE
+    ATX_COMPILER_UNUSED(self);
+    ATX_COMPILER_UNUSED(result);
+    return ATX_ERROR_NOT_SUPPORTED;
+#else
+    self = (ATX_SpinMutex*)ATX_AllocateZeroMemory(sizeof(ATX_SpinMutex));
+    if (self == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    /* the owner can only release the mutex while we spin if it is
+       running on another processor */
+    if (ATX_System_GetProcessorCount() > 1) {
+        self->max_spins = ATX_SPIN_MUTEX_MAX_SPINS;
+    }
+    
+    result = ATX_Semaphore_Create(0, &self->wakeup);
+    if (ATX_FAILED(result)) {
+        ATX_FreeMemory(self);
+        return result;
+    }
+    
+    *mutex = self;
+    return ATX_SUCCESS;
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_SpinMutex_Destroy(ATX_SpinMutex* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    
+    ATX_Semaphore_Destroy(self->wakeup);
+    ATX_FreeMemory(self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_Spin
+|
+|   Spin up to twice as long as the average, so that the average can 
+|   grow when the mutex is held longer, and shrink when spinning fails.
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_SpinMutex_Spin(ATX_SpinMutex* self)
+{
+    ATX_Int32   average = ATX_Atomic_Load(&self->spins, ATX_ATOMIC_RELAXED);
+    ATX_Int32   limit   = average*2+10;
+    ATX_Int32   spins;
+    ATX_Boolean locked  = ATX_FALSE;
+    
+    if (limit > self->max_spins) limit = self->max_spins;
+    for (spins=0; spins<limit; spins++) {
+        if (ATX_Atomic_Load(&self->state, ATX_ATOMIC_RELAXED) == ATX_SPIN_MUTEX_UNLOCKED &&
+            ATX_Atomic_CompareAndSwap(&self->state, 
+                                      ATX_SPIN_MUTEX_UNLOCKED, 
+                                      ATX_SPIN_MUTEX_LOCKED)) {
+            locked = ATX_TRUE;
+            break;
+        }
+        ATX_SPIN_MUTEX_PAUSE();
+    }
+    ATX_Atomic_Store(&self->spins, average+(spins-average)/8, ATX_ATOMIC_RELAXED);
+    
+    return locked;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_TimedLock
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_SpinMutex_TimedLock(ATX_SpinMutex* self, ATX_Timeout timeout)
+{
+    ATX_TimeStamp deadline = {0, 0};
+    
+    /* fast path */
+    if (ATX_Atomic_CompareAndSwap(&self->state, 
+                                  ATX_SPIN_MUTEX_UNLOCKED, 
+                                  ATX_SPIN_MUTEX_LOCKED)) {
+        return ATX_SUCCESS;
+    }
+    if (timeout == 0) return ATX_ERROR_TIMEOUT;
+    if (self->max_spins && ATX_SpinMutex_Spin(self)) return ATX_SUCCESS;
+    
+    /* mark the mutex as contended and sleep until the owner unlocks it.
+       We do not know if other threads are still sleeping after we get 
+       the mutex, so we leave it marked as contended */
+    ATX_Locks_GetDeadline(timeout, &deadline);
+    for (;;) {
+        ATX_Int32   state;
+        ATX_Timeout remaining;
+        
+        do {
+            state = ATX_Atomic_Load(&self->state, ATX_ATOMIC_RELAXED);
+        } while (!ATX_Atomic_CompareAndSwap(&self->state, state, ATX_SPIN_MUTEX_CONTENDED));
+        if (state == ATX_SPIN_MUTEX_UNLOCKED) return ATX_SUCCESS;
+        
+        remaining = ATX_Locks_GetRemainingTime(timeout, &deadline);
+        if (remaining == 0) return ATX_ERROR_TIMEOUT;
+        ATX_Semaphore_TimedAcquire(self->wakeup, remaining);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_Lock
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_SpinMutex_Lock(ATX_SpinMutex* self)
+{
+    return ATX_SpinMutex_TimedLock(self, ATX_TIMEOUT_INFINITE);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_TryLock
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_SpinMutex_TryLock(ATX_SpinMutex* self)
+{
+    return ATX_SpinMutex_TimedLock(self, 0);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_SpinMutex_Unlock
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_SpinMutex_Unlock(ATX_SpinMutex* self)
+{
+    if (ATX_Atomic_Add(&self->state, -1, ATX_ATOMIC_SEQ_CST) != ATX_SPIN_MUTEX_UNLOCKED) {
+        /* it was contended: wake up one sleeper, which will mark it 
+           as contended again */
+        ATX_Atomic_Store(&self->state, ATX_SPIN_MUTEX_UNLOCKED, ATX_ATOMIC_RELEASE);
+        ATX_Semaphore_Release(self->wakeup, 1);
+    }
+    
+    return ATX_SUCCESS;
+}
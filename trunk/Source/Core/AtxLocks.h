@@ -0,0 +1,163 @@
+/*****************************************************************
+|
+|   Atomix - Locks
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_LOCKS_H_
+#define _ATX_LOCKS_H_
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxThreads.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+/**
+ * Block new readers as soon as a writer is waiting, so that writers 
+ * are not starved by a continuous flow of readers. Without this flag, 
+ * readers may enter whenever no writer holds the lock.
+ */
+#define ATX_RW_LOCK_FLAG_PREFER_WRITERS 0x01
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/**
+ * A lock that is held either by any number of readers or by a single 
+ * writer. Taking and releasing an uncontended lock is a single atomic
+ * operation. Locks are not recursive.
+ */
+typedef struct ATX_RwLock ATX_RwLock;
+
+/**
+ * A mutex for short critical sections. A thread that finds it locked 
+ * spins for a while before sleeping, for about as long as it recently
+ * took to get the lock by spinning (it never spins on uniprocessors).
+ * Spin mutexes are not recursive.
+ */
+typedef struct ATX_SpinMutex ATX_SpinMutex;
+
+/*----------------------------------------------------------------------
+|   prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a reader-writer lock, with ATX_RW_LOCK_FLAG_XXX flags.
+ * Returns ATX_ERROR_NOT_SUPPORTED if the compiler has no atomic 
+ * operations.
+ */
+ATX_Result
+ATX_RwLock_Create(ATX_Flags flags, ATX_RwLock** lock);
+
+ATX_Result
+ATX_RwLock_Destroy(ATX_RwLock* lock);
+
+ATX_Result
+ATX_RwLock_LockRead(ATX_RwLock* lock);
+
+/**
+ * Same as ATX_RwLock_LockRead, but never wait.
+ * Returns ATX_ERROR_TIMEOUT if the lock could not be taken.
+ */
+ATX_Result
+ATX_RwLock_TryLockRead(ATX_RwLock* lock);
+
+/**
+ * Same as ATX_RwLock_LockRead, but give up after a timeout in 
+ * milliseconds. Returns ATX_ERROR_TIMEOUT if the timeout expired.
+ */
+ATX_Result
+ATX_RwLock_TimedLockRead(ATX_RwLock* lock, ATX_Timeout timeout);
+
+ATX_Result
+ATX_RwLock_UnlockRead(ATX_RwLock* lock);
+
+ATX_Result
+ATX_RwLock_LockWrite(ATX_RwLock* lock);
+
+/**
+ * Same as ATX_RwLock_LockWrite, but never wait.
+ * Returns ATX_ERROR_TIMEOUT if the lock could not be taken.
+ */
+ATX_Result
+ATX_RwLock_TryLockWrite(ATX_RwLock* lock);
+
+/**
+ * Same as ATX_RwLock_LockWrite, but give up after a timeout in 
+ * milliseconds. Returns ATX_ERROR_TIMEOUT if the timeout expired.
+ */
+ATX_Result
+ATX_RwLock_TimedLockWrite(ATX_RwLock* lock, ATX_Timeout timeout);
+
+ATX_Result
+ATX_RwLock_UnlockWrite(ATX_RwLock* lock);
+
+/**
+ * Create a spin mutex.
+ * Returns ATX_ERROR_NOT_SUPPORTED if the compiler has no atomic 
+ * operations.
+ */
+ATX_Result
+ATX_SpinMutex_Create(ATX_SpinMutex** mutex);
+
+ATX_Result
+ATX_SpinMutex_Destroy(ATX_SpinMutex* mutex);
+
+ATX_Result
+ATX_SpinMutex_Lock(ATX_SpinMutex* mutex);
+
+/**
+ * Same as ATX_SpinMutex_Lock, but never wait.
+ * Returns ATX_ERROR_TIMEOUT if the mutex could not be locked.
+ */
+ATX_Result
+ATX_SpinMutex_TryLock(ATX_SpinMutex* mutex);
+
+/**
+ * Same as ATX_SpinMutex_Lock, but give up after a timeout in 
+ * milliseconds. Returns ATX_ERROR_TIMEOUT if the timeout expired.
+ */
+ATX_Result
+ATX_SpinMutex_TimedLock(ATX_SpinMutex* mutex, ATX_Timeout timeout);
+
+ATX_Result
+ATX_SpinMutex_Unlock(ATX_SpinMutex* mutex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ATX_LOCKS_H_ */
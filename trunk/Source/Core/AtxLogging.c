@@ -74,9 +74,10 @@ typedef struct {
 } ATX_LogManager;
 
 typedef struct {
-    ATX_UInt32  outputs;
-    ATX_Boolean use_colors;
-    ATX_Flags   format_filter;
+    ATX_UInt32          outputs;
+    ATX_Boolean         use_colors;
+    ATX_Flags           format_filter;
+    ATX_DataBufferPool* pool;
 } ATX_LogConsoleHandler;
 
 typedef struct {
@@ -94,14 +95,25 @@ typedef struct {
     ATX_DatagramSocket* socket;
     ATX_SocketAddress   address;
     ATX_UInt32          sequence_number;
+    ATX_String          message;
+    ATX_DataBufferPool* pool;
 } ATX_LogUdpHandler;
 
+/* storage for the numbers of a formatted record */
+typedef struct {
+    char level[16];
+    char line[16];
+    char seconds[16];
+    char milliseconds[16];
+} ATX_LogRecordStrings;
+
 /*----------------------------------------------------------------------
 |   constants
 +---------------------------------------------------------------------*/
 #define ATX_LOG_HEAP_BUFFER_INCREMENT 4096
 #define ATX_LOG_STACK_BUFFER_MAX_SIZE 512
 #define ATX_LOG_HEAP_BUFFER_MAX_SIZE  65536
+#define ATX_LOG_RECORD_MAX_PARTS      24
 
 #if !defined(ATX_CONFIG_LOG_CONFIG_ENV)
 #define ATX_CONFIG_LOG_CONFIG_ENV "ATOMIX_LOG_CONFIG"
@@ -437,19 +449,23 @@ ATX_LogManager_ParseConfig(const char* config,
 static ATX_Result
 ATX_LogManager_ParseConfigFile(const char* filename) 
 {
-    ATX_Result result;
+    ATX_FileView* view = NULL;
+    ATX_Result    result;
 
-    /* load the file */
-    ATX_DataBuffer* buffer = NULL;
-    result = ATX_LoadFile(filename, &buffer);
+    /* map the file */
+    result = ATX_MapFile(filename, &view);
     if (ATX_FAILED(result)) return result;
 
-    /* parse the config */
-    result = ATX_LogManager_ParseConfig((const char*)ATX_DataBuffer_GetData(buffer),
-                                        ATX_DataBuffer_GetDataSize(buffer));
+    /* parse the config in place */
+    if (ATX_FileView_GetSize(view) > 0xFFFFFFFF) {
+        result = ATX_ERROR_OUT_OF_RANGE;
+    } else {
+        result = ATX_LogManager_ParseConfig((const char*)ATX_FileView_GetData(view),
+                                            (ATX_Size)ATX_FileView_GetSize(view));
+    }
 
-    /* destroy the buffer */
-    ATX_DataBuffer_Destroy(buffer);
+    /* release the view */
+    ATX_FileView_Destroy(view);
 
     return result;
 }
@@ -1014,64 +1030,98 @@ ATX_LogNullHandler_Interface = {
 };
 
 /*----------------------------------------------------------------------
-|   ATX_Log_FormatRecordToStream
+|   ATX_Log_AddRecordPart
 +---------------------------------------------------------------------*/
 static void
-ATX_Log_FormatRecordToStream(const ATX_LogRecord* record,
-                             ATX_OutputStream*    stream,
-                             ATX_Boolean          use_colors,
-                             ATX_Flags            format_filter)
+ATX_Log_AddRecordPart(ATX_IoVec* parts, ATX_Cardinal* part_count, const char* part)
 {
-    const char* level_name = ATX_Log_GetLogLevelName(record->level);
-    char        level_string[16];
-    char        buffer[64];
-    const char* ansi_color = NULL;
+    if (part == NULL || part[0] == '\0') return;
+    parts[*part_count].buffer = part;
+    parts[*part_count].size   = ATX_StringLength(part);
+    ++*part_count;
+}
 
-    /* format and emit the record */
+/*----------------------------------------------------------------------
+|   ATX_Log_FormatRecord
+|
+|   Split a record into the parts of its text representation. The parts
+|   point to the record and to the strings storage.
++---------------------------------------------------------------------*/
+static ATX_Cardinal
+ATX_Log_FormatRecord(const ATX_LogRecord*  record,
+                     ATX_Boolean           use_colors,
+                     ATX_Flags             format_filter,
+                     ATX_LogRecordStrings* strings,
+                     ATX_IoVec*            parts)
+{
+    const char*  level_name = ATX_Log_GetLogLevelName(record->level);
+    const char*  ansi_color = NULL;
+    ATX_Cardinal part_count = 0;
+
+    /* format the record */
     if (level_name[0] == '\0') {
-        ATX_IntegerToString(record->level, level_string, sizeof(level_string));
-        level_name = level_string;
+        ATX_IntegerToString(record->level, strings->level, sizeof(strings->level));
+        level_name = strings->level;
     }
     if ((format_filter & ATX_LOG_FORMAT_FILTER_NO_SOURCE) == 0) {
-        ATX_OutputStream_WriteString(stream, record->source_file);
-        ATX_OutputStream_WriteFully(stream, "(", 1);
-        ATX_IntegerToStringU(record->source_line, buffer, sizeof(buffer));
-        ATX_OutputStream_WriteString(stream, buffer);
-        ATX_OutputStream_WriteFully(stream, "): ", 3);
+        ATX_Log_AddRecordPart(parts, &part_count, record->source_file);
+        ATX_Log_AddRecordPart(parts, &part_count, "(");
+        ATX_IntegerToStringU(record->source_line, strings->line, sizeof(strings->line));
+        ATX_Log_AddRecordPart(parts, &part_count, strings->line);
+        ATX_Log_AddRecordPart(parts, &part_count, "): ");
     }
-    ATX_OutputStream_WriteFully(stream, "[", 1);
-    ATX_OutputStream_WriteString(stream, record->logger_name);
-    ATX_OutputStream_WriteFully(stream, "] ", 2);
+    ATX_Log_AddRecordPart(parts, &part_count, "[");
+    ATX_Log_AddRecordPart(parts, &part_count, record->logger_name);
+    ATX_Log_AddRecordPart(parts, &part_count, "] ");
     if ((format_filter & ATX_LOG_FORMAT_FILTER_NO_TIMESTAMP) == 0) {
-        ATX_IntegerToStringU(record->timestamp.seconds, buffer, sizeof(buffer));
-        ATX_OutputStream_WriteString(stream, buffer);
-        ATX_OutputStream_WriteString(stream, ":");
-        ATX_IntegerToStringU(record->timestamp.nanoseconds/1000000L, buffer, sizeof(buffer));
-        ATX_OutputStream_WriteString(stream, buffer);
-        ATX_OutputStream_WriteFully(stream, " ", 1);
+        ATX_IntegerToStringU(record->timestamp.seconds, strings->seconds, sizeof(strings->seconds));
+        ATX_Log_AddRecordPart(parts, &part_count, strings->seconds);
+        ATX_Log_AddRecordPart(parts, &part_count, ":");
+        ATX_IntegerToStringU(record->timestamp.nanoseconds/1000000L, strings->milliseconds, sizeof(strings->milliseconds));
+        ATX_Log_AddRecordPart(parts, &part_count, strings->milliseconds);
+        ATX_Log_AddRecordPart(parts, &part_count, " ");
     }
     if ((format_filter & ATX_LOG_FORMAT_FILTER_NO_FUNCTION_NAME) == 0) {
-        ATX_OutputStream_WriteFully(stream, "[",1);
-        if (record->source_function) {
-            ATX_OutputStream_WriteString(stream, record->source_function);
-        }
-        ATX_OutputStream_WriteFully(stream, "] ",2);
+        ATX_Log_AddRecordPart(parts, &part_count, "[");
+        ATX_Log_AddRecordPart(parts, &part_count, record->source_function);
+        ATX_Log_AddRecordPart(parts, &part_count, "] ");
     }
     if (use_colors) {
         ansi_color = ATX_Log_GetLogLevelAnsiColor(record->level);
         if (ansi_color) {
-            ATX_OutputStream_WriteFully(stream, "\033[", 2);
-            ATX_OutputStream_WriteString(stream, ansi_color);
-            ATX_OutputStream_WriteFully(stream, ";1m", 3);
+            ATX_Log_AddRecordPart(parts, &part_count, "\033[");
+            ATX_Log_AddRecordPart(parts, &part_count, ansi_color);
+            ATX_Log_AddRecordPart(parts, &part_count, ";1m");
         }
     }
-    ATX_OutputStream_WriteString(stream, level_name);
+    ATX_Log_AddRecordPart(parts, &part_count, level_name);
     if (use_colors && ansi_color) {
-        ATX_OutputStream_WriteFully(stream, "\033[0m", 4);
+        ATX_Log_AddRecordPart(parts, &part_count, "\033[0m");
     }
-    ATX_OutputStream_WriteFully(stream, ": ", 2);
-    ATX_OutputStream_WriteString(stream, record->message);
-    ATX_OutputStream_WriteFully(stream, "\r\n", 2);
+    ATX_Log_AddRecordPart(parts, &part_count, ": ");
+    ATX_Log_AddRecordPart(parts, &part_count, record->message);
+    ATX_Log_AddRecordPart(parts, &part_count, "\r\n");
+
+    return part_count;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Log_FormatRecordToStream
++---------------------------------------------------------------------*/
+static void
+ATX_Log_FormatRecordToStream(const ATX_LogRecord* record,
+                             ATX_OutputStream*    stream,
+                             ATX_Boolean          use_colors,
+                             ATX_Flags            format_filter)
+{
+    ATX_LogRecordStrings strings;
+    ATX_IoVec            parts[ATX_LOG_RECORD_MAX_PARTS];
+    ATX_Cardinal         part_count;
+
+    part_count = ATX_Log_FormatRecord(record, use_colors, format_filter, &strings, parts);
+
+    /* emit the record, the strings it points to are all still valid */
+    ATX_OutputStream_WriteVFully(stream, parts, part_count);
 }
 
 /*----------------------------------------------------------------------
@@ -1086,24 +1136,44 @@ static void
 ATX_LogConsoleHandler_Log(ATX_LogHandler* _self, const ATX_LogRecord* record)
 {
     ATX_LogConsoleHandler* self = (ATX_LogConsoleHandler*)_self->instance;
-    ATX_MemoryStream*      memory_stream;
-    ATX_OutputStream*      output_stream;
-
-    if (ATX_FAILED(ATX_MemoryStream_Create(4096, &memory_stream))) return;
-    if (ATX_SUCCEEDED(ATX_MemoryStream_GetOutputStream(memory_stream, &output_stream))) {
-        const ATX_DataBuffer* buffer;
-        ATX_Log_FormatRecordToStream(record, output_stream, self->use_colors, self->format_filter);
-        ATX_OutputStream_WriteFully(output_stream, "\0", 1);
-        ATX_MemoryStream_GetBuffer(memory_stream, &buffer);
-        if (self->outputs & ATX_LOG_CONSOLE_HANDLER_OUTPUT_TO_CONSOLE) {
-            ATX_ConsoleOutput((const char*)ATX_DataBuffer_GetData(buffer));
-        }
-        if (self->outputs & ATX_LOG_CONSOLE_HANDLER_OUTPUT_TO_DEBUG) {
-            ATX_DebugOutput((const char*)ATX_DataBuffer_GetData(buffer));
+    ATX_LogRecordStrings   strings;
+    ATX_IoVec              parts[ATX_LOG_RECORD_MAX_PARTS];
+    ATX_Cardinal           part_count;
+    ATX_Size               size = 1;
+    ATX_DataBuffer*        buffer;
+    ATX_Byte*              text;
+    ATX_Cardinal           i;
+
+    /* handlers are called with the log manager locked, so the pool does
+       not need its own lock */
+    if (self->pool == NULL) {
+        if (ATX_FAILED(ATX_DataBufferPool_Create(0, 0, ATX_DATA_BUFFER_POOL_FLAG_SINGLE_THREAD, &self->pool))) {
+            return;
         }
-        ATX_RELEASE_OBJECT(output_stream);
     }
-    ATX_MemoryStream_Destroy(memory_stream);
+
+    /* format the record into a null-terminated string */
+    part_count = ATX_Log_FormatRecord(record, self->use_colors, self->format_filter, &strings, parts);
+    for (i=0; i<part_count; i++) size += parts[i].size;
+    if (ATX_FAILED(ATX_DataBufferPool_Acquire(self->pool, size, &buffer))) return;
+    text = ATX_DataBuffer_UseData(buffer);
+    if (text == NULL) {
+        ATX_DataBuffer_Destroy(buffer);
+        return;
+    }
+    for (i=0; i<part_count; i++) {
+        ATX_CopyMemory(text, parts[i].buffer, parts[i].size);
+        text += parts[i].size;
+    }
+    *text = '\0';
+
+    if (self->outputs & ATX_LOG_CONSOLE_HANDLER_OUTPUT_TO_CONSOLE) {
+        ATX_ConsoleOutput((const char*)ATX_DataBuffer_GetData(buffer));
+    }
+    if (self->outputs & ATX_LOG_CONSOLE_HANDLER_OUTPUT_TO_DEBUG) {
+        ATX_DebugOutput((const char*)ATX_DataBuffer_GetData(buffer));
+    }
+    ATX_DataBuffer_Destroy(buffer);
 }
 
 /*----------------------------------------------------------------------
@@ -1114,6 +1184,9 @@ ATX_LogConsoleHandler_Destroy(ATX_LogHandler* _self)
 {
     ATX_LogConsoleHandler* self = (ATX_LogConsoleHandler*)_self->instance;
 
+    /* destroy fields */
+    ATX_DataBufferPool_Destroy(self->pool);
+
     /* free the object memory */
     ATX_FreeMemory((void*)self);
 }
@@ -1200,7 +1273,14 @@ static void
 ATX_LogFileHandler_Log(ATX_LogHandler* _self, const ATX_LogRecord* record)
 {
     ATX_LogFileHandler* self = (ATX_LogFileHandler*)_self->instance;
+    if (self->stream == NULL) return;
+    
+    /* the stream is buffered, records are only pushed out right away 
+       when they are severe enough to matter if the process dies */
     ATX_Log_FormatRecordToStream(record, self->stream, ATX_FALSE, 0);
+    if (record->level >= ATX_LOG_LEVEL_SEVERE) {
+        ATX_OutputStream_Flush(self->stream);
+    }
 }
 
 /*----------------------------------------------------------------------
@@ -1267,8 +1347,9 @@ ATX_LogFileHandler_Create(const char*     logger_name,
     /* open the log file */
     if (ATX_SUCCEEDED(ATX_File_Create(filename, &file))) {
         result = ATX_File_Open(file, 
-                               ATX_FILE_OPEN_MODE_CREATE |
-                               ATX_FILE_OPEN_MODE_WRITE  |
+                               ATX_FILE_OPEN_MODE_CREATE          |
+                               ATX_FILE_OPEN_MODE_WRITE           |
+                               ATX_FILE_OPEN_MODE_BUFFERED_OUTPUT |
                                (append?ATX_FILE_OPEN_MODE_APPEND:0));
         if (ATX_SUCCEEDED(result)) {
             result = ATX_File_GetOutputStream(file, &instance->stream);
@@ -1496,19 +1577,27 @@ ATX_LogUdpHandler_Log(ATX_LogHandler* _self, const ATX_LogRecord* record)
     ATX_LogUdpHandler* self = (ATX_LogUdpHandler*)_self->instance;
     ATX_DataBuffer*    buffer;
     
-    /* format the record */
-    ATX_String msg = ATX_EMPTY_STRING;
-    ATX_LogTcpHandler_FormatRecord(record, &msg, self->sequence_number++);
+    /* handlers are called with the log manager locked, so the pool does
+       not need its own lock */
+    if (self->pool == NULL) {
+        if (ATX_FAILED(ATX_DataBufferPool_Create(0, 0, ATX_DATA_BUFFER_POOL_FLAG_SINGLE_THREAD, &self->pool))) {
+            return;
+        }
+    }
+
+    /* format the record, reusing the memory of the previous message */
+    ATX_String_SetLength(&self->message, 0);
+    ATX_LogTcpHandler_FormatRecord(record, &self->message, self->sequence_number++);
 
     /* send the record in a datagram */
-    ATX_DataBuffer_Create(0, &buffer);
-    ATX_DataBuffer_SetBuffer(buffer, (void*)ATX_String_UseChars(&msg), ATX_String_GetLength(&msg)+1);
-    ATX_DataBuffer_SetDataSize(buffer, ATX_String_GetLength(&msg)+1);
+    if (ATX_FAILED(ATX_DataBufferPool_Acquire(self->pool, ATX_String_GetLength(&self->message)+1, &buffer))) {
+        return;
+    }
+    ATX_DataBuffer_SetData(buffer, (const ATX_Byte*)ATX_CSTR(self->message), ATX_String_GetLength(&self->message)+1);
     ATX_DatagramSocket_Send(self->socket, buffer, &self->address);
     
     /* cleanup */
     ATX_DataBuffer_Destroy(buffer);
-    ATX_String_Destruct(&msg);
 }
 
 /*----------------------------------------------------------------------
@@ -1521,6 +1610,8 @@ ATX_LogUdpHandler_Destroy(ATX_LogHandler* _self)
 
     /* destroy fields */
     ATX_DESTROY_OBJECT(self->socket);
+    ATX_String_Destruct(&self->message);
+    ATX_DataBufferPool_Destroy(self->pool);
 
     /* free the object memory */
     ATX_FreeMemory((void*)self);
@@ -0,0 +1,1145 @@
+/*****************************************************************
+|
+|   Atomix - LZ4 Compression
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxUtils.h"
+#include "AtxStreams.h"
+#include "AtxReferenceable.h"
+#include "AtxLz4.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_LZ4_MIN_MATCH        4
+#define ATX_LZ4_MF_LIMIT         12 /* no match may start in the last 12 bytes */
+#define ATX_LZ4_LAST_LITERALS    5  /* the last 5 bytes are always literals    */
+#define ATX_LZ4_MAX_OFFSET       65535
+#define ATX_LZ4_HASH_LOG         12
+#define ATX_LZ4_HASH_SIZE        (1<<ATX_LZ4_HASH_LOG)
+#define ATX_LZ4_SKIP_TRIGGER     6
+#define ATX_LZ4_HISTORY_SIZE     65536
+
+#define ATX_LZ4_FRAME_MAGIC      0x184D2204
+#define ATX_LZ4_SKIPPABLE_MAGIC  0x184D2A50 /* low 4 bits are free */
+#define ATX_LZ4_FRAME_VERSION    0x40
+#define ATX_LZ4_FLAG_INDEPENDENT 0x20
+#define ATX_LZ4_FLAG_BLOCK_CHECKSUM   0x10
+#define ATX_LZ4_FLAG_CONTENT_SIZE     0x08
+#define ATX_LZ4_FLAG_CONTENT_CHECKSUM 0x04
+#define ATX_LZ4_FLAG_DICTIONARY_ID    0x01
+#define ATX_LZ4_BLOCK_UNCOMPRESSED    0x80000000
+
+#define ATX_XXH32_PRIME_1 2654435761U
+#define ATX_XXH32_PRIME_2 2246822519U
+#define ATX_XXH32_PRIME_3 3266489917U
+#define ATX_XXH32_PRIME_4 668265263U
+#define ATX_XXH32_PRIME_5 374761393U
+
+/*----------------------------------------------------------------------
+|   macros
++---------------------------------------------------------------------*/
+#define ATX_LZ4_ROTL32(x, r) (((x) << (r)) | ((x) >> (32-(r))))
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_UInt32    v[4];
+    ATX_LargeSize total;
+    ATX_Byte      pending[16];
+    ATX_Size      pending_size;
+} ATX_Lz4Checksum;
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Read32
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Lz4_Read32(const ATX_Byte* p)
+{
+    ATX_UInt32 value;
+    ATX_CopyMemory(&value, p, 4);
+    return value;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Read64
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_Lz4_Read64(const ATX_Byte* p)
+{
+    ATX_UInt64 value;
+    ATX_CopyMemory(&value, p, 8);
+    return value;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Read32Le
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Lz4_Read32Le(const ATX_Byte* p)
+{
+    return ((ATX_UInt32)p[0]      ) | 
+           ((ATX_UInt32)p[1] <<  8) | 
+           ((ATX_UInt32)p[2] << 16) | 
+           ((ATX_UInt32)p[3] << 24);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Checksum_Init
+|
+|   XXH32 with a seed of 0, as used by the LZ4 frame format.
++---------------------------------------------------------------------*/
+static void
+ATX_Lz4Checksum_Init(ATX_Lz4Checksum* self)
+{
+    self->v[0] = ATX_XXH32_PRIME_1+ATX_XXH32_PRIME_2;
+    self->v[1] = ATX_XXH32_PRIME_2;
+    self->v[2] = 0;
+    self->v[3] = 0-ATX_XXH32_PRIME_1;
+    self->total        = 0;
+    self->pending_size = 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Checksum_Round
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Lz4Checksum_Round(ATX_UInt32 acc, ATX_UInt32 input)
+{
+    acc += input*ATX_XXH32_PRIME_2;
+    acc  = ATX_LZ4_ROTL32(acc, 13);
+    return acc*ATX_XXH32_PRIME_1;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Checksum_Update
++---------------------------------------------------------------------*/
+static void
+ATX_Lz4Checksum_Update(ATX_Lz4Checksum* self, const ATX_Byte* data, ATX_Size size)
+{
+    const ATX_Byte* end = data+size;
+    ATX_UInt32      v0, v1, v2, v3;
+    
+    self->total += size;
+    
+    /* complete a pending stripe */
+    if (self->pending_size+size < 16) {
+        ATX_CopyMemory(self->pending+self->pending_size, data, size);
+        self->pending_size += size;
+        return;
+    }
+    if (self->pending_size) {
+        ATX_Size chunk = 16-self->pending_size;
+        ATX_CopyMemory(self->pending+self->pending_size, data, chunk);
+        data += chunk;
+        self->v[0] = ATX_Lz4Checksum_Round(self->v[0], ATX_Lz4_Read32Le(self->pending   ));
+        self->v[1] = ATX_Lz4Checksum_Round(self->v[1], ATX_Lz4_Read32Le(self->pending+4 ));
+        self->v[2] = ATX_Lz4Checksum_Round(self->v[2], ATX_Lz4_Read32Le(self->pending+8 ));
+        self->v[3] = ATX_Lz4Checksum_Round(self->v[3], ATX_Lz4_Read32Le(self->pending+12));
+        self->pending_size = 0;
+    }
+    
+    /* whole stripes */
+    v0 = self->v[0];
+    v1 = self->v[1];
+    v2 = self->v[2];
+    v3 = self->v[3];
+    while (end-data >= 16) {
+        v0 = ATX_Lz4Checksum_Round(v0, ATX_Lz4_Read32Le(data   ));
+        v1 = ATX_Lz4Checksum_Round(v1, ATX_Lz4_Read32Le(data+4 ));
+        v2 = ATX_Lz4Checksum_Round(v2, ATX_Lz4_Read32Le(data+8 ));
+        v3 = ATX_Lz4Checksum_Round(v3, ATX_Lz4_Read32Le(data+12));
+        data += 16;
+    }
+    self->v[0] = v0;
+    self->v[1] = v1;
+    self->v[2] = v2;
+    self->v[3] = v3;
+    
+    /* keep the tail */
+    if (data != end) {
+        ATX_CopyMemory(self->pending, data, (ATX_Size)(end-data));
+        self->pending_size = (ATX_Size)(end-data);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Checksum_Digest
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Lz4Checksum_Digest(const ATX_Lz4Checksum* self)
+{
+    const ATX_Byte* p   = self->pending;
+    const ATX_Byte* end = self->pending+self->pending_size;
+    ATX_UInt32      h;
+    
+    if (self->total >= 16) {
+        h = ATX_LZ4_ROTL32(self->v[0],  1) + 
+            ATX_LZ4_ROTL32(self->v[1],  7) +
+            ATX_LZ4_ROTL32(self->v[2], 12) + 
+            ATX_LZ4_ROTL32(self->v[3], 18);
+    } else {
+        h = ATX_XXH32_PRIME_5;
+    }
+    h += (ATX_UInt32)self->total;
+    
+    while (end-p >= 4) {
+        h += ATX_Lz4_Read32Le(p)*ATX_XXH32_PRIME_3;
+        h  = ATX_LZ4_ROTL32(h, 17)*ATX_XXH32_PRIME_4;
+        p += 4;
+    }
+    while (p != end) {
+        h += (*p++)*ATX_XXH32_PRIME_5;
+        h  = ATX_LZ4_ROTL32(h, 11)*ATX_XXH32_PRIME_1;
+    }
+    
+    h ^= h >> 15;
+    h *= ATX_XXH32_PRIME_2;
+    h ^= h >> 13;
+    h *= ATX_XXH32_PRIME_3;
+    h ^= h >> 16;
+    
+    return h;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Checksum
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Lz4_Checksum(const ATX_Byte* data, ATX_Size size)
+{
+    ATX_Lz4Checksum checksum;
+    
+    ATX_Lz4Checksum_Init(&checksum);
+    ATX_Lz4Checksum_Update(&checksum, data, size);
+    return ATX_Lz4Checksum_Digest(&checksum);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Hash
++---------------------------------------------------------------------*/
+static ATX_UInt32
+ATX_Lz4_Hash(const ATX_Byte* p)
+{
+    return (ATX_Lz4_Read32(p)*2654435761U) >> (32-ATX_LZ4_HASH_LOG);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_WriteLength
++---------------------------------------------------------------------*/
+static ATX_Byte*
+ATX_Lz4_WriteLength(ATX_Byte* out, ATX_Size length)
+{
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (ATX_Byte)length;
+    
+    return out;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_WriteLiterals
++---------------------------------------------------------------------*/
+static ATX_Byte*
+ATX_Lz4_WriteLiterals(ATX_Byte* out, const ATX_Byte* literals, ATX_Size count)
+{
+    ATX_Byte* token = out++;
+    
+    if (count >= 15) {
+        *token = 15 << 4;
+        out = ATX_Lz4_WriteLength(out, count-15);
+    } else {
+        *token = (ATX_Byte)(count << 4);
+    }
+    ATX_CopyMemory(out, literals, count);
+    
+    return out+count;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Compress
+|
+|   Greedy single pass compressor, with a hash table of the last
+|   position where each 4-byte sequence was seen. The output buffer 
+|   must be at least ATX_Lz4_GetMaxCompressedSize(in_size) bytes.
++---------------------------------------------------------------------*/
+static ATX_Size
+ATX_Lz4_Compress(const ATX_Byte* in, 
+                 ATX_Size        in_size, 
+                 ATX_Byte*       out, 
+                 ATX_UInt32*     table)
+{
+    ATX_Byte* op     = out;
+    ATX_Size  anchor = 0;
+    ATX_Size  pos    = 0;
+    ATX_Size  mf_limit;
+    ATX_Size  match_limit;
+    
+    /* short inputs are all literals */
+    if (in_size < ATX_LZ4_MF_LIMIT+1) goto last_literals;
+    mf_limit    = in_size-ATX_LZ4_MF_LIMIT;
+    match_limit = in_size-ATX_LZ4_LAST_LITERALS;
+    
+    ATX_SetMemory(table, 0, ATX_LZ4_HASH_SIZE*sizeof(ATX_UInt32));
+    table[ATX_Lz4_Hash(in)] = 0;
+    pos = 1;
+    
+    for (;;) {
+        ATX_Size  match;
+        ATX_Size  length;
+        ATX_Size  offset;
+        ATX_Byte* token;
+        
+        /* look for a match, going faster through data that doesn't match */
+        for (;;) {
+            ATX_UInt32 hash;
+            if (pos > mf_limit) goto last_literals;
+            hash  = ATX_Lz4_Hash(in+pos);
+            match = table[hash];
+            table[hash] = (ATX_UInt32)pos;
+            if (match < pos && 
+                pos-match <= ATX_LZ4_MAX_OFFSET && 
+                ATX_Lz4_Read32(in+match) == ATX_Lz4_Read32(in+pos)) {
+                break;
+            }
+            pos += 1+((pos-anchor) >> ATX_LZ4_SKIP_TRIGGER);
+        }
+        
+        /* extend the match backward and forward */
+        while (pos > anchor && match > 0 && in[pos-1] == in[match-1]) {
+            --pos;
+            --match;
+        }
+        length = ATX_LZ4_MIN_MATCH;
+        while (pos+length+8 <= match_limit && 
+               ATX_Lz4_Read64(in+match+length) == ATX_Lz4_Read64(in+pos+length)) {
+            length += 8;
+        }
+        while (pos+length < match_limit && in[match+length] == in[pos+length]) {
+            ++length;
+        }
+        offset = pos-match;
+        
+        /* emit the sequence */
+        token = op;
+        op = ATX_Lz4_WriteLiterals(op, in+anchor, pos-anchor);
+        *op++ = (ATX_Byte)(offset     );
+        *op++ = (ATX_Byte)(offset >> 8);
+        if (length-ATX_LZ4_MIN_MATCH >= 15) {
+            *token |= 15;
+            op = ATX_Lz4_WriteLength(op, length-ATX_LZ4_MIN_MATCH-15);
+        } else {
+            *token |= (ATX_Byte)(length-ATX_LZ4_MIN_MATCH);
+        }
+        pos   += length;
+        anchor = pos;
+        if (pos > mf_limit) goto last_literals;
+        
+        /* index a position inside the match */
+        table[ATX_Lz4_Hash(in+pos-2)] = (ATX_UInt32)(pos-2);
+    }
+    
+last_literals:
+    op = ATX_Lz4_WriteLiterals(op, in+anchor, in_size-anchor);
+    return (ATX_Size)(op-out);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_Decompress
+|
+|   Decompress a block to a buffer that follows history_size bytes of
+|   data that matches may refer to.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4_Decompress(const ATX_Byte* in, 
+                   ATX_Size        in_size, 
+                   ATX_Byte*       out, 
+                   ATX_Size        out_size, 
+                   ATX_Size        history_size,
+                   ATX_Size*       decompressed_size)
+{
+    const ATX_Byte* ip     = in;
+    const ATX_Byte* in_end = in+in_size;
+    ATX_Byte*       op     = out;
+    ATX_Byte*       out_end = out+out_size;
+    
+    *decompressed_size = 0;
+    
+    for (;;) {
+        ATX_Byte   token;
+        ATX_Size   length;
+        ATX_Size   offset;
+        ATX_Byte*  match;
+        unsigned int b;
+        
+        /* literals */
+        if (ip == in_end) return ATX_ERROR_INVALID_FORMAT;
+        token  = *ip++;
+        length = token >> 4;
+        if (length == 15) {
+            do {
+                if (ip == in_end) return ATX_ERROR_INVALID_FORMAT;
+                b = *ip++;
+                length += b;
+            } while (b == 255 && length <= in_size);
+        }
+        if (length > (ATX_Size)(in_end-ip) || length > (ATX_Size)(out_end-op)) {
+            return ATX_ERROR_INVALID_FORMAT;
+        }
+        if (length <= 16 && in_end-ip >= 16 && out_end-op >= 16) {
+            /* short literal runs are copied with a fixed size, past their end */
+            ATX_CopyMemory(op, ip, 16);
+        } else {
+            ATX_CopyMemory(op, ip, length);
+        }
+        ip += length;
+        op += length;
+        
+        /* the last sequence has no match */
+        if (ip == in_end) break;
+        
+        /* match */
+        if (in_end-ip < 2) return ATX_ERROR_INVALID_FORMAT;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (ATX_Size)(op-out)+history_size) {
+            return ATX_ERROR_INVALID_FORMAT;
+        }
+        length = token & 15;
+        if (length == 15) {
+            do {
+                if (ip == in_end) return ATX_ERROR_INVALID_FORMAT;
+                b = *ip++;
+                length += b;
+            } while (b == 255 && length <= out_size);
+        }
+        length += ATX_LZ4_MIN_MATCH;
+        if (length > (ATX_Size)(out_end-op)) return ATX_ERROR_INVALID_FORMAT;
+        match = op-offset;
+        if (offset == 1) {
+            ATX_SetMemory(op, *match, length);
+            op += length;
+        } else {
+            /* 8 byte chunks never overlap when the offset is at least 8 */
+            if (offset >= 8) {
+                for (; length >= 8; length -= 8) {
+                    ATX_CopyMemory(op, match, 8);
+                    op    += 8;
+                    match += 8;
+                }
+                if (length && out_end-op >= 8) {
+                    ATX_CopyMemory(op, match, 8);
+                    op    += length;
+                    length = 0;
+                }
+            }
+            while (length--) *op++ = *match++;
+        }
+    }
+    
+    *decompressed_size = (ATX_Size)(op-out);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_GetMaxCompressedSize
++---------------------------------------------------------------------*/
+ATX_Size
+ATX_Lz4_GetMaxCompressedSize(ATX_Size size)
+{
+    return size+size/255+16;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_CompressBlock
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Lz4_CompressBlock(const ATX_Byte* in, 
+                      ATX_Size        in_size, 
+                      ATX_Byte*       out, 
+                      ATX_Size        out_size, 
+                      ATX_Size*       compressed_size)
+{
+    ATX_UInt32* table;
+    
+    *compressed_size = 0;
+    if (out_size < ATX_Lz4_GetMaxCompressedSize(in_size)) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    table = (ATX_UInt32*)ATX_AllocateMemory(ATX_LZ4_HASH_SIZE*sizeof(ATX_UInt32));
+    if (table == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    *compressed_size = ATX_Lz4_Compress(in, in_size, out, table);
+    ATX_FreeMemory((void*)table);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4_DecompressBlock
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Lz4_DecompressBlock(const ATX_Byte* in, 
+                        ATX_Size        in_size, 
+                        ATX_Byte*       out, 
+                        ATX_Size        out_size, 
+                        ATX_Size*       decompressed_size)
+{
+    return ATX_Lz4_Decompress(in, in_size, out, out_size, 0, decompressed_size);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer
++---------------------------------------------------------------------*/
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal      reference_count;
+    ATX_OutputStream* sink;
+    ATX_Size          block_size;
+    ATX_Byte*         buffer;
+    ATX_Size          buffered;
+    ATX_Byte*         block; /* block size followed by the block data */
+    ATX_UInt32*       table;
+    ATX_Lz4Checksum   checksum;
+    ATX_Position      position;
+} ATX_Lz4Writer;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_Lz4Writer, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_Lz4Writer, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4OutputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Lz4OutputStream_Create(ATX_OutputStream*  sink,
+                           ATX_Size           block_size,
+                           ATX_OutputStream** object)
+{
+    ATX_Lz4Writer* stream;
+    ATX_Byte       header[7];
+    unsigned int   code = 4;
+    ATX_Result     result;
+    
+    /* default value */
+    *object = NULL;
+    if (block_size == 0) block_size = ATX_LZ4_DEFAULT_BLOCK_SIZE;
+    if (block_size > ATX_LZ4_MAX_BLOCK_SIZE) return ATX_ERROR_INVALID_PARAMETERS;
+    
+    /* round up to a size the frame format can express */
+    while (block_size > (ATX_Size)1 << (2*code+8)) ++code;
+    block_size = (ATX_Size)1 << (2*code+8);
+    
+    /* allocate new object */
+    stream = (ATX_Lz4Writer*)ATX_AllocateZeroMemory(sizeof(ATX_Lz4Writer));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    stream->buffer = (ATX_Byte*)ATX_AllocateMemory(block_size);
+    stream->block  = (ATX_Byte*)ATX_AllocateMemory(4+ATX_Lz4_GetMaxCompressedSize(block_size));
+    stream->table  = (ATX_UInt32*)ATX_AllocateMemory(ATX_LZ4_HASH_SIZE*sizeof(ATX_UInt32));
+    if (stream->buffer == NULL || stream->block == NULL || stream->table == NULL) {
+        ATX_FreeMemory((void*)stream->buffer);
+        ATX_FreeMemory((void*)stream->block);
+        ATX_FreeMemory((void*)stream->table);
+        ATX_FreeMemory((void*)stream);
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* construct object */
+    stream->reference_count = 1;
+    stream->sink            = sink;
+    stream->block_size      = block_size;
+    stream->buffered        = 0;
+    stream->position        = 0;
+    ATX_Lz4Checksum_Init(&stream->checksum);
+    
+    /* keep a reference to the sink stream */
+    ATX_REFERENCE_OBJECT(sink);
+    
+    /* write the frame header */
+    ATX_BytesFromInt32Le(header, ATX_LZ4_FRAME_MAGIC);
+    header[4] = ATX_LZ4_FRAME_VERSION | ATX_LZ4_FLAG_INDEPENDENT | ATX_LZ4_FLAG_CONTENT_CHECKSUM;
+    header[5] = (ATX_Byte)(code << 4);
+    header[6] = (ATX_Byte)(ATX_Lz4_Checksum(header+4, 2) >> 8);
+    result = ATX_OutputStream_WriteFully(sink, header, sizeof(header));
+    if (ATX_FAILED(result)) {
+        ATX_RELEASE_OBJECT(stream->sink);
+        ATX_FreeMemory((void*)stream->buffer);
+        ATX_FreeMemory((void*)stream->block);
+        ATX_FreeMemory((void*)stream->table);
+        ATX_FreeMemory((void*)stream);
+        return result;
+    }
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_Lz4Writer, ATX_OutputStream);
+    ATX_SET_INTERFACE(stream, ATX_Lz4Writer, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_OutputStream);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_WriteBlock
+|
+|   Compress a block and write it to the sink. Blocks that don't 
+|   compress are written as they are.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4Writer_WriteBlock(ATX_Lz4Writer* self, const ATX_Byte* data, ATX_Size size)
+{
+    ATX_Size compressed_size;
+    
+    if (size == 0) return ATX_SUCCESS;
+    
+    compressed_size = ATX_Lz4_Compress(data, size, self->block+4, self->table);
+    if (compressed_size < size) {
+        ATX_BytesFromInt32Le(self->block, compressed_size);
+    } else {
+        ATX_BytesFromInt32Le(self->block, size | ATX_LZ4_BLOCK_UNCOMPRESSED);
+        ATX_CopyMemory(self->block+4, data, size);
+        compressed_size = size;
+    }
+    
+    return ATX_OutputStream_WriteFully(self->sink, self->block, 4+compressed_size);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4Writer_Destroy(ATX_Lz4Writer* self)
+{
+    ATX_Byte trailer[8];
+    
+    /* end the frame, there is no one to report an error to */
+    if (ATX_SUCCEEDED(ATX_Lz4Writer_WriteBlock(self, self->buffer, self->buffered))) {
+        ATX_BytesFromInt32Le(trailer, 0);
+        ATX_BytesFromInt32Le(trailer+4, ATX_Lz4Checksum_Digest(&self->checksum));
+        ATX_OutputStream_WriteFully(self->sink, trailer, sizeof(trailer));
+    }
+    
+    ATX_RELEASE_OBJECT(self->sink);
+    ATX_FreeMemory((void*)self->buffer);
+    ATX_FreeMemory((void*)self->block);
+    ATX_FreeMemory((void*)self->table);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_Write
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Writer_Write(ATX_OutputStream* _self,
+                    ATX_AnyConst      buffer, 
+                    ATX_Size          bytes_to_write, 
+                    ATX_Size*         bytes_written)
+{
+    ATX_Lz4Writer*  self = ATX_SELF(ATX_Lz4Writer, ATX_OutputStream);
+    const ATX_Byte* data = (const ATX_Byte*)buffer;
+    ATX_Size        written = 0;
+    ATX_Result      result = ATX_SUCCESS;
+
+    if (bytes_written) *bytes_written = 0;
+    
+    while (written < bytes_to_write) {
+        ATX_Size chunk = bytes_to_write-written;
+        
+        if (self->buffered == 0 && chunk >= self->block_size) {
+            /* whole blocks are compressed from the caller's buffer */
+            chunk = self->block_size;
+            result = ATX_Lz4Writer_WriteBlock(self, data+written, chunk);
+            if (ATX_FAILED(result)) break;
+            ATX_Lz4Checksum_Update(&self->checksum, data+written, chunk);
+            written += chunk;
+            continue;
+        }
+        
+        /* accumulate a block */
+        if (chunk > self->block_size-self->buffered) {
+            chunk = self->block_size-self->buffered;
+        }
+        ATX_CopyMemory(self->buffer+self->buffered, data+written, chunk);
+        ATX_Lz4Checksum_Update(&self->checksum, data+written, chunk);
+        self->buffered += chunk;
+        written        += chunk;
+        if (self->buffered == self->block_size) {
+            result = ATX_Lz4Writer_WriteBlock(self, self->buffer, self->buffered);
+            self->buffered = 0;
+            if (ATX_FAILED(result)) break;
+        }
+    }
+    
+    self->position += written;
+    if (bytes_written) *bytes_written = written;
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Writer_Seek(ATX_OutputStream* _self, ATX_Position where)
+{
+    ATX_COMPILER_UNUSED(_self);
+    ATX_COMPILER_UNUSED(where);
+    
+    return ATX_ERROR_NOT_SUPPORTED;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Writer_Tell(ATX_OutputStream* _self, ATX_Position* where)
+{
+    ATX_Lz4Writer* self = ATX_SELF(ATX_Lz4Writer, ATX_OutputStream);
+    
+    if (where) *where = self->position;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_Flush
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Writer_Flush(ATX_OutputStream* _self)
+{
+    ATX_Lz4Writer* self = ATX_SELF(ATX_Lz4Writer, ATX_OutputStream);
+    ATX_Result     result;
+    
+    /* end the current block early */
+    result = ATX_Lz4Writer_WriteBlock(self, self->buffer, self->buffered);
+    self->buffered = 0;
+    if (ATX_FAILED(result)) return result;
+    
+    return ATX_OutputStream_Flush(self->sink);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Writer_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_Lz4Writer)
+    ATX_GET_INTERFACE_ACCEPT(ATX_Lz4Writer, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_Lz4Writer, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_OutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_Lz4Writer, ATX_OutputStream)
+    ATX_Lz4Writer_Write,
+    ATX_Lz4Writer_Seek,
+    ATX_Lz4Writer_Tell,
+    ATX_Lz4Writer_Flush
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_Lz4Writer, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader
++---------------------------------------------------------------------*/
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal     reference_count;
+    ATX_InputStream* source;
+    ATX_Boolean      in_frame;
+    ATX_UInt8        flags;
+    ATX_Size         block_max;
+    ATX_Byte*        block;
+    ATX_Size         block_capacity;
+    ATX_Byte*        buffer; /* history followed by the decompressed block */
+    ATX_Size         buffer_size;
+    ATX_Size         buffer_capacity;
+    ATX_Size         offset; /* start of the data not read yet */
+    ATX_Size         end;    /* end of the decompressed data   */
+    ATX_Lz4Checksum  checksum;
+    ATX_Position     position;
+} ATX_Lz4Reader;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_Lz4Reader, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_Lz4Reader, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4InputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Lz4InputStream_Create(ATX_InputStream*  source,
+                          ATX_InputStream** object)
+{
+    ATX_Lz4Reader* stream;
+    
+    /* default value */
+    *object = NULL;
+    
+    /* allocate new object, the buffers are allocated with the first frame */
+    stream = (ATX_Lz4Reader*)ATX_AllocateZeroMemory(sizeof(ATX_Lz4Reader));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+
+    /* construct object */
+    stream->reference_count = 1;
+    stream->source          = source;
+    stream->in_frame        = ATX_FALSE;
+    
+    /* keep a reference to the source stream */
+    ATX_REFERENCE_OBJECT(source);
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_Lz4Reader, ATX_InputStream);
+    ATX_SET_INTERFACE(stream, ATX_Lz4Reader, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_InputStream);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4Reader_Destroy(ATX_Lz4Reader* self)
+{
+    ATX_RELEASE_OBJECT(self->source);
+    ATX_FreeMemory((void*)self->block);
+    ATX_FreeMemory((void*)self->buffer);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_ReadSource
+|
+|   Read exactly size bytes from the source. Returns ATX_ERROR_EOS if
+|   the source ends before anything was read and eos_ok is true, and
+|   ATX_ERROR_INVALID_FORMAT if it ends anywhere else.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4Reader_ReadSource(ATX_Lz4Reader* self, 
+                         ATX_Byte*      buffer, 
+                         ATX_Size       size,
+                         ATX_Boolean    eos_ok)
+{
+    ATX_Size total = 0;
+    
+    while (total < size) {
+        ATX_Size   bytes_read = 0;
+        ATX_Result result = ATX_InputStream_Read(self->source, buffer+total, size-total, &bytes_read);
+        if (result == ATX_ERROR_EOS || (ATX_SUCCEEDED(result) && bytes_read == 0)) {
+            return (eos_ok && total == 0) ? ATX_ERROR_EOS : ATX_ERROR_INVALID_FORMAT;
+        }
+        if (ATX_FAILED(result)) return result;
+        total += bytes_read;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_ReadFrameHeader
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4Reader_ReadFrameHeader(ATX_Lz4Reader* self)
+{
+    ATX_Byte   header[15]; /* FLG, BD, content size, dictionary id, HC */
+    ATX_Size   header_size = 2;
+    ATX_UInt32 magic;
+    ATX_Size   buffer_size;
+    ATX_Result result;
+    
+    /* skip skippable frames */
+    for (;;) {
+        /* the end of the source here is the normal end of the stream */
+        result = ATX_Lz4Reader_ReadSource(self, header, 4, ATX_TRUE);
+        if (ATX_FAILED(result)) return result;
+        magic = ATX_BytesToInt32Le(header);
+        if (magic == ATX_LZ4_FRAME_MAGIC) break;
+        if ((magic & 0xFFFFFFF0) == ATX_LZ4_SKIPPABLE_MAGIC) {
+            ATX_UInt32 skip;
+            ATX_CHECK(ATX_Lz4Reader_ReadSource(self, header, 4, ATX_FALSE));
+            skip = ATX_BytesToInt32Le(header);
+            while (skip) {
+                ATX_Size chunk = skip > sizeof(header) ? sizeof(header) : skip;
+                ATX_CHECK(ATX_Lz4Reader_ReadSource(self, header, chunk, ATX_FALSE));
+                skip -= chunk;
+            }
+            continue;
+        }
+        return ATX_ERROR_INVALID_FORMAT;
+    }
+    
+    /* frame descriptor */
+    ATX_CHECK(ATX_Lz4Reader_ReadSource(self, header, 2, ATX_FALSE));
+    self->flags = header[0];
+    if ((self->flags & 0xC2) != ATX_LZ4_FRAME_VERSION || (header[1] & 0x8F)) {
+        return ATX_ERROR_INVALID_FORMAT;
+    }
+    if (((header[1] >> 4) & 7) < 4) return ATX_ERROR_INVALID_FORMAT;
+    self->block_max = (ATX_Size)1 << (2*((header[1] >> 4) & 7)+8);
+    if (self->flags & ATX_LZ4_FLAG_CONTENT_SIZE)  header_size += 8;
+    if (self->flags & ATX_LZ4_FLAG_DICTIONARY_ID) header_size += 4;
+    ATX_CHECK(ATX_Lz4Reader_ReadSource(self, header+2, header_size-2+1, ATX_FALSE));
+    if (header[header_size] != (ATX_Byte)(ATX_Lz4_Checksum(header, header_size) >> 8)) {
+        return ATX_ERROR_INVALID_FORMAT;
+    }
+    
+    /* there is no way to pass a dictionary */
+    if (self->flags & ATX_LZ4_FLAG_DICTIONARY_ID) return ATX_ERROR_NOT_SUPPORTED;
+    
+    /* linked blocks need the previous 64KB as history */
+    buffer_size = self->block_max;
+    if ((self->flags & ATX_LZ4_FLAG_INDEPENDENT) == 0) buffer_size += ATX_LZ4_HISTORY_SIZE;
+    if (self->block_capacity < self->block_max) {
+        ATX_FreeMemory((void*)self->block);
+        self->block = (ATX_Byte*)ATX_AllocateMemory(self->block_max);
+        self->block_capacity = self->block ? self->block_max : 0;
+        if (self->block == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    }
+    if (self->buffer_capacity < buffer_size) {
+        ATX_FreeMemory((void*)self->buffer);
+        self->buffer = (ATX_Byte*)ATX_AllocateMemory(buffer_size);
+        self->buffer_capacity = self->buffer ? buffer_size : 0;
+        if (self->buffer == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    }
+    self->buffer_size = buffer_size;
+    self->offset      = 0;
+    self->end         = 0;
+    self->in_frame    = ATX_TRUE;
+    ATX_Lz4Checksum_Init(&self->checksum);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_ReadBlock
+|
+|   Read and decompress the next block. The end of a frame leaves
+|   the buffer empty, and the end of the last frame returns 
+|   ATX_ERROR_EOS.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Lz4Reader_ReadBlock(ATX_Lz4Reader* self)
+{
+    ATX_Byte   field[4];
+    ATX_UInt32 block_size;
+    ATX_Size   history = 0;
+    ATX_Size   size;
+    ATX_Result result;
+    
+    if (!self->in_frame) {
+        result = ATX_Lz4Reader_ReadFrameHeader(self);
+        if (ATX_FAILED(result)) return result;
+    }
+    
+    /* block size, or end mark */
+    ATX_CHECK(ATX_Lz4Reader_ReadSource(self, field, 4, ATX_FALSE));
+    block_size = ATX_BytesToInt32Le(field);
+    if (block_size == 0) {
+        self->in_frame = ATX_FALSE;
+        self->offset   = self->end;
+        if (self->flags & ATX_LZ4_FLAG_CONTENT_CHECKSUM) {
+            ATX_CHECK(ATX_Lz4Reader_ReadSource(self, field, 4, ATX_FALSE));
+            if (ATX_BytesToInt32Le(field) != ATX_Lz4Checksum_Digest(&self->checksum)) {
+                return ATX_ERROR_INVALID_FORMAT;
+            }
+        }
+        return ATX_SUCCESS;
+    }
+    size = block_size & ~ATX_LZ4_BLOCK_UNCOMPRESSED;
+    if (size > self->block_max) return ATX_ERROR_INVALID_FORMAT;
+    
+    /* make room, keeping the history for linked blocks */
+    if (self->flags & ATX_LZ4_FLAG_INDEPENDENT) {
+        self->end = 0;
+    } else {
+        if (self->end+self->block_max > self->buffer_size) {
+            ATX_MoveMemory(self->buffer, 
+                           self->buffer+self->end-ATX_LZ4_HISTORY_SIZE, 
+                           ATX_LZ4_HISTORY_SIZE);
+            self->end = ATX_LZ4_HISTORY_SIZE;
+        }
+        history = self->end;
+    }
+    
+    /* read the block data */
+    ATX_CHECK(ATX_Lz4Reader_ReadSource(self, self->block, size, ATX_FALSE));
+    if (self->flags & ATX_LZ4_FLAG_BLOCK_CHECKSUM) {
+        ATX_CHECK(ATX_Lz4Reader_ReadSource(self, field, 4, ATX_FALSE));
+        if (ATX_BytesToInt32Le(field) != ATX_Lz4_Checksum(self->block, size)) {
+            return ATX_ERROR_INVALID_FORMAT;
+        }
+    }
+    if (block_size & ATX_LZ4_BLOCK_UNCOMPRESSED) {
+        ATX_CopyMemory(self->buffer+self->end, self->block, size);
+    } else {
+        ATX_CHECK(ATX_Lz4_Decompress(self->block, 
+                                     size, 
+                                     self->buffer+self->end, 
+                                     self->block_max, 
+                                     history,
+                                     &size));
+    }
+    if (self->flags & ATX_LZ4_FLAG_CONTENT_CHECKSUM) {
+        ATX_Lz4Checksum_Update(&self->checksum, self->buffer+self->end, size);
+    }
+    self->offset = self->end;
+    self->end   += size;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_Read
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Reader_Read(ATX_InputStream* _self,
+                   ATX_Any          buffer, 
+                   ATX_Size         bytes_to_read, 
+                   ATX_Size*        bytes_read)
+{
+    ATX_Lz4Reader* self = ATX_SELF(ATX_Lz4Reader, ATX_InputStream);
+    ATX_Size       available;
+
+    if (bytes_read) *bytes_read = 0;
+    if (bytes_to_read == 0) return ATX_SUCCESS;
+    
+    while (self->offset == self->end) {
+        ATX_Result result = ATX_Lz4Reader_ReadBlock(self);
+        if (ATX_FAILED(result)) return result;
+    }
+    
+    available = self->end-self->offset;
+    if (bytes_to_read > available) bytes_to_read = available;
+    ATX_CopyMemory(buffer, self->buffer+self->offset, bytes_to_read);
+    self->offset   += bytes_to_read;
+    self->position += bytes_to_read;
+    if (bytes_read) *bytes_read = bytes_to_read;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Reader_Seek(ATX_InputStream* _self, ATX_Position where)
+{
+    ATX_COMPILER_UNUSED(_self);
+    ATX_COMPILER_UNUSED(where);
+    
+    return ATX_ERROR_NOT_SUPPORTED;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Reader_Tell(ATX_InputStream* _self, ATX_Position* where)
+{
+    ATX_Lz4Reader* self = ATX_SELF(ATX_Lz4Reader, ATX_InputStream);
+    
+    if (where) *where = self->position;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_GetSize
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Reader_GetSize(ATX_InputStream* _self, ATX_LargeSize* size)
+{
+    ATX_COMPILER_UNUSED(_self);
+    
+    *size = 0;
+    return ATX_ERROR_NOT_SUPPORTED;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_Lz4Reader_GetAvailable(ATX_InputStream* _self, ATX_LargeSize* available)
+{
+    ATX_Lz4Reader* self = ATX_SELF(ATX_Lz4Reader, ATX_InputStream);
+    
+    *available = self->end-self->offset;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Lz4Reader_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_Lz4Reader)
+    ATX_GET_INTERFACE_ACCEPT(ATX_Lz4Reader, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_Lz4Reader, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_Lz4Reader, ATX_InputStream)
+    ATX_Lz4Reader_Read,
+    ATX_Lz4Reader_Seek,
+    ATX_Lz4Reader_Tell,
+    ATX_Lz4Reader_GetSize,
+    ATX_Lz4Reader_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_Lz4Reader, reference_count)
@@ -0,0 +1,107 @@
+/*****************************************************************
+|
+|   Atomix - LZ4 Compression
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_LZ4_H_
+#define _ATX_LZ4_H_
+
+/*----------------------------------------------------------------------
+|    includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxStreams.h"
+
+/*----------------------------------------------------------------------
+|    constants
++---------------------------------------------------------------------*/
+#define ATX_LZ4_DEFAULT_BLOCK_SIZE 65536
+#define ATX_LZ4_MAX_BLOCK_SIZE     0x400000 /* 4MB */
+
+/*----------------------------------------------------------------------
+|    prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Size of the largest output ATX_Lz4_CompressBlock can produce for an
+ * input of the given size.
+ */
+ATX_Size   ATX_Lz4_GetMaxCompressedSize(ATX_Size size);
+
+/**
+ * Compress a buffer into a single LZ4 block (raw block format, without
+ * the frame around it).
+ */
+ATX_Result ATX_Lz4_CompressBlock(const ATX_Byte* in, 
+                                 ATX_Size        in_size, 
+                                 ATX_Byte*       out, 
+                                 ATX_Size        out_size, 
+                                 ATX_Size*       compressed_size);
+
+/**
+ * Decompress a single LZ4 block. Returns ATX_ERROR_INVALID_FORMAT if
+ * the block is corrupt or doesn't fit in the output buffer. The bytes
+ * of the output buffer after the decompressed data may be overwritten.
+ */
+ATX_Result ATX_Lz4_DecompressBlock(const ATX_Byte* in, 
+                                   ATX_Size        in_size, 
+                                   ATX_Byte*       out, 
+                                   ATX_Size        out_size, 
+                                   ATX_Size*       decompressed_size);
+
+/**
+ * Create an output stream that compresses what is written to it into 
+ * an LZ4 frame written to a sink stream. Each block is compressed 
+ * independently, and the frame carries a content checksum. 
+ * Flushing the stream ends the current block. The frame is completed
+ * when the stream is released.
+ * @param block_size Maximum size of the uncompressed blocks, rounded
+ * up to 64KB, 256KB, 1MB or 4MB, or 0 for the default size.
+ */
+ATX_Result ATX_Lz4OutputStream_Create(ATX_OutputStream*  sink,
+                                      ATX_Size           block_size,
+                                      ATX_OutputStream** stream);
+
+/**
+ * Create an input stream that decompresses LZ4 frames read from a 
+ * source stream. Linked and independent blocks, block and content 
+ * checksums, concatenated frames and skippable frames are supported.
+ */
+ATX_Result ATX_Lz4InputStream_Create(ATX_InputStream*  source,
+                                     ATX_InputStream** stream);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _ATX_LZ4_H_ */
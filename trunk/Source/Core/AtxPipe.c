@@ -0,0 +1,588 @@
+/*****************************************************************
+|
+|   Atomix - Pipes
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxUtils.h"
+#include "AtxStreams.h"
+#include "AtxReferenceable.h"
+#include "AtxRingBuffer.h"
+#include "AtxThreads.h"
+#include "AtxPipe.h"
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/* state shared by the two ends, protected by the lock */
+typedef struct {
+    ATX_Mutex*      lock;
+    ATX_Condition*  can_read;
+    ATX_Condition*  can_write;
+    ATX_RingBuffer* ring;
+    ATX_Size        capacity;
+    ATX_Boolean     input_closed;
+    ATX_Boolean     output_closed;
+    ATX_Boolean     reader_waiting;
+    ATX_Size        writer_waiting; /* space the writer waits for, or 0 */
+    ATX_Cardinal    open_ends;
+} ATX_Pipe;
+
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_PipeInputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal reference_count;
+    ATX_Pipe*    pipe;
+    ATX_Position position;
+} ATX_PipeReader;
+
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_PipeOutputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal reference_count;
+    ATX_Pipe*    pipe;
+    ATX_Position position;
+} ATX_PipeWriter;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_PipeReader, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_PipeReader, ATX_PipeInputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_PipeReader, ATX_Referenceable)
+ATX_DECLARE_INTERFACE_MAP(ATX_PipeWriter, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_PipeWriter, ATX_PipeOutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_PipeWriter, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_Pipe_Destroy
++---------------------------------------------------------------------*/
+static void
+ATX_Pipe_Destroy(ATX_Pipe* self)
+{
+    ATX_Condition_Destroy(self->can_read);
+    ATX_Condition_Destroy(self->can_write);
+    ATX_Mutex_Destroy(self->lock);
+    if (self->ring) ATX_RingBuffer_Destroy(self->ring);
+    ATX_FreeMemory((void*)self);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Pipe_CloseEnd
+|
+|   Mark one end as closed and wake up the other side.
++---------------------------------------------------------------------*/
+static void
+ATX_Pipe_CloseEnd(ATX_Pipe* self, ATX_Boolean input)
+{
+    ATX_Mutex_Lock(self->lock);
+    if (input) {
+        self->input_closed = ATX_TRUE;
+        if (self->writer_waiting) ATX_Condition_Signal(self->can_write);
+    } else {
+        self->output_closed = ATX_TRUE;
+        if (self->reader_waiting) ATX_Condition_Signal(self->can_read);
+    }
+    ATX_Mutex_Unlock(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Pipe_Release
+|
+|   Close one end and destroy the pipe when both are gone.
++---------------------------------------------------------------------*/
+static void
+ATX_Pipe_Release(ATX_Pipe* self, ATX_Boolean input)
+{
+    ATX_Cardinal open_ends;
+    
+    ATX_Pipe_CloseEnd(self, input);
+    ATX_Mutex_Lock(self->lock);
+    open_ends = --self->open_ends;
+    ATX_Mutex_Unlock(self->lock);
+    
+    if (open_ends == 0) ATX_Pipe_Destroy(self);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Pipe_WaitForData
+|
+|   Called with the lock held.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Pipe_WaitForData(ATX_Pipe* self)
+{
+    ATX_Result result;
+    
+    if (self->input_closed) return ATX_ERROR_EOS;
+    while (ATX_RingBuffer_GetAvailable(self->ring) == 0) {
+        if (self->output_closed) return ATX_ERROR_EOS;
+        self->reader_waiting = ATX_TRUE;
+        result = ATX_Condition_Wait(self->can_read, self->lock);
+        self->reader_waiting = ATX_FALSE;
+        if (ATX_FAILED(result)) return result;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Pipe_Consume
+|
+|   Called with the lock held. The writer is only woken up once there is
+|   room for what it is waiting for, rather than for every read.
++---------------------------------------------------------------------*/
+static void
+ATX_Pipe_Consume(ATX_Pipe* self, ATX_Size size)
+{
+    ATX_RingBuffer_MoveOut(self->ring, size);
+    if (self->writer_waiting && 
+        ATX_RingBuffer_GetSpace(self->ring) >= self->writer_waiting) {
+        ATX_Condition_Signal(self->can_write);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Pipe_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Pipe_Create(ATX_Size           capacity,
+                ATX_InputStream**  input,
+                ATX_OutputStream** output)
+{
+    ATX_Pipe*       pipe;
+    ATX_PipeReader* reader = NULL;
+    ATX_PipeWriter* writer = NULL;
+    ATX_Result      result;
+    
+    /* default return values */
+    *input  = NULL;
+    *output = NULL;
+    if (capacity == 0) capacity = ATX_PIPE_DEFAULT_CAPACITY;
+    
+    /* create the shared state */
+    pipe = (ATX_Pipe*)ATX_AllocateZeroMemory(sizeof(ATX_Pipe));
+    if (pipe == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    pipe->capacity  = capacity;
+    pipe->open_ends = 2;
+    result = ATX_Mutex_Create(&pipe->lock);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&pipe->can_read);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&pipe->can_write);
+    if (ATX_FAILED(result)) goto fail;
+    
+    /* the ring buffer keeps one byte free to tell full from empty */
+    result = ATX_RingBuffer_Create(capacity+1, &pipe->ring);
+    if (ATX_FAILED(result)) goto fail;
+    
+    /* create the two ends */
+    reader = (ATX_PipeReader*)ATX_AllocateZeroMemory(sizeof(ATX_PipeReader));
+    writer = (ATX_PipeWriter*)ATX_AllocateZeroMemory(sizeof(ATX_PipeWriter));
+    if (reader == NULL || writer == NULL) {
+        result = ATX_ERROR_OUT_OF_MEMORY;
+        goto fail;
+    }
+    reader->reference_count = 1;
+    reader->pipe            = pipe;
+    writer->reference_count = 1;
+    writer->pipe            = pipe;
+    
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(reader, ATX_PipeReader, ATX_InputStream);
+    ATX_SET_INTERFACE(reader, ATX_PipeReader, ATX_PipeInputStream);
+    ATX_SET_INTERFACE(reader, ATX_PipeReader, ATX_Referenceable);
+    ATX_SET_INTERFACE(writer, ATX_PipeWriter, ATX_OutputStream);
+    ATX_SET_INTERFACE(writer, ATX_PipeWriter, ATX_PipeOutputStream);
+    ATX_SET_INTERFACE(writer, ATX_PipeWriter, ATX_Referenceable);
+    *input  = &ATX_BASE(reader, ATX_InputStream);
+    *output = &ATX_BASE(writer, ATX_OutputStream);
+    
+    return ATX_SUCCESS;
+    
+fail:
+    if (reader) ATX_FreeMemory((void*)reader);
+    if (writer) ATX_FreeMemory((void*)writer);
+    ATX_Pipe_Destroy(pipe);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_PipeReader_Destroy(ATX_PipeReader* self)
+{
+    ATX_Pipe_Release(self->pipe, ATX_TRUE);
+    ATX_FreeMemory((void*)self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_Read
+|
+|   The data is copied without holding the lock: only the reader moves 
+|   the read pointer, so the writer can't touch the region meanwhile.
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_Read(ATX_InputStream* _self,
+                    ATX_Any          buffer,
+                    ATX_Size         bytes_to_read,
+                    ATX_Size*        bytes_read)
+{
+    ATX_PipeReader* self = ATX_SELF(ATX_PipeReader, ATX_InputStream);
+    ATX_Pipe*       pipe = self->pipe;
+    ATX_Byte*       out  = (ATX_Byte*)buffer;
+    ATX_Size        total = 0;
+    ATX_Result      result;
+    
+    if (bytes_read) *bytes_read = 0;
+    if (bytes_to_read == 0) return ATX_SUCCESS;
+    
+    ATX_Mutex_Lock(pipe->lock);
+    result = ATX_Pipe_WaitForData(pipe);
+    while (ATX_SUCCEEDED(result) && total < bytes_to_read) {
+        const ATX_Byte* region = ATX_RingBuffer_GetOut(pipe->ring);
+        ATX_Size        chunk  = ATX_RingBuffer_GetContiguousAvailable(pipe->ring);
+        
+        if (chunk == 0) break;
+        if (chunk > bytes_to_read-total) chunk = bytes_to_read-total;
+        ATX_Mutex_Unlock(pipe->lock);
+        ATX_CopyMemory(out+total, region, chunk);
+        ATX_Mutex_Lock(pipe->lock);
+        ATX_Pipe_Consume(pipe, chunk);
+        total += chunk;
+    }
+    ATX_Mutex_Unlock(pipe->lock);
+    
+    if (total == 0) return result;
+    self->position += total;
+    if (bytes_read) *bytes_read = total;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_Seek(ATX_InputStream* _self, ATX_Position where)
+{
+    ATX_COMPILER_UNUSED(_self);
+    ATX_COMPILER_UNUSED(where);
+    return ATX_ERROR_NOT_SUPPORTED;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_Tell(ATX_InputStream* _self, ATX_Position* where)
+{
+    ATX_PipeReader* self = ATX_SELF(ATX_PipeReader, ATX_InputStream);
+    if (where) *where = self->position;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_GetSize
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_GetSize(ATX_InputStream* _self, ATX_LargeSize* size)
+{
+    ATX_COMPILER_UNUSED(_self);
+    if (size) *size = 0;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_GetAvailable(ATX_InputStream* _self, ATX_LargeSize* available)
+{
+    ATX_PipeReader* self = ATX_SELF(ATX_PipeReader, ATX_InputStream);
+    
+    ATX_Mutex_Lock(self->pipe->lock);
+    *available = ATX_RingBuffer_GetAvailable(self->pipe->ring);
+    ATX_Mutex_Unlock(self->pipe->lock);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_GetReadRegion
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_GetReadRegion(ATX_PipeInputStream* _self,
+                             const ATX_Byte**     region,
+                             ATX_Size*            region_size)
+{
+    ATX_PipeReader* self = ATX_SELF(ATX_PipeReader, ATX_PipeInputStream);
+    ATX_Pipe*       pipe = self->pipe;
+    ATX_Result      result;
+    
+    *region      = NULL;
+    *region_size = 0;
+    
+    ATX_Mutex_Lock(pipe->lock);
+    result = ATX_Pipe_WaitForData(pipe);
+    if (ATX_SUCCEEDED(result)) {
+        *region      = ATX_RingBuffer_GetOut(pipe->ring);
+        *region_size = ATX_RingBuffer_GetContiguousAvailable(pipe->ring);
+    }
+    ATX_Mutex_Unlock(pipe->lock);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_CommitRead
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_CommitRead(ATX_PipeInputStream* _self, ATX_Size size)
+{
+    ATX_PipeReader* self = ATX_SELF(ATX_PipeReader, ATX_PipeInputStream);
+    ATX_Pipe*       pipe = self->pipe;
+    ATX_Result      result = ATX_SUCCESS;
+    
+    ATX_Mutex_Lock(pipe->lock);
+    if (size > ATX_RingBuffer_GetContiguousAvailable(pipe->ring)) {
+        result = ATX_ERROR_INVALID_PARAMETERS;
+    } else {
+        ATX_Pipe_Consume(pipe, size);
+        self->position += size;
+    }
+    ATX_Mutex_Unlock(pipe->lock);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_Close
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeReader_Close(ATX_PipeInputStream* _self)
+{
+    ATX_PipeReader* self = ATX_SELF(ATX_PipeReader, ATX_PipeInputStream);
+    ATX_Pipe_CloseEnd(self->pipe, ATX_TRUE);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeReader_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_PipeReader)
+    ATX_GET_INTERFACE_ACCEPT(ATX_PipeReader, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_PipeReader, ATX_PipeInputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_PipeReader, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_PipeReader, ATX_InputStream)
+    ATX_PipeReader_Read,
+    ATX_PipeReader_Seek,
+    ATX_PipeReader_Tell,
+    ATX_PipeReader_GetSize,
+    ATX_PipeReader_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_PipeInputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_PipeReader, ATX_PipeInputStream)
+    ATX_PipeReader_GetReadRegion,
+    ATX_PipeReader_CommitRead,
+    ATX_PipeReader_Close
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_PipeReader, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_PipeWriter_Destroy(ATX_PipeWriter* self)
+{
+    ATX_Pipe_Release(self->pipe, ATX_FALSE);
+    ATX_FreeMemory((void*)self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_Write
+|
+|   Waits until everything is written, or the pipe is closed. When
+|   waiting, the writer asks for room for half the pipe (or what is 
+|   left to write) so that it isn't woken up for every small read.
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeWriter_Write(ATX_OutputStream* _self,
+                     ATX_AnyConst      buffer,
+                     ATX_Size          bytes_to_write,
+                     ATX_Size*         bytes_written)
+{
+    ATX_PipeWriter* self = ATX_SELF(ATX_PipeWriter, ATX_OutputStream);
+    ATX_Pipe*       pipe = self->pipe;
+    const ATX_Byte* in   = (const ATX_Byte*)buffer;
+    ATX_Size        total = 0;
+    ATX_Result      result = ATX_SUCCESS;
+    
+    ATX_Mutex_Lock(pipe->lock);
+    while (total < bytes_to_write) {
+        ATX_Byte* region;
+        ATX_Size  chunk;
+        
+        if (pipe->input_closed || pipe->output_closed) {
+            result = ATX_ERROR_PIPE_CLOSED;
+            break;
+        }
+        
+        chunk = ATX_RingBuffer_GetContiguousSpace(pipe->ring);
+        if (chunk == 0) {
+            ATX_Size wanted = bytes_to_write-total;
+            if (wanted > (pipe->capacity+1)/2) wanted = (pipe->capacity+1)/2;
+            pipe->writer_waiting = wanted;
+            result = ATX_Condition_Wait(pipe->can_write, pipe->lock);
+            pipe->writer_waiting = 0;
+            if (ATX_FAILED(result)) break;
+            continue;
+        }
+        
+        if (chunk > bytes_to_write-total) chunk = bytes_to_write-total;
+        region = ATX_RingBuffer_GetIn(pipe->ring);
+        ATX_Mutex_Unlock(pipe->lock);
+        ATX_CopyMemory(region, in+total, chunk);
+        ATX_Mutex_Lock(pipe->lock);
+        ATX_RingBuffer_MoveIn(pipe->ring, chunk);
+        if (pipe->reader_waiting) ATX_Condition_Signal(pipe->can_read);
+        total += chunk;
+    }
+    ATX_Mutex_Unlock(pipe->lock);
+    
+    self->position += total;
+    if (bytes_written) *bytes_written = total;
+    
+    return total ? ATX_SUCCESS : result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeWriter_Seek(ATX_OutputStream* _self, ATX_Position where)
+{
+    ATX_COMPILER_UNUSED(_self);
+    ATX_COMPILER_UNUSED(where);
+    return ATX_ERROR_NOT_SUPPORTED;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeWriter_Tell(ATX_OutputStream* _self, ATX_Position* where)
+{
+    ATX_PipeWriter* self = ATX_SELF(ATX_PipeWriter, ATX_OutputStream);
+    if (where) *where = self->position;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_Flush
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeWriter_Flush(ATX_OutputStream* _self)
+{
+    /* the data is visible to the reader as soon as it is written */
+    ATX_COMPILER_UNUSED(_self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_Close
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_PipeWriter_Close(ATX_PipeOutputStream* _self)
+{
+    ATX_PipeWriter* self = ATX_SELF(ATX_PipeWriter, ATX_PipeOutputStream);
+    ATX_Pipe_CloseEnd(self->pipe, ATX_FALSE);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_PipeWriter_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_PipeWriter)
+    ATX_GET_INTERFACE_ACCEPT(ATX_PipeWriter, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_PipeWriter, ATX_PipeOutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_PipeWriter, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_OutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_PipeWriter, ATX_OutputStream)
+    ATX_PipeWriter_Write,
+    ATX_PipeWriter_Seek,
+    ATX_PipeWriter_Tell,
+    ATX_PipeWriter_Flush
+};
+
+/*----------------------------------------------------------------------
+|   ATX_PipeOutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_PipeWriter, ATX_PipeOutputStream)
+    ATX_PipeWriter_Close
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_PipeWriter, reference_count)
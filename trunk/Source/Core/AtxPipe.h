@@ -0,0 +1,124 @@
+/*****************************************************************
+|
+|   Atomix - Pipes
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_PIPE_H_
+#define _ATX_PIPE_H_
+
+/*----------------------------------------------------------------------
+|    includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxInterfaces.h"
+#include "AtxStreams.h"
+
+/*----------------------------------------------------------------------
+|    error codes
++---------------------------------------------------------------------*/
+#define ATX_ERROR_PIPE_CLOSED (ATX_ERROR_BASE_BYTE_STREAM - 1)
+
+/*----------------------------------------------------------------------
+|    constants
++---------------------------------------------------------------------*/
+#define ATX_PIPE_DEFAULT_CAPACITY 65536
+
+/*----------------------------------------------------------------------
+|   ATX_PipeInputStream
++---------------------------------------------------------------------*/
+/**
+ * Interface implemented by the input end of a pipe.
+ * GetReadRegion waits until data is available and returns the largest
+ * contiguous run of it, without copying. The region stays valid until 
+ * CommitRead consumes some or all of it. It returns ATX_ERROR_EOS once 
+ * the output end is closed and everything was read.
+ * Close makes further writes to the pipe fail with ATX_ERROR_PIPE_CLOSED.
+ */
+ATX_DECLARE_INTERFACE(ATX_PipeInputStream)
+ATX_BEGIN_INTERFACE_DEFINITION(ATX_PipeInputStream)
+    ATX_Result (*GetReadRegion)(ATX_PipeInputStream* self,
+                                const ATX_Byte**     region,
+                                ATX_Size*            region_size);
+    ATX_Result (*CommitRead)(ATX_PipeInputStream* self, ATX_Size size);
+    ATX_Result (*Close)(ATX_PipeInputStream* self);
+ATX_END_INTERFACE_DEFINITION
+
+#define ATX_PipeInputStream_GetReadRegion(object, region, region_size) \
+ATX_INTERFACE(object)->GetReadRegion(object, region, region_size)
+
+#define ATX_PipeInputStream_CommitRead(object, size) \
+ATX_INTERFACE(object)->CommitRead(object, size)
+
+#define ATX_PipeInputStream_Close(object) \
+ATX_INTERFACE(object)->Close(object)
+
+/*----------------------------------------------------------------------
+|   ATX_PipeOutputStream
++---------------------------------------------------------------------*/
+/**
+ * Interface implemented by the output end of a pipe.
+ * Close signals the end of the stream: the reader gets ATX_ERROR_EOS
+ * after it has read what was written before.
+ */
+ATX_DECLARE_INTERFACE(ATX_PipeOutputStream)
+ATX_BEGIN_INTERFACE_DEFINITION(ATX_PipeOutputStream)
+    ATX_Result (*Close)(ATX_PipeOutputStream* self);
+ATX_END_INTERFACE_DEFINITION
+
+#define ATX_PipeOutputStream_Close(object) \
+ATX_INTERFACE(object)->Close(object)
+
+/*----------------------------------------------------------------------
+|    prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Create a pipe: bytes written to the output stream can be read from the
+ * input stream, typically by another thread. 
+ * Reads wait until data is available, and writes wait until the reader 
+ * has made room for all of their data. Releasing the last reference to 
+ * one end closes it, like the Close method of its pipe interface.
+ * The input stream implements ATX_PipeInputStream and the output stream 
+ * implements ATX_PipeOutputStream.
+ * @param capacity Number of bytes the pipe can hold, or 0 for
+ * ATX_PIPE_DEFAULT_CAPACITY.
+ */
+ATX_Result ATX_Pipe_Create(ATX_Size           capacity,
+                           ATX_InputStream**  input,
+                           ATX_OutputStream** output);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _ATX_PIPE_H_ */
@@ -532,6 +532,7 @@ ATX_PropertyValue_Clone(const ATX_PropertyValue* self, ATX_PropertyValue* clone)
       case ATX_PROPERTY_VALUE_TYPE_FLOAT:
       case ATX_PROPERTY_VALUE_TYPE_BOOLEAN:
       case ATX_PROPERTY_VALUE_TYPE_POINTER:
+      case ATX_PROPERTY_VALUE_TYPE_LARGE_INTEGER:
         clone->data = self->data;
         break;
 
@@ -61,7 +61,8 @@ typedef enum {
     ATX_PROPERTY_VALUE_TYPE_STRING,   /**< The value is a string                */
     ATX_PROPERTY_VALUE_TYPE_BOOLEAN,  /**< The value is a boolean               */
     ATX_PROPERTY_VALUE_TYPE_RAW_DATA, /**< The value is a raw data block        */
-    ATX_PROPERTY_VALUE_TYPE_POINTER   /**< The value is a pointer               */
+    ATX_PROPERTY_VALUE_TYPE_POINTER,  /**< The value is a pointer               */
+    ATX_PROPERTY_VALUE_TYPE_LARGE_INTEGER /**< The value is a 64-bit integer    */
 } ATX_PropertyValueType;
 
 typedef struct {
@@ -77,6 +78,7 @@ typedef union {
     const void*         pointer;  /**< A pointer                 */
     ATX_CString         string;   /**< A character string        */
     ATX_Int32           integer;  /**< An integer number         */
+    ATX_Int64           large_integer; /**< A 64-bit integer number */
     ATX_Float           fp;       /**< A floating point number   */
     ATX_Boolean         boolean;  /**< A boolean value           */
     ATX_PropertyRawData raw_data; /**< A pointer to untyped data */
@@ -42,6 +42,7 @@
 #include "AtxDefs.h"
 #include "AtxTypes.h"
 #include "AtxDebug.h"
+#include "AtxAtomic.h"
 
 /*----------------------------------------------------------------------
 |   ATX_Referenceable interface
@@ -129,45 +130,55 @@ do {                                                          \
     }                                                         \
 } while(0)
 
-#define ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(_class, _counter)    \
-ATX_METHOD _class##_AddReference(ATX_Referenceable* _self)         \
-{                                                                  \
-    _class* self = ATX_SELF(_class, ATX_Referenceable);            \
-    self->_counter++;                                              \
-    return ATX_SUCCESS;                                            \
-}                                                                  \
-ATX_METHOD _class##_Release(ATX_Referenceable* _self)              \
-{                                                                  \
-    _class* self = ATX_SELF(_class, ATX_Referenceable);            \
-    if (--self->_counter == 0) {                                   \
-        _class##_Destroy(self);                                    \
-    }                                                              \
-    return ATX_SUCCESS;                                            \
-}                                                                  \
-ATX_BEGIN_INTERFACE_MAP(_class, ATX_Referenceable)                 \
-    _class##_AddReference,                                         \
-    _class##_Release                                               \
+/**
+ * Implement the ATX_Referenceable interface of a class with a 32-bit
+ * counter member, and a _class##_Destroy function that is called when
+ * the counter drops to 0. The counter is updated atomically, so objects
+ * can be referenced and released from several threads: a reference is
+ * taken with a relaxed increment (it is only ever taken through another
+ * reference), and released with an acquire-release decrement so that 
+ * the thread that destroys the object sees all the writes made to it.
+ */
+#define ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(_class, _counter)         \
+ATX_METHOD _class##_AddReference(ATX_Referenceable* _self)              \
+{                                                                       \
+    _class* self = ATX_SELF(_class, ATX_Referenceable);                 \
+    ATX_Atomic_Add(&self->_counter, 1, ATX_ATOMIC_RELAXED);             \
+    return ATX_SUCCESS;                                                 \
+}                                                                       \
+ATX_METHOD _class##_Release(ATX_Referenceable* _self)                   \
+{                                                                       \
+    _class* self = ATX_SELF(_class, ATX_Referenceable);                 \
+    if (ATX_Atomic_Add(&self->_counter, -1, ATX_ATOMIC_ACQ_REL) == 0) { \
+        _class##_Destroy(self);                                         \
+    }                                                                   \
+    return ATX_SUCCESS;                                                 \
+}                                                                       \
+ATX_BEGIN_INTERFACE_MAP(_class, ATX_Referenceable)                      \
+    _class##_AddReference,                                              \
+    _class##_Release                                                    \
 };         
 
-#define ATX_IMPLEMENT_REFERENCEABLE_INTERFACE_EX(_class, _base, _counter) \
-ATX_METHOD _class##_AddReference(ATX_Referenceable* _self)                \
-{                                                                         \
-    _class* self = ATX_SELF_EX(_class, _base, ATX_Referenceable);         \
-    ATX_BASE(self, _base)._counter++;                                     \
-    return ATX_SUCCESS;                                                   \
-}                                                                         \
-ATX_METHOD _class##_Release(ATX_Referenceable* _self)                     \
-{                                                                         \
-    _class* self = ATX_SELF_EX(_class, _base, ATX_Referenceable);         \
-    ATX_ASSERT(ATX_BASE(self, _base)._counter != 0);                      \
-    if (--ATX_BASE(self, _base)._counter == 0) {                          \
-        _class##_Destroy(self);                                           \
-    }                                                                     \
-    return ATX_SUCCESS;                                                   \
-}                                                                         \
-ATX_BEGIN_INTERFACE_MAP_EX(_class, _base, ATX_Referenceable)              \
-    _class##_AddReference,                                                \
-    _class##_Release                                                      \
+#define ATX_IMPLEMENT_REFERENCEABLE_INTERFACE_EX(_class, _base, _counter)   \
+ATX_METHOD _class##_AddReference(ATX_Referenceable* _self)                  \
+{                                                                           \
+    _class* self = ATX_SELF_EX(_class, _base, ATX_Referenceable);           \
+    ATX_Atomic_Add(&ATX_BASE(self, _base)._counter, 1, ATX_ATOMIC_RELAXED); \
+    return ATX_SUCCESS;                                                     \
+}                                                                           \
+ATX_METHOD _class##_Release(ATX_Referenceable* _self)                       \
+{                                                                           \
+    _class* self = ATX_SELF_EX(_class, _base, ATX_Referenceable);           \
+    ATX_ASSERT(ATX_BASE(self, _base)._counter != 0);                        \
+    if (ATX_Atomic_Add(&ATX_BASE(self, _base)._counter, -1,                 \
+                       ATX_ATOMIC_ACQ_REL) == 0) {                          \
+        _class##_Destroy(self);                                             \
+    }                                                                       \
+    return ATX_SUCCESS;                                                     \
+}                                                                           \
+ATX_BEGIN_INTERFACE_MAP_EX(_class, _base, ATX_Referenceable)                \
+    _class##_AddReference,                                                  \
+    _class##_Release                                                        \
 };         
 
 #endif /* _ATX_REFERENCEABLE_H_ */
@@ -37,6 +37,22 @@
 #include "AtxDefs.h"
 #include "AtxRingBuffer.h"
 #include "AtxResults.h"
+#include "AtxStreams.h"
+#include "AtxSockets.h"
+#include "AtxUtils.h"
+
+#if defined(ATX_CONFIG_HAVE_MEMFD)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(ATX_CONFIG_HAVE_READV)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
 
 /*----------------------------------------------------------------------
 |   types
@@ -49,6 +65,7 @@ struct ATX_RingBuffer {
     unsigned char* in;
     unsigned char* out;
     ATX_Size       size;
+    ATX_Boolean    mirrored; /* the data is mapped a second time at data.end */
 };
 
 /*----------------------------------------------------------------------
@@ -67,6 +84,7 @@ ATX_RingBuffer_Create(ATX_Size size, ATX_RingBuffer** buffer)
     }
     
     /* construct the object */
+    ring->mirrored       = ATX_FALSE;
     ring->size           = size;
     ring->data.start     = ATX_AllocateZeroMemory(size);
     ring->data.end       = ring->data.start + size;
@@ -81,6 +99,93 @@ ATX_RingBuffer_Create(ATX_Size size, ATX_RingBuffer** buffer)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_RingBuffer_MapMirrored
+|
+|   Map the same pages twice, back to back, using an anonymous memory file.
++---------------------------------------------------------------------*/
+#if defined(ATX_CONFIG_HAVE_MEMFD) && defined(SYS_memfd_create)
+static ATX_Result
+ATX_RingBuffer_MapMirrored(ATX_Size size, unsigned char** memory)
+{
+    unsigned char* base;
+    void*          mapping;
+    ATX_Result     result = ATX_SUCCESS;
+    int            fd;
+
+    /* create the memory file */
+    fd = (int)syscall(SYS_memfd_create, "atx-ring-buffer", 0);
+    if (fd < 0) return ATX_ERROR_ERRNO(errno);
+    if (ftruncate(fd, (off_t)size)) {
+        result = ATX_ERROR_ERRNO(errno);
+        close(fd);
+        return result;
+    }
+
+    /* reserve an address range for the two views */
+    mapping = mmap(NULL, 2*size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+    base = (unsigned char*)mapping;
+
+    /* map the file over both halves of the range */
+    if (mmap(base,      size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base+size, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) == MAP_FAILED) {
+        result = ATX_ERROR_OUT_OF_MEMORY;
+        munmap(base, 2*size);
+        base = NULL;
+    }
+
+    /* the mappings keep the memory alive */
+    close(fd);
+    *memory = base;
+
+    return result;
+}
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_RingBuffer_CreateMirrored
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_CreateMirrored(ATX_Size size, ATX_RingBuffer** buffer)
+{
+#if defined(ATX_CONFIG_HAVE_MEMFD) && defined(SYS_memfd_create)
+    ATX_RingBuffer* ring;
+    ATX_Size        page_size = (ATX_Size)sysconf(_SC_PAGESIZE);
+    ATX_Result      result;
+
+    /* round the size up to a whole number of pages */
+    *buffer = NULL;
+    if (size == 0) return ATX_ERROR_INVALID_PARAMETERS;
+    size = ((size+page_size-1)/page_size)*page_size;
+
+    /* allocate a new object */
+    ring = (ATX_RingBuffer*)ATX_AllocateMemory(sizeof(ATX_RingBuffer));
+    if (ring == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+
+    /* construct the object */
+    result = ATX_RingBuffer_MapMirrored(size, &ring->data.start);
+    if (ATX_FAILED(result)) {
+        ATX_FreeMemory((void*)ring);
+        return result;
+    }
+    ring->mirrored       = ATX_TRUE;
+    ring->size           = size;
+    ring->data.end       = ring->data.start + size;
+    ring->in = ring->out = ring->data.start;
+
+    *buffer = ring;
+    return ATX_SUCCESS;
+#else
+    ATX_COMPILER_UNUSED(size);
+    *buffer = NULL;
+    return ATX_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 /*----------------------------------------------------------------------
 |   ATX_RingBuffer_Destroy
 +---------------------------------------------------------------------*/
@@ -88,6 +193,12 @@ ATX_Result
 ATX_RingBuffer_Destroy(ATX_RingBuffer* ring)
 {
     /* free the data buffer */
+#if defined(ATX_CONFIG_HAVE_MEMFD)
+    if (ring->mirrored) {
+        munmap(ring->data.start, 2*ring->size);
+        ring->data.start = NULL;
+    }
+#endif
     if (ring->data.start) {
         ATX_FreeMemory((void*)ring->data.start);
     }
@@ -104,6 +215,7 @@ ATX_RingBuffer_Destroy(ATX_RingBuffer* ring)
 ATX_Size
 ATX_RingBuffer_GetContiguousSpace(ATX_RingBuffer* ring)
 {
+    if (ring->mirrored) return ATX_RingBuffer_GetSpace(ring);
     return 
         (ring->in < ring->out) ?
         (ring->out - ring->in - 1) :
@@ -133,7 +245,16 @@ ATX_RingBuffer_Write(ATX_RingBuffer*      ring,
                      ATX_Size             byte_count)
 {
     if (!byte_count) return ATX_SUCCESS;
-    if (ring->in < ring->out) {
+    if (ring->mirrored) {
+        /* the region after ring->in is always contiguous */
+        if (buffer) {
+            ATX_CopyMemory(ring->in, buffer, byte_count);
+        }
+        ring->in += byte_count;
+        if (ring->in >= ring->data.end) {
+            ring->in -= ring->size;
+        }
+    } else if (ring->in < ring->out) {
         if (buffer) {
             ATX_CopyMemory(ring->in, buffer, byte_count);
         }
@@ -174,6 +295,7 @@ ATX_RingBuffer_Write(ATX_RingBuffer*      ring,
 ATX_Size
 ATX_RingBuffer_GetContiguousAvailable(ATX_RingBuffer* ring)
 {
+    if (ring->mirrored) return ATX_RingBuffer_GetAvailable(ring);
     return 
         (ring->out <= ring->in) ? 
         (ring->in-ring->out) :
@@ -201,7 +323,16 @@ ATX_RingBuffer_Read(ATX_RingBuffer* ring,
                     ATX_Size        byte_count)
 {
     if (!byte_count) return ATX_SUCCESS;
-    if (ring->in > ring->out) {
+    if (ring->mirrored) {
+        /* the region after ring->out is always contiguous */
+        if (buffer) {
+            ATX_CopyMemory(buffer, ring->out, byte_count);
+        }
+        ring->out += byte_count;
+        if (ring->out >= ring->data.end) {
+            ring->out -= ring->size;
+        }
+    } else if (ring->in > ring->out) {
         if (buffer) {
             ATX_CopyMemory(buffer, ring->out, byte_count);
         }
@@ -324,3 +455,337 @@ ATX_RingBuffer_Reset(ATX_RingBuffer* ring)
     ring->in = ring->out = ring->data.start;
     return ATX_SUCCESS;
 }
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_GetSpaceSegments
+|
+|    Returns the free space of the ring as up to two buffers, in order.
++----------------------------------------------------------------------*/
+static ATX_Cardinal
+ATX_RingBuffer_GetSpaceSegments(ATX_RingBuffer* ring, ATX_IoVec* segments)
+{
+    ATX_Size space      = ATX_RingBuffer_GetSpace(ring);
+    ATX_Size contiguous = ATX_RingBuffer_GetContiguousSpace(ring);
+
+    if (space == 0) return 0;
+    segments[0].buffer = ring->in;
+    segments[0].size   = contiguous;
+    if (space == contiguous) return 1;
+    segments[1].buffer = ring->data.start;
+    segments[1].size   = space-contiguous;
+
+    return 2;
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_GetDataSegments
+|
+|    Returns the data of the ring as up to two buffers, in order.
++----------------------------------------------------------------------*/
+static ATX_Cardinal
+ATX_RingBuffer_GetDataSegments(ATX_RingBuffer* ring, ATX_IoVec* segments)
+{
+    ATX_Size available  = ATX_RingBuffer_GetAvailable(ring);
+    ATX_Size contiguous = ATX_RingBuffer_GetContiguousAvailable(ring);
+
+    if (available == 0) return 0;
+    segments[0].buffer = ring->out;
+    segments[0].size   = contiguous;
+    if (available == contiguous) return 1;
+    segments[1].buffer = ring->data.start;
+    segments[1].size   = available-contiguous;
+
+    return 2;
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_MapErrno
++----------------------------------------------------------------------*/
+#if defined(ATX_CONFIG_HAVE_READV)
+static ATX_Result
+ATX_RingBuffer_MapErrno(int error)
+{
+    if (error == EAGAIN) return ATX_ERROR_WOULD_BLOCK;
+#if defined(EWOULDBLOCK) && (EWOULDBLOCK != EAGAIN)
+    if (error == EWOULDBLOCK) return ATX_ERROR_WOULD_BLOCK;
+#endif
+    return ATX_ERROR_ERRNO(error);
+}
+#endif
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_FillFromDescriptor
++----------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_FillFromDescriptor(ATX_RingBuffer* ring,
+                                  int             fd,
+                                  ATX_Size*       bytes_read)
+{
+#if defined(ATX_CONFIG_HAVE_READV)
+    ATX_IoVec    segments[2];
+    struct iovec buffers[2];
+    ATX_Cardinal count;
+    ATX_Cardinal i;
+    ssize_t      nb_read;
+
+    if (bytes_read) *bytes_read = 0;
+    count = ATX_RingBuffer_GetSpaceSegments(ring, segments);
+    if (count == 0) return ATX_SUCCESS;
+    for (i=0; i<count; i++) {
+        buffers[i].iov_base = (void*)segments[i].buffer;
+        buffers[i].iov_len  = segments[i].size;
+    }
+
+    do {
+        nb_read = readv(fd, buffers, (int)count);
+    } while (nb_read < 0 && errno == EINTR);
+    if (nb_read < 0)  return ATX_RingBuffer_MapErrno(errno);
+    if (nb_read == 0) return ATX_ERROR_EOS;
+
+    ATX_RingBuffer_MoveIn(ring, (ATX_Offset)nb_read);
+    if (bytes_read) *bytes_read = (ATX_Size)nb_read;
+
+    return ATX_SUCCESS;
+#else
+    ATX_COMPILER_UNUSED(ring);
+    ATX_COMPILER_UNUSED(fd);
+    if (bytes_read) *bytes_read = 0;
+    return ATX_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_DrainToDescriptor
++----------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_DrainToDescriptor(ATX_RingBuffer* ring,
+                                 int             fd,
+                                 ATX_Size*       bytes_written)
+{
+#if defined(ATX_CONFIG_HAVE_READV)
+    ATX_IoVec    segments[2];
+    struct iovec buffers[2];
+    ATX_Cardinal count;
+    ATX_Cardinal i;
+    ssize_t      nb_written;
+
+    if (bytes_written) *bytes_written = 0;
+    count = ATX_RingBuffer_GetDataSegments(ring, segments);
+    if (count == 0) return ATX_SUCCESS;
+    for (i=0; i<count; i++) {
+        buffers[i].iov_base = (void*)segments[i].buffer;
+        buffers[i].iov_len  = segments[i].size;
+    }
+
+    do {
+        nb_written = writev(fd, buffers, (int)count);
+    } while (nb_written < 0 && errno == EINTR);
+    if (nb_written < 0) return ATX_RingBuffer_MapErrno(errno);
+
+    ATX_RingBuffer_MoveOut(ring, (ATX_Offset)nb_written);
+    if (bytes_written) *bytes_written = (ATX_Size)nb_written;
+
+    return ATX_SUCCESS;
+#else
+    ATX_COMPILER_UNUSED(ring);
+    ATX_COMPILER_UNUSED(fd);
+    if (bytes_written) *bytes_written = 0;
+    return ATX_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_FillFromStream
++----------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_FillFromStream(ATX_RingBuffer*  ring,
+                              ATX_InputStream* stream,
+                              ATX_Size*        bytes_read)
+{
+    ATX_IoVec  segments[2];
+    ATX_Size   count = 0;
+    ATX_Result result;
+
+    if (bytes_read) *bytes_read = 0;
+    if (ATX_RingBuffer_GetSpaceSegments(ring, segments) == 0) return ATX_SUCCESS;
+
+#if defined(ATX_CONFIG_HAVE_READV)
+    /* read from the descriptor if there is one */
+    {
+        ATX_DescriptorStream* descriptor = ATX_CAST(stream, ATX_DescriptorStream);
+        int                   fd;
+        if (descriptor && ATX_SUCCEEDED(ATX_DescriptorStream_GetDescriptor(descriptor, &fd))) {
+            result = ATX_RingBuffer_FillFromDescriptor(ring, fd, &count);
+            if (count) ATX_DescriptorStream_Advance(descriptor, count);
+            if (bytes_read) *bytes_read = count;
+            return result;
+        }
+    }
+#endif
+
+    /* read into the contiguous space */
+    result = ATX_InputStream_Read(stream, (ATX_Any)segments[0].buffer, segments[0].size, &count);
+    if (ATX_FAILED(result)) return result;
+    ATX_RingBuffer_MoveIn(ring, (ATX_Offset)count);
+    if (bytes_read) *bytes_read = count;
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_DrainToStream
++----------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_DrainToStream(ATX_RingBuffer*   ring,
+                             ATX_OutputStream* stream,
+                             ATX_Size*         bytes_written)
+{
+    ATX_IoVec    segments[2];
+    ATX_Cardinal segment_count;
+    ATX_Size     count = 0;
+    ATX_Result   result;
+
+    if (bytes_written) *bytes_written = 0;
+    segment_count = ATX_RingBuffer_GetDataSegments(ring, segments);
+    if (segment_count == 0) return ATX_SUCCESS;
+
+#if defined(ATX_CONFIG_HAVE_READV)
+    /* write to the descriptor if there is one */
+    {
+        ATX_DescriptorStream* descriptor = ATX_CAST(stream, ATX_DescriptorStream);
+        int                   fd;
+        if (descriptor && ATX_SUCCEEDED(ATX_DescriptorStream_GetDescriptor(descriptor, &fd))) {
+            result = ATX_RingBuffer_DrainToDescriptor(ring, fd, &count);
+            if (count) ATX_DescriptorStream_Advance(descriptor, count);
+            if (bytes_written) *bytes_written = count;
+            return result;
+        }
+    }
+#endif
+
+    /* write both segments at once */
+    result = ATX_OutputStream_WriteV(stream, segments, segment_count, &count);
+    if (ATX_FAILED(result)) return result;
+    ATX_RingBuffer_MoveOut(ring, (ATX_Offset)count);
+    if (bytes_written) *bytes_written = count;
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_GetView
+|
+|    Returns a range of the data, starting at an offset from the read
+|    position, as up to two buffers.
++----------------------------------------------------------------------*/
+static ATX_Cardinal
+ATX_RingBuffer_GetView(ATX_RingBuffer* ring, 
+                       ATX_Size        offset, 
+                       ATX_Size        size,
+                       ATX_IoVec*      segments)
+{
+    unsigned char* start = ring->out+offset;
+    ATX_Size       contiguous;
+
+    if (size == 0) return 0;
+    if (start >= ring->data.end) start -= ring->size;
+    contiguous = ring->mirrored ? size : (ATX_Size)(ring->data.end-start);
+    segments[0].buffer = start;
+    if (size <= contiguous) {
+        segments[0].size = size;
+        return 1;
+    }
+    segments[0].size   = contiguous;
+    segments[1].buffer = ring->data.start;
+    segments[1].size   = size-contiguous;
+
+    return 2;
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_FindByte
++----------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_FindByte(ATX_RingBuffer* ring,
+                        ATX_UInt8       value,
+                        ATX_Size        offset,
+                        ATX_Size*       position)
+{
+    ATX_Size     available = ATX_RingBuffer_GetAvailable(ring);
+    ATX_IoVec    segments[2];
+    ATX_Cardinal count;
+    ATX_Cardinal i;
+
+    if (offset >= available) return ATX_ERROR_NO_SUCH_ITEM;
+    count = ATX_RingBuffer_GetView(ring, offset, available-offset, segments);
+    for (i=0; i<count; i++) {
+        const ATX_Byte* found = (const ATX_Byte*)ATX_FindByte(segments[i].buffer, value, segments[i].size);
+        if (found) {
+            *position = offset+(ATX_Size)(found-(const ATX_Byte*)segments[i].buffer);
+            return ATX_SUCCESS;
+        }
+        offset += segments[i].size;
+    }
+
+    return ATX_ERROR_NO_SUCH_ITEM;
+}
+
+/*----------------------------------------------------------------------+
+|    ATX_RingBuffer_PeekFrame
++----------------------------------------------------------------------*/
+ATX_Result
+ATX_RingBuffer_PeekFrame(ATX_RingBuffer*       ring,
+                         ATX_RingBufferFraming framing,
+                         ATX_Size              max_frame_size,
+                         ATX_RingBufferFrame*  frame)
+{
+    ATX_Size available   = ATX_RingBuffer_GetAvailable(ring);
+    ATX_Size capacity    = ring->size-1;
+    ATX_Size header_size = 0;
+    ATX_Size size;
+    ATX_Size i;
+
+    switch (framing) {
+        case ATX_RING_BUFFER_FRAMING_LINE:
+            if (ATX_FAILED(ATX_RingBuffer_FindByte(ring, '\n', 0, &size))) {
+                /* no delimiter, check that there can still be one: a  */
+                /* line of max_frame_size bytes may be followed by '\r' */
+                ATX_Size limit = max_frame_size;
+                if (available &&
+                    ATX_RingBuffer_PeekByte(ring, available-1) == '\r') {
+                    ++limit;
+                }
+                if ((max_frame_size && available > limit) ||
+                    available == capacity) {
+                    return ATX_ERROR_OVERFLOW;
+                }
+                return ATX_ERROR_NO_SUCH_ITEM;
+            }
+            frame->frame_size = size+1;
+            if (size && ATX_RingBuffer_PeekByte(ring, size-1) == '\r') --size;
+            break;
+
+        case ATX_RING_BUFFER_FRAMING_LENGTH_16:
+        case ATX_RING_BUFFER_FRAMING_LENGTH_32:
+            header_size = (framing == ATX_RING_BUFFER_FRAMING_LENGTH_16) ? 2 : 4;
+            if (available < header_size) return ATX_ERROR_NO_SUCH_ITEM;
+            for (size=0, i=0; i<header_size; i++) {
+                size = (size<<8) | ATX_RingBuffer_PeekByte(ring, i);
+            }
+            if (max_frame_size && size > max_frame_size) return ATX_ERROR_OVERFLOW;
+            if (size > capacity-header_size)   return ATX_ERROR_OVERFLOW;
+            if (available < header_size+size)  return ATX_ERROR_NO_SUCH_ITEM;
+            frame->frame_size = header_size+size;
+            break;
+
+        default:
+            return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    if (max_frame_size && size > max_frame_size) return ATX_ERROR_OVERFLOW;
+
+    /* the payload follows the header, if any */
+    frame->size          = size;
+    frame->segment_count = ATX_RingBuffer_GetView(ring, header_size, size, frame->segments);
+
+    return ATX_SUCCESS;
+}
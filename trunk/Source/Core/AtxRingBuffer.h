@@ -40,12 +40,34 @@
 #include "AtxResults.h"
 #include "AtxUtils.h"
 #include "AtxInterfaces.h"
+#include "AtxStreams.h"
 
 /*----------------------------------------------------------------------
 |    types
 +---------------------------------------------------------------------*/
 typedef struct ATX_RingBuffer ATX_RingBuffer;
 
+/**
+ * How frames are delimited in the data of a ring buffer.
+ */
+typedef enum {
+    ATX_RING_BUFFER_FRAMING_LINE,      /** ends with '\n', a '\r' before it is dropped */
+    ATX_RING_BUFFER_FRAMING_LENGTH_16, /** 16-bit big-endian payload size first   */
+    ATX_RING_BUFFER_FRAMING_LENGTH_32  /** 32-bit big-endian payload size first   */
+} ATX_RingBufferFraming;
+
+/**
+ * A frame found in the data of a ring buffer. The payload is not copied:
+ * the segments point into the ring, and are valid until the data is
+ * moved out or overwritten.
+ */
+typedef struct {
+    ATX_IoVec    segments[2];   /** payload, in up to two pieces            */
+    ATX_Cardinal segment_count;
+    ATX_Size     size;          /** payload size                            */
+    ATX_Size     frame_size;    /** size to move out, with delimiter/prefix */
+} ATX_RingBufferFrame;
+
 /*----------------------------------------------------------------------
 |    prototypes
 +---------------------------------------------------------------------*/
@@ -54,6 +76,17 @@ extern "C" {
 #endif /* __cplusplus */
 
 ATX_Result     ATX_RingBuffer_Create(ATX_Size size, ATX_RingBuffer** buffer);
+
+/**
+ * Create a ring buffer whose memory is mapped twice, back to back, so that
+ * any readable or writable region is contiguous: the contiguous space and
+ * available sizes are always the full ones. The size is rounded up to a 
+ * multiple of the memory page size. Returns ATX_ERROR_NOT_SUPPORTED on 
+ * platforms that cannot do this, in which case callers can fall back to 
+ * ATX_RingBuffer_Create.
+ */
+ATX_Result     ATX_RingBuffer_CreateMirrored(ATX_Size size, ATX_RingBuffer** buffer);
+
 ATX_Result     ATX_RingBuffer_Destroy(ATX_RingBuffer* ring);
 ATX_Size       ATX_RingBuffer_GetSpace(ATX_RingBuffer* ring);
 ATX_Size       ATX_RingBuffer_GetContiguousSpace(ATX_RingBuffer* ring);
@@ -74,6 +107,81 @@ ATX_Result     ATX_RingBuffer_MoveIn(ATX_RingBuffer* ring, ATX_Offset offset);
 ATX_Result     ATX_RingBuffer_MoveOut(ATX_RingBuffer* ring, ATX_Offset offset);
 ATX_Result     ATX_RingBuffer_Reset(ATX_RingBuffer* ring);
 
+/**
+ * Find the first occurrence of a byte in the data of the ring, starting 
+ * at an offset from the read position. Both segments of the data are
+ * searched with ATX_FindByte.
+ * Returns ATX_ERROR_NO_SUCH_ITEM if the byte is not there.
+ * @param position Offset of the byte from the read position.
+ */
+ATX_Result     ATX_RingBuffer_FindByte(ATX_RingBuffer* ring,
+                                       ATX_UInt8       value,
+                                       ATX_Size        offset,
+                                       ATX_Size*       position);
+
+/**
+ * Get the next complete frame at the read position, without copying or
+ * consuming it. Once the frame is processed, remove it from the ring 
+ * with ATX_RingBuffer_MoveOut(ring, frame->frame_size).
+ * Returns ATX_ERROR_NO_SUCH_ITEM if the frame is not complete yet, and
+ * ATX_ERROR_OVERFLOW if its payload is larger than max_frame_size or
+ * could never fit in the ring.
+ * @param max_frame_size Largest payload size, or 0 for no limit.
+ */
+ATX_Result     ATX_RingBuffer_PeekFrame(ATX_RingBuffer*       ring,
+                                        ATX_RingBufferFraming framing,
+                                        ATX_Size              max_frame_size,
+                                        ATX_RingBufferFrame*  frame);
+
+/**
+ * Read from a stream directly into the free space of the ring, with a 
+ * single read. Streams backed by a file descriptor are read with 
+ * ATX_RingBuffer_FillFromDescriptor, which can fill both segments of 
+ * the space at once. Other streams are read into the contiguous space 
+ * only.
+ * Returns ATX_ERROR_EOS if the stream is at its end. Nothing is read
+ * if the ring is full.
+ * @param bytes_read Number of bytes added to the ring. May be NULL.
+ */
+ATX_Result     ATX_RingBuffer_FillFromStream(ATX_RingBuffer*  ring,
+                                             ATX_InputStream* stream,
+                                             ATX_Size*        bytes_read);
+
+/**
+ * Write the data of the ring directly to a stream, with a single 
+ * vectored write covering both segments of the data (see 
+ * ATX_OutputStream_WriteV). Streams backed by a file descriptor are 
+ * written with ATX_RingBuffer_DrainToDescriptor.
+ * @param bytes_written Number of bytes removed from the ring. May be NULL.
+ */
+ATX_Result     ATX_RingBuffer_DrainToStream(ATX_RingBuffer*   ring,
+                                            ATX_OutputStream* stream,
+                                            ATX_Size*         bytes_written);
+
+/**
+ * Read from a file descriptor directly into the free space of the ring,
+ * with a single readv call covering both segments of the space.
+ * Returns ATX_ERROR_EOS at the end of the input, ATX_ERROR_WOULD_BLOCK
+ * if the descriptor is non-blocking and has no data, and 
+ * ATX_ERROR_NOT_SUPPORTED on platforms without readv.
+ * @param bytes_read Number of bytes added to the ring. May be NULL.
+ */
+ATX_Result     ATX_RingBuffer_FillFromDescriptor(ATX_RingBuffer* ring,
+                                                 int             fd,
+                                                 ATX_Size*       bytes_read);
+
+/**
+ * Write the data of the ring directly to a file descriptor, with a 
+ * single writev call covering both segments of the data.
+ * Returns ATX_ERROR_WOULD_BLOCK if the descriptor is non-blocking and
+ * can't take any data, and ATX_ERROR_NOT_SUPPORTED on platforms 
+ * without writev.
+ * @param bytes_written Number of bytes removed from the ring. May be NULL.
+ */
+ATX_Result     ATX_RingBuffer_DrainToDescriptor(ATX_RingBuffer* ring,
+                                                int             fd,
+                                                ATX_Size*       bytes_written);
+
 #ifdef __cplusplus
 }
 #endif
@@ -62,6 +62,8 @@ typedef struct {
 +---------------------------------------------------------------------*/
 #define ATX_SOCKET_TIMEOUT_INFINITE         -1
 
+#define ATX_SOCKET_FLAG_BUFFERED_OUTPUT     0x01
+
 #define ATX_ERROR_DISCONNECTED        (ATX_ERROR_BASE_SOCKETS - 0)
 #define ATX_ERROR_HOST_UNKNOWN        (ATX_ERROR_BASE_SOCKETS - 1)
 #define ATX_ERROR_SOCKET_FAILED       (ATX_ERROR_BASE_SOCKETS - 2)
@@ -236,6 +238,21 @@ extern "C" {
 
 extern ATX_Result ATX_TcpClientSocket_Create(ATX_Socket** bsd_socket);
 extern ATX_Result ATX_TcpServerSocket_Create(ATX_ServerSocket** bsd_socket);
+
+/**
+ * Same as ATX_TcpClientSocket_Create, with ATX_SOCKET_FLAG_XXX flags.
+ * With ATX_SOCKET_FLAG_BUFFERED_OUTPUT, the socket's output streams
+ * buffer their writes and must be flushed.
+ */
+extern ATX_Result ATX_TcpClientSocket_CreateEx(ATX_Flags    flags, 
+                                               ATX_Socket** bsd_socket);
+
+/**
+ * Same as ATX_TcpServerSocket_Create, with ATX_SOCKET_FLAG_XXX flags
+ * that are passed on to the client sockets it accepts.
+ */
+extern ATX_Result ATX_TcpServerSocket_CreateEx(ATX_Flags          flags, 
+                                               ATX_ServerSocket** bsd_socket);
 extern ATX_Result ATX_UdpSocket_Create(ATX_DatagramSocket** bsd_socket);
 
 #ifdef __cplusplus
@@ -32,12 +32,33 @@
 /*----------------------------------------------------------------------
 |   includes
 +---------------------------------------------------------------------*/
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for splice and copy_file_range */
+#endif
+
 #include "AtxConfig.h"
 #include "AtxTypes.h"
 #include "AtxResults.h"
 #include "AtxUtils.h"
 #include "AtxStreams.h"
 #include "AtxReferenceable.h"
+#include "AtxThreads.h"
+#include "AtxAtomic.h"
+
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <poll.h>
+#endif
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_STREAM_PUMP_KERNEL_CHUNK_SIZE 0x1000000 /* 16MB per system call */
 
 /*----------------------------------------------------------------------
 |   types
@@ -56,6 +77,20 @@ typedef struct {
     ATX_Position           position;
 } ATX_SubInputStream;
 
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal           reference_count;
+    ATX_OutputStream*      parent;
+    ATX_StreamTransformer* transformer;
+    ATX_LargeSize          size;
+    ATX_Position           offset;
+    ATX_Position           position;
+} ATX_SubOutputStream;
+
 /*----------------------------------------------------------------------
 |   constants
 +---------------------------------------------------------------------*/
@@ -71,8 +106,14 @@ ATX_InputStream_ReadLine(ATX_InputStream* self,
                          ATX_Size         size, 
                          ATX_Size*        chars_read)
 {
-    ATX_Result result;
-    ATX_Size   total = 0;
+    ATX_BufferedInputStream* buffered = ATX_CAST(self, ATX_BufferedInputStream);
+    ATX_Result               result;
+    ATX_Size                 total = 0;
+
+    /* use the buffered implementation if there is one */
+    if (buffered) {
+        return ATX_BufferedInputStream_ReadLine(buffered, buffer, size, chars_read);
+    }
 
     /* check parameters */
     if (buffer == NULL || size < 1) {
@@ -124,7 +165,13 @@ ATX_InputStream_ReadLineString(ATX_InputStream* self,
                                ATX_String*      string,
                                ATX_Size         max_length)
 {
-    ATX_Result result;
+    ATX_BufferedInputStream* buffered = ATX_CAST(self, ATX_BufferedInputStream);
+    ATX_Result               result;
+
+    /* use the buffered implementation if there is one */
+    if (buffered) {
+        return ATX_BufferedInputStream_ReadLineString(buffered, string, max_length);
+    }
 
     /* reset the string */
     ATX_String_SetLength(string, 0);
@@ -329,7 +376,9 @@ ATX_InputStream_Load(ATX_InputStream* self, ATX_Size max_read, ATX_DataBuffer**
         ATX_CHECK(ATX_DataBuffer_Reserve(*buffer, (ATX_Size)(total_bytes_read+bytes_to_read)));
 
         /* read the data */
-        data = ATX_DataBuffer_UseData(*buffer)+total_bytes_read;
+        data = ATX_DataBuffer_UseData(*buffer);
+        if (data == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+        data += total_bytes_read;
         result = ATX_InputStream_Read(self, (void*)data, (ATX_Size)bytes_to_read, &bytes_read);
         if (ATX_SUCCEEDED(result) && bytes_read != 0) {
             total_bytes_read += bytes_read;
@@ -369,6 +418,84 @@ ATX_OutputStream_WriteFully(ATX_OutputStream* self,
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_OutputStream_WriteV
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_OutputStream_WriteV(ATX_OutputStream* self,
+                        const ATX_IoVec*  buffers,
+                        ATX_Cardinal      buffer_count,
+                        ATX_Size*         bytes_written)
+{
+    ATX_VectoredOutputStream* vectored = ATX_CAST(self, ATX_VectoredOutputStream);
+    ATX_Size                  total = 0;
+    ATX_Cardinal              i;
+
+    /* use the native implementation if there is one */
+    if (vectored) {
+        return ATX_VectoredOutputStream_WriteV(vectored, buffers, buffer_count, bytes_written);
+    }
+
+    /* write one buffer at a time, stopping at the first short write */
+    for (i=0; i<buffer_count; i++) {
+        ATX_Size   chunk = 0;
+        ATX_Result result;
+        if (buffers[i].size == 0) continue;
+        result = ATX_OutputStream_Write(self, buffers[i].buffer, buffers[i].size, &chunk);
+        if (ATX_FAILED(result)) {
+            if (total) break; /* report what was written, the error will come back */
+            if (bytes_written) *bytes_written = 0;
+            return result;
+        }
+        total += chunk;
+        if (chunk < buffers[i].size) break;
+    }
+    if (bytes_written) *bytes_written = total;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_OutputStream_WriteVFully
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_OutputStream_WriteVFully(ATX_OutputStream* self,
+                             const ATX_IoVec*  buffers,
+                             ATX_Cardinal      buffer_count)
+{
+    while (buffer_count) {
+        ATX_Size   bytes_written = 0;
+        ATX_Result result = ATX_OutputStream_WriteV(self, buffers, buffer_count, &bytes_written);
+        if (ATX_FAILED(result)) return result;
+        if (bytes_written == 0) {
+            /* nothing written: done if only empty buffers are left */
+            while (buffer_count && buffers->size == 0) {
+                ++buffers;
+                --buffer_count;
+            }
+            if (buffer_count == 0) break;
+            return ATX_ERROR_INTERNAL;
+        }
+        
+        /* skip what was written */
+        while (buffer_count && bytes_written >= buffers->size) {
+            bytes_written -= buffers->size;
+            ++buffers;
+            --buffer_count;
+        }
+        if (bytes_written) {
+            /* finish the buffer that was partially written */
+            ATX_CHECK(ATX_OutputStream_WriteFully(self, 
+                                                  (const ATX_Byte*)buffers->buffer+bytes_written, 
+                                                  buffers->size-bytes_written));
+            ++buffers;
+            --buffer_count;
+        }
+    }
+
+    return ATX_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
 |   ATX_OutputStream_WriteString
 +---------------------------------------------------------------------*/
@@ -641,219 +768,1752 @@ ATX_BEGIN_INTERFACE_MAP(ATX_SubInputStream, ATX_InputStream)
 +---------------------------------------------------------------------*/
 ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_SubInputStream, reference_count)
 
-/*----------------------------------------------------------------------
-|   ATX_MemoryStream
-+---------------------------------------------------------------------*/
-struct ATX_MemoryStream {
-    /* intefaces */
-    ATX_IMPLEMENTS(ATX_InputStream);
-    ATX_IMPLEMENTS(ATX_OutputStream);
-    ATX_IMPLEMENTS(ATX_Referenceable);
-
-    /* members */
-    ATX_Cardinal    reference_count;
-    ATX_DataBuffer* buffer;
-    ATX_Position    read_offset;
-    ATX_Position    write_offset;
-};
-
 /*----------------------------------------------------------------------
 |   forward declarations
 +---------------------------------------------------------------------*/
-ATX_DECLARE_INTERFACE_MAP(ATX_MemoryStream, ATX_InputStream)
-ATX_DECLARE_INTERFACE_MAP(ATX_MemoryStream, ATX_OutputStream)
-ATX_DECLARE_INTERFACE_MAP(ATX_MemoryStream, ATX_Referenceable)
+ATX_DECLARE_INTERFACE_MAP(ATX_SubOutputStream, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_SubOutputStream, ATX_Referenceable)
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_Create
+|   ATX_SubOutputStream_Create
 +---------------------------------------------------------------------*/
 ATX_Result
-ATX_MemoryStream_Create(ATX_Size size, ATX_MemoryStream** stream)
+ATX_SubOutputStream_Create(ATX_OutputStream*      parent, 
+                           ATX_Position           offset,
+                           ATX_LargeSize          size,
+                           ATX_StreamTransformer* transformer,
+                           ATX_OutputStream**     object)
 { 
-    return ATX_MemoryStream_CreateFromBuffer(NULL, size, stream);
-}
+    ATX_SubOutputStream* stream;
+    ATX_Result           result;
 
-/*----------------------------------------------------------------------
-|   ATX_MemoryStream_CreateFromBuffer
-+---------------------------------------------------------------------*/
-ATX_Result
-ATX_MemoryStream_CreateFromBuffer(ATX_Byte*          buffer, 
-                                  ATX_Size           size, 
-                                  ATX_MemoryStream** stream)
-{ 
-    ATX_Result result;
+    /* allocate new object */
+    stream = (ATX_SubOutputStream*)ATX_AllocateZeroMemory(sizeof(ATX_SubOutputStream));
+    if (stream == NULL) {
+        *object = NULL;
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
 
-    /* allocate the object */
-    *stream = ATX_AllocateZeroMemory(sizeof(ATX_MemoryStream));
-    if (*stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    /* construct object */
+    stream->reference_count = 1;
+    stream->parent          = parent;
+    stream->transformer     = transformer;
+    stream->offset          = offset;
+    stream->size            = size;
+    stream->position        = 0;
 
-    /* construct the object */
-    if (buffer == NULL) {
-        result = ATX_DataBuffer_Create(size, &(*stream)->buffer);
-    } else {
-        result = ATX_DataBuffer_Create(0, &(*stream)->buffer);
-    }
-    if (ATX_FAILED(result)) {
-        ATX_FreeMemory((void*)(*stream));
-        return result;
-    }
-    
-    /* set the buffer if needed */
-    if (buffer != NULL) {
-        result = ATX_DataBuffer_SetBuffer((*stream)->buffer, 
-                                          buffer,
-                                          size);
-        if (ATX_SUCCEEDED(result)) {
-            result = ATX_DataBuffer_SetDataSize((*stream)->buffer, size);
-        }
-        if (ATX_FAILED(result)) {
-            ATX_DataBuffer_Destroy((*stream)->buffer);
-            ATX_FreeMemory((void*)(*stream));
-            return result;
-        }
-    }
-    
-    (*stream)->reference_count = 1;
-    (*stream)->read_offset = 0;
-    (*stream)->write_offset = 0;
+    /* seek to the start point */
+    result = ATX_OutputStream_Seek(parent, offset);
+    if (ATX_FAILED(result)) stream->offset = 0;
+
+    /* keep a reference to the parent stream */
+    ATX_REFERENCE_OBJECT(parent);
 
     /* setup the interfaces */
-    ATX_SET_INTERFACE(*stream, ATX_MemoryStream, ATX_InputStream);
-    ATX_SET_INTERFACE(*stream, ATX_MemoryStream, ATX_OutputStream);
-    ATX_SET_INTERFACE(*stream, ATX_MemoryStream, ATX_Referenceable);
+    ATX_SET_INTERFACE(stream, ATX_SubOutputStream, ATX_OutputStream);
+    ATX_SET_INTERFACE(stream, ATX_SubOutputStream, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_OutputStream);
 
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_AddReference
+|   ATX_SubOutputStream_Destroy
 +---------------------------------------------------------------------*/
 static ATX_Result
-ATX_MemoryStream_AddReference(ATX_Referenceable* _self)
+ATX_SubOutputStream_Destroy(ATX_SubOutputStream* self)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_Referenceable);
-    ++self->reference_count;
+    /* release the reference to the parent */
+    ATX_RELEASE_OBJECT(self->parent);
+    ATX_FreeMemory((void*)self);
+
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_Release
+|   ATX_SubOutputStream_Write
 +---------------------------------------------------------------------*/
-static ATX_Result
-ATX_MemoryStream_Release(ATX_Referenceable* _self)
+ATX_METHOD
+ATX_SubOutputStream_Write(ATX_OutputStream* _self,
+                          ATX_AnyConst      buffer, 
+                          ATX_Size          bytes_to_write, 
+                          ATX_Size*         bytes_written)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_Referenceable);
-    if (--self->reference_count == 0) {
-        ATX_DataBuffer_Destroy(self->buffer);
-        ATX_FreeMemory((void*)self);
+    ATX_SubOutputStream* self = ATX_SELF(ATX_SubOutputStream, ATX_OutputStream);
+    ATX_Size             local_written = 0;
+    ATX_Result           result;
+
+    if (bytes_written) *bytes_written = 0;
+    
+    /* clip the request */
+    if (self->size > 0) {
+        if (bytes_to_write > self->size - self->position) {
+            bytes_to_write = (ATX_Size)(self->size - self->position);
+            if (bytes_to_write == 0) return ATX_ERROR_OUT_OF_RANGE;
+        }
+    }
+
+    /* write to the parent */
+    result = ATX_OutputStream_Write(self->parent, 
+                                    buffer, 
+                                    bytes_to_write, 
+                                    &local_written);
+    if (ATX_FAILED(result)) return result;
+    
+    /* transform what was actually written */
+    if (self->transformer) {
+        ATX_StreamTransformer_Transform(self->transformer, buffer, local_written);
     }
 
+    /* update the position */
+    self->position += local_written;
+    if (bytes_written) *bytes_written = local_written;
+    
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_Destroy
+|   ATX_SubOutputStream_Seek
 +---------------------------------------------------------------------*/
-ATX_Result
-ATX_MemoryStream_Destroy(ATX_MemoryStream* self)
+ATX_METHOD
+ATX_SubOutputStream_Seek(ATX_OutputStream* _self, 
+                         ATX_Position      where)
 {
-    return ATX_MemoryStream_Release(&ATX_BASE(self, ATX_Referenceable));
+    ATX_SubOutputStream* self = ATX_SELF(ATX_SubOutputStream, ATX_OutputStream);
+    ATX_Result           result;
+
+    /* shortcut */
+    if (where == self->position) return ATX_SUCCESS;
+    
+    /* check the bounds */
+    if (self->size > 0 && (ATX_LargeSize)where > self->size) {
+        return ATX_ERROR_OUT_OF_RANGE;
+    }
+
+    /* seek */
+    result = ATX_OutputStream_Seek(self->parent, where + self->offset);
+    if (ATX_SUCCEEDED(result)) {
+        self->position = where;
+    }
+    return result;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_GetBuffer
+|   ATX_SubOutputStream_Tell
 +---------------------------------------------------------------------*/
-ATX_Result 
-ATX_MemoryStream_GetBuffer(ATX_MemoryStream*       self, 
-                           const ATX_DataBuffer**  buffer)
+ATX_METHOD
+ATX_SubOutputStream_Tell(ATX_OutputStream* _self, 
+                         ATX_Position*     where)
 {
-    *buffer = self->buffer;
+    ATX_SubOutputStream* self = ATX_SELF(ATX_SubOutputStream, ATX_OutputStream);
+    if (where) *where = self->position;
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_GetInputStream
+|   ATX_SubOutputStream_Flush
 +---------------------------------------------------------------------*/
-ATX_Result 
-ATX_MemoryStream_GetInputStream(ATX_MemoryStream* self,
-                                ATX_InputStream** stream)
+ATX_METHOD
+ATX_SubOutputStream_Flush(ATX_OutputStream* _self)
 {
-    ++self->reference_count;
-    *stream = &ATX_BASE(self, ATX_InputStream);
-    return ATX_SUCCESS;
+    ATX_SubOutputStream* self = ATX_SELF(ATX_SubOutputStream, ATX_OutputStream);
+    return ATX_OutputStream_Flush(self->parent);
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_GetOutputStream
+|   ATX_SubOutputStream_GetInterface
 +---------------------------------------------------------------------*/
-ATX_Result 
-ATX_MemoryStream_GetOutputStream(ATX_MemoryStream*  self,
-                                 ATX_OutputStream** stream)
-{
-    ++self->reference_count;
-    *stream = &ATX_BASE(self, ATX_OutputStream);
-    return ATX_SUCCESS;
-}
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_SubOutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_SubOutputStream, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_SubOutputStream, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_Read
+|   ATX_OutputStream interface
 +---------------------------------------------------------------------*/
-ATX_METHOD
-ATX_MemoryStream_Read(ATX_InputStream* _self,
-                      ATX_Any          buffer, 
-                      ATX_Size         bytes_to_read, 
-                      ATX_Size*        bytes_read)
-{
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
-    ATX_Size          available;
-
-    /* check for shortcut */
-    if (bytes_to_read == 0) {
-        if (bytes_read) *bytes_read = 0;
-        return ATX_SUCCESS;
-    }
-
-    /* clip to what's available */
-    available = ATX_DataBuffer_GetDataSize(self->buffer);
-    if (self->read_offset+bytes_to_read > available) {
-        bytes_to_read = (ATX_Size)(available-self->read_offset);
-    }
-
-    /* copy the data */
-    if (bytes_to_read) {
-        ATX_CopyMemory(buffer, (void*)(((char*)ATX_DataBuffer_UseData(self->buffer))+self->read_offset), bytes_to_read);
-        self->read_offset += bytes_to_read;
-    } 
-    if (bytes_read) *bytes_read = bytes_to_read;
+ATX_BEGIN_INTERFACE_MAP(ATX_SubOutputStream, ATX_OutputStream)
+    ATX_SubOutputStream_Write,
+    ATX_SubOutputStream_Seek,
+    ATX_SubOutputStream_Tell,
+    ATX_SubOutputStream_Flush
+};
 
-    return bytes_to_read?ATX_SUCCESS:ATX_ERROR_EOS; 
-}
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_SubOutputStream, reference_count)
 
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_InputSeek
+|   ATX_Stream_IsDatagramSocket
 +---------------------------------------------------------------------*/
-ATX_METHOD
-ATX_MemoryStream_InputSeek(ATX_InputStream* _self, 
-                           ATX_Position     offset)
+static ATX_Boolean
+ATX_Stream_IsDatagramSocket(int fd, const struct stat* info)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
-    if (offset > ATX_DataBuffer_GetDataSize(self->buffer)) {
-        return ATX_ERROR_INVALID_PARAMETERS;
-    } else {
-        self->read_offset = offset;
-        return ATX_SUCCESS;
-    }
+    int       type = 0;
+    socklen_t length = sizeof(type);
+    
+    if (!S_ISSOCK(info->st_mode)) return ATX_FALSE;
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length)) return ATX_TRUE;
+    return type != SOCK_STREAM;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_InputTell
+|   ATX_Stream_DrainPipe
+|
+|   Copy what is left in a pipe to a descriptor with read/write, when
+|   splice won't take it.
 +---------------------------------------------------------------------*/
-ATX_METHOD
-ATX_MemoryStream_InputTell(ATX_InputStream* _self, 
-                           ATX_Position*    where)
+static ATX_Result
+ATX_Stream_DrainPipe(int            pipe_fd,
+                     int            out_fd,
+                     ATX_Size       pending,
+                     ATX_LargeSize* copied)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
-    if (where) *where = self->read_offset;
+    ATX_Byte buffer[4096];
+    
+    while (pending) {
+        ssize_t nb_read = read(pipe_fd, buffer, pending < sizeof(buffer) ? pending : sizeof(buffer));
+        ssize_t offset  = 0;
+        if (nb_read < 0 && errno == EINTR) continue;
+        if (nb_read <= 0) return nb_read < 0 ? ATX_ERROR_ERRNO(errno) : ATX_ERROR_INTERNAL;
+        
+        while (offset < nb_read) {
+            ssize_t nb_written = write(out_fd, buffer+offset, (size_t)(nb_read-offset));
+            if (nb_written < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    /* the data is already out of the pipe, wait for room */
+                    struct pollfd poll_fd;
+                    poll_fd.fd      = out_fd;
+                    poll_fd.events  = POLLOUT;
+                    poll_fd.revents = 0;
+                    if (poll(&poll_fd, 1, -1) >= 0 || errno == EINTR) continue;
+                }
+                return ATX_ERROR_ERRNO(errno);
+            }
+            offset  += nb_written;
+            *copied += nb_written;
+        }
+        pending -= (ATX_Size)nb_read;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Stream_PumpDescriptors
+|
+|   Move data from one descriptor to another inside the kernel.
+|   Returns ATX_ERROR_NOT_SUPPORTED if the kernel can't do it for these 
+|   descriptors. What was moved before that is counted in copied, and 
+|   the caller carries on with read/write.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Stream_PumpDescriptors(int            in_fd, 
+                           int            out_fd, 
+                           ATX_LargeSize  max_bytes,
+                           ATX_LargeSize* copied)
+{
+    struct stat in_info;
+    struct stat out_info;
+    int         pipe_fds[2] = {-1, -1};
+    int         splice_out_fd = out_fd;
+    int         out_flags;
+    ATX_Boolean use_copy_range = ATX_FALSE;
+    ATX_Result  result = ATX_SUCCESS;
+
+    if (fstat(in_fd, &in_info) || fstat(out_fd, &out_info)) {
+        return ATX_ERROR_NOT_SUPPORTED;
+    }
+    
+    /* none of sendfile, splice and copy_file_range write in append mode */
+    out_flags = fcntl(out_fd, F_GETFL);
+    if (out_flags < 0 || (out_flags & O_APPEND)) {
+        return ATX_ERROR_NOT_SUPPORTED;
+    }
+    
+    /* leave datagram sockets to Read/Write, to keep packet boundaries */
+    if (ATX_Stream_IsDatagramSocket(in_fd,  &in_info) ||
+        ATX_Stream_IsDatagramSocket(out_fd, &out_info)) {
+        return ATX_ERROR_NOT_SUPPORTED;
+    }
+    
+    /* splice needs a pipe on one side */
+    if (!S_ISREG(in_info.st_mode) && 
+        !S_ISFIFO(in_info.st_mode) && 
+        !S_ISFIFO(out_info.st_mode)) {
+        if (pipe(pipe_fds)) return ATX_ERROR_NOT_SUPPORTED;
+        splice_out_fd = pipe_fds[1];
+    }
+#if defined(ATX_CONFIG_HAVE_COPY_FILE_RANGE)
+    use_copy_range = S_ISREG(in_info.st_mode) && S_ISREG(out_info.st_mode);
+#endif
+
+    for (;;) {
+        size_t  chunk = ATX_STREAM_PUMP_KERNEL_CHUNK_SIZE;
+        ssize_t nb_moved;
+        
+        if (max_bytes) {
+            if (*copied >= max_bytes) break;
+            if (max_bytes-*copied < chunk) chunk = (size_t)(max_bytes-*copied);
+        }
+        
+        if (S_ISREG(in_info.st_mode)) {
+#if defined(ATX_CONFIG_HAVE_COPY_FILE_RANGE)
+            if (use_copy_range) {
+                nb_moved = copy_file_range(in_fd, NULL, out_fd, NULL, chunk, 0);
+                if (nb_moved < 0 && errno != EINTR && *copied == 0) {
+                    /* not for these file systems, try sendfile */
+                    use_copy_range = ATX_FALSE;
+                    continue;
+                }
+            } else 
+#endif
+            nb_moved = sendfile(out_fd, in_fd, NULL, chunk);
+        } else {
+            nb_moved = splice(in_fd, NULL, splice_out_fd, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+        }
+        if (nb_moved < 0) {
+            if (errno == EINTR) continue;
+            if (*copied == 0 && (errno == EINVAL || errno == ENOSYS)) {
+                result = ATX_ERROR_NOT_SUPPORTED;
+            } else {
+                result = ATX_ERROR_ERRNO(errno);
+            }
+            break;
+        }
+        if (nb_moved == 0) break; /* end of input */
+        
+        if (splice_out_fd != out_fd) {
+            /* drain the pipe into the output */
+            ssize_t pending = nb_moved;
+            while (pending) {
+                ssize_t nb_written = splice(pipe_fds[0], NULL, out_fd, NULL, (size_t)pending, SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (nb_written < 0 && errno == EINTR) continue;
+                if (nb_written <= 0) {
+                    /* the data has left the input, so don't drop it: copy 
+                       it out of the pipe and let the caller take over */
+                    result = ATX_Stream_DrainPipe(pipe_fds[0], out_fd, (ATX_Size)pending, copied);
+                    if (ATX_SUCCEEDED(result)) result = ATX_ERROR_NOT_SUPPORTED;
+                    break;
+                }
+                pending -= nb_written;
+                *copied += nb_written;
+            }
+            if (ATX_FAILED(result)) break;
+        } else {
+            *copied += nb_moved;
+        }
+    }
+    
+    if (pipe_fds[0] >= 0) close(pipe_fds[0]);
+    if (pipe_fds[1] >= 0) close(pipe_fds[1]);
+    
+    return result;
+}
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_Stream_Pump
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Stream_Pump(ATX_InputStream*  input,
+                ATX_OutputStream* output,
+                ATX_LargeSize     max_bytes,
+                ATX_LargeSize*    bytes_copied)
+{
+    ATX_LargeSize copied = 0;
+    ATX_Byte*     buffer;
+    ATX_Result    result = ATX_SUCCESS;
+
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+    /* let the kernel do it if both sides are descriptors */
+    {
+        ATX_DescriptorStream* in_descriptor  = ATX_CAST(input,  ATX_DescriptorStream);
+        ATX_DescriptorStream* out_descriptor = ATX_CAST(output, ATX_DescriptorStream);
+        int                   in_fd;
+        int                   out_fd;
+        
+        if (in_descriptor  && ATX_SUCCEEDED(ATX_DescriptorStream_GetDescriptor(in_descriptor,  &in_fd)) &&
+            out_descriptor && ATX_SUCCEEDED(ATX_DescriptorStream_GetDescriptor(out_descriptor, &out_fd))) {
+            result = ATX_Stream_PumpDescriptors(in_fd, out_fd, max_bytes, &copied);
+            if (copied) {
+                ATX_DescriptorStream_Advance(in_descriptor,  copied);
+                ATX_DescriptorStream_Advance(out_descriptor, copied);
+            }
+            if (result != ATX_ERROR_NOT_SUPPORTED) {
+                if (bytes_copied) *bytes_copied = copied;
+                if (ATX_SUCCEEDED(result) && copied == 0) return ATX_ERROR_EOS;
+                return result;
+            }
+            result = ATX_SUCCESS;
+        }
+    }
+#endif
+
+    /* data that is already in memory can be written from where it is */
+    {
+        ATX_MappedInputStream* mapped = ATX_CAST(input, ATX_MappedInputStream);
+        if (mapped) {
+            for (;;) {
+                const ATX_Byte* data = NULL;
+                ATX_Size        chunk = ATX_STREAM_PUMP_KERNEL_CHUNK_SIZE;
+                ATX_Size        bytes_read = 0;
+                
+                if (max_bytes) {
+                    if (copied >= max_bytes) break;
+                    if (max_bytes-copied < chunk) chunk = (ATX_Size)(max_bytes-copied);
+                }
+                result = ATX_MappedInputStream_ReadPointer(mapped, chunk, &data, &bytes_read);
+                if (ATX_FAILED(result) || bytes_read == 0) break;
+                result = ATX_OutputStream_WriteFully(output, data, bytes_read);
+                if (ATX_FAILED(result)) break;
+                copied += bytes_read;
+            }
+            goto end;
+        }
+    }
+    
+    /* copy through a buffer */
+    buffer = (ATX_Byte*)ATX_AllocateMemory(ATX_STREAM_PUMP_BUFFER_SIZE);
+    if (buffer == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    for (;;) {
+        ATX_Size chunk = ATX_STREAM_PUMP_BUFFER_SIZE;
+        ATX_Size bytes_read = 0;
+        
+        if (max_bytes) {
+            if (copied >= max_bytes) break;
+            if (max_bytes-copied < chunk) chunk = (ATX_Size)(max_bytes-copied);
+        }
+        result = ATX_InputStream_Read(input, buffer, chunk, &bytes_read);
+        if (ATX_FAILED(result) || bytes_read == 0) break;
+        result = ATX_OutputStream_WriteFully(output, buffer, bytes_read);
+        if (ATX_FAILED(result)) break;
+        copied += bytes_read;
+    }
+    ATX_FreeMemory((void*)buffer);
+    
+end:
+    if (bytes_copied) *bytes_copied = copied;
+    if (result == ATX_ERROR_EOS && copied) result = ATX_SUCCESS;
+    if (ATX_SUCCEEDED(result) && copied == 0) result = ATX_ERROR_EOS;
+
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader
++---------------------------------------------------------------------*/
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_BufferedInputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal     reference_count;
+    ATX_InputStream* source;
+    ATX_Byte*        buffer;
+    ATX_Size         buffer_size;
+    ATX_Size         offset; /* start of the buffered data */
+    ATX_Size         end;    /* end of the buffered data   */
+} ATX_BufferedReader;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_BufferedReader, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_BufferedReader, ATX_BufferedInputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_BufferedReader, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedInputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferedInputStream_Create(ATX_InputStream*  source,
+                               ATX_Size          buffer_size,
+                               ATX_InputStream** object)
+{
+    ATX_BufferedReader* stream;
+    
+    /* default value */
+    *object = NULL;
+    if (buffer_size == 0) buffer_size = ATX_BUFFERED_INPUT_STREAM_DEFAULT_BUFFER_SIZE;
+    
+    /* allocate new object */
+    stream = (ATX_BufferedReader*)ATX_AllocateZeroMemory(sizeof(ATX_BufferedReader));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    stream->buffer = (ATX_Byte*)ATX_AllocateMemory(buffer_size);
+    if (stream->buffer == NULL) {
+        ATX_FreeMemory((void*)stream);
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* construct object */
+    stream->reference_count = 1;
+    stream->source          = source;
+    stream->buffer_size     = buffer_size;
+    stream->offset          = 0;
+    stream->end             = 0;
+    
+    /* keep a reference to the source stream */
+    ATX_REFERENCE_OBJECT(source);
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_BufferedReader, ATX_InputStream);
+    ATX_SET_INTERFACE(stream, ATX_BufferedReader, ATX_BufferedInputStream);
+    ATX_SET_INTERFACE(stream, ATX_BufferedReader, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_InputStream);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_BufferedReader_Destroy(ATX_BufferedReader* self)
+{
+    ATX_RELEASE_OBJECT(self->source);
+    ATX_FreeMemory((void*)self->buffer);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Fill
+|
+|   Read from the source into the free space at the end of the buffer.
+|   Returns ATX_ERROR_EOS if the source has no more data.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_BufferedReader_Fill(ATX_BufferedReader* self)
+{
+    ATX_Size   bytes_read = 0;
+    ATX_Result result;
+    
+    /* move what is left to the start of the buffer */
+    if (self->offset) {
+        if (self->end != self->offset) {
+            ATX_MoveMemory(self->buffer, self->buffer+self->offset, self->end-self->offset);
+        }
+        self->end   -= self->offset;
+        self->offset = 0;
+    }
+    if (self->end == self->buffer_size) return ATX_SUCCESS;
+    
+    result = ATX_InputStream_Read(self->source, 
+                                  self->buffer+self->end, 
+                                  self->buffer_size-self->end, 
+                                  &bytes_read);
+    if (ATX_FAILED(result)) return result;
+    if (bytes_read == 0) return ATX_ERROR_EOS;
+    self->end += bytes_read;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Read
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_Read(ATX_InputStream* _self,
+                        ATX_Any          buffer, 
+                        ATX_Size         bytes_to_read, 
+                        ATX_Size*        bytes_read)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_InputStream);
+    ATX_Size            available;
+
+    if (bytes_read) *bytes_read = 0;
+    if (bytes_to_read == 0) return ATX_SUCCESS;
+    
+    if (self->offset == self->end) {
+        /* large reads go straight to the source */
+        if (bytes_to_read >= self->buffer_size) {
+            return ATX_InputStream_Read(self->source, buffer, bytes_to_read, bytes_read);
+        }
+        ATX_CHECK(ATX_BufferedReader_Fill(self));
+    }
+    
+    /* copy from the buffer */
+    available = self->end-self->offset;
+    if (bytes_to_read > available) bytes_to_read = available;
+    ATX_CopyMemory(buffer, self->buffer+self->offset, bytes_to_read);
+    self->offset += bytes_to_read;
+    if (bytes_read) *bytes_read = bytes_to_read;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_Seek(ATX_InputStream* _self, ATX_Position where)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_InputStream);
+    
+    /* discard the buffer */
+    self->offset = 0;
+    self->end    = 0;
+    
+    return ATX_InputStream_Seek(self->source, where);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_Tell(ATX_InputStream* _self, ATX_Position* where)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_InputStream);
+    ATX_Position        position = 0;
+    ATX_Size            buffered = self->end-self->offset;
+    
+    ATX_CHECK(ATX_InputStream_Tell(self->source, &position));
+    if (where) *where = position > buffered ? position-buffered : 0;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_GetSize
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_GetSize(ATX_InputStream* _self, ATX_LargeSize* size)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_InputStream);
+    return ATX_InputStream_GetSize(self->source, size);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_GetAvailable(ATX_InputStream* _self, ATX_LargeSize* available)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_InputStream);
+    ATX_LargeSize       source_available = 0;
+    
+    if (ATX_FAILED(ATX_InputStream_GetAvailable(self->source, &source_available))) {
+        source_available = 0;
+    }
+    *available = source_available+(self->end-self->offset);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_ReadLine
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_ReadLine(ATX_BufferedInputStream* _self,
+                            char*                    line,
+                            ATX_Size                 line_size,
+                            ATX_Size*                chars_read)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_BufferedInputStream);
+    ATX_Size            total = 0;
+    ATX_Result          result;
+    
+    /* check parameters */
+    if (line == NULL || line_size < 1) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    
+    /* read until EOF or newline, ignoring CR characters */
+    while (total < line_size-1) {
+        const ATX_Byte* start;
+        const ATX_Byte* newline;
+        ATX_Size        chunk;
+        ATX_Size        i;
+        
+        if (self->offset == self->end) {
+            result = ATX_BufferedReader_Fill(self);
+            if (ATX_FAILED(result)) {
+                line[total] = '\0';
+                if (chars_read) *chars_read = total;
+                if (result == ATX_ERROR_EOS && total != 0) return ATX_SUCCESS;
+                return result;
+            }
+        }
+        
+        /* look for the end of the line in what is buffered */
+        start   = self->buffer+self->offset;
+        newline = (const ATX_Byte*)ATX_FindByte(start, '\n', self->end-self->offset);
+        chunk   = newline ? (ATX_Size)(newline-start) : self->end-self->offset;
+        for (i=0; i<chunk && total<line_size-1; i++) {
+            if (start[i] != '\r') line[total++] = (char)start[i];
+        }
+        self->offset += i;
+        if (newline && i == chunk && total < line_size-1) {
+            /* consume the newline */
+            ++self->offset;
+            break;
+        }
+    }
+    
+    /* terminate the line */
+    line[total] = '\0';
+    if (chars_read) *chars_read = total;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_ReadLineString
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_ReadLineString(ATX_BufferedInputStream* _self,
+                                  ATX_String*              string,
+                                  ATX_Size                 max_length)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_BufferedInputStream);
+    ATX_Size            length = 0;
+    ATX_Result          result;
+    
+    /* reset the string */
+    ATX_String_SetLength(string, 0);
+    
+    /* read until EOF or newline, ignoring CR characters */
+    while (length < max_length) {
+        const ATX_Byte* start;
+        const ATX_Byte* newline;
+        ATX_Size        chunk;
+        ATX_Size        i = 0;
+        
+        if (self->offset == self->end) {
+            result = ATX_BufferedReader_Fill(self);
+            if (result == ATX_ERROR_EOS) {
+                return length?ATX_SUCCESS:ATX_ERROR_EOS;
+            }
+            if (ATX_FAILED(result)) return result;
+        }
+        
+        /* look for the end of the line in what is buffered */
+        start   = self->buffer+self->offset;
+        newline = (const ATX_Byte*)ATX_FindByte(start, '\n', self->end-self->offset);
+        chunk   = newline ? (ATX_Size)(newline-start) : self->end-self->offset;
+        while (i < chunk && length < max_length) {
+            ATX_Size run = i;
+            if (start[i] == '\r') {
+                ++i;
+                continue;
+            }
+            while (run < chunk && start[run] != '\r' && length+(run-i) < max_length) ++run;
+            result = ATX_String_AppendSubString(string, (const char*)start+i, run-i);
+            if (ATX_FAILED(result)) {
+                self->offset += i;
+                return result;
+            }
+            length += run-i;
+            i = run;
+        }
+        self->offset += i;
+        if (newline && i == chunk && length < max_length) {
+            /* consume the newline */
+            ++self->offset;
+            return ATX_SUCCESS;
+        }
+    }
+    
+    return ATX_ERROR_NOT_ENOUGH_SPACE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Peek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_Peek(ATX_BufferedInputStream* _self,
+                        ATX_Any                  buffer,
+                        ATX_Size                 bytes_to_peek,
+                        ATX_Size*                bytes_peeked)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_BufferedInputStream);
+    ATX_Size            available = self->end-self->offset;
+    
+    if (bytes_peeked) *bytes_peeked = 0;
+    if (bytes_to_peek == 0) return ATX_SUCCESS;
+    
+    /* try to get more data if we don't have enough */
+    if (available < bytes_to_peek) {
+        ATX_Result result = ATX_BufferedReader_Fill(self);
+        if (ATX_FAILED(result) && result != ATX_ERROR_EOS) return result;
+        available = self->end-self->offset;
+        if (available == 0) return ATX_ERROR_EOS;
+    }
+    
+    /* copy without consuming */
+    if (bytes_to_peek > available) bytes_to_peek = available;
+    ATX_CopyMemory(buffer, self->buffer+self->offset, bytes_to_peek);
+    if (bytes_peeked) *bytes_peeked = bytes_to_peek;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_Unread
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedReader_Unread(ATX_BufferedInputStream* _self,
+                          ATX_AnyConst             buffer,
+                          ATX_Size                 bytes_to_unread)
+{
+    ATX_BufferedReader* self = ATX_SELF(ATX_BufferedReader, ATX_BufferedInputStream);
+    ATX_Size            buffered = self->end-self->offset;
+    
+    if (bytes_to_unread > self->offset) {
+        /* make room at the start of the buffer, growing it if needed */
+        if (buffered+bytes_to_unread > self->buffer_size) {
+            ATX_Size  new_size   = buffered+bytes_to_unread;
+            ATX_Byte* new_buffer = (ATX_Byte*)ATX_AllocateMemory(new_size);
+            if (new_buffer == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+            ATX_CopyMemory(new_buffer+bytes_to_unread, self->buffer+self->offset, buffered);
+            ATX_FreeMemory((void*)self->buffer);
+            self->buffer      = new_buffer;
+            self->buffer_size = new_size;
+        } else {
+            ATX_MoveMemory(self->buffer+bytes_to_unread, self->buffer+self->offset, buffered);
+        }
+        self->offset = bytes_to_unread;
+        self->end    = bytes_to_unread+buffered;
+    }
+    
+    /* put the data back in front of what is buffered */
+    self->offset -= bytes_to_unread;
+    ATX_CopyMemory(self->buffer+self->offset, buffer, bytes_to_unread);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedReader_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_BufferedReader)
+    ATX_GET_INTERFACE_ACCEPT(ATX_BufferedReader, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_BufferedReader, ATX_BufferedInputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_BufferedReader, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_BufferedReader, ATX_InputStream)
+    ATX_BufferedReader_Read,
+    ATX_BufferedReader_Seek,
+    ATX_BufferedReader_Tell,
+    ATX_BufferedReader_GetSize,
+    ATX_BufferedReader_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedInputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_BufferedReader, ATX_BufferedInputStream)
+    ATX_BufferedReader_ReadLine,
+    ATX_BufferedReader_ReadLineString,
+    ATX_BufferedReader_Peek,
+    ATX_BufferedReader_Unread
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_BufferedReader, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter
++---------------------------------------------------------------------*/
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_VectoredOutputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal      reference_count;
+    ATX_OutputStream* sink;
+    ATX_Byte*         buffer;
+    ATX_Size          buffer_size;
+    ATX_Size          buffered;
+} ATX_BufferedWriter;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_BufferedWriter, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_BufferedWriter, ATX_VectoredOutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_BufferedWriter, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedOutputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferedOutputStream_Create(ATX_OutputStream*  sink,
+                                ATX_Size           buffer_size,
+                                ATX_OutputStream** object)
+{
+    ATX_BufferedWriter* stream;
+    
+    /* default value */
+    *object = NULL;
+    if (buffer_size == 0) buffer_size = ATX_BUFFERED_OUTPUT_STREAM_DEFAULT_BUFFER_SIZE;
+    
+    /* allocate new object */
+    stream = (ATX_BufferedWriter*)ATX_AllocateZeroMemory(sizeof(ATX_BufferedWriter));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    stream->buffer = (ATX_Byte*)ATX_AllocateMemory(buffer_size);
+    if (stream->buffer == NULL) {
+        ATX_FreeMemory((void*)stream);
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* construct object */
+    stream->reference_count = 1;
+    stream->sink            = sink;
+    stream->buffer_size     = buffer_size;
+    stream->buffered        = 0;
+    
+    /* keep a reference to the sink stream */
+    ATX_REFERENCE_OBJECT(sink);
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_BufferedWriter, ATX_OutputStream);
+    ATX_SET_INTERFACE(stream, ATX_BufferedWriter, ATX_VectoredOutputStream);
+    ATX_SET_INTERFACE(stream, ATX_BufferedWriter, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_OutputStream);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_WriteBuffer
+|
+|   Write what is buffered to the sink. On failure, what could not be 
+|   written stays in the buffer.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_BufferedWriter_WriteBuffer(ATX_BufferedWriter* self)
+{
+    ATX_Size   offset = 0;
+    ATX_Result result = ATX_SUCCESS;
+    
+    while (offset < self->buffered) {
+        ATX_Size bytes_written = 0;
+        result = ATX_OutputStream_Write(self->sink, 
+                                        self->buffer+offset, 
+                                        self->buffered-offset, 
+                                        &bytes_written);
+        if (ATX_FAILED(result)) break;
+        if (bytes_written == 0) {
+            result = ATX_ERROR_INTERNAL;
+            break;
+        }
+        offset += bytes_written;
+    }
+    
+    /* keep what is left */
+    if (offset && offset < self->buffered) {
+        ATX_MoveMemory(self->buffer, self->buffer+offset, self->buffered-offset);
+    }
+    self->buffered -= offset;
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_BufferedWriter_Destroy(ATX_BufferedWriter* self)
+{
+    /* write what is left, there is no one to report an error to */
+    ATX_BufferedWriter_WriteBuffer(self);
+
+    ATX_RELEASE_OBJECT(self->sink);
+    ATX_FreeMemory((void*)self->buffer);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_Write
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedWriter_Write(ATX_OutputStream* _self,
+                         ATX_AnyConst      buffer, 
+                         ATX_Size          bytes_to_write, 
+                         ATX_Size*         bytes_written)
+{
+    ATX_BufferedWriter* self = ATX_SELF(ATX_BufferedWriter, ATX_OutputStream);
+    const ATX_Byte*     data = (const ATX_Byte*)buffer;
+    ATX_Size            chunk;
+    ATX_Result          result;
+
+    if (bytes_written) *bytes_written = 0;
+    if (bytes_to_write == 0) return ATX_SUCCESS;
+    
+    /* common case: the data fits in the buffer */
+    if (self->buffered+bytes_to_write <= self->buffer_size) {
+        ATX_CopyMemory(self->buffer+self->buffered, data, bytes_to_write);
+        self->buffered += bytes_to_write;
+        if (bytes_written) *bytes_written = bytes_to_write;
+        return ATX_SUCCESS;
+    }
+    
+    /* large writes go straight to the sink, after what is buffered */
+    if (bytes_to_write >= self->buffer_size) {
+        ATX_CHECK(ATX_BufferedWriter_WriteBuffer(self));
+        return ATX_OutputStream_Write(self->sink, buffer, bytes_to_write, bytes_written);
+    }
+    
+    /* top up the buffer, write it out, and keep the rest */
+    chunk = self->buffer_size-self->buffered;
+    ATX_CopyMemory(self->buffer+self->buffered, data, chunk);
+    self->buffered = self->buffer_size;
+    result = ATX_BufferedWriter_WriteBuffer(self);
+    if (ATX_FAILED(result)) {
+        /* the bytes taken so far stay buffered, so report them as written */
+        if (chunk == 0) return result;
+        if (bytes_written) *bytes_written = chunk;
+        return ATX_SUCCESS;
+    }
+    ATX_CopyMemory(self->buffer, data+chunk, bytes_to_write-chunk);
+    self->buffered = bytes_to_write-chunk;
+    if (bytes_written) *bytes_written = bytes_to_write;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_WriteV
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedWriter_WriteV(ATX_VectoredOutputStream* _self,
+                          const ATX_IoVec*          buffers,
+                          ATX_Cardinal              buffer_count,
+                          ATX_Size*                 bytes_written)
+{
+    ATX_BufferedWriter* self = ATX_SELF(ATX_BufferedWriter, ATX_VectoredOutputStream);
+    ATX_Size            total = 0;
+    ATX_Cardinal        i;
+
+    if (bytes_written) *bytes_written = 0;
+    for (i=0; i<buffer_count; i++) {
+        total += buffers[i].size;
+    }
+    
+    /* large writes go straight to the sink, after what is buffered */
+    if (total >= self->buffer_size) {
+        ATX_CHECK(ATX_BufferedWriter_WriteBuffer(self));
+        return ATX_OutputStream_WriteV(self->sink, buffers, buffer_count, bytes_written);
+    }
+    
+    /* collect the buffers, stopping at the first one not taken whole 
+       so that only what was actually buffered is reported */
+    total = 0;
+    for (i=0; i<buffer_count; i++) {
+        ATX_Size   taken = 0;
+        ATX_Result result = ATX_BufferedWriter_Write(&ATX_BASE(self, ATX_OutputStream),
+                                                     buffers[i].buffer,
+                                                     buffers[i].size,
+                                                     &taken);
+        if (ATX_FAILED(result)) {
+            if (total == 0) return result;
+            break;
+        }
+        total += taken;
+        if (taken != buffers[i].size) break;
+    }
+    if (bytes_written) *bytes_written = total;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedWriter_Seek(ATX_OutputStream* _self, ATX_Position where)
+{
+    ATX_BufferedWriter* self = ATX_SELF(ATX_BufferedWriter, ATX_OutputStream);
+    
+    ATX_CHECK(ATX_BufferedWriter_WriteBuffer(self));
+    return ATX_OutputStream_Seek(self->sink, where);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedWriter_Tell(ATX_OutputStream* _self, ATX_Position* where)
+{
+    ATX_BufferedWriter* self = ATX_SELF(ATX_BufferedWriter, ATX_OutputStream);
+    ATX_Position        position = 0;
+    
+    ATX_CHECK(ATX_OutputStream_Tell(self->sink, &position));
+    if (where) *where = position+self->buffered;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_Flush
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_BufferedWriter_Flush(ATX_OutputStream* _self)
+{
+    ATX_BufferedWriter* self = ATX_SELF(ATX_BufferedWriter, ATX_OutputStream);
+    
+    ATX_CHECK(ATX_BufferedWriter_WriteBuffer(self));
+    return ATX_OutputStream_Flush(self->sink);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferedWriter_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_BufferedWriter)
+    ATX_GET_INTERFACE_ACCEPT(ATX_BufferedWriter, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_BufferedWriter, ATX_VectoredOutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_BufferedWriter, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_OutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_BufferedWriter, ATX_OutputStream)
+    ATX_BufferedWriter_Write,
+    ATX_BufferedWriter_Seek,
+    ATX_BufferedWriter_Tell,
+    ATX_BufferedWriter_Flush
+};
+
+/*----------------------------------------------------------------------
+|   ATX_VectoredOutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_BufferedWriter, ATX_VectoredOutputStream)
+    ATX_BufferedWriter_WriteV
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_BufferedWriter, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_Byte*  data;
+    ATX_Size   size;
+} ATX_ReadAheadBuffer;
+
+typedef struct {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal         reference_count;
+    ATX_InputStream*     source;
+    ATX_LargeSize        source_size;
+    ATX_Position         position;
+    ATX_Thread*          thread;
+    ATX_Byte*            data;
+    ATX_ReadAheadBuffer* buffers;
+    ATX_Size             buffer_size;
+    ATX_Cardinal         buffer_count;
+
+    /* shared with the helper thread, protected by the lock */
+    ATX_Mutex*           lock;
+    ATX_Condition*       filled;       /* signaled by the helper thread  */
+    ATX_Condition*       emptied;      /* signaled by the reader         */
+    ATX_Cardinal         head;         /* first filled buffer            */
+    ATX_Cardinal         filled_count;
+    ATX_Size             head_offset;  /* bytes consumed from the head   */
+    ATX_Cardinal         generation;   /* incremented by each seek       */
+    ATX_Boolean          source_ended;
+    ATX_Result           source_result;
+    ATX_Boolean          seek_pending;
+    ATX_Position         seek_target;
+    ATX_Result           seek_result;
+    ATX_Boolean          stopping;
+} ATX_ReadAheadReader;
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_ReadAheadReader, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_ReadAheadReader, ATX_Referenceable)
+static void ATX_ReadAheadReader_Run(void* argument);
+static ATX_Result ATX_ReadAheadReader_Destroy(ATX_ReadAheadReader* self);
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadInputStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ReadAheadInputStream_Create(ATX_InputStream*  source,
+                                ATX_Size          buffer_size,
+                                ATX_Cardinal      buffer_count,
+                                ATX_InputStream** object)
+{
+    ATX_ReadAheadReader* stream;
+    ATX_Cardinal         i;
+    ATX_Result           result;
+    
+    /* default values */
+    *object = NULL;
+    if (buffer_size  == 0) buffer_size  = ATX_READ_AHEAD_INPUT_STREAM_DEFAULT_BUFFER_SIZE;
+    if (buffer_count == 0) buffer_count = ATX_READ_AHEAD_INPUT_STREAM_DEFAULT_BUFFER_COUNT;
+    
+    /* allocate new object */
+    stream = (ATX_ReadAheadReader*)ATX_AllocateZeroMemory(sizeof(ATX_ReadAheadReader));
+    if (stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    /* construct object */
+    stream->reference_count = 1;
+    stream->source          = source;
+    stream->buffer_size     = buffer_size;
+    stream->buffer_count    = buffer_count;
+    stream->source_result   = ATX_SUCCESS;
+    ATX_REFERENCE_OBJECT(source);
+    if (ATX_FAILED(ATX_InputStream_GetSize(source, &stream->source_size))) {
+        stream->source_size = 0;
+    }
+    if (ATX_FAILED(ATX_InputStream_Tell(source, &stream->position))) {
+        stream->position = 0;
+    }
+    
+    /* allocate the buffers */
+    stream->buffers = (ATX_ReadAheadBuffer*)ATX_AllocateZeroMemory(buffer_count*sizeof(ATX_ReadAheadBuffer));
+    stream->data    = (ATX_Byte*)ATX_AllocateMemory(buffer_count*buffer_size);
+    if (stream->buffers == NULL || stream->data == NULL) {
+        result = ATX_ERROR_OUT_OF_MEMORY;
+        goto fail;
+    }
+    for (i=0; i<buffer_count; i++) {
+        stream->buffers[i].data = stream->data+i*buffer_size;
+    }
+    
+    /* start the helper thread */
+    result = ATX_Mutex_Create(&stream->lock);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&stream->filled);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&stream->emptied);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Thread_Create(ATX_ReadAheadReader_Run, stream, &stream->thread);
+    if (ATX_FAILED(result)) goto fail;
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(stream, ATX_ReadAheadReader, ATX_InputStream);
+    ATX_SET_INTERFACE(stream, ATX_ReadAheadReader, ATX_Referenceable);
+    *object = &ATX_BASE(stream, ATX_InputStream);
+
+    return ATX_SUCCESS;
+    
+fail:
+    ATX_ReadAheadReader_Destroy(stream);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_Destroy
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_ReadAheadReader_Destroy(ATX_ReadAheadReader* self)
+{
+    /* stop the helper thread */
+    if (self->thread) {
+        ATX_Mutex_Lock(self->lock);
+        self->stopping = ATX_TRUE;
+        ATX_Condition_Signal(self->emptied);
+        ATX_Mutex_Unlock(self->lock);
+        ATX_Thread_Join(self->thread);
+    }
+    
+    ATX_Condition_Destroy(self->filled);
+    ATX_Condition_Destroy(self->emptied);
+    ATX_Mutex_Destroy(self->lock);
+    ATX_RELEASE_OBJECT(self->source);
+    if (self->buffers) ATX_FreeMemory((void*)self->buffers);
+    if (self->data)    ATX_FreeMemory((void*)self->data);
+    ATX_FreeMemory((void*)self);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_Run
+|
+|   Body of the helper thread: fill free buffers from the source until 
+|   its end, and carry out the seeks requested by the reader. Reading is
+|   done without the lock, and the data is dropped if a seek happened in
+|   the meantime.
++---------------------------------------------------------------------*/
+static void
+ATX_ReadAheadReader_Run(void* argument)
+{
+    ATX_ReadAheadReader* self = (ATX_ReadAheadReader*)argument;
+    
+    ATX_Mutex_Lock(self->lock);
+    while (!self->stopping) {
+        ATX_ReadAheadBuffer* buffer;
+        ATX_Cardinal         generation;
+        ATX_Size             size = 0;
+        ATX_Result           result = ATX_SUCCESS;
+        
+        if (self->seek_pending) {
+            self->seek_result   = ATX_InputStream_Seek(self->source, self->seek_target);
+            self->seek_pending  = ATX_FALSE;
+            self->source_ended  = ATX_FAILED(self->seek_result);
+            self->source_result = self->seek_result;
+            ATX_Condition_Signal(self->filled);
+            continue;
+        }
+        if (self->source_ended || self->filled_count == self->buffer_count) {
+            ATX_Condition_Wait(self->emptied, self->lock);
+            continue;
+        }
+        
+        /* fill the next free buffer */
+        buffer = &self->buffers[(self->head+self->filled_count)%self->buffer_count];
+        generation = self->generation;
+        ATX_Mutex_Unlock(self->lock);
+        while (size < self->buffer_size) {
+            ATX_Size bytes_read = 0;
+            result = ATX_InputStream_Read(self->source, 
+                                          buffer->data+size, 
+                                          self->buffer_size-size, 
+                                          &bytes_read);
+            if (ATX_FAILED(result)) break;
+            size += bytes_read;
+        }
+        ATX_Mutex_Lock(self->lock);
+        if (generation != self->generation) continue;
+        
+        /* queue the buffer, even if empty, so the reader sees the end */
+        buffer->size = size;
+        self->filled_count++;
+        if (ATX_FAILED(result)) {
+            self->source_ended  = ATX_TRUE;
+            self->source_result = result;
+        }
+        ATX_Condition_Signal(self->filled);
+    }
+    ATX_Mutex_Unlock(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_Consume
+|
+|   Called with the lock held.
++---------------------------------------------------------------------*/
+static void
+ATX_ReadAheadReader_Consume(ATX_ReadAheadReader* self, ATX_Size size)
+{
+    self->head_offset += size;
+    self->position    += size;
+    if (self->head_offset == self->buffers[self->head].size) {
+        /* give the buffer back to the helper thread */
+        self->head        = (self->head+1)%self->buffer_count;
+        self->head_offset = 0;
+        self->filled_count--;
+        ATX_Condition_Signal(self->emptied);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_Read
+|
+|   The head buffer belongs to the reader until it is consumed, so it is
+|   copied from without holding the lock.
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ReadAheadReader_Read(ATX_InputStream* _self,
+                         ATX_Any          buffer,
+                         ATX_Size         bytes_to_read,
+                         ATX_Size*        bytes_read)
+{
+    ATX_ReadAheadReader* self = ATX_SELF(ATX_ReadAheadReader, ATX_InputStream);
+    ATX_Size             total = 0;
+    ATX_Result           result = ATX_SUCCESS;
+
+    if (bytes_read) *bytes_read = 0;
+    if (bytes_to_read == 0) return ATX_SUCCESS;
+    
+    ATX_Mutex_Lock(self->lock);
+    
+    /* wait for data */
+    while (self->filled_count == 0 && !self->source_ended) {
+        ATX_Condition_Wait(self->filled, self->lock);
+    }
+    
+    /* copy what is buffered, without waiting for more */
+    while (total < bytes_to_read && self->filled_count) {
+        ATX_ReadAheadBuffer* head  = &self->buffers[self->head];
+        ATX_Size             chunk = head->size-self->head_offset;
+        
+        if (chunk > bytes_to_read-total) chunk = bytes_to_read-total;
+        if (chunk) {
+            ATX_Mutex_Unlock(self->lock);
+            ATX_CopyMemory((ATX_Byte*)buffer+total, head->data+self->head_offset, chunk);
+            ATX_Mutex_Lock(self->lock);
+        }
+        ATX_ReadAheadReader_Consume(self, chunk);
+        total += chunk;
+    }
+    if (total == 0) result = self->source_result;
+    
+    ATX_Mutex_Unlock(self->lock);
+    
+    if (bytes_read) *bytes_read = total;
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_Seek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ReadAheadReader_Seek(ATX_InputStream* _self, 
+                         ATX_Position     where)
+{
+    ATX_ReadAheadReader* self = ATX_SELF(ATX_ReadAheadReader, ATX_InputStream);
+    ATX_LargeSize        buffered = 0;
+    ATX_Cardinal         i;
+    ATX_Result           result;
+
+    /* shortcut */
+    if (where == self->position) return ATX_SUCCESS;
+    
+    ATX_Mutex_Lock(self->lock);
+    
+    /* skip forward within the buffered data if possible */
+    for (i=0; i<self->filled_count; i++) {
+        buffered += self->buffers[(self->head+i)%self->buffer_count].size;
+    }
+    buffered -= self->head_offset;
+    if (where > self->position && where-self->position < buffered) {
+        while (self->position < where) {
+            ATX_Size chunk = self->buffers[self->head].size-self->head_offset;
+            if (chunk > where-self->position) chunk = (ATX_Size)(where-self->position);
+            ATX_ReadAheadReader_Consume(self, chunk);
+        }
+        ATX_Mutex_Unlock(self->lock);
+        return ATX_SUCCESS;
+    }
+    
+    /* drop the buffers and let the helper thread seek */
+    self->generation++;
+    self->filled_count = 0;
+    self->head_offset  = 0;
+    self->seek_pending = ATX_TRUE;
+    self->seek_target  = where;
+    ATX_Condition_Signal(self->emptied);
+    while (self->seek_pending) {
+        ATX_Condition_Wait(self->filled, self->lock);
+    }
+    result = self->seek_result;
+    if (ATX_SUCCEEDED(result)) self->position = where;
+    
+    ATX_Mutex_Unlock(self->lock);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_Tell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ReadAheadReader_Tell(ATX_InputStream* _self, 
+                         ATX_Position*    where)
+{
+    ATX_ReadAheadReader* self = ATX_SELF(ATX_ReadAheadReader, ATX_InputStream);
+    if (where) *where = self->position;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_GetSize
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ReadAheadReader_GetSize(ATX_InputStream* _self, 
+                            ATX_LargeSize*   size)
+{
+    ATX_ReadAheadReader* self = ATX_SELF(ATX_ReadAheadReader, ATX_InputStream);
+    if (size) *size = self->source_size;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ReadAheadReader_GetAvailable(ATX_InputStream* _self, 
+                                 ATX_LargeSize*   available)
+{
+    ATX_ReadAheadReader* self = ATX_SELF(ATX_ReadAheadReader, ATX_InputStream);
+    ATX_LargeSize        buffered = 0;
+    ATX_Cardinal         i;
+    
+    if (self->source_size > (ATX_LargeSize)self->position) {
+        *available = self->source_size-self->position;
+        return ATX_SUCCESS;
+    }
+    
+    /* unknown size: only count what is buffered */
+    ATX_Mutex_Lock(self->lock);
+    for (i=0; i<self->filled_count; i++) {
+        buffered += self->buffers[(self->head+i)%self->buffer_count].size;
+    }
+    if (self->filled_count) buffered -= self->head_offset;
+    ATX_Mutex_Unlock(self->lock);
+    *available = buffered;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ReadAheadReader_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_ReadAheadReader)
+    ATX_GET_INTERFACE_ACCEPT(ATX_ReadAheadReader, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_ReadAheadReader, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_ReadAheadReader, ATX_InputStream)
+    ATX_ReadAheadReader_Read,
+    ATX_ReadAheadReader_Seek,
+    ATX_ReadAheadReader_Tell,
+    ATX_ReadAheadReader_GetSize,
+    ATX_ReadAheadReader_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_IMPLEMENT_REFERENCEABLE_INTERFACE(ATX_ReadAheadReader, reference_count)
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream
++---------------------------------------------------------------------*/
+struct ATX_MemoryStream {
+    /* intefaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal    reference_count;
+    ATX_DataBuffer* buffer;
+    ATX_Position    read_offset;
+    ATX_Position    write_offset;
+};
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_MemoryStream, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_MemoryStream, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_MemoryStream, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_MemoryStream_Create(ATX_Size size, ATX_MemoryStream** stream)
+{ 
+    return ATX_MemoryStream_CreateFromBuffer(NULL, size, stream);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_CreateFromBuffer
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_MemoryStream_CreateFromBuffer(ATX_Byte*          buffer, 
+                                  ATX_Size           size, 
+                                  ATX_MemoryStream** stream)
+{ 
+    ATX_Result result;
+
+    /* allocate the object */
+    *stream = ATX_AllocateZeroMemory(sizeof(ATX_MemoryStream));
+    if (*stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+
+    /* construct the object */
+    if (buffer == NULL) {
+        result = ATX_DataBuffer_Create(size, &(*stream)->buffer);
+    } else {
+        result = ATX_DataBuffer_Create(0, &(*stream)->buffer);
+    }
+    if (ATX_FAILED(result)) {
+        ATX_FreeMemory((void*)(*stream));
+        return result;
+    }
+    
+    /* set the buffer if needed */
+    if (buffer != NULL) {
+        result = ATX_DataBuffer_SetBuffer((*stream)->buffer, 
+                                          buffer,
+                                          size);
+        if (ATX_SUCCEEDED(result)) {
+            result = ATX_DataBuffer_SetDataSize((*stream)->buffer, size);
+        }
+        if (ATX_FAILED(result)) {
+            ATX_DataBuffer_Destroy((*stream)->buffer);
+            ATX_FreeMemory((void*)(*stream));
+            return result;
+        }
+    }
+    
+    (*stream)->reference_count = 1;
+    (*stream)->read_offset = 0;
+    (*stream)->write_offset = 0;
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(*stream, ATX_MemoryStream, ATX_InputStream);
+    ATX_SET_INTERFACE(*stream, ATX_MemoryStream, ATX_OutputStream);
+    ATX_SET_INTERFACE(*stream, ATX_MemoryStream, ATX_Referenceable);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_AddReference
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_MemoryStream_AddReference(ATX_Referenceable* _self)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_Referenceable);
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_Release
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_MemoryStream_Release(ATX_Referenceable* _self)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_Referenceable);
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
+        ATX_DataBuffer_Destroy(self->buffer);
+        ATX_FreeMemory((void*)self);
+    }
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_MemoryStream_Destroy(ATX_MemoryStream* self)
+{
+    return ATX_MemoryStream_Release(&ATX_BASE(self, ATX_Referenceable));
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_GetBuffer
++---------------------------------------------------------------------*/
+ATX_Result 
+ATX_MemoryStream_GetBuffer(ATX_MemoryStream*       self, 
+                           const ATX_DataBuffer**  buffer)
+{
+    *buffer = self->buffer;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_GetInputStream
++---------------------------------------------------------------------*/
+ATX_Result 
+ATX_MemoryStream_GetInputStream(ATX_MemoryStream* self,
+                                ATX_InputStream** stream)
+{
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+    *stream = &ATX_BASE(self, ATX_InputStream);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_GetOutputStream
++---------------------------------------------------------------------*/
+ATX_Result 
+ATX_MemoryStream_GetOutputStream(ATX_MemoryStream*  self,
+                                 ATX_OutputStream** stream)
+{
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+    *stream = &ATX_BASE(self, ATX_OutputStream);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_Read
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_Read(ATX_InputStream* _self,
+                      ATX_Any          buffer, 
+                      ATX_Size         bytes_to_read, 
+                      ATX_Size*        bytes_read)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
+    ATX_Size          available;
+
+    /* check for shortcut */
+    if (bytes_to_read == 0) {
+        if (bytes_read) *bytes_read = 0;
+        return ATX_SUCCESS;
+    }
+
+    /* clip to what's available */
+    available = ATX_DataBuffer_GetDataSize(self->buffer);
+    if (self->read_offset+bytes_to_read > available) {
+        bytes_to_read = (ATX_Size)(available-self->read_offset);
+    }
+
+    /* copy the data */
+    if (bytes_to_read) {
+        ATX_CopyMemory(buffer, ATX_DataBuffer_GetData(self->buffer)+self->read_offset, bytes_to_read);
+        self->read_offset += bytes_to_read;
+    } 
+    if (bytes_read) *bytes_read = bytes_to_read;
+
+    return bytes_to_read?ATX_SUCCESS:ATX_ERROR_EOS; 
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_InputSeek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_InputSeek(ATX_InputStream* _self, 
+                           ATX_Position     offset)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
+    if (offset > ATX_DataBuffer_GetDataSize(self->buffer)) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    } else {
+        self->read_offset = offset;
+        return ATX_SUCCESS;
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_InputTell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_InputTell(ATX_InputStream* _self, 
+                           ATX_Position*    where)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
+    if (where) *where = self->read_offset;
     return ATX_SUCCESS;
 }
 
@@ -861,121 +2521,731 @@ ATX_MemoryStream_InputTell(ATX_InputStream* _self,
 |   ATX_MemoryStream_GetSize
 +---------------------------------------------------------------------*/
 ATX_METHOD
-ATX_MemoryStream_GetSize(ATX_InputStream* _self,
-                         ATX_LargeSize*   size)
+ATX_MemoryStream_GetSize(ATX_InputStream* _self,
+                         ATX_LargeSize*   size)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
+    if (size) *size = ATX_DataBuffer_GetDataSize(self->buffer);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_GetAvailable(ATX_InputStream* _self,
+                              ATX_LargeSize*   available)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
+    *available = ATX_DataBuffer_GetDataSize(self->buffer)-self->read_offset; 
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_Write
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_Write(ATX_OutputStream* _self,
+                       ATX_AnyConst      data,
+                       ATX_Size          bytes_to_write,
+                       ATX_Size*         bytes_written)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_OutputStream);
+    ATX_Byte*         destination;
+
+    ATX_CHECK(ATX_DataBuffer_Reserve(self->buffer, (ATX_Size)(self->write_offset+bytes_to_write)));
+    destination = ATX_DataBuffer_UseData(self->buffer);
+    if (destination == NULL && bytes_to_write) {
+        if (bytes_written) *bytes_written = 0;
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+
+    ATX_CopyMemory(destination+self->write_offset, data, bytes_to_write);
+    self->write_offset += bytes_to_write;
+    if (self->write_offset > ATX_DataBuffer_GetDataSize(self->buffer)) {
+        ATX_DataBuffer_SetDataSize(self->buffer, (ATX_Size)self->write_offset);
+    }
+    if (bytes_written) *bytes_written = bytes_to_write;
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_OutputSeek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_OutputSeek(ATX_OutputStream* _self, 
+                            ATX_Position      offset)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_OutputStream);
+    if (offset <= ATX_DataBuffer_GetDataSize(self->buffer)) {
+        self->write_offset = offset;
+        return ATX_SUCCESS;
+    } else {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_OutputTell
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_OutputTell(ATX_OutputStream* _self, 
+                            ATX_Position*     where)
+{
+    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_OutputStream);
+    if (where) *where = self->write_offset;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_Flush
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_MemoryStream_Flush(ATX_OutputStream* self)
+{
+    ATX_COMPILER_UNUSED(self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_MemoryStream_GetInterface
++---------------------------------------------------------------------*/
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_MemoryStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_MemoryStream, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_MemoryStream, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_MemoryStream, ATX_Referenceable)
+ATX_END_GET_INTERFACE_IMPLEMENTATION
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_MemoryStream, ATX_InputStream)
+    ATX_MemoryStream_Read,
+    ATX_MemoryStream_InputSeek,
+    ATX_MemoryStream_InputTell,
+    ATX_MemoryStream_GetSize,
+    ATX_MemoryStream_GetAvailable
+};
+
+/*----------------------------------------------------------------------
+|   ATX_OutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_MemoryStream, ATX_OutputStream)
+    ATX_MemoryStream_Write,
+    ATX_MemoryStream_OutputSeek,
+    ATX_MemoryStream_OutputTell,
+    ATX_MemoryStream_Flush
+};
+
+/*----------------------------------------------------------------------
+|   ATX_Referenceable interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(ATX_MemoryStream, ATX_Referenceable)
+    ATX_MemoryStream_AddReference,
+    ATX_MemoryStream_Release
+};
+
+/*----------------------------------------------------------------------
+|   ATX_BufferSegment
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_Cardinal reference_count;
+    ATX_Size     size;
+} ATX_BufferSegment; /* followed by size bytes of data */
+
+#define ATX_BufferSegment_GetData(segment) ((ATX_Byte*)((segment)+1))
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain
++---------------------------------------------------------------------*/
+typedef struct ATX_BufferChainLink {
+    ATX_BufferSegment*          segment;
+    ATX_Size                    start; /* first byte of data in the segment */
+    ATX_Size                    end;   /* one past the last byte of data    */
+    struct ATX_BufferChainLink* next;
+} ATX_BufferChainLink;
+
+struct ATX_BufferChain {
+    ATX_Size             segment_size;
+    ATX_LargeSize        data_size;
+    ATX_BufferChainLink* head;
+    ATX_BufferChainLink* tail;
+};
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_Create(ATX_Size segment_size, ATX_BufferChain** chain)
+{
+    *chain = (ATX_BufferChain*)ATX_AllocateZeroMemory(sizeof(ATX_BufferChain));
+    if (*chain == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+
+    (*chain)->segment_size = segment_size?segment_size:ATX_BUFFER_CHAIN_DEFAULT_SEGMENT_SIZE;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_AddLink
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_BufferChain_AddLink(ATX_BufferChain*   self, 
+                        ATX_BufferSegment* segment, 
+                        ATX_Size           start, 
+                        ATX_Size           end)
+{
+    ATX_BufferChainLink* link;
+    
+    link = (ATX_BufferChainLink*)ATX_AllocateMemory(sizeof(ATX_BufferChainLink));
+    if (link == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    /* a new segment if none was given */
+    if (segment == NULL) {
+        segment = (ATX_BufferSegment*)ATX_AllocateMemory(sizeof(ATX_BufferSegment)+self->segment_size);
+        if (segment == NULL) {
+            ATX_FreeMemory((void*)link);
+            return ATX_ERROR_OUT_OF_MEMORY;
+        }
+        segment->reference_count = 0;
+        segment->size            = self->segment_size;
+    }
+    ATX_Atomic_Add(&segment->reference_count, 1, ATX_ATOMIC_RELAXED);
+    
+    link->segment = segment;
+    link->start   = start;
+    link->end     = end;
+    link->next    = NULL;
+    if (self->tail) {
+        self->tail->next = link;
+    } else {
+        self->head = link;
+    }
+    self->tail = link;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_RemoveHead
++---------------------------------------------------------------------*/
+static void
+ATX_BufferChain_RemoveHead(ATX_BufferChain* self)
+{
+    ATX_BufferChainLink* link = self->head;
+    
+    self->head = link->next;
+    if (self->head == NULL) self->tail = NULL;
+    if (ATX_Atomic_Add(&link->segment->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
+        ATX_FreeMemory((void*)link->segment);
+    }
+    ATX_FreeMemory((void*)link);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_Clone
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_Clone(const ATX_BufferChain* self, ATX_BufferChain** clone)
+{
+    ATX_BufferChainLink* link;
+    ATX_Result           result;
+
+    ATX_CHECK(ATX_BufferChain_Create(self->segment_size, clone));
+    
+    /* share the segments */
+    for (link = self->head; link; link = link->next) {
+        result = ATX_BufferChain_AddLink(*clone, link->segment, link->start, link->end);
+        if (ATX_FAILED(result)) {
+            ATX_BufferChain_Destroy(*clone);
+            *clone = NULL;
+            return result;
+        }
+    }
+    (*clone)->data_size = self->data_size;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_Destroy(ATX_BufferChain* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    while (self->head) ATX_BufferChain_RemoveHead(self);
+    ATX_FreeMemory((void*)self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_GetDataSize
++---------------------------------------------------------------------*/
+ATX_LargeSize
+ATX_BufferChain_GetDataSize(const ATX_BufferChain* self)
+{
+    return self->data_size;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_GetIn
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_GetIn(ATX_BufferChain* self, ATX_ByteBuffer* in, ATX_Size* space)
+{
+    ATX_BufferChainLink* tail = self->tail;
+    
+    /* the tail segment can only be written to if it isn't shared */
+    if (tail == NULL ||
+        ATX_Atomic_Load(&tail->segment->reference_count, ATX_ATOMIC_ACQUIRE) != 1 ||
+        tail->end == tail->segment->size) {
+        ATX_CHECK(ATX_BufferChain_AddLink(self, NULL, 0, 0));
+        tail = self->tail;
+    }
+    *in    = ATX_BufferSegment_GetData(tail->segment)+tail->end;
+    *space = tail->segment->size-tail->end;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_MoveIn
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_MoveIn(ATX_BufferChain* self, ATX_Size size)
+{
+    ATX_BufferChainLink* tail = self->tail;
+    
+    if (size == 0) return ATX_SUCCESS;
+    if (tail == NULL || size > tail->segment->size-tail->end) {
+        return ATX_ERROR_INVALID_PARAMETERS;
+    }
+    tail->end       += size;
+    self->data_size += size;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_Append
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_Append(ATX_BufferChain* self, ATX_AnyConst data, ATX_Size size)
+{
+    const ATX_Byte* source = (const ATX_Byte*)data;
+    
+    while (size) {
+        ATX_ByteBuffer in;
+        ATX_Size       chunk;
+        
+        ATX_CHECK(ATX_BufferChain_GetIn(self, &in, &chunk));
+        if (chunk > size) chunk = size;
+        ATX_CopyMemory(in, source, chunk);
+        ATX_BufferChain_MoveIn(self, chunk);
+        source += chunk;
+        size   -= chunk;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_Peek
++---------------------------------------------------------------------*/
+ATX_Size
+ATX_BufferChain_Peek(const ATX_BufferChain* self, ATX_Any buffer, ATX_Size size)
+{
+    ATX_BufferChainLink* link;
+    ATX_Byte*            dest = (ATX_Byte*)buffer;
+    ATX_Size             copied = 0;
+    
+    for (link = self->head; link && copied < size; link = link->next) {
+        ATX_Size chunk = link->end-link->start;
+        if (chunk > size-copied) chunk = size-copied;
+        ATX_CopyMemory(dest+copied, ATX_BufferSegment_GetData(link->segment)+link->start, chunk);
+        copied += chunk;
+    }
+    
+    return copied;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_Consume
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_BufferChain_Consume(ATX_BufferChain* self, ATX_LargeSize size)
+{
+    if (size > self->data_size) return ATX_ERROR_OUT_OF_RANGE;
+    self->data_size -= size;
+    
+    while (self->head) {
+        ATX_BufferChainLink* head = self->head;
+        ATX_Size             chunk = head->end-head->start;
+        
+        if (chunk > size) {
+            head->start += (ATX_Size)size;
+            break;
+        }
+        size -= chunk;
+        if (head == self->tail && 
+            ATX_Atomic_Load(&head->segment->reference_count, ATX_ATOMIC_ACQUIRE) == 1) {
+            /* keep the last segment around for the next writes */
+            head->start = head->end = 0;
+            break;
+        }
+        ATX_BufferChain_RemoveHead(self);
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_BufferChain_GetIoVecs
++---------------------------------------------------------------------*/
+ATX_Cardinal
+ATX_BufferChain_GetIoVecs(const ATX_BufferChain* self, 
+                          ATX_IoVec*             buffers, 
+                          ATX_Cardinal           max_count)
+{
+    ATX_BufferChainLink* link;
+    ATX_Cardinal         count = 0;
+    
+    for (link = self->head; link && count < max_count; link = link->next) {
+        if (link->end == link->start) continue;
+        buffers[count].buffer = ATX_BufferSegment_GetData(link->segment)+link->start;
+        buffers[count].size   = link->end-link->start;
+        ++count;
+    }
+    
+    return count;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_InputStream_LoadChain
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_InputStream_LoadChain(ATX_InputStream* self, 
+                          ATX_LargeSize    max_read, 
+                          ATX_BufferChain* chain)
+{
+    ATX_LargeSize total_bytes_read = 0;
+    ATX_Result    result = ATX_SUCCESS;
+
+    while (max_read == 0 || total_bytes_read < max_read) {
+        ATX_ByteBuffer in;
+        ATX_Size       space;
+        ATX_Size       bytes_read = 0;
+        
+        /* read straight into the tail of the chain */
+        ATX_CHECK(ATX_BufferChain_GetIn(chain, &in, &space));
+        if (max_read && max_read-total_bytes_read < space) {
+            space = (ATX_Size)(max_read-total_bytes_read);
+        }
+        result = ATX_InputStream_Read(self, in, space, &bytes_read);
+        if (ATX_FAILED(result)) break;
+        if (bytes_read == 0) {
+            result = ATX_ERROR_EOS;
+            break;
+        }
+        ATX_BufferChain_MoveIn(chain, bytes_read);
+        total_bytes_read += bytes_read;
+    }
+
+    return result == ATX_ERROR_EOS ? ATX_SUCCESS : result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream
++---------------------------------------------------------------------*/
+struct ATX_ChainStream {
+    /* interfaces */
+    ATX_IMPLEMENTS(ATX_InputStream);
+    ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_Referenceable);
+
+    /* members */
+    ATX_Cardinal     reference_count;
+    ATX_BufferChain* chain;
+    ATX_Position     read_offset;
+    ATX_Position     write_offset;
+};
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+ATX_DECLARE_INTERFACE_MAP(ATX_ChainStream, ATX_InputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_ChainStream, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(ATX_ChainStream, ATX_Referenceable)
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ChainStream_Create(ATX_Size segment_size, ATX_ChainStream** stream)
+{
+    ATX_Result result;
+    
+    /* allocate the object */
+    *stream = (ATX_ChainStream*)ATX_AllocateZeroMemory(sizeof(ATX_ChainStream));
+    if (*stream == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+
+    /* construct the object */
+    result = ATX_BufferChain_Create(segment_size, &(*stream)->chain);
+    if (ATX_FAILED(result)) {
+        ATX_FreeMemory((void*)(*stream));
+        *stream = NULL;
+        return result;
+    }
+    (*stream)->reference_count = 1;
+
+    /* setup the interfaces */
+    ATX_SET_INTERFACE(*stream, ATX_ChainStream, ATX_InputStream);
+    ATX_SET_INTERFACE(*stream, ATX_ChainStream, ATX_OutputStream);
+    ATX_SET_INTERFACE(*stream, ATX_ChainStream, ATX_Referenceable);
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_AddReference
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_ChainStream_AddReference(ATX_Referenceable* _self)
+{
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_Referenceable);
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_Release
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_ChainStream_Release(ATX_Referenceable* _self)
+{
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_Referenceable);
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
+        ATX_BufferChain_Destroy(self->chain);
+        ATX_FreeMemory((void*)self);
+    }
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ChainStream_Destroy(ATX_ChainStream* self)
+{
+    return ATX_ChainStream_Release(&ATX_BASE(self, ATX_Referenceable));
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_GetChain
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ChainStream_GetChain(ATX_ChainStream* self, ATX_BufferChain** chain)
+{
+    *chain = self->chain;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_GetInputStream
++---------------------------------------------------------------------*/
+ATX_Result 
+ATX_ChainStream_GetInputStream(ATX_ChainStream*  self,
+                               ATX_InputStream** stream)
+{
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+    *stream = &ATX_BASE(self, ATX_InputStream);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_GetOutputStream
++---------------------------------------------------------------------*/
+ATX_Result 
+ATX_ChainStream_GetOutputStream(ATX_ChainStream*   self,
+                                ATX_OutputStream** stream)
+{
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
+    *stream = &ATX_BASE(self, ATX_OutputStream);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_Read
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ChainStream_Read(ATX_InputStream* _self,
+                     ATX_Any          buffer, 
+                     ATX_Size         bytes_to_read, 
+                     ATX_Size*        bytes_read)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
-    if (size) *size = ATX_DataBuffer_GetDataSize(self->buffer);
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_InputStream);
+    ATX_Size         size;
+
+    /* check for shortcut */
+    if (bytes_to_read == 0) {
+        if (bytes_read) *bytes_read = 0;
+        return ATX_SUCCESS;
+    }
+
+    /* copy and consume */
+    size = ATX_BufferChain_Peek(self->chain, buffer, bytes_to_read);
+    ATX_BufferChain_Consume(self->chain, size);
+    self->read_offset += size;
+    if (bytes_read) *bytes_read = size;
+
+    return size?ATX_SUCCESS:ATX_ERROR_EOS; 
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_InputSeek
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ChainStream_InputSeek(ATX_InputStream* _self, 
+                          ATX_Position     offset)
+{
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_InputStream);
+
+    /* consumed data is gone, we can only skip forward */
+    if (offset < self->read_offset) return ATX_ERROR_NOT_SUPPORTED;
+    ATX_CHECK(ATX_BufferChain_Consume(self->chain, offset-self->read_offset));
+    self->read_offset = offset;
+    
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_GetAvailable
+|   ATX_ChainStream_InputTell
 +---------------------------------------------------------------------*/
 ATX_METHOD
-ATX_MemoryStream_GetAvailable(ATX_InputStream* _self,
-                              ATX_LargeSize*   available)
+ATX_ChainStream_InputTell(ATX_InputStream* _self, 
+                          ATX_Position*    where)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_InputStream);
-    *available = ATX_DataBuffer_GetDataSize(self->buffer)-self->read_offset; 
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_InputStream);
+    if (where) *where = self->read_offset;
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_Write
+|   ATX_ChainStream_GetSize
 +---------------------------------------------------------------------*/
 ATX_METHOD
-ATX_MemoryStream_Write(ATX_OutputStream* _self,
-                       ATX_AnyConst      data,
-                       ATX_Size          bytes_to_write,
-                       ATX_Size*         bytes_written)
+ATX_ChainStream_GetSize(ATX_InputStream* _self,
+                        ATX_LargeSize*   size)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_OutputStream);
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_InputStream);
+    if (size) *size = self->read_offset+ATX_BufferChain_GetDataSize(self->chain);
+    return ATX_SUCCESS;
+}
 
-    ATX_CHECK(ATX_DataBuffer_Reserve(self->buffer, (ATX_Size)(self->write_offset+bytes_to_write)));
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_GetAvailable
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ChainStream_GetAvailable(ATX_InputStream* _self,
+                             ATX_LargeSize*   available)
+{
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_InputStream);
+    *available = ATX_BufferChain_GetDataSize(self->chain);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream_Write
++---------------------------------------------------------------------*/
+ATX_METHOD
+ATX_ChainStream_Write(ATX_OutputStream* _self,
+                      ATX_AnyConst      data,
+                      ATX_Size          bytes_to_write,
+                      ATX_Size*         bytes_written)
+{
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_OutputStream);
 
-    ATX_CopyMemory(ATX_DataBuffer_UseData(self->buffer)+self->write_offset, data, bytes_to_write);
+    if (bytes_written) *bytes_written = 0;
+    ATX_CHECK(ATX_BufferChain_Append(self->chain, data, bytes_to_write));
     self->write_offset += bytes_to_write;
-    if (self->write_offset > ATX_DataBuffer_GetDataSize(self->buffer)) {
-        ATX_DataBuffer_SetDataSize(self->buffer, (ATX_Size)self->write_offset);
-    }
     if (bytes_written) *bytes_written = bytes_to_write;
 
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_OutputSeek
+|   ATX_ChainStream_OutputSeek
 +---------------------------------------------------------------------*/
 ATX_METHOD
-ATX_MemoryStream_OutputSeek(ATX_OutputStream* _self, 
-                            ATX_Position      offset)
+ATX_ChainStream_OutputSeek(ATX_OutputStream* _self, 
+                           ATX_Position      offset)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_OutputStream);
-    if (offset <= ATX_DataBuffer_GetDataSize(self->buffer)) {
-        self->write_offset = offset;
-        return ATX_SUCCESS;
-    } else {
-        return ATX_ERROR_INVALID_PARAMETERS;
-    }
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_OutputStream);
+
+    /* the chain can only be appended to */
+    return offset == self->write_offset ? ATX_SUCCESS : ATX_ERROR_NOT_SUPPORTED;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_OutputTell
+|   ATX_ChainStream_OutputTell
 +---------------------------------------------------------------------*/
 ATX_METHOD
-ATX_MemoryStream_OutputTell(ATX_OutputStream* _self, 
-                            ATX_Position*     where)
+ATX_ChainStream_OutputTell(ATX_OutputStream* _self, 
+                           ATX_Position*     where)
 {
-    ATX_MemoryStream* self = ATX_SELF(ATX_MemoryStream, ATX_OutputStream);
+    ATX_ChainStream* self = ATX_SELF(ATX_ChainStream, ATX_OutputStream);
     if (where) *where = self->write_offset;
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_Flush
+|   ATX_ChainStream_Flush
 +---------------------------------------------------------------------*/
 ATX_METHOD
-ATX_MemoryStream_Flush(ATX_OutputStream* self)
+ATX_ChainStream_Flush(ATX_OutputStream* self)
 {
     ATX_COMPILER_UNUSED(self);
     return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
-|   ATX_MemoryStream_GetInterface
+|   ATX_ChainStream_GetInterface
 +---------------------------------------------------------------------*/
-ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_MemoryStream)
-    ATX_GET_INTERFACE_ACCEPT(ATX_MemoryStream, ATX_InputStream)
-    ATX_GET_INTERFACE_ACCEPT(ATX_MemoryStream, ATX_OutputStream)
-    ATX_GET_INTERFACE_ACCEPT(ATX_MemoryStream, ATX_Referenceable)
+ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(ATX_ChainStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_ChainStream, ATX_InputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_ChainStream, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(ATX_ChainStream, ATX_Referenceable)
 ATX_END_GET_INTERFACE_IMPLEMENTATION
 
 /*----------------------------------------------------------------------
 |   ATX_InputStream interface
 +---------------------------------------------------------------------*/
-ATX_BEGIN_INTERFACE_MAP(ATX_MemoryStream, ATX_InputStream)
-    ATX_MemoryStream_Read,
-    ATX_MemoryStream_InputSeek,
-    ATX_MemoryStream_InputTell,
-    ATX_MemoryStream_GetSize,
-    ATX_MemoryStream_GetAvailable
+ATX_BEGIN_INTERFACE_MAP(ATX_ChainStream, ATX_InputStream)
+    ATX_ChainStream_Read,
+    ATX_ChainStream_InputSeek,
+    ATX_ChainStream_InputTell,
+    ATX_ChainStream_GetSize,
+    ATX_ChainStream_GetAvailable
 };
 
 /*----------------------------------------------------------------------
 |   ATX_OutputStream interface
 +---------------------------------------------------------------------*/
-ATX_BEGIN_INTERFACE_MAP(ATX_MemoryStream, ATX_OutputStream)
-    ATX_MemoryStream_Write,
-    ATX_MemoryStream_OutputSeek,
-    ATX_MemoryStream_OutputTell,
-    ATX_MemoryStream_Flush
+ATX_BEGIN_INTERFACE_MAP(ATX_ChainStream, ATX_OutputStream)
+    ATX_ChainStream_Write,
+    ATX_ChainStream_OutputSeek,
+    ATX_ChainStream_OutputTell,
+    ATX_ChainStream_Flush
 };
 
 /*----------------------------------------------------------------------
 |   ATX_Referenceable interface
 +---------------------------------------------------------------------*/
-ATX_BEGIN_INTERFACE_MAP(ATX_MemoryStream, ATX_Referenceable)
-    ATX_MemoryStream_AddReference,
-    ATX_MemoryStream_Release
+ATX_BEGIN_INTERFACE_MAP(ATX_ChainStream, ATX_Referenceable)
+    ATX_ChainStream_AddReference,
+    ATX_ChainStream_Release
 };
@@ -71,6 +71,17 @@ ATX_BEGIN_INTERFACE_DEFINITION(ATX_InputStream)
                                ATX_LargeSize*   available);
 ATX_END_INTERFACE_DEFINITION
 
+/*----------------------------------------------------------------------
+|   ATX_IoVec
++---------------------------------------------------------------------*/
+/**
+ * One buffer of a scatter-gather write.
+ */
+typedef struct {
+    ATX_AnyConst buffer;
+    ATX_Size     size;
+} ATX_IoVec;
+
 /*----------------------------------------------------------------------
 |   ATX_OutputStream
 +---------------------------------------------------------------------*/
@@ -99,6 +110,19 @@ ATX_Result ATX_OutputStream_WriteString(ATX_OutputStream* stream,
                                         ATX_CString       string);
 ATX_Result ATX_OutputStream_WriteLine(ATX_OutputStream* stream,
                                       ATX_CString       line);
+/**
+ * Write the buffers of an ATX_IoVec array, in order, with a single
+ * call to the stream if it implements ATX_VectoredOutputStream, or one
+ * Write per buffer otherwise. Like Write, this may write less than
+ * the total size of the buffers.
+ */
+ATX_Result ATX_OutputStream_WriteV(ATX_OutputStream* stream,
+                                   const ATX_IoVec*  buffers,
+                                   ATX_Cardinal      buffer_count,
+                                   ATX_Size*         bytes_written);
+ATX_Result ATX_OutputStream_WriteVFully(ATX_OutputStream* stream,
+                                        const ATX_IoVec*  buffers,
+                                        ATX_Cardinal      buffer_count);
 ATX_Result ATX_InputStream_ReadLine(ATX_InputStream* stream,
                                     char*            line,
                                     ATX_Size         line_size,
@@ -127,6 +151,23 @@ ATX_Result ATX_InputStream_Skip(ATX_InputStream* stream,
 ATX_Result ATX_InputStream_Load(ATX_InputStream* stream, 
                                 ATX_Size         max_read, /* = 0 if no limit */
                                 ATX_DataBuffer** buffer);
+
+/**
+ * Copy data from an input stream to an output stream, until the end of
+ * the input stream or until max_bytes bytes have been copied.
+ * When both streams implement ATX_DescriptorStream, the data is moved
+ * by the kernel where possible (copy_file_range, sendfile or splice on
+ * Linux). Otherwise it is copied through a large buffer.
+ * Returns ATX_ERROR_EOS if the input was at its end and nothing was
+ * copied.
+ * @param max_bytes Maximum number of bytes to copy, or 0 for no limit.
+ * @param bytes_copied Number of bytes copied, also when an error is
+ * returned. May be NULL.
+ */
+ATX_Result ATX_Stream_Pump(ATX_InputStream*  input,
+                           ATX_OutputStream* output,
+                           ATX_LargeSize     max_bytes,
+                           ATX_LargeSize*    bytes_copied);
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -180,6 +221,119 @@ ATX_END_INTERFACE_DEFINITION
 #define ATX_StreamTransformer_Transform(object, buffer, size) \
 ATX_INTERFACE(object)->Transform(object, buffer, size)
 
+/*----------------------------------------------------------------------
+|   ATX_BufferedInputStream
++---------------------------------------------------------------------*/
+/**
+ * Interface implemented by input streams that buffer their input.
+ * ATX_InputStream_ReadLine and ATX_InputStream_ReadLineString use it
+ * automatically when a stream exposes it, instead of reading one byte
+ * at a time.
+ */
+ATX_DECLARE_INTERFACE(ATX_BufferedInputStream)
+ATX_BEGIN_INTERFACE_DEFINITION(ATX_BufferedInputStream)
+    ATX_Result (*ReadLine)(ATX_BufferedInputStream* self,
+                           char*                    line,
+                           ATX_Size                 line_size,
+                           ATX_Size*                chars_read);
+    ATX_Result (*ReadLineString)(ATX_BufferedInputStream* self,
+                                 ATX_String*              string,
+                                 ATX_Size                 max_length);
+    ATX_Result (*Peek)(ATX_BufferedInputStream* self,
+                       ATX_Any                  buffer,
+                       ATX_Size                 bytes_to_peek,
+                       ATX_Size*                bytes_peeked);
+    ATX_Result (*Unread)(ATX_BufferedInputStream* self,
+                         ATX_AnyConst             buffer,
+                         ATX_Size                 bytes_to_unread);
+ATX_END_INTERFACE_DEFINITION
+
+#define ATX_BufferedInputStream_ReadLine(object, line, line_size, chars_read) \
+ATX_INTERFACE(object)->ReadLine(object, line, line_size, chars_read)
+
+#define ATX_BufferedInputStream_ReadLineString(object, string, max_length) \
+ATX_INTERFACE(object)->ReadLineString(object, string, max_length)
+
+#define ATX_BufferedInputStream_Peek(object, buffer, bytes_to_peek, bytes_peeked) \
+ATX_INTERFACE(object)->Peek(object, buffer, bytes_to_peek, bytes_peeked)
+
+#define ATX_BufferedInputStream_Unread(object, buffer, bytes_to_unread) \
+ATX_INTERFACE(object)->Unread(object, buffer, bytes_to_unread)
+
+/*----------------------------------------------------------------------
+|   ATX_VectoredOutputStream
++---------------------------------------------------------------------*/
+/**
+ * Interface implemented by output streams that can write several
+ * buffers at once (writev, sendmsg, ...). Use ATX_OutputStream_WriteV
+ * rather than calling it directly: it falls back to a Write loop for
+ * streams that don't implement it.
+ * Implementations may write at most ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS 
+ * buffers per call.
+ */
+ATX_DECLARE_INTERFACE(ATX_VectoredOutputStream)
+ATX_BEGIN_INTERFACE_DEFINITION(ATX_VectoredOutputStream)
+    ATX_Result (*WriteV)(ATX_VectoredOutputStream* self,
+                         const ATX_IoVec*          buffers,
+                         ATX_Cardinal              buffer_count,
+                         ATX_Size*                 bytes_written);
+ATX_END_INTERFACE_DEFINITION
+
+#define ATX_VectoredOutputStream_WriteV(object, buffers, buffer_count, bytes_written) \
+ATX_INTERFACE(object)->WriteV(object, buffers, buffer_count, bytes_written)
+
+#define ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS 16
+
+/*----------------------------------------------------------------------
+|   ATX_DescriptorStream
++---------------------------------------------------------------------*/
+/**
+ * Interface implemented by streams backed by an OS file descriptor, so
+ * that ATX_Stream_Pump can move data between them inside the kernel.
+ * GetDescriptor writes or drops anything the stream buffers itself and
+ * leaves the descriptor at the stream's position. Advance tells the
+ * stream that bytes were read or written directly on the descriptor.
+ */
+ATX_DECLARE_INTERFACE(ATX_DescriptorStream)
+ATX_BEGIN_INTERFACE_DEFINITION(ATX_DescriptorStream)
+    ATX_Result (*GetDescriptor)(ATX_DescriptorStream* self, int* fd);
+    ATX_Result (*Advance)(ATX_DescriptorStream* self, ATX_LargeSize count);
+ATX_END_INTERFACE_DEFINITION
+
+#define ATX_DescriptorStream_GetDescriptor(object, fd) \
+ATX_INTERFACE(object)->GetDescriptor(object, fd)
+
+#define ATX_DescriptorStream_Advance(object, count) \
+ATX_INTERFACE(object)->Advance(object, count)
+
+#define ATX_STREAM_PUMP_BUFFER_SIZE 65536
+
+/*----------------------------------------------------------------------
+|   ATX_MappedInputStream
++---------------------------------------------------------------------*/
+/**
+ * Interface implemented by input streams whose data already sits in
+ * memory, such as the streams of an ATX_FileView. ReadPointer returns
+ * a pointer to the next bytes of the stream instead of copying them,
+ * and moves the stream position past them. The data stays valid for as
+ * long as the stream object is alive.
+ */
+ATX_DECLARE_INTERFACE(ATX_MappedInputStream)
+ATX_BEGIN_INTERFACE_DEFINITION(ATX_MappedInputStream)
+    ATX_Result (*ReadPointer)(ATX_MappedInputStream* self,
+                              ATX_Size               max_bytes,
+                              const ATX_Byte**       data,
+                              ATX_Size*              bytes_read);
+ATX_END_INTERFACE_DEFINITION
+
+#define ATX_MappedInputStream_ReadPointer(object, max_bytes, data, bytes_read) \
+ATX_INTERFACE(object)->ReadPointer(object, max_bytes, data, bytes_read)
+
+#define ATX_BUFFERED_INPUT_STREAM_DEFAULT_BUFFER_SIZE  4096
+#define ATX_BUFFERED_OUTPUT_STREAM_DEFAULT_BUFFER_SIZE 4096
+#define ATX_READ_AHEAD_INPUT_STREAM_DEFAULT_BUFFER_SIZE  262144
+#define ATX_READ_AHEAD_INPUT_STREAM_DEFAULT_BUFFER_COUNT 4
+
 /*----------------------------------------------------------------------
 |   ATX_MemoryStream
 +---------------------------------------------------------------------*/
@@ -215,6 +369,100 @@ ATX_MemoryStream_GetOutputStream(ATX_MemoryStream* self,
 }
 #endif /* __cplusplus */
 
+/*----------------------------------------------------------------------
+|   ATX_BufferChain
++---------------------------------------------------------------------*/
+/**
+ * A byte queue stored in a list of fixed-size segments. Data is 
+ * appended at the tail and consumed from the head, and is never moved
+ * once written: growing the chain only adds segments. Segments are
+ * reference counted, so a clone shares them with the original instead 
+ * of copying.
+ */
+typedef struct ATX_BufferChain ATX_BufferChain;
+
+#define ATX_BUFFER_CHAIN_DEFAULT_SEGMENT_SIZE 65536
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @param segment_size Size of the segments, or 0 for the default size.
+ */
+ATX_Result    ATX_BufferChain_Create(ATX_Size segment_size, ATX_BufferChain** chain);
+ATX_Result    ATX_BufferChain_Clone(const ATX_BufferChain* self, ATX_BufferChain** clone);
+ATX_Result    ATX_BufferChain_Destroy(ATX_BufferChain* self);
+ATX_LargeSize ATX_BufferChain_GetDataSize(const ATX_BufferChain* self);
+ATX_Result    ATX_BufferChain_Append(ATX_BufferChain* self, ATX_AnyConst data, ATX_Size size);
+/**
+ * Get writable space at the tail of the chain, adding a segment if 
+ * needed. Call ATX_BufferChain_MoveIn with the number of bytes written
+ * there to append them.
+ */
+ATX_Result    ATX_BufferChain_GetIn(ATX_BufferChain* self, ATX_ByteBuffer* in, ATX_Size* space);
+ATX_Result    ATX_BufferChain_MoveIn(ATX_BufferChain* self, ATX_Size size);
+/**
+ * Copy up to size bytes from the head of the chain without consuming
+ * them. Returns the number of bytes copied.
+ */
+ATX_Size      ATX_BufferChain_Peek(const ATX_BufferChain* self, ATX_Any buffer, ATX_Size size);
+ATX_Result    ATX_BufferChain_Consume(ATX_BufferChain* self, ATX_LargeSize size);
+/**
+ * Describe the data at the head of the chain as at most max_count 
+ * buffers, ready for ATX_OutputStream_WriteV. Returns the number of
+ * buffers filled.
+ */
+ATX_Cardinal  ATX_BufferChain_GetIoVecs(const ATX_BufferChain* self, ATX_IoVec* buffers, ATX_Cardinal max_count);
+
+/**
+ * Read a stream into a chain, appending to what the chain already 
+ * holds. Unlike ATX_InputStream_Load, the data is read directly into
+ * its final place.
+ * @param max_read Maximum number of bytes to read, or 0 for no limit.
+ */
+ATX_Result    ATX_InputStream_LoadChain(ATX_InputStream* stream, 
+                                        ATX_LargeSize    max_read, 
+                                        ATX_BufferChain* chain);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+/*----------------------------------------------------------------------
+|   ATX_ChainStream
++---------------------------------------------------------------------*/
+/**
+ * A memory stream backed by an ATX_BufferChain: writes to the output 
+ * stream append to the chain, and reads from the input stream consume 
+ * from it, so memory is given back as the data is read.
+ */
+typedef struct ATX_ChainStream ATX_ChainStream;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+ATX_Result 
+ATX_ChainStream_Create(ATX_Size segment_size, ATX_ChainStream** stream);
+
+ATX_Result 
+ATX_ChainStream_Destroy(ATX_ChainStream* self);
+
+ATX_Result 
+ATX_ChainStream_GetChain(ATX_ChainStream* self, ATX_BufferChain** chain);
+
+ATX_Result 
+ATX_ChainStream_GetInputStream(ATX_ChainStream*  self,
+                               ATX_InputStream** stream);
+
+ATX_Result 
+ATX_ChainStream_GetOutputStream(ATX_ChainStream*   self,
+                                ATX_OutputStream** stream);
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
 /*----------------------------------------------------------------------
 |   functions
 +---------------------------------------------------------------------*/
@@ -234,6 +482,43 @@ ATX_Result ATX_SubOutputStream_Create(ATX_OutputStream*      parent,
                                       ATX_StreamTransformer* transformer,
                                       ATX_OutputStream**     stream);
 
+/**
+ * Create an input stream that reads from a source stream through a buffer.
+ * The returned stream also implements the ATX_BufferedInputStream 
+ * interface. Reads larger than the buffer bypass it when it is empty.
+ * @param buffer_size Size of the buffer, or 0 for the default size.
+ */
+ATX_Result ATX_BufferedInputStream_Create(ATX_InputStream*  source,
+                                          ATX_Size          buffer_size,
+                                          ATX_InputStream** stream);
+
+/**
+ * Create an output stream that collects small writes in a buffer and 
+ * passes them on to a sink stream in larger chunks.
+ * The buffer is written to the sink when it is full, when the stream
+ * is flushed, seeked, or released. Writes at least as large as the
+ * buffer are passed straight to the sink.
+ * @param buffer_size Size of the buffer, or 0 for the default size.
+ */
+ATX_Result ATX_BufferedOutputStream_Create(ATX_OutputStream*  sink,
+                                           ATX_Size           buffer_size,
+                                           ATX_OutputStream** stream);
+
+/**
+ * Create an input stream that reads from a source stream ahead of the
+ * caller, on a helper thread that keeps up to buffer_count buffers 
+ * filled. Seeking within the buffered data skips it, other seeks drop 
+ * the buffers and restart reading at the new position.
+ * The source stream is only used by the helper thread once this returns,
+ * and its size is read once, when the stream is created.
+ * @param buffer_size Size of each buffer, or 0 for the default size.
+ * @param buffer_count Number of buffers, or 0 for the default count.
+ */
+ATX_Result ATX_ReadAheadInputStream_Create(ATX_InputStream*  source,
+                                           ATX_Size          buffer_size,
+                                           ATX_Cardinal      buffer_count,
+                                           ATX_InputStream** stream);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -46,11 +46,17 @@ extern "C" {
 #endif /* __cplusplus */
 
 extern ATX_Result ATX_System_GetCurrentTimeStamp(ATX_TimeStamp* now);
+extern ATX_Result ATX_System_GetMonotonicTimeStamp(ATX_TimeStamp* now);
 extern ATX_Result ATX_System_Sleep(const ATX_TimeInterval* duration);
 extern ATX_Result ATX_System_SleepUntil(const ATX_TimeStamp* when);
 extern ATX_Result ATX_System_SetRandomSeed(unsigned int seed);
 extern ATX_UInt32 ATX_System_GetRandomInteger(void);
 
+/**
+ * Number of processors (or hardware threads) available, at least 1.
+ */
+extern ATX_Cardinal ATX_System_GetProcessorCount(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,873 @@
+/*****************************************************************
+|
+|   Atomix - Task Pools
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTaskPool.h"
+#include "AtxAtomic.h"
+#include "AtxThreads.h"
+#include "AtxSystem.h"
+#include "AtxUtils.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_TASK_POOL_INITIAL_DEQUE_SIZE 256 /* must be a power of two */
+#define ATX_TASK_POOL_RANGES_PER_WORKER  4
+#define ATX_TASK_POOL_HELP_INTERVAL      1   /* milliseconds */
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+typedef struct ATX_TaskItem ATX_TaskItem;
+struct ATX_TaskItem {
+    ATX_TaskFunction  function;
+    ATX_RangeFunction range_function; /* NULL unless the task is a range */
+    void*             argument;
+    ATX_Size          begin;
+    ATX_Size          end;
+    ATX_Size          grain_size;
+    ATX_Future*       future;         /* NULL if nobody waits for it     */
+    ATX_TaskItem*     next;           /* next task in the shared queue   */
+};
+
+typedef struct ATX_TaskArray ATX_TaskArray;
+struct ATX_TaskArray {
+    ATX_Int64               capacity; /* a power of two       */
+    ATX_TaskItem* volatile* items;
+    ATX_TaskArray*          retired;  /* the previous array, freed with 
+                                         the pool since thieves may 
+                                         still be reading it */
+};
+
+/* a Chase-Lev deque: the owner pushes and takes tasks at the bottom,
+   other workers steal them at the top, and the owner only competes 
+   with thieves for the last task */
+typedef struct {
+    ATX_AtomicInt64         top;
+    ATX_AtomicInt64         bottom;
+    ATX_TaskArray* volatile array;
+} ATX_TaskDeque;
+
+typedef struct {
+    ATX_TaskPool* pool;
+    ATX_Thread*   thread;
+    ATX_ThreadId  thread_id; /* set before the pool is returned */
+    ATX_TaskDeque deque;
+    ATX_UInt32    seed;      /* to pick the workers to steal from */
+} ATX_TaskWorker;
+
+typedef struct ATX_FutureContinuation ATX_FutureContinuation;
+struct ATX_FutureContinuation {
+    ATX_FutureCallback      callback;
+    void*                   argument;
+    ATX_FutureContinuation* next;
+};
+
+struct ATX_Future {
+    ATX_TaskPool*           pool;
+    ATX_AtomicInt           reference_count; /* the caller, and the pool 
+                                                until it is done        */
+    ATX_AtomicInt           remaining;       /* tasks not done yet      */
+    ATX_AtomicInt           result;
+    ATX_AtomicInt           done;
+    ATX_FutureContinuation* continuations;   /* protected by future_lock */
+};
+
+struct ATX_TaskPool {
+    ATX_Cardinal    worker_count;
+    ATX_TaskWorker* workers;
+    ATX_Semaphore*  startup;
+    ATX_AtomicInt   terminating;
+
+    /* tasks submitted by threads that are not workers */
+    ATX_Mutex*      queue_lock;
+    ATX_TaskItem*   queue_head;
+    ATX_TaskItem*   queue_tail;
+    ATX_AtomicInt   queue_length;
+
+    /* workers going to sleep, and the semaphore they sleep on */
+    ATX_AtomicInt   idle_count;
+    ATX_Semaphore*  wakeup;
+
+    /* signaled when any future is done */
+    ATX_Mutex*      future_lock;
+    ATX_Condition*  future_done;
+};
+
+/*----------------------------------------------------------------------
+|   forward declarations
++---------------------------------------------------------------------*/
+static void ATX_Future_Complete(ATX_Future* self, ATX_Result result);
+
+/*----------------------------------------------------------------------
+|   ATX_TaskArray_Create
++---------------------------------------------------------------------*/
+static ATX_TaskArray*
+ATX_TaskArray_Create(ATX_Int64 capacity)
+{
+    ATX_TaskArray* array = (ATX_TaskArray*)ATX_AllocateZeroMemory(
+        sizeof(ATX_TaskArray)+(ATX_Size)capacity*sizeof(ATX_TaskItem*));
+    if (array == NULL) return NULL;
+    
+    array->capacity = capacity;
+    array->items    = (ATX_TaskItem* volatile*)(array+1);
+    return array;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskDeque_Push
+|
+|   Called by the owner only.
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_TaskDeque_Push(ATX_TaskDeque* self, ATX_TaskItem* item)
+{
+    ATX_Int64      bottom = ATX_Atomic_Load64(&self->bottom, ATX_ATOMIC_SEQ_CST);
+    ATX_Int64      top    = ATX_Atomic_Load64(&self->top, ATX_ATOMIC_SEQ_CST);
+    ATX_TaskArray* array  = self->array;
+    
+    if (bottom-top >= array->capacity) {
+        /* full, move the tasks to an array twice as large */
+        ATX_TaskArray* larger = ATX_TaskArray_Create(2*array->capacity);
+        ATX_Int64      i;
+        if (larger == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+        for (i=top; i<bottom; i++) {
+            larger->items[i & (larger->capacity-1)] = 
+                array->items[i & (array->capacity-1)];
+        }
+        larger->retired = array;
+        ATX_Atomic_StorePointer(&self->array, larger, ATX_ATOMIC_RELEASE);
+        array = larger;
+    }
+    
+    ATX_Atomic_StorePointer(&array->items[bottom & (array->capacity-1)], 
+                            item, 
+                            ATX_ATOMIC_RELEASE);
+    ATX_Atomic_Store64(&self->bottom, bottom+1, ATX_ATOMIC_SEQ_CST);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskDeque_Take
+|
+|   Called by the owner only: take the most recently pushed task.
++---------------------------------------------------------------------*/
+static ATX_TaskItem*
+ATX_TaskDeque_Take(ATX_TaskDeque* self)
+{
+    ATX_Int64      bottom = ATX_Atomic_Load64(&self->bottom, ATX_ATOMIC_SEQ_CST)-1;
+    ATX_TaskArray* array  = self->array;
+    ATX_Int64      top;
+    ATX_TaskItem*  item = NULL;
+    
+    /* reserve the bottom task before looking at the top, so that 
+       thieves and the owner never both get it */
+    ATX_Atomic_Store64(&self->bottom, bottom, ATX_ATOMIC_SEQ_CST);
+    top = ATX_Atomic_Load64(&self->top, ATX_ATOMIC_SEQ_CST);
+    if (top <= bottom) {
+        item = (ATX_TaskItem*)ATX_Atomic_LoadPointer(
+            &array->items[bottom & (array->capacity-1)], ATX_ATOMIC_ACQUIRE);
+        if (top == bottom) {
+            /* last task, a thief may be taking it too */
+            if (!ATX_Atomic_CompareAndSwap64(&self->top, top, top+1)) item = NULL;
+            ATX_Atomic_Store64(&self->bottom, bottom+1, ATX_ATOMIC_SEQ_CST);
+        }
+    } else {
+        /* empty */
+        ATX_Atomic_Store64(&self->bottom, bottom+1, ATX_ATOMIC_SEQ_CST);
+    }
+    
+    return item;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskDeque_Steal
+|
+|   Take the oldest task. Sets *aborted if another thread took it first
+|   while the deque was not empty.
++---------------------------------------------------------------------*/
+static ATX_TaskItem*
+ATX_TaskDeque_Steal(ATX_TaskDeque* self, ATX_Boolean* aborted)
+{
+    ATX_Int64      top    = ATX_Atomic_Load64(&self->top, ATX_ATOMIC_SEQ_CST);
+    ATX_Int64      bottom = ATX_Atomic_Load64(&self->bottom, ATX_ATOMIC_SEQ_CST);
+    ATX_TaskArray* array;
+    ATX_TaskItem*  item;
+    
+    if (top >= bottom) return NULL;
+    
+    array = (ATX_TaskArray*)ATX_Atomic_LoadPointer(&self->array, ATX_ATOMIC_ACQUIRE);
+    item  = (ATX_TaskItem*)ATX_Atomic_LoadPointer(
+        &array->items[top & (array->capacity-1)], ATX_ATOMIC_ACQUIRE);
+    if (!ATX_Atomic_CompareAndSwap64(&self->top, top, top+1)) {
+        *aborted = ATX_TRUE;
+        return NULL;
+    }
+    
+    return item;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Inject
++---------------------------------------------------------------------*/
+static void
+ATX_TaskPool_Inject(ATX_TaskPool* self, ATX_TaskItem* item)
+{
+    item->next = NULL;
+    ATX_Mutex_Lock(self->queue_lock);
+    if (self->queue_tail) {
+        self->queue_tail->next = item;
+    } else {
+        self->queue_head = item;
+    }
+    self->queue_tail = item;
+    ATX_Atomic_Add(&self->queue_length, 1, ATX_ATOMIC_SEQ_CST);
+    ATX_Mutex_Unlock(self->queue_lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Dequeue
++---------------------------------------------------------------------*/
+static ATX_TaskItem*
+ATX_TaskPool_Dequeue(ATX_TaskPool* self)
+{
+    ATX_TaskItem* item;
+    
+    /* don't take the lock when there is nothing to take */
+    if (ATX_Atomic_Load(&self->queue_length, ATX_ATOMIC_SEQ_CST) == 0) return NULL;
+    
+    ATX_Mutex_Lock(self->queue_lock);
+    item = self->queue_head;
+    if (item) {
+        self->queue_head = item->next;
+        if (self->queue_head == NULL) self->queue_tail = NULL;
+        ATX_Atomic_Add(&self->queue_length, -1, ATX_ATOMIC_SEQ_CST);
+    }
+    ATX_Mutex_Unlock(self->queue_lock);
+    
+    return item;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_TakeIdle
+|
+|   Decrement the idle count if it is positive. 
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_TaskPool_TakeIdle(ATX_TaskPool* self)
+{
+    ATX_Int32 idle = ATX_Atomic_Load(&self->idle_count, ATX_ATOMIC_SEQ_CST);
+    
+    while (idle > 0) {
+        if (ATX_Atomic_CompareAndSwap(&self->idle_count, idle, idle-1)) {
+            return ATX_TRUE;
+        }
+        idle = ATX_Atomic_Load(&self->idle_count, ATX_ATOMIC_SEQ_CST);
+    }
+    return ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_HasWork
++---------------------------------------------------------------------*/
+static ATX_Boolean
+ATX_TaskPool_HasWork(ATX_TaskPool* self)
+{
+    ATX_Cardinal i;
+    
+    if (ATX_Atomic_Load(&self->queue_length, ATX_ATOMIC_SEQ_CST)) return ATX_TRUE;
+    for (i=0; i<self->worker_count; i++) {
+        ATX_TaskDeque* deque = &self->workers[i].deque;
+        if (ATX_Atomic_Load64(&deque->bottom, ATX_ATOMIC_SEQ_CST) > 
+            ATX_Atomic_Load64(&deque->top, ATX_ATOMIC_SEQ_CST)) {
+            return ATX_TRUE;
+        }
+    }
+    return ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Enqueue
+|
+|   Workers push to their own deque, other threads to the shared queue,
+|   then a sleeping worker is woken up if there is one.
++---------------------------------------------------------------------*/
+static void
+ATX_TaskPool_Enqueue(ATX_TaskPool* self, ATX_TaskWorker* worker, ATX_TaskItem* item)
+{
+    if (worker == NULL || ATX_FAILED(ATX_TaskDeque_Push(&worker->deque, item))) {
+        ATX_TaskPool_Inject(self, item);
+    }
+    if (ATX_TaskPool_TakeIdle(self)) {
+        ATX_Semaphore_Release(self->wakeup, 1);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_GetCurrentWorker
++---------------------------------------------------------------------*/
+static ATX_TaskWorker*
+ATX_TaskPool_GetCurrentWorker(ATX_TaskPool* self)
+{
+    ATX_ThreadId thread_id = ATX_GetCurrentThreadId();
+    ATX_Cardinal i;
+    
+    for (i=0; i<self->worker_count; i++) {
+        if (self->workers[i].thread_id == thread_id) return &self->workers[i];
+    }
+    return NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_FindWork
+|
+|   worker is NULL when called from a thread that is not a worker.
++---------------------------------------------------------------------*/
+static ATX_TaskItem*
+ATX_TaskPool_FindWork(ATX_TaskPool* self, ATX_TaskWorker* worker)
+{
+    ATX_TaskItem* item;
+    ATX_Cardinal  start = 0;
+    ATX_Boolean   aborted;
+    ATX_Cardinal  i;
+    
+    /* our own tasks first, then the ones submitted from outside */
+    if (worker) {
+        item = ATX_TaskDeque_Take(&worker->deque);
+        if (item) return item;
+    }
+    item = ATX_TaskPool_Dequeue(self);
+    if (item) return item;
+    
+    /* steal, starting at a random worker so that thieves spread out */
+    if (worker) {
+        worker->seed = worker->seed*1103515245+12345;
+        start = (worker->seed >> 16) % self->worker_count;
+    }
+    do {
+        aborted = ATX_FALSE;
+        for (i=0; i<self->worker_count; i++) {
+            ATX_TaskWorker* victim = &self->workers[(start+i)%self->worker_count];
+            if (victim == worker) continue;
+            item = ATX_TaskDeque_Steal(&victim->deque, &aborted);
+            if (item) return item;
+        }
+    } while (aborted);
+    
+    return NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Run
++---------------------------------------------------------------------*/
+static void
+ATX_TaskPool_Run(ATX_TaskPool* self, ATX_TaskWorker* worker, ATX_TaskItem* item)
+{
+    ATX_Future* future = item->future;
+    ATX_Result  result;
+    
+    if (item->range_function) {
+        /* split the range, leaving the upper halves to other workers */
+        while (item->end-item->begin > item->grain_size) {
+            ATX_TaskItem* half = (ATX_TaskItem*)ATX_AllocateMemory(sizeof(ATX_TaskItem));
+            if (half == NULL) break;
+            *half = *item;
+            half->begin = item->begin+(item->end-item->begin)/2;
+            item->end   = half->begin;
+            ATX_Atomic_Add(&future->remaining, 1, ATX_ATOMIC_SEQ_CST);
+            ATX_TaskPool_Enqueue(self, worker, half);
+        }
+        result = item->range_function(item->argument, item->begin, item->end);
+    } else {
+        result = item->function(item->argument);
+    }
+    ATX_FreeMemory(item);
+    
+    if (future) ATX_Future_Complete(future, result);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskWorker_Main
++---------------------------------------------------------------------*/
+static void
+ATX_TaskWorker_Main(void* argument)
+{
+    ATX_TaskWorker* self = (ATX_TaskWorker*)argument;
+    ATX_TaskPool*   pool = self->pool;
+    
+    self->thread_id = ATX_GetCurrentThreadId();
+    ATX_Semaphore_Release(pool->startup, 1);
+    
+    for (;;) {
+        ATX_TaskItem* item = ATX_TaskPool_FindWork(pool, self);
+        if (item) {
+            ATX_TaskPool_Run(pool, self, item);
+            continue;
+        }
+        if (ATX_Atomic_Load(&pool->terminating, ATX_ATOMIC_SEQ_CST)) break;
+        
+        /* say that we are going to sleep, then look again, so that a 
+           task submitted in between is not missed: either we see it, 
+           or its submitter sees our idle count and wakes us up */
+        ATX_Atomic_Add(&pool->idle_count, 1, ATX_ATOMIC_SEQ_CST);
+        if (ATX_TaskPool_HasWork(pool) || 
+            ATX_Atomic_Load(&pool->terminating, ATX_ATOMIC_SEQ_CST)) {
+            /* if a submitter took our idle count already, it released
+               the semaphore for us */
+            if (!ATX_TaskPool_TakeIdle(pool)) {
+                ATX_Semaphore_Acquire(pool->wakeup);
+            }
+        } else {
+            ATX_Semaphore_Acquire(pool->wakeup);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TaskPool_Create(ATX_Cardinal worker_count, ATX_TaskPool** pool)
+{
+    ATX_TaskPool* self;
+    ATX_Cardinal  started = 0;
+    ATX_Cardinal  i;
+    ATX_Result    result;
+    
+    *pool = NULL;
+#if !ATX_ATOMIC_IS_LOCK_FREE
+    ATX_COMPILER_UNUSED(self);
+    ATX_COMPILER_UNUSED(started);
+    ATX_COMPILER_UNUSED(i);
+    ATX_COMPILER_UNUSED(result);
+    ATX_COMPILER_UNUSED(worker_count);
+    return ATX_ERROR_NOT_SUPPORTED;
+#else
+    if (worker_count == 0) worker_count = ATX_System_GetProcessorCount();
+    
+    self = (ATX_TaskPool*)ATX_AllocateZeroMemory(sizeof(ATX_TaskPool));
+    if (self == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    self->workers = (ATX_TaskWorker*)ATX_AllocateZeroMemory(
+        worker_count*sizeof(ATX_TaskWorker));
+    if (self->workers == NULL) {
+        result = ATX_ERROR_OUT_OF_MEMORY;
+        goto fail;
+    }
+    self->worker_count = worker_count;
+    
+    result = ATX_Mutex_Create(&self->queue_lock);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Mutex_Create(&self->future_lock);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&self->future_done);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Semaphore_Create(0, &self->wakeup);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Semaphore_Create(0, &self->startup);
+    if (ATX_FAILED(result)) goto fail;
+    
+    for (i=0; i<worker_count; i++) {
+        ATX_TaskWorker* worker = &self->workers[i];
+        worker->pool        = self;
+        worker->seed        = i+1;
+        worker->deque.array = ATX_TaskArray_Create(ATX_TASK_POOL_INITIAL_DEQUE_SIZE);
+        if (worker->deque.array == NULL) {
+            result = ATX_ERROR_OUT_OF_MEMORY;
+            goto fail;
+        }
+    }
+    
+    /* start the workers */
+    for (i=0; i<worker_count; i++) {
+        ATX_ThreadOptions options;
+        char              name[32];
+        
+        ATX_FormatStringN(name, sizeof(name), "atx-task-%u", (unsigned int)i);
+        options.name       = name;
+        options.stack_size = 0;
+        result = ATX_Thread_CreateEx(ATX_TaskWorker_Main, 
+                                     &self->workers[i], 
+                                     &options, 
+                                     &self->workers[i].thread);
+        if (ATX_FAILED(result)) break;
+        ++started;
+    }
+    
+    /* wait until the workers know their thread ids */
+    for (i=0; i<started; i++) {
+        ATX_Semaphore_Acquire(self->startup);
+    }
+    if (ATX_FAILED(result)) goto fail;
+    
+    *pool = self;
+    return ATX_SUCCESS;
+    
+fail:
+    ATX_TaskPool_Destroy(self);
+    return result;
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TaskPool_Destroy(ATX_TaskPool* self)
+{
+    ATX_Cardinal i;
+    
+    if (self == NULL) return ATX_SUCCESS;
+    
+    if (self->workers) {
+        /* the workers stop when they find no more tasks */
+        ATX_Atomic_Store(&self->terminating, 1, ATX_ATOMIC_SEQ_CST);
+        if (self->wakeup) ATX_Semaphore_Release(self->wakeup, self->worker_count);
+        for (i=0; i<self->worker_count; i++) {
+            if (self->workers[i].thread) ATX_Thread_Join(self->workers[i].thread);
+        }
+        for (i=0; i<self->worker_count; i++) {
+            ATX_TaskArray* array = self->workers[i].deque.array;
+            while (array) {
+                ATX_TaskArray* retired = array->retired;
+                ATX_FreeMemory(array);
+                array = retired;
+            }
+        }
+        ATX_FreeMemory(self->workers);
+    }
+    
+    if (self->queue_lock)  ATX_Mutex_Destroy(self->queue_lock);
+    if (self->future_lock) ATX_Mutex_Destroy(self->future_lock);
+    if (self->future_done) ATX_Condition_Destroy(self->future_done);
+    if (self->wakeup)      ATX_Semaphore_Destroy(self->wakeup);
+    if (self->startup)     ATX_Semaphore_Destroy(self->startup);
+    ATX_FreeMemory(self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_GetWorkerCount
++---------------------------------------------------------------------*/
+ATX_Cardinal
+ATX_TaskPool_GetWorkerCount(ATX_TaskPool* self)
+{
+    return self->worker_count;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_Create
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Future_Create(ATX_TaskPool* pool, ATX_Cardinal task_count, ATX_Future** future)
+{
+    *future = (ATX_Future*)ATX_AllocateZeroMemory(sizeof(ATX_Future));
+    if (*future == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    (*future)->pool   = pool;
+    (*future)->result = ATX_SUCCESS;
+    if (task_count) {
+        (*future)->reference_count = 2;
+        (*future)->remaining       = (ATX_Int32)task_count;
+    } else {
+        (*future)->reference_count = 1;
+        (*future)->done            = 1;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_Release
++---------------------------------------------------------------------*/
+static void
+ATX_Future_Release(ATX_Future* self)
+{
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
+        ATX_FreeMemory(self);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_Complete
+|
+|   Called when one of the tasks of the future is done.
++---------------------------------------------------------------------*/
+static void
+ATX_Future_Complete(ATX_Future* self, ATX_Result result)
+{
+    ATX_TaskPool*           pool = self->pool;
+    ATX_FutureContinuation* continuations = NULL;
+    
+    /* keep the first failure */
+    if (ATX_FAILED(result)) {
+        ATX_Atomic_CompareAndSwap(&self->result, ATX_SUCCESS, result);
+    }
+    if (ATX_Atomic_Add(&self->remaining, -1, ATX_ATOMIC_SEQ_CST) != 0) return;
+    
+    /* run the callbacks, in the order they were added, before the future
+       is marked as done, so that waiters see their side effects. Callbacks
+       added while they run are picked up by the next round */
+    result = (ATX_Result)ATX_Atomic_Load(&self->result, ATX_ATOMIC_SEQ_CST);
+    for (;;) {
+        ATX_Mutex_Lock(pool->future_lock);
+        if (self->continuations == NULL) {
+            ATX_Atomic_Store(&self->done, 1, ATX_ATOMIC_SEQ_CST);
+            ATX_Condition_Broadcast(pool->future_done);
+            ATX_Mutex_Unlock(pool->future_lock);
+            break;
+        }
+        while (self->continuations) {
+            ATX_FutureContinuation* continuation = self->continuations;
+            self->continuations = continuation->next;
+            continuation->next = continuations;
+            continuations = continuation;
+        }
+        ATX_Mutex_Unlock(pool->future_lock);
+    
+        while (continuations) {
+            ATX_FutureContinuation* next = continuations->next;
+            continuations->callback(continuations->argument, result);
+            ATX_FreeMemory(continuations);
+            continuations = next;
+        }
+    }
+    
+    ATX_Future_Release(self);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_Submit
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TaskPool_Submit(ATX_TaskPool*    self,
+                    ATX_TaskFunction function,
+                    void*            argument,
+                    ATX_Future**     future)
+{
+    ATX_Task task;
+    
+    task.function = function;
+    task.argument = argument;
+    return ATX_TaskPool_SubmitBatch(self, &task, 1, future);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_SubmitBatch
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TaskPool_SubmitBatch(ATX_TaskPool*   self,
+                         const ATX_Task* tasks,
+                         ATX_Cardinal    task_count,
+                         ATX_Future**    future)
+{
+    ATX_Future*     group = NULL;
+    ATX_TaskItem*   items = NULL;
+    ATX_TaskWorker* worker;
+    ATX_Cardinal    i;
+    
+    if (future) {
+        *future = NULL;
+        ATX_CHECK(ATX_Future_Create(self, task_count, &group));
+    }
+    
+    /* allocate all the tasks first, so that a batch is either submitted
+       entirely or not at all */
+    for (i=task_count; i--;) {
+        ATX_TaskItem* item = (ATX_TaskItem*)ATX_AllocateZeroMemory(sizeof(ATX_TaskItem));
+        if (item == NULL) {
+            while (items) {
+                item = items->next;
+                ATX_FreeMemory(items);
+                items = item;
+            }
+            if (group) ATX_FreeMemory(group);
+            return ATX_ERROR_OUT_OF_MEMORY;
+        }
+        item->function = tasks[i].function;
+        item->argument = tasks[i].argument;
+        item->future   = group;
+        item->next     = items;
+        items = item;
+    }
+    
+    worker = ATX_TaskPool_GetCurrentWorker(self);
+    while (items) {
+        ATX_TaskItem* next = items->next;
+        ATX_TaskPool_Enqueue(self, worker, items);
+        items = next;
+    }
+    
+    if (future) *future = group;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TaskPool_ParallelFor
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TaskPool_ParallelFor(ATX_TaskPool*     self,
+                         ATX_Size          begin,
+                         ATX_Size          end,
+                         ATX_Size          grain_size,
+                         ATX_RangeFunction function,
+                         void*             argument)
+{
+    ATX_TaskItem* item;
+    ATX_Future*   future = NULL;
+    ATX_Result    result = ATX_SUCCESS;
+    
+    if (end <= begin) return ATX_SUCCESS;
+    if (grain_size == 0) {
+        grain_size = (end-begin)/(self->worker_count*ATX_TASK_POOL_RANGES_PER_WORKER);
+        if (grain_size == 0) grain_size = 1;
+    }
+    
+    ATX_CHECK(ATX_Future_Create(self, 1, &future));
+    item = (ATX_TaskItem*)ATX_AllocateZeroMemory(sizeof(ATX_TaskItem));
+    if (item == NULL) {
+        ATX_FreeMemory(future);
+        return ATX_ERROR_OUT_OF_MEMORY;
+    }
+    item->range_function = function;
+    item->argument       = argument;
+    item->begin          = begin;
+    item->end            = end;
+    item->grain_size     = grain_size;
+    item->future         = future;
+    
+    /* the calling thread splits the range and runs the first part */
+    ATX_TaskPool_Run(self, ATX_TaskPool_GetCurrentWorker(self), item);
+    ATX_Future_Wait(future, &result);
+    ATX_Future_Destroy(future);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_Wait
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Future_Wait(ATX_Future* self, ATX_Result* result)
+{
+    if (!ATX_Atomic_Load(&self->done, ATX_ATOMIC_SEQ_CST)) {
+        ATX_TaskPool*   pool   = self->pool;
+        ATX_TaskWorker* worker = ATX_TaskPool_GetCurrentWorker(pool);
+        
+        while (!ATX_Atomic_Load(&self->done, ATX_ATOMIC_SEQ_CST)) {
+            /* help with the pending tasks */
+            ATX_TaskItem* item = ATX_TaskPool_FindWork(pool, worker);
+            if (item) {
+                ATX_TaskPool_Run(pool, worker, item);
+                continue;
+            }
+            
+            /* wait for a future to be done. Workers also look for new 
+               tasks regularly, since other workers may be waiting for 
+               their help: tasks are pushed on the deques without 
+               signaling anything a busy worker could wait on, so a 
+               wake per future would not tell a waiting worker that there
+               is work to steal. Threads that are not workers only need
+               to know when a future is done, and share one condition 
+               rather than allocating one per future, re-checking their
+               own future when woken */
+            ATX_Mutex_Lock(pool->future_lock);
+            if (!ATX_Atomic_Load(&self->done, ATX_ATOMIC_SEQ_CST)) {
+                if (worker) {
+                    ATX_Condition_TimedWait(pool->future_done, 
+                                            pool->future_lock, 
+                                            ATX_TASK_POOL_HELP_INTERVAL);
+                } else {
+                    ATX_Condition_Wait(pool->future_done, pool->future_lock);
+                }
+            }
+            ATX_Mutex_Unlock(pool->future_lock);
+        }
+    }
+    
+    if (result) *result = (ATX_Result)ATX_Atomic_Load(&self->result, ATX_ATOMIC_SEQ_CST);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_IsDone
++---------------------------------------------------------------------*/
+ATX_Boolean
+ATX_Future_IsDone(ATX_Future* self)
+{
+    return ATX_Atomic_Load(&self->done, ATX_ATOMIC_SEQ_CST) ? ATX_TRUE : ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_Then
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Future_Then(ATX_Future*        self, 
+                ATX_FutureCallback callback, 
+                void*              argument)
+{
+    if (!ATX_Atomic_Load(&self->done, ATX_ATOMIC_SEQ_CST)) {
+        ATX_FutureContinuation* continuation;
+        
+        continuation = (ATX_FutureContinuation*)ATX_AllocateMemory(sizeof(ATX_FutureContinuation));
+        if (continuation == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+        continuation->callback = callback;
+        continuation->argument = argument;
+        
+        ATX_Mutex_Lock(self->pool->future_lock);
+        if (!ATX_Atomic_Load(&self->done, ATX_ATOMIC_SEQ_CST)) {
+            continuation->next  = self->continuations;
+            self->continuations = continuation;
+            continuation = NULL;
+        }
+        ATX_Mutex_Unlock(self->pool->future_lock);
+        
+        if (continuation == NULL) return ATX_SUCCESS;
+        ATX_FreeMemory(continuation);
+    }
+    
+    /* already done */
+    callback(argument, (ATX_Result)ATX_Atomic_Load(&self->result, ATX_ATOMIC_SEQ_CST));
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Future_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Future_Destroy(ATX_Future* self)
+{
+    if (self) ATX_Future_Release(self);
+    return ATX_SUCCESS;
+}
@@ -0,0 +1,167 @@
+/*****************************************************************
+|
+|   Atomix - Task Pools
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_TASK_POOL_H_
+#define _ATX_TASK_POOL_H_
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/**
+ * A fixed set of worker threads that run tasks. Each worker has its own
+ * deque of tasks: tasks submitted by a worker go to the bottom of its 
+ * deque, where the worker takes them back in LIFO order, and idle 
+ * workers steal the oldest tasks from the top of other deques. Tasks 
+ * submitted by other threads go through a shared queue.
+ * Tasks may submit other tasks and wait for them.
+ */
+typedef struct ATX_TaskPool ATX_TaskPool;
+
+/**
+ * The completion of a task or of a group of tasks. The result of a 
+ * group is ATX_SUCCESS, or the first failure of its tasks.
+ */
+typedef struct ATX_Future ATX_Future;
+
+typedef ATX_Result (*ATX_TaskFunction)(void* argument);
+typedef ATX_Result (*ATX_RangeFunction)(void*    argument, 
+                                        ATX_Size begin, 
+                                        ATX_Size end);
+typedef void (*ATX_FutureCallback)(void* argument, ATX_Result result);
+
+typedef struct {
+    ATX_TaskFunction function;
+    void*            argument;
+} ATX_Task;
+
+/*----------------------------------------------------------------------
+|   prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a pool with worker_count threads, or one per processor if 
+ * worker_count is 0.
+ * Returns ATX_ERROR_NOT_SUPPORTED if the compiler has no atomic 
+ * operations.
+ */
+ATX_Result
+ATX_TaskPool_Create(ATX_Cardinal worker_count, ATX_TaskPool** pool);
+
+/**
+ * Run the tasks that are still pending, then stop the workers and 
+ * destroy the pool. Must not be called from a task.
+ * Futures obtained from the pool remain valid until they are destroyed.
+ */
+ATX_Result
+ATX_TaskPool_Destroy(ATX_TaskPool* pool);
+
+ATX_Cardinal
+ATX_TaskPool_GetWorkerCount(ATX_TaskPool* pool);
+
+/**
+ * Run function(argument) on a worker. If future is not NULL, it 
+ * receives a new future for the task, to be destroyed by the caller.
+ */
+ATX_Result
+ATX_TaskPool_Submit(ATX_TaskPool*    pool,
+                    ATX_TaskFunction function,
+                    void*            argument,
+                    ATX_Future**     future);
+
+/**
+ * Run task_count tasks, with a single future for the group.
+ */
+ATX_Result
+ATX_TaskPool_SubmitBatch(ATX_TaskPool*   pool,
+                         const ATX_Task* tasks,
+                         ATX_Cardinal    task_count,
+                         ATX_Future**    future);
+
+/**
+ * Call function(argument, b, e) over subranges [b,e) covering 
+ * [begin,end), and wait until they are all done. Ranges are split in 
+ * halves, that other workers can steal, down to grain_size elements 
+ * (or a size picked from the number of workers if grain_size is 0).
+ * The calling thread takes part in the work.
+ * Returns ATX_SUCCESS, or the first failure of function.
+ */
+ATX_Result
+ATX_TaskPool_ParallelFor(ATX_TaskPool*     pool,
+                         ATX_Size          begin,
+                         ATX_Size          end,
+                         ATX_Size          grain_size,
+                         ATX_RangeFunction function,
+                         void*             argument);
+
+/**
+ * Wait until a future is done. The waiting thread runs pending tasks
+ * in the meantime, so tasks can wait for the tasks they submit.
+ * result may be NULL.
+ */
+ATX_Result
+ATX_Future_Wait(ATX_Future* future, ATX_Result* result);
+
+ATX_Boolean
+ATX_Future_IsDone(ATX_Future* future);
+
+/**
+ * Call callback(argument, result) when the future is done, on the 
+ * thread that completes it (or right away if it is already done).
+ * Callbacks should be short, and may submit new tasks.
+ * The future is only marked as done once all its callbacks have
+ * returned, so ATX_Future_Wait and ATX_Future_IsDone observe their
+ * side effects; a callback must therefore not wait for its own future.
+ */
+ATX_Result
+ATX_Future_Then(ATX_Future*        future, 
+                ATX_FutureCallback callback, 
+                void*              argument);
+
+/**
+ * Release a future. The tasks of the future are not affected.
+ */
+ATX_Result
+ATX_Future_Destroy(ATX_Future* future);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ATX_TASK_POOL_H_ */
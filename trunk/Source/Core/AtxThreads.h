@@ -38,11 +38,43 @@
 #include "AtxTypes.h"
 #include "AtxResults.h"
 
+/*----------------------------------------------------------------------
+|   error codes
++---------------------------------------------------------------------*/
+/* same code as socket timeouts (see AtxSockets.h) */
+#if !defined(ATX_ERROR_TIMEOUT)
+#define ATX_ERROR_TIMEOUT             (ATX_ERROR_BASE_SOCKETS - 7)
+#endif
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_TIMEOUT_INFINITE -1
+
 /*----------------------------------------------------------------------
 |   types
 +---------------------------------------------------------------------*/
-typedef struct ATX_Mutex ATX_Mutex;
-typedef unsigned long    ATX_ThreadId;
+typedef struct ATX_Mutex     ATX_Mutex;
+typedef struct ATX_Condition ATX_Condition;
+typedef struct ATX_Semaphore ATX_Semaphore;
+typedef struct ATX_Thread    ATX_Thread;
+typedef unsigned long        ATX_ThreadId;
+
+/**
+ * A variable that has a separate value in each thread.
+ */
+typedef struct ATX_ThreadLocal ATX_ThreadLocal;
+
+typedef void (*ATX_ThreadFunction)(void* argument);
+typedef void (*ATX_ThreadLocalDestructor)(void* value);
+
+/**
+ * Options for ATX_Thread_CreateEx.
+ */
+typedef struct {
+    const char* name;       /** name shown by debuggers and tools, or NULL */
+    ATX_Size    stack_size; /** stack size in bytes, or 0 for the default  */
+} ATX_ThreadOptions;
 
 /*----------------------------------------------------------------------
 |   prototypes
@@ -65,6 +97,8 @@ ATX_Mutex_Create(ATX_Mutex** mutex);
  * if *mutex is NULL, the mutex will be created in a thread safe manner
  * (it is ok to have several threads try to create the same mutex at 
  * the same time), and will then locked. Otherwise, it will just be locked.
+ * The mutex is published with an atomic compare-and-swap, so once it
+ * exists this costs no more than ATX_Mutex_Lock.
  */
 ATX_Result
 ATX_Mutex_LockAutoCreate(ATX_Mutex** mutex);
@@ -78,9 +112,137 @@ ATX_Mutex_Unlock(ATX_Mutex* mutex);
 ATX_Result
 ATX_Mutex_Destroy(ATX_Mutex* mutex);
 
+/**
+ * Create a condition variable, to be used with an ATX_Mutex.
+ */
+ATX_Result
+ATX_Condition_Create(ATX_Condition** condition);
+
+/**
+ * Atomically unlock the mutex and wait until the condition is signaled,
+ * then lock the mutex again. Wakeups may be spurious, so callers must
+ * check their predicate in a loop.
+ */
+ATX_Result
+ATX_Condition_Wait(ATX_Condition* condition, ATX_Mutex* mutex);
+
+/**
+ * Same as ATX_Condition_Wait, but give up after a timeout in 
+ * milliseconds (or never, with ATX_TIMEOUT_INFINITE). The mutex is 
+ * locked again in all cases.
+ * Returns ATX_ERROR_TIMEOUT if the timeout expired.
+ */
+ATX_Result
+ATX_Condition_TimedWait(ATX_Condition* condition, 
+                        ATX_Mutex*     mutex, 
+                        ATX_Timeout    timeout);
+
+/**
+ * Wake up one thread waiting on the condition, if any.
+ */
+ATX_Result
+ATX_Condition_Signal(ATX_Condition* condition);
+
+/**
+ * Wake up all the threads waiting on the condition.
+ */
+ATX_Result
+ATX_Condition_Broadcast(ATX_Condition* condition);
+
+ATX_Result
+ATX_Condition_Destroy(ATX_Condition* condition);
+
+/**
+ * Create a counting semaphore.
+ */
+ATX_Result
+ATX_Semaphore_Create(ATX_Cardinal initial_count, ATX_Semaphore** semaphore);
+
+/**
+ * Wait until the count is positive, then decrement it.
+ */
+ATX_Result
+ATX_Semaphore_Acquire(ATX_Semaphore* semaphore);
+
+/**
+ * Same as ATX_Semaphore_Acquire, but give up after a timeout in 
+ * milliseconds. A timeout of 0 never waits.
+ * Returns ATX_ERROR_TIMEOUT if the count could not be decremented.
+ */
+ATX_Result
+ATX_Semaphore_TimedAcquire(ATX_Semaphore* semaphore, ATX_Timeout timeout);
+
+/**
+ * Increment the count, waking up as many waiting threads.
+ */
+ATX_Result
+ATX_Semaphore_Release(ATX_Semaphore* semaphore, ATX_Cardinal count);
+
+ATX_Result
+ATX_Semaphore_Destroy(ATX_Semaphore* semaphore);
+
+/**
+ * Start a thread that runs function(argument).
+ */
+ATX_Result
+ATX_Thread_Create(ATX_ThreadFunction function, 
+                  void*              argument, 
+                  ATX_Thread**       thread);
+
+/**
+ * Same as ATX_Thread_Create, with a name and a stack size. 
+ * Names may be truncated by the system (15 characters on Linux).
+ */
+ATX_Result
+ATX_Thread_CreateEx(ATX_ThreadFunction       function, 
+                    void*                    argument, 
+                    const ATX_ThreadOptions* options,
+                    ATX_Thread**             thread);
+
+/**
+ * Set the name of the calling thread.
+ */
+ATX_Result
+ATX_Thread_SetCurrentName(const char* name);
+
+/**
+ * Wait for a thread to end, then destroy the thread object.
+ */
+ATX_Result
+ATX_Thread_Join(ATX_Thread* thread);
+
 ATX_ThreadId
 ATX_GetCurrentThreadId(void);
 
+/**
+ * Create a thread local variable, whose value is initially NULL in all
+ * threads. When a thread exits, the destructor (if not NULL) is called
+ * with the value of the variable in that thread, if it is not NULL.
+ */
+ATX_Result
+ATX_ThreadLocal_Create(ATX_ThreadLocalDestructor destructor, 
+                       ATX_ThreadLocal**         local);
+
+/**
+ * Destroy a thread local variable. The destructor is not called for
+ * the values that threads still have: they must be released before.
+ */
+ATX_Result
+ATX_ThreadLocal_Destroy(ATX_ThreadLocal* local);
+
+/**
+ * Get the value of the variable in the calling thread.
+ */
+void*
+ATX_ThreadLocal_Get(ATX_ThreadLocal* local);
+
+/**
+ * Set the value of the variable in the calling thread. The previous
+ * value is not passed to the destructor.
+ */
+ATX_Result
+ATX_ThreadLocal_Set(ATX_ThreadLocal* local, void* value);
+
 #ifdef __cplusplus
 }
 #endif
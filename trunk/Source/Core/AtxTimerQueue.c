@@ -0,0 +1,586 @@
+/*****************************************************************
+|
+|   Atomix - Timer Queues
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxConfig.h"
+#include "AtxTimerQueue.h"
+#include "AtxSystem.h"
+#include "AtxUtils.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+/* the root wheel has a slot per tick for the next 256 ticks, and each
+   of the next wheels has 64 slots, each covering a full turn of the 
+   wheel below it. Timers move down one wheel when the wheel below 
+   completes a turn, so each timer is moved at most 4 times */
+#define ATX_TIMER_WHEEL_ROOT_BITS  8
+#define ATX_TIMER_WHEEL_ROOT_SIZE  (1 << ATX_TIMER_WHEEL_ROOT_BITS)
+#define ATX_TIMER_WHEEL_ROOT_MASK  (ATX_TIMER_WHEEL_ROOT_SIZE-1)
+#define ATX_TIMER_WHEEL_LEVEL_BITS 6
+#define ATX_TIMER_WHEEL_LEVEL_SIZE (1 << ATX_TIMER_WHEEL_LEVEL_BITS)
+#define ATX_TIMER_WHEEL_LEVEL_MASK (ATX_TIMER_WHEEL_LEVEL_SIZE-1)
+#define ATX_TIMER_WHEEL_LEVELS     4 /* above the root, up to 2^32 ticks */
+
+#define ATX_TIMER_QUEUE_NO_TICK    ((ATX_UInt64)-1)
+
+/*----------------------------------------------------------------------
+|   macros
++---------------------------------------------------------------------*/
+#define ATX_TIMER_WHEEL_LEVEL_SHIFT(l) \
+    (ATX_TIMER_WHEEL_ROOT_BITS+(l)*ATX_TIMER_WHEEL_LEVEL_BITS)
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+struct ATX_Timer {
+    ATX_Timer*        next;
+    ATX_Timer*        previous;
+    ATX_Timer**       list;     /* slot or expired list, NULL if in none */
+    ATX_Boolean       in_root;
+    ATX_TimerQueue*   queue;    /* NULL unless scheduled                 */
+    ATX_UInt64        expires;  /* tick                                  */
+    ATX_UInt64        period;   /* ticks, 0 if the timer only runs once  */
+    ATX_TimerCallback callback;
+    void*             argument;
+};
+
+struct ATX_TimerQueue {
+    ATX_Mutex*     lock;
+    ATX_Condition* wakeup;          /* wakes up the thread               */
+    ATX_Condition* idle;            /* signaled when a callback returns  */
+    ATX_Thread*    thread;
+    ATX_Boolean    terminating;
+    ATX_Boolean    advancing;
+    ATX_ThreadId   advancing_thread;
+    ATX_Timer*     running;         /* timer whose callback is running   */
+    ATX_Cardinal   cancel_waiters;
+    ATX_UInt64     resolution;      /* nanoseconds                       */
+    ATX_TimeStamp  origin;          /* time of tick 0                    */
+    ATX_UInt64     tick;            /* next tick to process              */
+    ATX_UInt64     wakeup_tick;     /* tick the thread sleeps until      */
+    ATX_Cardinal   timer_count;
+    ATX_Cardinal   root_count;      /* timers in the root wheel          */
+    ATX_Timer*     expired;         /* timers of the tick being processed */
+    ATX_Timer*     root[ATX_TIMER_WHEEL_ROOT_SIZE];
+    ATX_Timer*     levels[ATX_TIMER_WHEEL_LEVELS][ATX_TIMER_WHEEL_LEVEL_SIZE];
+};
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_GetElapsed
+|
+|   Returns the number of nanoseconds from the origin of the queue to 
+|   now, or to the current time if now is NULL.
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_TimerQueue_GetElapsed(ATX_TimerQueue* self, const ATX_TimeStamp* now)
+{
+    ATX_TimeStamp current;
+    ATX_Int64     elapsed;
+    
+    if (now == NULL) {
+        ATX_System_GetMonotonicTimeStamp(&current);
+        now = &current;
+    }
+    elapsed = (ATX_Int64)(now->seconds-self->origin.seconds)*1000000000+
+              (now->nanoseconds-self->origin.nanoseconds);
+    
+    return elapsed > 0 ? (ATX_UInt64)elapsed : 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Link
++---------------------------------------------------------------------*/
+static void
+ATX_TimerQueue_Link(ATX_Timer** list, ATX_Timer* timer)
+{
+    timer->previous = NULL;
+    timer->next     = *list;
+    if (*list) (*list)->previous = timer;
+    *list       = timer;
+    timer->list = list;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Unlink
++---------------------------------------------------------------------*/
+static void
+ATX_TimerQueue_Unlink(ATX_TimerQueue* self, ATX_Timer* timer)
+{
+    if (timer->previous) {
+        timer->previous->next = timer->next;
+    } else {
+        *timer->list = timer->next;
+    }
+    if (timer->next) timer->next->previous = timer->previous;
+    if (timer->in_root) --self->root_count;
+    timer->next     = NULL;
+    timer->previous = NULL;
+    timer->list     = NULL;
+    timer->in_root  = ATX_FALSE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Insert
+|
+|   Put a timer in the slot of the wheel that covers its expiration.
+|   Timers that are overdue go in the slot of the next tick.
++---------------------------------------------------------------------*/
+static void
+ATX_TimerQueue_Insert(ATX_TimerQueue* self, ATX_Timer* timer)
+{
+    ATX_UInt64 expires = timer->expires;
+    ATX_UInt64 delta;
+    unsigned   level;
+    
+    if (expires < self->tick) expires = self->tick;
+    delta = expires-self->tick;
+    if (delta < ATX_TIMER_WHEEL_ROOT_SIZE) {
+        ATX_TimerQueue_Link(&self->root[expires & ATX_TIMER_WHEEL_ROOT_MASK], timer);
+        timer->in_root = ATX_TRUE;
+        ++self->root_count;
+        return;
+    }
+    
+    for (level=0; level<ATX_TIMER_WHEEL_LEVELS-1; level++) {
+        if (delta < ((ATX_UInt64)1 << ATX_TIMER_WHEEL_LEVEL_SHIFT(level+1))) break;
+    }
+    if (delta >= ((ATX_UInt64)1 << ATX_TIMER_WHEEL_LEVEL_SHIFT(ATX_TIMER_WHEEL_LEVELS))) {
+        /* beyond the last wheel: park it in the farthest slot, it will
+           be placed again when it is moved down */
+        expires = self->tick+((ATX_UInt64)1 << ATX_TIMER_WHEEL_LEVEL_SHIFT(ATX_TIMER_WHEEL_LEVELS))-1;
+    }
+    ATX_TimerQueue_Link(&self->levels[level][(expires >> ATX_TIMER_WHEEL_LEVEL_SHIFT(level)) & 
+                                             ATX_TIMER_WHEEL_LEVEL_MASK], 
+                        timer);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Cascade
+|
+|   Move the timers of a slot to the wheels below, and returns the 
+|   index of the slot.
++---------------------------------------------------------------------*/
+static unsigned int
+ATX_TimerQueue_Cascade(ATX_TimerQueue* self, unsigned int level)
+{
+    unsigned int index = (unsigned int)(self->tick >> ATX_TIMER_WHEEL_LEVEL_SHIFT(level)) & 
+                         ATX_TIMER_WHEEL_LEVEL_MASK;
+    ATX_Timer*   timer = self->levels[level][index];
+    
+    self->levels[level][index] = NULL;
+    while (timer) {
+        ATX_Timer* next = timer->next;
+        ATX_TimerQueue_Insert(self, timer);
+        timer = next;
+    }
+    
+    return index;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_ProcessTick
+|
+|   Run the timers of the current tick. Called with the lock held, 
+|   which is released while callbacks run.
++---------------------------------------------------------------------*/
+static void
+ATX_TimerQueue_ProcessTick(ATX_TimerQueue* self)
+{
+    unsigned int index = (unsigned int)(self->tick & ATX_TIMER_WHEEL_ROOT_MASK);
+    unsigned int level;
+    ATX_Timer*   timer;
+    
+    /* move timers down when the root wheel starts a new turn */
+    if (index == 0) {
+        for (level=0; level<ATX_TIMER_WHEEL_LEVELS; level++) {
+            if (ATX_TimerQueue_Cascade(self, level) != 0) break;
+        }
+    }
+    
+    /* take the expired timers out of the wheel */
+    self->expired = self->root[index];
+    self->root[index] = NULL;
+    for (timer = self->expired; timer; timer = timer->next) {
+        timer->list    = &self->expired;
+        timer->in_root = ATX_FALSE;
+        --self->root_count;
+    }
+    ++self->tick;
+    
+    /* run them, the timers that are cancelled meanwhile are removed */
+    while ((timer = self->expired)) {
+        ATX_TimerQueue_Unlink(self, timer);
+        if (timer->period) {
+            timer->expires += timer->period;
+            ATX_TimerQueue_Insert(self, timer);
+        } else {
+            timer->queue = NULL;
+            --self->timer_count;
+        }
+        
+        self->running = timer;
+        ATX_Mutex_Unlock(self->lock);
+        timer->callback(timer, timer->argument);
+        ATX_Mutex_Lock(self->lock);
+        self->running = NULL;
+        if (self->cancel_waiters) ATX_Condition_Broadcast(self->idle);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_GetNextTick
+|
+|   Returns the next tick that has timers to run or to move, or 
+|   ATX_TIMER_QUEUE_NO_TICK. Called with the lock held.
++---------------------------------------------------------------------*/
+static ATX_UInt64
+ATX_TimerQueue_GetNextTick(ATX_TimerQueue* self)
+{
+    ATX_UInt64 next = ATX_TIMER_QUEUE_NO_TICK;
+    ATX_UInt64 tick;
+    
+    if (self->timer_count == 0) return ATX_TIMER_QUEUE_NO_TICK;
+    
+    /* the root wheel holds the timers of the next 256 ticks */
+    if (self->root_count) {
+        for (tick=self->tick; tick<self->tick+ATX_TIMER_WHEEL_ROOT_SIZE; tick++) {
+            if (self->root[tick & ATX_TIMER_WHEEL_ROOT_MASK]) {
+                next = tick;
+                break;
+            }
+        }
+    }
+    
+    /* other timers may be moved to the root at the start of its turn */
+    if (self->timer_count > self->root_count) {
+        tick = (self->tick+ATX_TIMER_WHEEL_ROOT_MASK) & ~(ATX_UInt64)ATX_TIMER_WHEEL_ROOT_MASK;
+        if (tick < next) next = tick;
+    }
+    
+    return next;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_GetTimeUntil
+|
+|   Returns the number of milliseconds until a tick (rounded up).
++---------------------------------------------------------------------*/
+static ATX_Timeout
+ATX_TimerQueue_GetTimeUntil(ATX_TimerQueue* self, ATX_UInt64 tick)
+{
+    ATX_UInt64 elapsed = ATX_TimerQueue_GetElapsed(self, NULL);
+    ATX_UInt64 when;
+    ATX_UInt64 timeout;
+    
+    if (tick == ATX_TIMER_QUEUE_NO_TICK) return ATX_TIMEOUT_INFINITE;
+    when = tick*self->resolution;
+    if (when <= elapsed) return 0;
+    timeout = (when-elapsed+999999)/1000000;
+    
+    return timeout > 0x7FFFFFFF ? 0x7FFFFFFF : (ATX_Timeout)timeout;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Run
++---------------------------------------------------------------------*/
+static void
+ATX_TimerQueue_Run(void* argument)
+{
+    ATX_TimerQueue* self = (ATX_TimerQueue*)argument;
+    
+    ATX_Mutex_Lock(self->lock);
+    while (!self->terminating) {
+        ATX_Timeout timeout;
+        
+        ATX_Mutex_Unlock(self->lock);
+        ATX_TimerQueue_Advance(self, NULL);
+        ATX_Mutex_Lock(self->lock);
+        
+        /* sleep until the next tick that has something to do, or until
+           a timer is scheduled before it */
+        self->wakeup_tick = ATX_TimerQueue_GetNextTick(self);
+        timeout = ATX_TimerQueue_GetTimeUntil(self, self->wakeup_tick);
+        if (timeout == 0 && self->advancing) {
+            /* another thread is running the timers, let it finish */
+            timeout = 1;
+        }
+        if (timeout != 0 && !self->terminating) {
+            ATX_Condition_TimedWait(self->wakeup, self->lock, timeout);
+        }
+    }
+    ATX_Mutex_Unlock(self->lock);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TimerQueue_Create(ATX_UInt32       resolution, 
+                      ATX_Flags        flags, 
+                      ATX_TimerQueue** queue)
+{
+    ATX_TimerQueue* self;
+    ATX_Result      result;
+    
+    *queue = NULL;
+    self = (ATX_TimerQueue*)ATX_AllocateZeroMemory(sizeof(ATX_TimerQueue));
+    if (self == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    
+    if (resolution == 0) resolution = ATX_TIMER_QUEUE_DEFAULT_RESOLUTION;
+    self->resolution  = (ATX_UInt64)resolution*1000000;
+    self->wakeup_tick = ATX_TIMER_QUEUE_NO_TICK;
+    ATX_System_GetMonotonicTimeStamp(&self->origin);
+    
+    result = ATX_Mutex_Create(&self->lock);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&self->wakeup);
+    if (ATX_FAILED(result)) goto fail;
+    result = ATX_Condition_Create(&self->idle);
+    if (ATX_FAILED(result)) goto fail;
+    
+    if (flags & ATX_TIMER_QUEUE_FLAG_THREAD) {
+        ATX_ThreadOptions options;
+        options.name       = "atx-timers";
+        options.stack_size = 0;
+        result = ATX_Thread_CreateEx(ATX_TimerQueue_Run, self, &options, &self->thread);
+        if (ATX_FAILED(result)) goto fail;
+    }
+    
+    *queue = self;
+    return ATX_SUCCESS;
+    
+fail:
+    ATX_TimerQueue_Destroy(self);
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_DetachList
++---------------------------------------------------------------------*/
+static void
+ATX_TimerQueue_DetachList(ATX_Timer** list)
+{
+    ATX_Timer* timer = *list;
+    
+    while (timer) {
+        ATX_Timer* next = timer->next;
+        timer->next     = NULL;
+        timer->previous = NULL;
+        timer->list     = NULL;
+        timer->in_root  = ATX_FALSE;
+        timer->queue    = NULL;
+        timer = next;
+    }
+    *list = NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TimerQueue_Destroy(ATX_TimerQueue* self)
+{
+    unsigned int level;
+    unsigned int index;
+    
+    if (self == NULL) return ATX_SUCCESS;
+    
+    /* stop the thread */
+    if (self->thread) {
+        ATX_Mutex_Lock(self->lock);
+        self->terminating = ATX_TRUE;
+        ATX_Condition_Signal(self->wakeup);
+        ATX_Mutex_Unlock(self->lock);
+        ATX_Thread_Join(self->thread);
+    }
+    
+    /* the timers that are left are no longer scheduled */
+    ATX_TimerQueue_DetachList(&self->expired);
+    for (index=0; index<ATX_TIMER_WHEEL_ROOT_SIZE; index++) {
+        ATX_TimerQueue_DetachList(&self->root[index]);
+    }
+    for (level=0; level<ATX_TIMER_WHEEL_LEVELS; level++) {
+        for (index=0; index<ATX_TIMER_WHEEL_LEVEL_SIZE; index++) {
+            ATX_TimerQueue_DetachList(&self->levels[level][index]);
+        }
+    }
+    
+    if (self->lock)   ATX_Mutex_Destroy(self->lock);
+    if (self->wakeup) ATX_Condition_Destroy(self->wakeup);
+    if (self->idle)   ATX_Condition_Destroy(self->idle);
+    ATX_FreeMemory(self);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Schedule
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TimerQueue_Schedule(ATX_TimerQueue* self, 
+                        ATX_Timer*      timer, 
+                        ATX_UInt32      delay, 
+                        ATX_UInt32      period)
+{
+    ATX_UInt64 elapsed;
+    
+    ATX_Mutex_Lock(self->lock);
+    if (timer->queue && timer->queue != self) {
+        ATX_Mutex_Unlock(self->lock);
+        return ATX_ERROR_INVALID_STATE;
+    }
+    
+    if (timer->list) {
+        ATX_TimerQueue_Unlink(self, timer);
+    } else {
+        ++self->timer_count;
+    }
+    
+    /* round up, so that the timer does not expire early */
+    elapsed = ATX_TimerQueue_GetElapsed(self, NULL);
+    timer->expires = (elapsed+(ATX_UInt64)delay*1000000+self->resolution-1)/self->resolution;
+    timer->period  = ((ATX_UInt64)period*1000000+self->resolution-1)/self->resolution;
+    timer->queue   = self;
+    ATX_TimerQueue_Insert(self, timer);
+    
+    if (self->thread && timer->expires < self->wakeup_tick) {
+        ATX_Condition_Signal(self->wakeup);
+    }
+    ATX_Mutex_Unlock(self->lock);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Cancel
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TimerQueue_Cancel(ATX_TimerQueue* self, ATX_Timer* timer)
+{
+    ATX_Mutex_Lock(self->lock);
+    if (timer->queue == self) {
+        if (timer->list) ATX_TimerQueue_Unlink(self, timer);
+        timer->queue = NULL;
+        --self->timer_count;
+    }
+    
+    /* wait for the callback to return, unless we are in it */
+    while (self->running == timer && self->advancing_thread != ATX_GetCurrentThreadId()) {
+        ++self->cancel_waiters;
+        ATX_Condition_Wait(self->idle, self->lock);
+        --self->cancel_waiters;
+    }
+    ATX_Mutex_Unlock(self->lock);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_Advance
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TimerQueue_Advance(ATX_TimerQueue* self, const ATX_TimeStamp* now)
+{
+    ATX_UInt64 target;
+    
+    ATX_Mutex_Lock(self->lock);
+    if (self->advancing) {
+        ATX_Mutex_Unlock(self->lock);
+        return ATX_SUCCESS;
+    }
+    self->advancing        = ATX_TRUE;
+    self->advancing_thread = ATX_GetCurrentThreadId();
+    
+    target = ATX_TimerQueue_GetElapsed(self, now)/self->resolution;
+    while (self->tick <= target) {
+        if (self->timer_count == 0) {
+            self->tick = target+1;
+            break;
+        }
+        if (self->root_count == 0 && (self->tick & ATX_TIMER_WHEEL_ROOT_MASK) != 0) {
+            /* nothing happens until the root wheel starts a new turn */
+            ATX_UInt64 turn = (self->tick | ATX_TIMER_WHEEL_ROOT_MASK)+1;
+            self->tick = turn <= target ? turn : target+1;
+            continue;
+        }
+        ATX_TimerQueue_ProcessTick(self);
+    }
+    
+    self->advancing = ATX_FALSE;
+    ATX_Mutex_Unlock(self->lock);
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TimerQueue_GetTimeout
++---------------------------------------------------------------------*/
+ATX_Timeout
+ATX_TimerQueue_GetTimeout(ATX_TimerQueue* self)
+{
+    ATX_Timeout timeout;
+    
+    ATX_Mutex_Lock(self->lock);
+    timeout = ATX_TimerQueue_GetTimeUntil(self, ATX_TimerQueue_GetNextTick(self));
+    ATX_Mutex_Unlock(self->lock);
+    
+    return timeout;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Timer_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Timer_Create(ATX_TimerCallback callback, void* argument, ATX_Timer** timer)
+{
+    *timer = (ATX_Timer*)ATX_AllocateZeroMemory(sizeof(ATX_Timer));
+    if (*timer == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    (*timer)->callback = callback;
+    (*timer)->argument = argument;
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Timer_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Timer_Destroy(ATX_Timer* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    if (self->queue) return ATX_ERROR_INVALID_STATE;
+    ATX_FreeMemory(self);
+    
+    return ATX_SUCCESS;
+}
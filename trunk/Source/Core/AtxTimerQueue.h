@@ -0,0 +1,150 @@
+/*****************************************************************
+|
+|   Atomix - Timer Queues
+|
+| Copyright (c) 2002-2010, Axiomatic Systems, LLC.
+| All rights reserved.
+|
+| Redistribution and use in source and binary forms, with or without
+| modification, are permitted provided that the following conditions are met:
+|     * Redistributions of source code must retain the above copyright
+|       notice, this list of conditions and the following disclaimer.
+|     * Redistributions in binary form must reproduce the above copyright
+|       notice, this list of conditions and the following disclaimer in the
+|       documentation and/or other materials provided with the distribution.
+|     * Neither the name of Axiomatic Systems nor the
+|       names of its contributors may be used to endorse or promote products
+|       derived from this software without specific prior written permission.
+|
+| THIS SOFTWARE IS PROVIDED BY AXIOMATIC SYSTEMS ''AS IS'' AND ANY
+| EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+| WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+| DISCLAIMED. IN NO EVENT SHALL AXIOMATIC SYSTEMS BE LIABLE FOR ANY
+| DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+| (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+| LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+| ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+| (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+| SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+|
+ ****************************************************************/
+
+#ifndef _ATX_TIMER_QUEUE_H_
+#define _ATX_TIMER_QUEUE_H_
+
+/*----------------------------------------------------------------------
+|   includes
++---------------------------------------------------------------------*/
+#include "AtxTypes.h"
+#include "AtxResults.h"
+#include "AtxThreads.h"
+#include "AtxTime.h"
+
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+/** Run the callbacks on a thread owned by the queue. */
+#define ATX_TIMER_QUEUE_FLAG_THREAD 0x01
+
+#define ATX_TIMER_QUEUE_DEFAULT_RESOLUTION 1 /* milliseconds */
+
+/*----------------------------------------------------------------------
+|   types
++---------------------------------------------------------------------*/
+/**
+ * A set of timers, kept in a hierarchical timing wheel: scheduling and 
+ * cancelling a timer take constant time, however many timers there are.
+ * Time advances in ticks of a fixed resolution. Callbacks run either on 
+ * the thread of the queue, or in the thread that calls 
+ * ATX_TimerQueue_Advance, one at a time and without any lock held, so 
+ * they may schedule and cancel timers.
+ */
+typedef struct ATX_TimerQueue ATX_TimerQueue;
+
+/**
+ * A timer is created and destroyed by its user, and is scheduled in 
+ * at most one queue at a time.
+ */
+typedef struct ATX_Timer ATX_Timer;
+
+typedef void (*ATX_TimerCallback)(ATX_Timer* timer, void* argument);
+
+/*----------------------------------------------------------------------
+|   prototypes
++---------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a queue whose ticks last resolution milliseconds (or 
+ * ATX_TIMER_QUEUE_DEFAULT_RESOLUTION if 0), with ATX_TIMER_QUEUE_FLAG_XXX
+ * flags.
+ */
+ATX_Result
+ATX_TimerQueue_Create(ATX_UInt32       resolution, 
+                      ATX_Flags        flags, 
+                      ATX_TimerQueue** queue);
+
+/**
+ * Destroy a queue. Timers that are still scheduled are cancelled, 
+ * but not destroyed. Must not be called from a callback.
+ */
+ATX_Result
+ATX_TimerQueue_Destroy(ATX_TimerQueue* queue);
+
+/**
+ * Schedule a timer to expire in delay milliseconds, and then every 
+ * period milliseconds if period is not 0. A timer that is already 
+ * scheduled in the queue is rescheduled.
+ * Timers never expire early, but may expire up to one tick late, or 
+ * later if the queue is not advanced in time.
+ * Periodic timers keep a fixed rate: the periods that are missed 
+ * because the queue is advanced late all run when it catches up.
+ * Returns ATX_ERROR_INVALID_STATE if the timer is scheduled in another
+ * queue.
+ */
+ATX_Result
+ATX_TimerQueue_Schedule(ATX_TimerQueue* queue, 
+                        ATX_Timer*      timer, 
+                        ATX_UInt32      delay, 
+                        ATX_UInt32      period);
+
+/**
+ * Cancel a timer if it is scheduled. When this returns, the callback of
+ * the timer is not running, unless it is the caller.
+ */
+ATX_Result
+ATX_TimerQueue_Cancel(ATX_TimerQueue* queue, ATX_Timer* timer);
+
+/**
+ * Run the callbacks of the timers that have expired at a time obtained
+ * from ATX_System_GetMonotonicTimeStamp, or at the current time if now
+ * is NULL. Does nothing when called from a callback, or while another
+ * thread is advancing the queue.
+ */
+ATX_Result
+ATX_TimerQueue_Advance(ATX_TimerQueue* queue, const ATX_TimeStamp* now);
+
+/**
+ * Returns the number of milliseconds after which the queue should be 
+ * advanced next, which may be before the next timer expires, or 
+ * ATX_TIMEOUT_INFINITE if no timer is scheduled.
+ */
+ATX_Timeout
+ATX_TimerQueue_GetTimeout(ATX_TimerQueue* queue);
+
+ATX_Result
+ATX_Timer_Create(ATX_TimerCallback callback, void* argument, ATX_Timer** timer);
+
+/**
+ * Destroy a timer, which must not be scheduled (cancel it first).
+ */
+ATX_Result
+ATX_Timer_Destroy(ATX_Timer* timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ATX_TIMER_QUEUE_H_ */
@@ -43,6 +43,25 @@
 #include <limits.h>
 #endif
 
+/* SIMD UTF-8 validation: runtime dispatch on x86 with gcc/clang, 
+   compile-time selection elsewhere */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <immintrin.h>
+#define ATX_UTF8_CONFIG_HAVE_SSSE3
+#define ATX_UTF8_CONFIG_HAVE_AVX2
+#define ATX_UTF8_CONFIG_RUNTIME_DISPATCH
+#define ATX_UTF8_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define ATX_UTF8_TARGET_AVX2  __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#include <immintrin.h>
+#define ATX_UTF8_CONFIG_HAVE_AVX2
+#define ATX_UTF8_TARGET_AVX2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ATX_UTF8_CONFIG_HAVE_NEON
+#endif
+
 /*----------------------------------------------------------------------
 |   constants
 +---------------------------------------------------------------------*/
@@ -177,15 +196,30 @@ ATX_BytesToInt16Le(const unsigned char* buffer)
 
 /*----------------------------------------------------------------------
 |    ATX_ParseDouble
+|
+|   The syntax is checked here, and the significant digits and exponent
+|   are then handed to strtod, without a radix character so that the
+|   locale doesn't matter, for a correctly rounded result. Without a C
+|   library, the digits are scaled by powers of ten, which is exact for
+|   up to 15 digits and small exponents.
 +---------------------------------------------------------------------*/
 ATX_Result 
 ATX_ParseDouble(const char* str, double* result, ATX_Boolean relaxed)
 {
+#if !defined(ATX_CONFIG_HAVE_STDLIB_H)
+    static const double powers[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+#endif
     ATX_Boolean  after_radix = ATX_FALSE;
     ATX_Boolean  negative    = ATX_FALSE;
     ATX_Boolean  empty       = ATX_TRUE;
-    double       value       = 0.0;
-    double       decimal     = 10.0;
+    ATX_UInt64   mantissa    = 0;
+    char         significant[32];
+    unsigned int digits      = 0;
+    int          exponent    = 0;
+    double       value;
     char         c;
 
     /* safe default value */
@@ -225,18 +259,23 @@ ATX_ParseDouble(const char* str, double* result, ATX_Boolean relaxed)
             }
         } else if (c >= '0' && c <= '9') {
             empty = ATX_FALSE;
-            if (after_radix) {
-                value += (double)(c-'0')/decimal;
-                decimal *= 10.0f;
-            } else {
-                value = 10.0f*value + (double)(c-'0');
+            if (digits < 19) {
+                /* keep as many digits as fit in the mantissa */
+                mantissa = 10*mantissa + (ATX_UInt64)(c-'0');
+                if (mantissa) significant[digits++] = c;
+                if (after_radix) --exponent;
+            } else if (!after_radix) {
+                ++exponent;
             }
         } else if (c == 'e' || c == 'E') {
             /* exponent */
             if (*str == '+' || *str == '-' || (*str >= '0' && *str <= '9')) {
-                int exponent = 0;
-                if (ATX_SUCCEEDED(ATX_ParseInteger(str, &exponent, relaxed))) {
-                    value *= (double)pow(10.0f, (double)exponent);
+                int value_exponent = 0;
+                if (ATX_SUCCEEDED(ATX_ParseInteger(str, &value_exponent, relaxed))) {
+                    /* beyond these, any mantissa overflows or underflows */
+                    if (value_exponent >  400) value_exponent =  400;
+                    if (value_exponent < -400) value_exponent = -400;
+                    exponent += value_exponent;
                     break;
                 } else {
                     return ATX_ERROR_INVALID_PARAMETERS;
@@ -258,6 +297,32 @@ ATX_ParseDouble(const char* str, double* result, ATX_Boolean relaxed)
         return ATX_ERROR_INVALID_PARAMETERS;
     }
 
+#if defined(ATX_CONFIG_HAVE_STDLIB_H)
+    value = 0.0;
+    if (digits) {
+        ATX_FormatStringN(significant+digits, sizeof(significant)-digits, "e%d", exponent);
+        value = strtod(significant, NULL);
+    }
+#else
+    /* scale the mantissa, a single step is exact when both are */
+    value = (double)mantissa;
+    if (mantissa) {
+        while (exponent > 22) {
+            value *= 1e22;
+            exponent -= 22;
+        }
+        while (exponent < -22) {
+            value /= 1e22;
+            exponent += 22;
+        }
+        if (exponent >= 0) {
+            value *= powers[exponent];
+        } else {
+            value /= powers[-exponent];
+        }
+    }
+#endif
+
     /* return the result */
     *result = negative ? -value : value;
     return ATX_SUCCESS;
@@ -778,6 +843,7 @@ ATX_HexToBytes(const char*     hex,
                ATX_DataBuffer* bytes)
 {
     ATX_Size     byte_count;
+    ATX_Byte*    data;
     unsigned int i;
     ATX_Result   result;
     
@@ -787,11 +853,378 @@ ATX_HexToBytes(const char*     hex,
     byte_count = len / 2;
     result = ATX_DataBuffer_SetDataSize(bytes, byte_count);
     if (ATX_FAILED(result)) return result;
+    if (byte_count == 0) return ATX_SUCCESS;
+    data = ATX_DataBuffer_UseData(bytes);
+    if (data == NULL) return ATX_ERROR_OUT_OF_MEMORY;
     
     /* decode */
     for (i=0; i<byte_count; i++) {
-        result = ATX_HexToByte(hex+(i*2), ATX_DataBuffer_UseData(bytes)+i);
+        result = ATX_HexToByte(hex+(i*2), data+i);
         if (ATX_FAILED(result)) return result;
     }
     return ATX_SUCCESS;
 }
+
+/*----------------------------------------------------------------------
+|   UTF-8 validation
+|
+|   The SIMD variants implement the lookup table algorithm from Keiser
+|   and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte":
+|   each byte is classified together with the byte that precedes it by
+|   three 16-entry table lookups (high nibble of the previous byte, low
+|   nibble of the previous byte, high nibble of the current byte) whose
+|   results are ANDed together, so that any non-zero bit is an error. 
+|   The 3rd and 4th bytes of long sequences are checked separately with 
+|   two saturated subtractions.
++---------------------------------------------------------------------*/
+#if defined(ATX_UTF8_CONFIG_HAVE_SSSE3) || \
+    defined(ATX_UTF8_CONFIG_HAVE_AVX2)  || \
+    defined(ATX_UTF8_CONFIG_HAVE_NEON)
+#define ATX_UTF8_TOO_SHORT      (1<<0) /* 11______ 0_______ or 11______ 11______ */
+#define ATX_UTF8_TOO_LONG       (1<<1) /* 0_______ 10______                      */
+#define ATX_UTF8_OVERLONG_3     (1<<2) /* 11100000 100_____                      */
+#define ATX_UTF8_TOO_LARGE      (1<<3) /* 11110100 1001____ and above            */
+#define ATX_UTF8_SURROGATE      (1<<4) /* 11101101 101_____                      */
+#define ATX_UTF8_OVERLONG_2     (1<<5) /* 1100000_ 10______                      */
+#define ATX_UTF8_TOO_LARGE_1000 (1<<6) /* 11110101 1000____ and above            */
+#define ATX_UTF8_OVERLONG_4     (1<<6) /* 11110000 1000____                      */
+#define ATX_UTF8_TWO_CONTS      (1<<7) /* 10______ 10______                      */
+#define ATX_UTF8_CARRY          (ATX_UTF8_TOO_SHORT | ATX_UTF8_TOO_LONG | ATX_UTF8_TWO_CONTS)
+
+static const unsigned char ATX_Utf8_Byte1High[16] = {
+    /* 0_______ ________ */
+    ATX_UTF8_TOO_LONG, ATX_UTF8_TOO_LONG, ATX_UTF8_TOO_LONG, ATX_UTF8_TOO_LONG,
+    ATX_UTF8_TOO_LONG, ATX_UTF8_TOO_LONG, ATX_UTF8_TOO_LONG, ATX_UTF8_TOO_LONG,
+    /* 10______ ________ */
+    ATX_UTF8_TWO_CONTS, ATX_UTF8_TWO_CONTS, ATX_UTF8_TWO_CONTS, ATX_UTF8_TWO_CONTS,
+    /* 1100____ ________ */
+    ATX_UTF8_TOO_SHORT | ATX_UTF8_OVERLONG_2,
+    /* 1101____ ________ */
+    ATX_UTF8_TOO_SHORT,
+    /* 1110____ ________ */
+    ATX_UTF8_TOO_SHORT | ATX_UTF8_OVERLONG_3 | ATX_UTF8_SURROGATE,
+    /* 1111____ ________ */
+    ATX_UTF8_TOO_SHORT | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000 | ATX_UTF8_OVERLONG_4
+};
+
+static const unsigned char ATX_Utf8_Byte1Low[16] = {
+    /* ____0000 ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_OVERLONG_3 | ATX_UTF8_OVERLONG_2 | ATX_UTF8_OVERLONG_4,
+    /* ____0001 ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_OVERLONG_2,
+    /* ____001_ ________ */
+    ATX_UTF8_CARRY,
+    ATX_UTF8_CARRY,
+    /* ____0100 ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE,
+    /* ____0101 ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    /* ____011_ ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    /* ____1___ ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    /* ____1101 ________ */
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000 | ATX_UTF8_SURROGATE,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000,
+    ATX_UTF8_CARRY | ATX_UTF8_TOO_LARGE | ATX_UTF8_TOO_LARGE_1000
+};
+
+static const unsigned char ATX_Utf8_Byte2High[16] = {
+    /* ________ 0_______ */
+    ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT,
+    ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT,
+    /* ________ 1000____ */
+    ATX_UTF8_TOO_LONG | ATX_UTF8_OVERLONG_2 | ATX_UTF8_TWO_CONTS | ATX_UTF8_OVERLONG_3 | 
+    ATX_UTF8_TOO_LARGE_1000 | ATX_UTF8_OVERLONG_4,
+    /* ________ 1001____ */
+    ATX_UTF8_TOO_LONG | ATX_UTF8_OVERLONG_2 | ATX_UTF8_TWO_CONTS | ATX_UTF8_OVERLONG_3 | 
+    ATX_UTF8_TOO_LARGE,
+    /* ________ 101_____ */
+    ATX_UTF8_TOO_LONG | ATX_UTF8_OVERLONG_2 | ATX_UTF8_TWO_CONTS | ATX_UTF8_SURROGATE | 
+    ATX_UTF8_TOO_LARGE,
+    ATX_UTF8_TOO_LONG | ATX_UTF8_OVERLONG_2 | ATX_UTF8_TWO_CONTS | ATX_UTF8_SURROGATE | 
+    ATX_UTF8_TOO_LARGE,
+    /* ________ 11______ */
+    ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT, ATX_UTF8_TOO_SHORT
+};
+
+/* a block that ends with one of these is incomplete (the last 16 bytes
+   are used for 16-byte blocks, all 32 for 32-byte blocks) */
+static const unsigned char ATX_Utf8_IncompleteMax[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0-1, 0xE0-1, 0xC0-1
+};
+#endif
+
+#if defined(ATX_UTF8_CONFIG_HAVE_SSSE3)
+/*----------------------------------------------------------------------
+|   ATX_Utf8_ValidateSsse3
++---------------------------------------------------------------------*/
+ATX_UTF8_TARGET_SSSE3 static ATX_Result
+ATX_Utf8_ValidateSsse3(const unsigned char* data, ATX_Size size)
+{
+    const __m128i byte_1_high_table = _mm_loadu_si128((const __m128i*)ATX_Utf8_Byte1High);
+    const __m128i byte_1_low_table  = _mm_loadu_si128((const __m128i*)ATX_Utf8_Byte1Low);
+    const __m128i byte_2_high_table = _mm_loadu_si128((const __m128i*)ATX_Utf8_Byte2High);
+    const __m128i incomplete_max    = _mm_loadu_si128((const __m128i*)(ATX_Utf8_IncompleteMax+16));
+    const __m128i nibble_mask       = _mm_set1_epi8(0x0F);
+    __m128i       error             = _mm_setzero_si128();
+    __m128i       prev_input        = _mm_setzero_si128();
+    __m128i       prev_incomplete   = _mm_setzero_si128();
+    unsigned char tail[16];
+    
+    while (size) {
+        __m128i input;
+        
+        /* the last partial block is padded with zeros */
+        if (size >= 16) {
+            input = _mm_loadu_si128((const __m128i*)data);
+            data += 16;
+            size -= 16;
+        } else {
+            ATX_SetMemory(tail, 0, sizeof(tail));
+            ATX_CopyMemory(tail, data, size);
+            input = _mm_loadu_si128((const __m128i*)tail);
+            size = 0;
+        }
+        
+        if (_mm_movemask_epi8(input) == 0) {
+            /* ASCII block: only check the end of the previous block */
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+            __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+            __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+            __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, 
+                                                   _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble_mask));
+            __m128i byte_1_low  = _mm_shuffle_epi8(byte_1_low_table, 
+                                                   _mm_and_si128(prev1, nibble_mask));
+            __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, 
+                                                   _mm_and_si128(_mm_srli_epi16(input, 4), nibble_mask));
+            __m128i special     = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+            __m128i must_be_23  = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xE0-0x80)),
+                                               _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0-0x80)));
+            must_be_23 = _mm_and_si128(must_be_23, _mm_set1_epi8((char)0x80));
+            error = _mm_or_si128(error, _mm_xor_si128(must_be_23, special));
+            prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+    
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF ?
+           ATX_SUCCESS : ATX_ERROR_INVALID_FORMAT;
+}
+#endif
+
+#if defined(ATX_UTF8_CONFIG_HAVE_AVX2)
+/*----------------------------------------------------------------------
+|   ATX_Utf8_ValidateAvx2
++---------------------------------------------------------------------*/
+ATX_UTF8_TARGET_AVX2 static ATX_Result
+ATX_Utf8_ValidateAvx2(const unsigned char* data, ATX_Size size)
+{
+    const __m256i byte_1_high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)ATX_Utf8_Byte1High));
+    const __m256i byte_1_low_table  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)ATX_Utf8_Byte1Low));
+    const __m256i byte_2_high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)ATX_Utf8_Byte2High));
+    const __m256i incomplete_max    = _mm256_loadu_si256((const __m256i*)ATX_Utf8_IncompleteMax);
+    const __m256i nibble_mask       = _mm256_set1_epi8(0x0F);
+    __m256i       error             = _mm256_setzero_si256();
+    __m256i       prev_input        = _mm256_setzero_si256();
+    __m256i       prev_incomplete   = _mm256_setzero_si256();
+    unsigned char tail[32];
+    
+    while (size) {
+        __m256i input;
+        
+        /* the last partial block is padded with zeros */
+        if (size >= 32) {
+            input = _mm256_loadu_si256((const __m256i*)data);
+            data += 32;
+            size -= 32;
+        } else {
+            ATX_SetMemory(tail, 0, sizeof(tail));
+            ATX_CopyMemory(tail, data, size);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+            size = 0;
+        }
+        
+        if (_mm256_movemask_epi8(input) == 0) {
+            /* ASCII block: only check the end of the previous block */
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            /* shifting across the two 128-bit lanes needs a permute first */
+            __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+            __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+            __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+            __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, 
+                                                      _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask));
+            __m256i byte_1_low  = _mm256_shuffle_epi8(byte_1_low_table, 
+                                                      _mm256_and_si256(prev1, nibble_mask));
+            __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, 
+                                                      _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble_mask));
+            __m256i special     = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+            __m256i must_be_23  = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0-0x80)),
+                                                  _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0-0x80)));
+            must_be_23 = _mm256_and_si256(must_be_23, _mm256_set1_epi8((char)0x80));
+            error = _mm256_or_si256(error, _mm256_xor_si256(must_be_23, special));
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    
+    return _mm256_testz_si256(error, error) ? ATX_SUCCESS : ATX_ERROR_INVALID_FORMAT;
+}
+#endif
+
+#if defined(ATX_UTF8_CONFIG_HAVE_NEON)
+/*----------------------------------------------------------------------
+|   ATX_Utf8_ValidateNeon
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Utf8_ValidateNeon(const unsigned char* data, ATX_Size size)
+{
+    const uint8x16_t byte_1_high_table = vld1q_u8(ATX_Utf8_Byte1High);
+    const uint8x16_t byte_1_low_table  = vld1q_u8(ATX_Utf8_Byte1Low);
+    const uint8x16_t byte_2_high_table = vld1q_u8(ATX_Utf8_Byte2High);
+    const uint8x16_t incomplete_max    = vld1q_u8(ATX_Utf8_IncompleteMax+16);
+    const uint8x16_t nibble_mask       = vdupq_n_u8(0x0F);
+    uint8x16_t       error             = vdupq_n_u8(0);
+    uint8x16_t       prev_input        = vdupq_n_u8(0);
+    uint8x16_t       prev_incomplete   = vdupq_n_u8(0);
+    unsigned char    tail[16];
+    
+    while (size) {
+        uint8x16_t input;
+        
+        /* the last partial block is padded with zeros */
+        if (size >= 16) {
+            input = vld1q_u8(data);
+            data += 16;
+            size -= 16;
+        } else {
+            ATX_SetMemory(tail, 0, sizeof(tail));
+            ATX_CopyMemory(tail, data, size);
+            input = vld1q_u8(tail);
+            size = 0;
+        }
+        
+        if (vmaxvq_u8(input) < 0x80) {
+            /* ASCII block: only check the end of the previous block */
+            error = vorrq_u8(error, prev_incomplete);
+        } else {
+            uint8x16_t prev1 = vextq_u8(prev_input, input, 15);
+            uint8x16_t prev2 = vextq_u8(prev_input, input, 14);
+            uint8x16_t prev3 = vextq_u8(prev_input, input, 13);
+            uint8x16_t byte_1_high = vqtbl1q_u8(byte_1_high_table, vshrq_n_u8(prev1, 4));
+            uint8x16_t byte_1_low  = vqtbl1q_u8(byte_1_low_table, vandq_u8(prev1, nibble_mask));
+            uint8x16_t byte_2_high = vqtbl1q_u8(byte_2_high_table, vshrq_n_u8(input, 4));
+            uint8x16_t special     = vandq_u8(vandq_u8(byte_1_high, byte_1_low), byte_2_high);
+            uint8x16_t must_be_23  = vorrq_u8(vqsubq_u8(prev2, vdupq_n_u8(0xE0-0x80)),
+                                              vqsubq_u8(prev3, vdupq_n_u8(0xF0-0x80)));
+            must_be_23 = vandq_u8(must_be_23, vdupq_n_u8(0x80));
+            error = vorrq_u8(error, veorq_u8(must_be_23, special));
+            prev_incomplete = vqsubq_u8(input, incomplete_max);
+        }
+        prev_input = input;
+    }
+    error = vorrq_u8(error, prev_incomplete);
+    
+    return vmaxvq_u8(error) == 0 ? ATX_SUCCESS : ATX_ERROR_INVALID_FORMAT;
+}
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_Utf8_ValidateScalar
++---------------------------------------------------------------------*/
+static ATX_Result
+ATX_Utf8_ValidateScalar(const unsigned char* data, ATX_Size size)
+{
+    while (size) {
+        unsigned int  lead = data[0];
+        unsigned char low  = 0x80;
+        unsigned char high = 0xBF;
+        ATX_Size      count;
+        ATX_Size      i;
+        
+        /* skip ASCII 8 bytes at a time */
+        if (size >= 8) {
+            ATX_UInt32 chunk[2];
+            ATX_CopyMemory(chunk, data, 8);
+            if (((chunk[0]|chunk[1]) & 0x80808080) == 0) {
+                data += 8;
+                size -= 8;
+                continue;
+            }
+        }
+        if (lead < 0x80) {
+            ++data;
+            --size;
+            continue;
+        }
+        
+        /* multi-byte sequence (see the Unicode standard, table 3-7) */
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            count = 1;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            count = 2;
+            if (lead == 0xE0) {
+                low = 0xA0;
+            } else if (lead == 0xED) {
+                high = 0x9F;
+            }
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            count = 3;
+            if (lead == 0xF0) {
+                low = 0x90;
+            } else if (lead == 0xF4) {
+                high = 0x8F;
+            }
+        } else {
+            return ATX_ERROR_INVALID_FORMAT;
+        }
+        if (size <= count) return ATX_ERROR_INVALID_FORMAT;
+        if (data[1] < low || data[1] > high) return ATX_ERROR_INVALID_FORMAT;
+        for (i=2; i<=count; i++) {
+            if ((data[i]&0xC0) != 0x80) return ATX_ERROR_INVALID_FORMAT;
+        }
+        data += count+1;
+        size -= count+1;
+    }
+    
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Utf8_Validate
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Utf8_Validate(const char* data, ATX_Size size)
+{
+    /* short buffers are not worth setting up the vector registers */
+    if (size < 16) return ATX_Utf8_ValidateScalar((const unsigned char*)data, size);
+    
+#if defined(ATX_UTF8_CONFIG_RUNTIME_DISPATCH)
+    if (__builtin_cpu_supports("avx2")) {
+        return ATX_Utf8_ValidateAvx2((const unsigned char*)data, size);
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return ATX_Utf8_ValidateSsse3((const unsigned char*)data, size);
+    }
+#elif defined(ATX_UTF8_CONFIG_HAVE_AVX2)
+    return ATX_Utf8_ValidateAvx2((const unsigned char*)data, size);
+#elif defined(ATX_UTF8_CONFIG_HAVE_NEON)
+    return ATX_Utf8_ValidateNeon((const unsigned char*)data, size);
+#endif
+
+    return ATX_Utf8_ValidateScalar((const unsigned char*)data, size);
+}
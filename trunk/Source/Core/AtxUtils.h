@@ -172,6 +172,18 @@ ATX_String ATX_HexString(const unsigned char* data,
 void ATX_ByteToHex(ATX_Byte b, char* buffer, ATX_Boolean uppercase);
 char ATX_NibbleToHex(unsigned int nibble, ATX_Boolean uppercase);
 
+/*----------------------------------------------------------------------
+|    UTF-8
++---------------------------------------------------------------------*/
+/**
+ * Check that a buffer contains well-formed UTF-8: no overlong encodings,
+ * no surrogate code points, nothing above U+10FFFF and no truncated 
+ * sequence at the end of the buffer.
+ * @returns ATX_SUCCESS if the buffer is valid, or ATX_ERROR_INVALID_FORMAT
+ * if it is not.
+ */
+extern ATX_Result ATX_Utf8_Validate(const char* data, ATX_Size size);
+
 /*----------------------------------------------------------------------
 |    environment variables
 +---------------------------------------------------------------------*/
@@ -241,6 +253,12 @@ extern void ATX_SetMemory(void* dest, int c, ATX_Size size);
 #else 
 extern int ATX_CompareMemory(void* mem1, const void* mem2, ATX_Size size);
 #endif
+
+#if defined(ATX_CONFIG_HAVE_MEMCHR)
+#define ATX_FindByte(s, c, n) memchr((s), (c), (n))
+#else 
+extern void* ATX_FindByte(const void* s, int c, ATX_Size n);
+#endif
     
 #if defined(ATX_CONFIG_HAVE_STRCPY)
 #define ATX_CopyString(dst, src) ((void)strcpy((dst), (src)))
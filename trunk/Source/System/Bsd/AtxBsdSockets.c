@@ -68,6 +68,7 @@
 #include <sys/time.h>
 #include <sys/select.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <fcntl.h>
@@ -85,9 +86,11 @@
 #include "AtxTypes.h"
 #include "AtxResults.h"
 #include "AtxStreams.h"
+#include "AtxInstrumentedStreams.h"
 #include "AtxSockets.h"
 #include "AtxUtils.h"
 #include "AtxLogging.h"
+#include "AtxAtomic.h"
 
 /*----------------------------------------------------------------------
 |   constants
@@ -199,6 +202,10 @@ typedef struct {
     /* interfaces */
     ATX_IMPLEMENTS(ATX_InputStream);
     ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_VectoredOutputStream);
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+    ATX_IMPLEMENTS(ATX_DescriptorStream);
+#endif
     ATX_IMPLEMENTS(ATX_Referenceable);
     
     /* members */
@@ -213,6 +220,7 @@ typedef struct {
 
     BsdSocketFdWrapper* socket_ref;
     ATX_SocketInfo      info;
+    ATX_Flags           flags;
 } BsdSocket;
 
 typedef struct {
@@ -480,7 +488,7 @@ BsdSocketFdWrapper_Destroy(BsdSocketFdWrapper* self)
 static void
 BsdSocketFdWrapper_AddReference(BsdSocketFdWrapper* self)
 {
-    ++self->reference_count;
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
 }
 
 /*----------------------------------------------------------------------
@@ -490,7 +498,7 @@ static void
 BsdSocketFdWrapper_Release(BsdSocketFdWrapper* self)
 {
     if (self == NULL) return;
-    if (--self->reference_count == 0) {
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
         BsdSocketFdWrapper_Destroy(self);
     }
 }
@@ -520,6 +528,10 @@ BsdSocketStream_Create(BsdSocketFdWrapper* socket_ref, BsdSocketStream** stream)
 +---------------------------------------------------------------------*/
 ATX_DECLARE_INTERFACE_MAP(BsdSocketStream, ATX_InputStream)
 ATX_DECLARE_INTERFACE_MAP(BsdSocketStream, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(BsdSocketStream, ATX_VectoredOutputStream)
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+ATX_DECLARE_INTERFACE_MAP(BsdSocketStream, ATX_DescriptorStream)
+#endif
 ATX_DECLARE_INTERFACE_MAP(BsdSocketStream, ATX_Referenceable)
 
 /*----------------------------------------------------------------------
@@ -542,6 +554,10 @@ BsdSocketInputStream_Create(BsdSocketFdWrapper* socket_ref,
     /* setup the interfaces */
     ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_InputStream);
     ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_OutputStream);
+    ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_VectoredOutputStream);
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+    ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_DescriptorStream);
+#endif
     ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_Referenceable);
     *stream = &ATX_BASE(socket_stream, ATX_InputStream);
 
@@ -568,6 +584,10 @@ BsdSocketOutputStream_Create(BsdSocketFdWrapper* socket_ref,
     /* set the interface */
     ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_InputStream);
     ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_OutputStream);
+    ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_VectoredOutputStream);
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+    ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_DescriptorStream);
+#endif
     ATX_SET_INTERFACE(socket_stream, BsdSocketStream, ATX_Referenceable);
     *stream = &ATX_BASE(socket_stream, ATX_OutputStream);
 
@@ -661,6 +681,82 @@ BsdSocketStream_Write(ATX_OutputStream* _self,
     }
 }
 
+/*----------------------------------------------------------------------
+|   BsdSocketStream_WriteV
++---------------------------------------------------------------------*/
+ATX_METHOD
+BsdSocketStream_WriteV(ATX_VectoredOutputStream* _self,
+                       const ATX_IoVec*          buffers,
+                       ATX_Cardinal              buffer_count,
+                       ATX_Size*                 bytes_written)
+{
+    BsdSocketStream* self = ATX_SELF(BsdSocketStream, ATX_VectoredOutputStream);
+    ATX_Cardinal     i;
+    ssize_t          nb_written;
+#if defined(_WIN32) && defined(ATX_WIN32_USE_WINSOCK2)
+    WSABUF           vecs[ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS];
+    DWORD            sent = 0;
+#elif !defined(__PPU__)
+    struct iovec     vecs[ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS];
+    struct msghdr    message;
+#endif
+
+    if (bytes_written) *bytes_written = 0;
+    if (buffer_count > ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS) {
+        buffer_count = ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS;
+    }
+
+#if defined(_WIN32) && defined(ATX_WIN32_USE_WINSOCK2)
+    for (i=0; i<buffer_count; i++) {
+        vecs[i].buf = (CHAR*)buffers[i].buffer;
+        vecs[i].len = buffers[i].size;
+    }
+#elif !defined(__PPU__)
+    for (i=0; i<buffer_count; i++) {
+        vecs[i].iov_base = (void*)buffers[i].buffer;
+        vecs[i].iov_len  = buffers[i].size;
+    }
+    ATX_SetMemory(&message, 0, sizeof(message));
+    message.msg_iov    = vecs;
+    message.msg_iovlen = buffer_count;
+#else
+    /* no sendmsg here, send the first non-empty buffer only */
+    for (i=0; i<buffer_count && buffers[i].size == 0; i++) {}
+    if (i == buffer_count) return ATX_SUCCESS;
+#endif
+
+    /* try again if we get interrupted */
+    do {
+#if defined(_WIN32) && defined(ATX_WIN32_USE_WINSOCK2)
+        if (WSASend(self->socket_ref->fd, vecs, buffer_count, &sent, 0, NULL, NULL) == SOCKET_ERROR) {
+            nb_written = -1;
+        } else {
+            nb_written = (ssize_t)sent;
+        }
+#elif !defined(__PPU__)
+        nb_written = sendmsg(self->socket_ref->fd, &message, 0);
+#else
+        nb_written = send(self->socket_ref->fd, 
+                          (SocketConstBuffer)buffers[i].buffer, 
+                          (ssize_t)buffers[i].size, 
+                          0);
+#endif
+    } while (nb_written < 0 && GetSocketError() == EINTR);
+
+    if (nb_written > 0) {
+        if (bytes_written) *bytes_written = (ATX_Size)nb_written;
+        return ATX_SUCCESS;
+    } else if (nb_written == 0) {
+        /* only empty buffers */
+        for (i=0; i<buffer_count; i++) {
+            if (buffers[i].size) return ATX_ERROR_DISCONNECTED;
+        }
+        return ATX_SUCCESS;
+    } else {
+        return MapErrorCode(GetSocketError());
+    }
+}
+
 /*----------------------------------------------------------------------
 |   BsdSocketInputStream_Seek
 +---------------------------------------------------------------------*/
@@ -771,12 +867,43 @@ BsdSocketOutputStream_Flush(ATX_OutputStream* self)
     return ATX_SUCCESS;
 }
 
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+/*----------------------------------------------------------------------
+|   BsdSocketStream_GetDescriptor
++---------------------------------------------------------------------*/
+ATX_METHOD
+BsdSocketStream_GetDescriptor(ATX_DescriptorStream* _self, int* fd)
+{
+    BsdSocketStream* self = ATX_SELF(BsdSocketStream, ATX_DescriptorStream);
+
+    *fd = self->socket_ref->fd;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   BsdSocketStream_Advance
++---------------------------------------------------------------------*/
+ATX_METHOD
+BsdSocketStream_Advance(ATX_DescriptorStream* self, ATX_LargeSize count)
+{
+    /* sockets have no position to keep track of */
+    ATX_COMPILER_UNUSED(self);
+    ATX_COMPILER_UNUSED(count);
+
+    return ATX_SUCCESS;
+}
+#endif
+
 /*----------------------------------------------------------------------
 |   BsdSocketStream_GetInterface
 +---------------------------------------------------------------------*/
 ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(BsdSocketStream)
     ATX_GET_INTERFACE_ACCEPT(BsdSocketStream, ATX_InputStream)
     ATX_GET_INTERFACE_ACCEPT(BsdSocketStream, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(BsdSocketStream, ATX_VectoredOutputStream)
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+    ATX_GET_INTERFACE_ACCEPT(BsdSocketStream, ATX_DescriptorStream)
+#endif
     ATX_GET_INTERFACE_ACCEPT(BsdSocketStream, ATX_Referenceable)
 ATX_END_GET_INTERFACE_IMPLEMENTATION
 
@@ -801,6 +928,23 @@ ATX_BEGIN_INTERFACE_MAP(BsdSocketStream, ATX_OutputStream)
     BsdSocketOutputStream_Flush
 ATX_END_INTERFACE_MAP
 
+/*----------------------------------------------------------------------
+|   ATX_VectoredOutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(BsdSocketStream, ATX_VectoredOutputStream)
+    BsdSocketStream_WriteV
+ATX_END_INTERFACE_MAP
+
+#if defined(ATX_CONFIG_HAVE_SENDFILE)
+/*----------------------------------------------------------------------
+|   ATX_DescriptorStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(BsdSocketStream, ATX_DescriptorStream)
+    BsdSocketStream_GetDescriptor,
+    BsdSocketStream_Advance
+ATX_END_INTERFACE_MAP
+#endif
+
 /*----------------------------------------------------------------------
 |   ATX_Referenceable interface
 +---------------------------------------------------------------------*/
@@ -849,7 +993,7 @@ BsdSocket_Destruct(BsdSocket* self)
 |   BsdSocket_Create
 +---------------------------------------------------------------------*/
 static ATX_Result
-BsdSocket_Create(SocketFd fd, ATX_Socket** object)
+BsdSocket_Create(SocketFd fd, ATX_Flags flags, ATX_Socket** object)
 { 
     BsdSocket* bsd_socket;
 
@@ -862,6 +1006,7 @@ BsdSocket_Create(SocketFd fd, ATX_Socket** object)
 
     /* construct object */
     BsdSocket_Construct(bsd_socket, fd);
+    bsd_socket->flags = flags;
 
     return ATX_SUCCESS;
 }
@@ -1015,7 +1160,10 @@ BsdSocket_GetInputStream(ATX_Socket* _self, ATX_InputStream** stream)
     if (self->socket_ref == NULL) return ATX_ERROR_INVALID_STATE;
 
     /* create a stream */
-    return BsdSocketInputStream_Create(self->socket_ref, stream);
+    ATX_CHECK(BsdSocketInputStream_Create(self->socket_ref, stream));
+
+    /* record statistics if enabled for the process */
+    return ATX_StreamInstrumentation_WrapInputStream(stream);
 }
 
 /*----------------------------------------------------------------------
@@ -1025,12 +1173,25 @@ ATX_METHOD
 BsdSocket_GetOutputStream(ATX_Socket* _self, ATX_OutputStream** stream)
 {
     BsdSocket* self = ATX_SELF(BsdSocket, ATX_Socket);
+    ATX_Result result;
 
     /* check that we have a socket */
     if (self->socket_ref == NULL) return ATX_ERROR_INVALID_STATE;
 
-    /* create a stream */
-    return BsdSocketOutputStream_Create(self->socket_ref, stream);
+    /* wrap the stream in a buffer if requested */
+    if (self->flags & ATX_SOCKET_FLAG_BUFFERED_OUTPUT) {
+        ATX_OutputStream* socket_stream = NULL;
+        ATX_CHECK(BsdSocketOutputStream_Create(self->socket_ref, &socket_stream));
+        result = ATX_BufferedOutputStream_Create(socket_stream, 0, stream);
+        ATX_RELEASE_OBJECT(socket_stream);
+    } else {
+        /* create a stream */
+        result = BsdSocketOutputStream_Create(self->socket_ref, stream);
+    }
+    if (ATX_FAILED(result)) return result;
+
+    /* record statistics if enabled for the process */
+    return ATX_StreamInstrumentation_WrapOutputStream(stream);
 }
 
 /*----------------------------------------------------------------------
@@ -1224,6 +1385,7 @@ BsdUdpSocket_Receive(ATX_DatagramSocket* _self,
     if (buffer_length == 0) {
         return ATX_ERROR_INVALID_PARAMETERS;
     }
+    if (buffer == NULL) return ATX_ERROR_OUT_OF_MEMORY;
 
     /* receive a packet */
     if (address != NULL) {
@@ -1437,6 +1599,15 @@ ATX_DECLARE_INTERFACE_MAP(BsdTcpClientSocket, ATX_Destroyable)
 +---------------------------------------------------------------------*/
 ATX_Result
 ATX_TcpClientSocket_Create(ATX_Socket** object)
+{ 
+    return ATX_TcpClientSocket_CreateEx(0, object);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TcpClientSocket_CreateEx
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TcpClientSocket_CreateEx(ATX_Flags flags, ATX_Socket** object)
 { 
     BsdSocket* client;
 
@@ -1452,6 +1623,7 @@ ATX_TcpClientSocket_Create(ATX_Socket** object)
 
     /* construct the object */
     BsdSocket_Construct(client, socket(AF_INET, SOCK_STREAM, 0));
+    client->flags = flags;
 
     /* setup the interfaces */
     ATX_SET_INTERFACE(client, BsdTcpClientSocket, ATX_Socket);
@@ -1604,6 +1776,15 @@ ATX_DECLARE_INTERFACE_MAP(BsdTcpServerSocket, ATX_Destroyable)
 +---------------------------------------------------------------------*/
 ATX_Result
 ATX_TcpServerSocket_Create(ATX_ServerSocket** object)
+{ 
+    return ATX_TcpServerSocket_CreateEx(0, object);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_TcpServerSocket_CreateEx
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_TcpServerSocket_CreateEx(ATX_Flags flags, ATX_ServerSocket** object)
 { 
     BsdTcpServerSocket* server;
 
@@ -1619,6 +1800,7 @@ ATX_TcpServerSocket_Create(ATX_ServerSocket** object)
 
     /* construct object */
     BsdSocket_Construct(&ATX_BASE(server,BsdSocket), socket(AF_INET, SOCK_STREAM, 0));
+    ATX_BASE(server,BsdSocket).flags = flags;
     server->max_clients = 0;
 
     /* set socket options */
@@ -1686,7 +1868,7 @@ BsdTcpServerSocket_WaitForNewClient(ATX_ServerSocket* _self,
     }
 
     /* create a new client socket to wrap this file descriptor */
-    result = BsdSocket_Create(socket_fd, client);
+    result = BsdSocket_Create(socket_fd, ATX_BASE(self, BsdSocket).flags, client);
     if (result != ATX_SUCCESS) return result;
     
     /* done */
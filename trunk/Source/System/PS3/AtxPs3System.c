@@ -74,6 +74,15 @@ ATX_System_GetCurrentTimeStamp(ATX_TimeStamp* now)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_System_GetMonotonicTimeStamp
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_System_GetMonotonicTimeStamp(ATX_TimeStamp* now)
+{
+    return ATX_System_GetCurrentTimeStamp(now);
+}
+
 /*----------------------------------------------------------------------
 |   ATX_System_Sleep
 +---------------------------------------------------------------------*/
@@ -129,4 +138,12 @@ ATX_System_GetRandomInteger()
     return rand();
 }
 
-
+/*----------------------------------------------------------------------
+|   ATX_System_GetProcessorCount
++---------------------------------------------------------------------*/
+ATX_Cardinal
+ATX_System_GetProcessorCount(void)
+{
+    /* the PPU runs two hardware threads */
+    return 2;
+}
@@ -72,6 +72,27 @@ ATX_System_GetCurrentTimeStamp(ATX_TimeStamp* now)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_System_GetMonotonicTimeStamp
+|
+|   Time elapsed since an arbitrary origin, unaffected by changes to
+|   the wall clock. Use this for measuring durations.
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_System_GetMonotonicTimeStamp(ATX_TimeStamp* now)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now_ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &now_ts) == 0) {
+        now->seconds     = (ATX_Int32)now_ts.tv_sec;
+        now->nanoseconds = (ATX_Int32)now_ts.tv_nsec;
+        return ATX_SUCCESS;
+    }
+#endif
+
+    return ATX_System_GetCurrentTimeStamp(now);
+}
+
 /*----------------------------------------------------------------------
 |   ATX_System_Sleep
 +---------------------------------------------------------------------*/
@@ -127,3 +148,15 @@ ATX_System_GetRandomInteger()
     return rand();
 }
 
+/*----------------------------------------------------------------------
+|   ATX_System_GetProcessorCount
++---------------------------------------------------------------------*/
+ATX_Cardinal
+ATX_System_GetProcessorCount(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0) return (ATX_Cardinal)count;
+#endif
+    return 1;
+}
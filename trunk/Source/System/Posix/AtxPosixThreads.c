@@ -33,9 +33,24 @@
 |   includes
 +---------------------------------------------------------------------*/
 #include <pthread.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include "AtxConfig.h"
 #include "AtxThreads.h"
 #include "AtxLogging.h"
 #include "AtxUtils.h"
+#include "AtxAtomic.h"
+
+#if defined(ATX_CONFIG_HAVE_FUTEX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#if defined(ATX_CONFIG_HAVE_PRCTL)
+#include <sys/prctl.h>
+#endif
 
 /*----------------------------------------------------------------------
 |   types
@@ -44,15 +59,93 @@ struct ATX_Mutex {
     pthread_mutex_t mutex;
 };
 
+struct ATX_Condition {
+    pthread_cond_t condition;
+};
+
+/* on Linux, semaphores are a counter that threads wait on with futexes,
+   so acquiring and releasing without contention stays in user space */
+struct ATX_Semaphore {
+#if defined(ATX_CONFIG_HAVE_FUTEX)
+    ATX_AtomicInt   value;
+    ATX_AtomicInt   waiters;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t  condition;
+    ATX_Cardinal    value;
+#endif
+};
+
+struct ATX_Thread {
+    pthread_t          thread;
+    ATX_ThreadFunction function;
+    void*              argument;
+    char               name[16];
+};
+
+/* when the compiler supports __thread, values are kept in a per-thread
+   array of slots, and a single pthread key runs the destructors. 
+   Thread locals that do not get a slot use a pthread key of their own */
+struct ATX_ThreadLocal {
+    ATX_ThreadLocalDestructor destructor;
+    pthread_key_t             key;
+#if defined(ATX_CONFIG_HAVE_TLS)
+    ATX_Int32                 id;   /* never reused */
+    int                       slot; /* -1 if the thread local has a key */
+#endif
+};
+
+#if defined(ATX_CONFIG_HAVE_TLS)
+typedef struct {
+    ATX_AtomicInt             id;   /* 0 if the slot is free */
+    ATX_ThreadLocalDestructor destructor;
+} ATX_ThreadLocalSlot;
+
+typedef struct {
+    ATX_Int32 id;                   /* id of the thread local that set it */
+    void*     value;
+} ATX_ThreadLocalValue;
+#endif
+
 /*----------------------------------------------------------------------
 |   logger
 +---------------------------------------------------------------------*/
 ATX_SET_LOCAL_LOGGER("atomix.posix.threads")
 
+/*----------------------------------------------------------------------
+|   constants
++---------------------------------------------------------------------*/
+#define ATX_THREAD_LOCAL_MAX_SLOTS 64
+#define ATX_THREAD_LOCAL_RESERVED  -1 /* slot id while it is set up */
+
 /*----------------------------------------------------------------------
 |   globals
 +---------------------------------------------------------------------*/
-static pthread_mutex_t atx_global_lock = PTHREAD_MUTEX_INITIALIZER;
+#if defined(ATX_CONFIG_HAVE_TLS)
+static pthread_once_t               atx_thread_local_once = PTHREAD_ONCE_INIT;
+static pthread_key_t                atx_thread_local_exit_key;
+static ATX_AtomicInt                atx_thread_local_last_id = 0;
+static ATX_ThreadLocalSlot          atx_thread_local_slots[ATX_THREAD_LOCAL_MAX_SLOTS];
+static __thread ATX_ThreadLocalValue atx_thread_local_values[ATX_THREAD_LOCAL_MAX_SLOTS];
+static __thread int                 atx_thread_local_exit_registered = 0;
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_Posix_GetDeadline
+|
+|   Compute the time at which a timeout expires, on the given clock.
++---------------------------------------------------------------------*/
+static void
+ATX_Posix_GetDeadline(clockid_t clock, ATX_Timeout timeout, struct timespec* deadline)
+{
+    clock_gettime(clock, deadline);
+    deadline->tv_sec  += timeout/1000;
+    deadline->tv_nsec += (long)(timeout%1000)*1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_nsec -= 1000000000L;
+        ++deadline->tv_sec;
+    }
+}
 
 /*----------------------------------------------------------------------
 |   ATX_GetCurrentThreadId
@@ -75,9 +168,14 @@ ATX_Mutex_Create(ATX_Mutex** mutex)
         ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
     }
     *mutex = ATX_AllocateZeroMemory(sizeof(ATX_Mutex));
+    if (*mutex == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
     pres = pthread_mutex_init(&(*mutex)->mutex, NULL);
     if (pres != 0) {
         ATX_LOG_SEVERE_1("pthread mutex init failed with error %d", pres);
+        ATX_FreeMemory(*mutex);
+        *mutex = NULL;
         return ATX_FAILURE;
     }
     return ATX_SUCCESS;
@@ -89,34 +187,31 @@ ATX_Mutex_Create(ATX_Mutex** mutex)
 ATX_Result 
 ATX_Mutex_LockAutoCreate(ATX_Mutex** mutex)
 {
-    ATX_Result result = ATX_SUCCESS;
-    int pres;
+    ATX_Mutex* self;
+    int        pres;
 
     if (mutex == NULL) {
         ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
     }
     
-    if (*mutex == NULL) { /* slight optimization */
-        /* lock global */
-        pthread_mutex_lock(&atx_global_lock);
-
-        /* creation */
-        if (*mutex == NULL) {
-            result = ATX_Mutex_Create(mutex);
+    /* once the mutex is published, this is just a load */
+    self = (ATX_Mutex*)ATX_Atomic_LoadPointer((ATX_AtomicPointer*)mutex, ATX_ATOMIC_ACQUIRE);
+    if (self == NULL) {
+        /* racing threads each create one, and only the first one is kept */
+        ATX_CHECK_WARNING(ATX_Mutex_Create(&self));
+        if (!ATX_Atomic_CompareAndSwapPointer((ATX_AtomicPointer*)mutex, NULL, (void*)self)) {
+            ATX_Mutex_Destroy(self);
+            self = (ATX_Mutex*)ATX_Atomic_LoadPointer((ATX_AtomicPointer*)mutex, ATX_ATOMIC_ACQUIRE);
         }
-    
-        /* unlock global */
-        pthread_mutex_unlock(&atx_global_lock);
     }
-    ATX_CHECK_WARNING(result);
 
     /* go on and lock */
-    pres = pthread_mutex_lock(&(*mutex)->mutex);
+    pres = pthread_mutex_lock(&self->mutex);
     if (pres != 0) {
         ATX_LOG_SEVERE_1("pthread mutex lock failed with error %d", pres);
-        result = ATX_FAILURE;
+        return ATX_FAILURE;
     }
-    return result;
+    return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
@@ -168,4 +263,571 @@ ATX_Mutex_Destroy(ATX_Mutex* mutex)
     ATX_FreeMemory(mutex);
     return ATX_SUCCESS;
 }
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Create(ATX_Condition** condition)
+{
+    int pres;
+    if (condition == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *condition = ATX_AllocateZeroMemory(sizeof(ATX_Condition));
+    if (*condition == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+#if defined(ATX_CONFIG_HAVE_CONDATTR_SETCLOCK)
+    {
+        /* time out on the monotonic clock, immune to clock changes */
+        pthread_condattr_t attributes;
+        pthread_condattr_init(&attributes);
+        pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+        pres = pthread_cond_init(&(*condition)->condition, &attributes);
+        pthread_condattr_destroy(&attributes);
+    }
+#else
+    pres = pthread_cond_init(&(*condition)->condition, NULL);
+#endif
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread cond init failed with error %d", pres);
+        ATX_FreeMemory(*condition);
+        *condition = NULL;
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Wait
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Wait(ATX_Condition* condition, ATX_Mutex* mutex)
+{
+    int pres;
+    if (condition == NULL || mutex == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+
+    pres = pthread_cond_wait(&condition->condition, &mutex->mutex);
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread cond wait failed with error %d", pres);
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_TimedWait
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_TimedWait(ATX_Condition* condition, 
+                        ATX_Mutex*     mutex, 
+                        ATX_Timeout    timeout)
+{
+    struct timespec deadline;
+    int             pres;
+
+    if (timeout < 0) return ATX_Condition_Wait(condition, mutex);
+    if (condition == NULL || mutex == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+
+#if defined(ATX_CONFIG_HAVE_CONDATTR_SETCLOCK)
+    ATX_Posix_GetDeadline(CLOCK_MONOTONIC, timeout, &deadline);
+#else
+    ATX_Posix_GetDeadline(CLOCK_REALTIME, timeout, &deadline);
+#endif
+    pres = pthread_cond_timedwait(&condition->condition, &mutex->mutex, &deadline);
+    if (pres == ETIMEDOUT) return ATX_ERROR_TIMEOUT;
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread cond timedwait failed with error %d", pres);
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Signal
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Signal(ATX_Condition* condition)
+{
+    if (condition == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    pthread_cond_signal(&condition->condition);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Broadcast
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Broadcast(ATX_Condition* condition)
+{
+    if (condition == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    pthread_cond_broadcast(&condition->condition);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Destroy(ATX_Condition* condition)
+{
+    if (condition == NULL) return ATX_SUCCESS;
+    pthread_cond_destroy(&condition->condition);
+    ATX_FreeMemory(condition);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Create(ATX_Cardinal initial_count, ATX_Semaphore** semaphore)
+{
+    if (semaphore == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *semaphore = ATX_AllocateZeroMemory(sizeof(ATX_Semaphore));
+    if (*semaphore == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+#if defined(ATX_CONFIG_HAVE_FUTEX)
+    (*semaphore)->value = (int)initial_count;
+#else
+    pthread_mutex_init(&(*semaphore)->mutex, NULL);
+    pthread_cond_init(&(*semaphore)->condition, NULL);
+    (*semaphore)->value = initial_count;
+#endif
+    return ATX_SUCCESS;
+}
+
+#if defined(ATX_CONFIG_HAVE_FUTEX)
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_TimedAcquire
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_TimedAcquire(ATX_Semaphore* self, ATX_Timeout timeout)
+{
+    struct timespec deadline;
+    struct timespec remaining;
+    
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (timeout > 0) ATX_Posix_GetDeadline(CLOCK_MONOTONIC, timeout, &deadline);
+    
+    for (;;) {
+        /* take one if we can */
+        int value = ATX_Atomic_Load(&self->value, ATX_ATOMIC_RELAXED);
+        if (value > 0) {
+            if (ATX_Atomic_CompareAndSwap(&self->value, value, value-1)) {
+                return ATX_SUCCESS;
+            }
+            continue;
+        }
+        
+        /* see how long we can still wait */
+        if (timeout == 0) return ATX_ERROR_TIMEOUT;
+        if (timeout > 0) {
+            clock_gettime(CLOCK_MONOTONIC, &remaining);
+            remaining.tv_sec  = deadline.tv_sec-remaining.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec-remaining.tv_nsec;
+            if (remaining.tv_nsec < 0) {
+                remaining.tv_nsec += 1000000000L;
+                --remaining.tv_sec;
+            }
+            if (remaining.tv_sec < 0) return ATX_ERROR_TIMEOUT;
+        }
+        
+        /* sleep until the value is no longer 0 (the kernel checks that 
+           it still is before sleeping, so a release can't be missed) */
+        ATX_Atomic_Add(&self->waiters, 1, ATX_ATOMIC_SEQ_CST);
+        syscall(SYS_futex, &self->value, FUTEX_WAIT_PRIVATE, 0, 
+                timeout < 0 ? NULL : &remaining, NULL, 0);
+        ATX_Atomic_Add(&self->waiters, -1, ATX_ATOMIC_RELAXED);
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Release
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Release(ATX_Semaphore* self, ATX_Cardinal count)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (count == 0) return ATX_SUCCESS;
+    ATX_Atomic_Add(&self->value, (int)count, ATX_ATOMIC_SEQ_CST);
+    if (ATX_Atomic_Load(&self->waiters, ATX_ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &self->value, FUTEX_WAKE_PRIVATE, (int)count, NULL, NULL, 0);
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Destroy(ATX_Semaphore* self)
+{
+    if (self) ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+#else
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_TimedAcquire
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_TimedAcquire(ATX_Semaphore* self, ATX_Timeout timeout)
+{
+    struct timespec deadline;
+    ATX_Result      result = ATX_SUCCESS;
+    
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (timeout > 0) ATX_Posix_GetDeadline(CLOCK_REALTIME, timeout, &deadline);
+    
+    pthread_mutex_lock(&self->mutex);
+    while (self->value == 0 && ATX_SUCCEEDED(result)) {
+        if (timeout < 0) {
+            pthread_cond_wait(&self->condition, &self->mutex);
+        } else if (timeout == 0 ||
+                   pthread_cond_timedwait(&self->condition, &self->mutex, &deadline) == ETIMEDOUT) {
+            if (self->value == 0) result = ATX_ERROR_TIMEOUT;
+        }
+    }
+    if (ATX_SUCCEEDED(result)) --self->value;
+    pthread_mutex_unlock(&self->mutex);
+    
+    return result;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Release
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Release(ATX_Semaphore* self, ATX_Cardinal count)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    pthread_mutex_lock(&self->mutex);
+    self->value += count;
+    if (count == 1) {
+        pthread_cond_signal(&self->condition);
+    } else if (count) {
+        pthread_cond_broadcast(&self->condition);
+    }
+    pthread_mutex_unlock(&self->mutex);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Destroy(ATX_Semaphore* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    pthread_cond_destroy(&self->condition);
+    pthread_mutex_destroy(&self->mutex);
+    ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Acquire
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Acquire(ATX_Semaphore* self)
+{
+    return ATX_Semaphore_TimedAcquire(self, ATX_TIMEOUT_INFINITE);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_SetCurrentName
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_SetCurrentName(const char* name)
+{
+    if (name == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+#if defined(ATX_CONFIG_HAVE_PRCTL)
+    if (prctl(PR_SET_NAME, (unsigned long)name, 0, 0, 0)) {
+        return ATX_ERROR_ERRNO(errno);
+    }
+    return ATX_SUCCESS;
+#elif defined(ATX_CONFIG_HAVE_PTHREAD_SETNAME_NP)
+    {
+        int pres = pthread_setname_np(name);
+        return pres ? ATX_ERROR_ERRNO(pres) : ATX_SUCCESS;
+    }
+#else
+    return ATX_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_Run
++---------------------------------------------------------------------*/
+static void*
+ATX_Thread_Run(void* argument)
+{
+    ATX_Thread* thread = (ATX_Thread*)argument;
+    
+    /* names can only be set from the thread itself on some systems */
+    if (thread->name[0]) ATX_Thread_SetCurrentName(thread->name);
+    
+    thread->function(thread->argument);
+    return NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_Create(ATX_ThreadFunction function, 
+                  void*              argument, 
+                  ATX_Thread**       thread)
+{
+    return ATX_Thread_CreateEx(function, argument, NULL, thread);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_CreateEx
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_CreateEx(ATX_ThreadFunction       function, 
+                    void*                    argument, 
+                    const ATX_ThreadOptions* options,
+                    ATX_Thread**             thread)
+{
+    pthread_attr_t  attributes;
+    pthread_attr_t* thread_attributes = NULL;
+    int             pres;
+    
+    if (function == NULL || thread == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *thread = ATX_AllocateZeroMemory(sizeof(ATX_Thread));
+    if (*thread == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+    (*thread)->function = function;
+    (*thread)->argument = argument;
+    
+    /* apply the options */
+    if (options && options->name) {
+        ATX_CopyStringN((*thread)->name, options->name, sizeof((*thread)->name)-1);
+    }
+    if (options && options->stack_size) {
+        size_t stack_size = options->stack_size;
+#if defined(PTHREAD_STACK_MIN)
+        if (stack_size < (size_t)PTHREAD_STACK_MIN) stack_size = PTHREAD_STACK_MIN;
+#endif
+        pthread_attr_init(&attributes);
+        pres = pthread_attr_setstacksize(&attributes, stack_size);
+        if (pres != 0) {
+            ATX_LOG_WARNING_1("pthread attr setstacksize failed with error %d", pres);
+        }
+        thread_attributes = &attributes;
+    }
+    
+    pres = pthread_create(&(*thread)->thread, thread_attributes, ATX_Thread_Run, *thread);
+    if (thread_attributes) pthread_attr_destroy(thread_attributes);
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread create failed with error %d", pres);
+        ATX_FreeMemory(*thread);
+        *thread = NULL;
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_Join
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_Join(ATX_Thread* thread)
+{
+    int pres;
+    if (thread == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    pres = pthread_join(thread->thread, NULL);
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread join failed with error %d", pres);
+        return ATX_FAILURE;
+    }
+    ATX_FreeMemory(thread);
+    return ATX_SUCCESS;
+}
+
+#if defined(ATX_CONFIG_HAVE_TLS)
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_RunDestructors
+|
+|   Called by pthreads when a thread that set a value in a slot exits.
+|   A destructor that sets values registers the thread again, and 
+|   pthreads then calls us again.
++---------------------------------------------------------------------*/
+static void
+ATX_ThreadLocal_RunDestructors(void* marker)
+{
+    int i;
+    
+    ATX_COMPILER_UNUSED(marker);
+    atx_thread_local_exit_registered = 0;
+    for (i=0; i<ATX_THREAD_LOCAL_MAX_SLOTS; i++) {
+        ATX_ThreadLocalValue* value = &atx_thread_local_values[i];
+        void*                 data  = value->value;
         
+        if (data == NULL) continue;
+        value->value = NULL;
+        if (value->id == ATX_Atomic_Load(&atx_thread_local_slots[i].id, ATX_ATOMIC_ACQUIRE) &&
+            atx_thread_local_slots[i].destructor) {
+            atx_thread_local_slots[i].destructor(data);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Initialize
++---------------------------------------------------------------------*/
+static void
+ATX_ThreadLocal_Initialize(void)
+{
+    int pres = pthread_key_create(&atx_thread_local_exit_key, ATX_ThreadLocal_RunDestructors);
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread key create failed with error %d", pres);
+    }
+}
+#endif
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ThreadLocal_Create(ATX_ThreadLocalDestructor destructor, ATX_ThreadLocal** local)
+{
+    ATX_ThreadLocal* self;
+    int              pres;
+    
+    if (local == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *local = NULL;
+    self = ATX_AllocateZeroMemory(sizeof(ATX_ThreadLocal));
+    if (self == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+    self->destructor = destructor;
+    
+#if defined(ATX_CONFIG_HAVE_TLS)
+    /* take a free slot if there is one */
+    pthread_once(&atx_thread_local_once, ATX_ThreadLocal_Initialize);
+    do {
+        self->id = ATX_Atomic_Add(&atx_thread_local_last_id, 1, ATX_ATOMIC_RELAXED) & 0x7FFFFFFF;
+    } while (self->id == 0);
+    for (self->slot=0; self->slot<ATX_THREAD_LOCAL_MAX_SLOTS; self->slot++) {
+        ATX_ThreadLocalSlot* slot = &atx_thread_local_slots[self->slot];
+        if (ATX_Atomic_CompareAndSwap(&slot->id, 0, ATX_THREAD_LOCAL_RESERVED)) {
+            slot->destructor = destructor;
+            ATX_Atomic_Store(&slot->id, self->id, ATX_ATOMIC_RELEASE);
+            *local = self;
+            return ATX_SUCCESS;
+        }
+    }
+    self->slot = -1;
+#endif
+
+    pres = pthread_key_create(&self->key, destructor);
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread key create failed with error %d", pres);
+        ATX_FreeMemory(self);
+        return ATX_FAILURE;
+    }
+    *local = self;
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ThreadLocal_Destroy(ATX_ThreadLocal* self)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+#if defined(ATX_CONFIG_HAVE_TLS)
+    if (self->slot >= 0) {
+        /* values left in threads no longer match the id of the slot */
+        ATX_Atomic_Store(&atx_thread_local_slots[self->slot].id, 0, ATX_ATOMIC_RELEASE);
+        ATX_FreeMemory(self);
+        return ATX_SUCCESS;
+    }
+#endif
+    pthread_key_delete(self->key);
+    ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Get
++---------------------------------------------------------------------*/
+void*
+ATX_ThreadLocal_Get(ATX_ThreadLocal* self)
+{
+#if defined(ATX_CONFIG_HAVE_TLS)
+    if (self->slot >= 0) {
+        ATX_ThreadLocalValue* value = &atx_thread_local_values[self->slot];
+        return value->id == self->id ? value->value : NULL;
+    }
+#endif
+    return pthread_getspecific(self->key);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Set
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ThreadLocal_Set(ATX_ThreadLocal* self, void* value)
+{
+    int pres;
+    
+#if defined(ATX_CONFIG_HAVE_TLS)
+    if (self->slot >= 0) {
+        /* make sure that the destructors run when this thread exits */
+        if (value && !atx_thread_local_exit_registered) {
+            pres = pthread_setspecific(atx_thread_local_exit_key, &atx_thread_local_exit_registered);
+            if (pres != 0) {
+                ATX_LOG_SEVERE_1("pthread setspecific failed with error %d", pres);
+                return ATX_FAILURE;
+            }
+            atx_thread_local_exit_registered = 1;
+        }
+        atx_thread_local_values[self->slot].id    = self->id;
+        atx_thread_local_values[self->slot].value = value;
+        return ATX_SUCCESS;
+    }
+#endif
+    pres = pthread_setspecific(self->key, value);
+    if (pres != 0) {
+        ATX_LOG_SEVERE_1("pthread setspecific failed with error %d", pres);
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
@@ -46,13 +46,26 @@
 #if defined(ATX_CONFIG_HAVE_UNISTD_H)
 #include <unistd.h>
 #endif
+#if defined(ATX_CONFIG_HAVE_READV)
+#include <sys/uio.h>
+#endif
+
+/*----------------------------------------------------------------------
+|       config
++---------------------------------------------------------------------*/
+#if (defined(ATX_CONFIG_HAVE_SENDFILE) || defined(ATX_CONFIG_HAVE_MMAP)) && \
+    defined(ATX_CONFIG_HAVE_UNISTD_H)
+#define ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM
+#endif
 
 #include "AtxUtils.h"
 #include "AtxStreams.h"
 #include "AtxFile.h"
+#include "AtxInstrumentedStreams.h"
 #include "AtxResults.h"
 #include "AtxReferenceable.h"
 #include "AtxDestroyable.h"
+#include "AtxAtomic.h"
 
 /*----------------------------------------------------------------------
 |       types
@@ -63,12 +76,17 @@ typedef struct {
     ATX_LargeSize size;
     ATX_Position  position;
     ATX_String    name;
+    ATX_Boolean   unbuffered;
 } StdcFileWrapper;
 
 typedef struct {
     /* interfaces */
     ATX_IMPLEMENTS(ATX_InputStream);
     ATX_IMPLEMENTS(ATX_OutputStream);
+    ATX_IMPLEMENTS(ATX_VectoredOutputStream);
+#if defined(ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM)
+    ATX_IMPLEMENTS(ATX_DescriptorStream);
+#endif
     ATX_IMPLEMENTS(ATX_Referenceable);
 
     /* members */
@@ -161,7 +179,7 @@ StdcFileWrapper_Destroy(StdcFileWrapper* self)
 static void
 StdcFileWrapper_AddReference(StdcFileWrapper* self)
 {
-    ++self->reference_count;
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
 }
 
 /*----------------------------------------------------------------------
@@ -171,7 +189,7 @@ static void
 StdcFileWrapper_Release(StdcFileWrapper* self)
 {
     if (self == NULL) return;
-    if (--self->reference_count == 0) {
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
         StdcFileWrapper_Destroy(self);
     }
 }
@@ -181,6 +199,10 @@ StdcFileWrapper_Release(StdcFileWrapper* self)
 +---------------------------------------------------------------------*/
 ATX_DECLARE_INTERFACE_MAP(StdcFileStream, ATX_InputStream)
 ATX_DECLARE_INTERFACE_MAP(StdcFileStream, ATX_OutputStream)
+ATX_DECLARE_INTERFACE_MAP(StdcFileStream, ATX_VectoredOutputStream)
+#if defined(ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM)
+ATX_DECLARE_INTERFACE_MAP(StdcFileStream, ATX_DescriptorStream)
+#endif
 ATX_DECLARE_INTERFACE_MAP(StdcFileStream, ATX_Referenceable)
 
 /*----------------------------------------------------------------------
@@ -203,6 +225,10 @@ StdcFileStream_Create(StdcFileWrapper* file, StdcFileStream** stream)
     /* setup interfaces */
     ATX_SET_INTERFACE((*stream), StdcFileStream, ATX_InputStream);
     ATX_SET_INTERFACE((*stream), StdcFileStream, ATX_OutputStream);
+    ATX_SET_INTERFACE((*stream), StdcFileStream, ATX_VectoredOutputStream);
+#if defined(ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM)
+    ATX_SET_INTERFACE((*stream), StdcFileStream, ATX_DescriptorStream);
+#endif
     ATX_SET_INTERFACE((*stream), StdcFileStream, ATX_Referenceable);
 
     return ATX_SUCCESS;
@@ -418,6 +444,73 @@ StdcFileOutputStream_Write(ATX_OutputStream* _self,
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|       StdcFileOutputStream_WriteV
++---------------------------------------------------------------------*/
+ATX_METHOD
+StdcFileOutputStream_WriteV(ATX_VectoredOutputStream* _self,
+                            const ATX_IoVec*          buffers,
+                            ATX_Cardinal              buffer_count,
+                            ATX_Size*                 bytes_written)
+{
+    StdcFileStream* self = ATX_SELF(StdcFileStream, ATX_VectoredOutputStream);
+    ATX_Size        total = 0;
+    ATX_Cardinal    i;
+
+    if (bytes_written) *bytes_written = 0;
+    
+#if defined(ATX_CONFIG_HAVE_READV)
+    /* when stdio doesn't buffer, write all the buffers with one call.
+       writev goes to the current offset of the descriptor, so this also
+       works for pipes and for files opened in append mode */
+    if (self->file->unbuffered) {
+        struct iovec vecs[ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS];
+        int          fd = fileno(self->file->file);
+        ssize_t      nb_written;
+        off_t        offset;
+        if (buffer_count > ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS) {
+            buffer_count = ATX_VECTORED_OUTPUT_STREAM_MAX_BUFFERS;
+        }
+        for (i=0; i<buffer_count; i++) {
+            vecs[i].iov_base = (void*)buffers[i].buffer;
+            vecs[i].iov_len  = buffers[i].size;
+        }
+        fflush(self->file->file);
+        do {
+            nb_written = writev(fd, vecs, buffer_count);
+        } while (nb_written < 0 && errno == EINTR);
+        if (nb_written < 0) return ATX_ERROR_ERRNO(errno);
+        
+        /* keep stdio and our position in sync with the descriptor */
+        offset = lseek(fd, 0, SEEK_CUR);
+        if (offset >= 0) {
+            self->file->position = (ATX_Position)offset;
+            ATX_fseek(self->file->file, offset, SEEK_SET);
+        } else {
+            self->file->position += nb_written;
+        }
+        if (bytes_written) *bytes_written = (ATX_Size)nb_written;
+        return ATX_SUCCESS;
+    }
+#endif
+
+    /* stdio already coalesces small writes */
+    for (i=0; i<buffer_count; i++) {
+        size_t nb_written;
+        if (buffers[i].size == 0) continue;
+        nb_written = fwrite(buffers[i].buffer, 1, (size_t)buffers[i].size, self->file->file);
+        self->file->position += nb_written;
+        total += (ATX_Size)nb_written;
+        if (nb_written < buffers[i].size) {
+            if (total == 0) return ATX_FAILURE;
+            break;
+        }
+    }
+    if (bytes_written) *bytes_written = total;
+
+    return ATX_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
 |       StdcFileOutputStream_Seek
 +---------------------------------------------------------------------*/
@@ -447,12 +540,52 @@ StdcFileOutputStream_Flush(ATX_OutputStream* _self)
     return StdcFileStream_Flush(ATX_SELF(StdcFileStream, ATX_OutputStream));
 }
 
+#if defined(ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM)
+/*----------------------------------------------------------------------
+|       StdcFileStream_GetDescriptor
++---------------------------------------------------------------------*/
+ATX_METHOD
+StdcFileStream_GetDescriptor(ATX_DescriptorStream* _self, int* fd)
+{
+    StdcFileStream* self = ATX_SELF(StdcFileStream, ATX_DescriptorStream);
+
+    /* write out what stdio buffers and line the descriptor up with us */
+    fflush(self->file->file);
+    if (ATX_fseek(self->file->file, self->file->position, SEEK_SET) != 0) {
+        /* not seekable: stdio may hold read-ahead data we can't give back */
+        if (!self->file->unbuffered) return ATX_ERROR_NOT_SUPPORTED;
+    }
+    *fd = fileno(self->file->file);
+    
+    return *fd < 0 ? ATX_ERROR_NOT_SUPPORTED : ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|       StdcFileStream_Advance
++---------------------------------------------------------------------*/
+ATX_METHOD
+StdcFileStream_Advance(ATX_DescriptorStream* _self, ATX_LargeSize count)
+{
+    StdcFileStream* self = ATX_SELF(StdcFileStream, ATX_DescriptorStream);
+
+    /* the descriptor has moved, bring stdio in sync */
+    self->file->position += count;
+    ATX_fseek(self->file->file, self->file->position, SEEK_SET);
+    
+    return ATX_SUCCESS;
+}
+#endif
+
 /*----------------------------------------------------------------------
 |   GetInterface implementation
 +---------------------------------------------------------------------*/
 ATX_BEGIN_GET_INTERFACE_IMPLEMENTATION(StdcFileStream)
     ATX_GET_INTERFACE_ACCEPT(StdcFileStream, ATX_InputStream)
     ATX_GET_INTERFACE_ACCEPT(StdcFileStream, ATX_OutputStream)
+    ATX_GET_INTERFACE_ACCEPT(StdcFileStream, ATX_VectoredOutputStream)
+#if defined(ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM)
+    ATX_GET_INTERFACE_ACCEPT(StdcFileStream, ATX_DescriptorStream)
+#endif
     ATX_GET_INTERFACE_ACCEPT(StdcFileStream, ATX_Referenceable)
 ATX_END_GET_INTERFACE_IMPLEMENTATION
 
@@ -477,6 +610,23 @@ ATX_BEGIN_INTERFACE_MAP(StdcFileStream, ATX_OutputStream)
     StdcFileOutputStream_Flush
 ATX_END_INTERFACE_MAP
 
+/*----------------------------------------------------------------------
+|       ATX_VectoredOutputStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(StdcFileStream, ATX_VectoredOutputStream)
+    StdcFileOutputStream_WriteV
+ATX_END_INTERFACE_MAP
+
+#if defined(ATX_STDC_FILE_HAVE_DESCRIPTOR_STREAM)
+/*----------------------------------------------------------------------
+|       ATX_DescriptorStream interface
++---------------------------------------------------------------------*/
+ATX_BEGIN_INTERFACE_MAP(StdcFileStream, ATX_DescriptorStream)
+    StdcFileStream_GetDescriptor,
+    StdcFileStream_Advance
+ATX_END_INTERFACE_MAP
+#endif
+
 /*----------------------------------------------------------------------
 |       ATX_Referenceable interface
 +---------------------------------------------------------------------*/
@@ -514,6 +664,29 @@ ATX_File_Create(const char* filename, ATX_File** object)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|       ATX_File_DeleteFile
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_File_DeleteFile(const char* filename)
+{
+    if (remove(filename) != 0) {
+        switch (errno) {
+          case EACCES:
+          case EPERM:
+            return ATX_ERROR_ACCESS_DENIED;
+
+          case ENOENT:
+            return ATX_ERROR_NO_SUCH_FILE;
+
+          default:
+            return ATX_ERROR_ERRNO(errno);
+        }
+    }
+
+    return ATX_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
 |       StdcFile_Destroy
 +---------------------------------------------------------------------*/
@@ -606,7 +779,10 @@ StdcFile_Open(ATX_File* _self, ATX_Flags mode)
     self->mode = mode;
 
     /* create a wrapper */
-    return StdcFileWrapper_Create(stdc_file, &self->name, &self->file);
+    ATX_CHECK(StdcFileWrapper_Create(stdc_file, &self->name, &self->file));
+    if (mode & ATX_FILE_OPEN_MODE_UNBUFFERED) self->file->unbuffered = ATX_TRUE;
+    
+    return ATX_SUCCESS;
 }
 
 /*----------------------------------------------------------------------
@@ -650,7 +826,8 @@ ATX_METHOD
 StdcFile_GetInputStream(ATX_File*          _self, 
                         ATX_InputStream**  stream)
 {
-    StdcFile* self = ATX_SELF(StdcFile, ATX_File);
+    StdcFile*  self = ATX_SELF(StdcFile, ATX_File);
+    ATX_Result result;
 
     /* check that the file is open */
     if (self->file == NULL) return ATX_ERROR_FILE_NOT_OPEN;
@@ -660,7 +837,19 @@ StdcFile_GetInputStream(ATX_File*          _self,
         return ATX_ERROR_FILE_NOT_READABLE;
     }
 
-    return StdcFileInputStream_Create(self->file, stream);
+    /* read ahead on a helper thread if requested */
+    if (self->mode & ATX_FILE_OPEN_MODE_READ_AHEAD) {
+        ATX_InputStream* file_stream = NULL;
+        ATX_CHECK(StdcFileInputStream_Create(self->file, &file_stream));
+        result = ATX_ReadAheadInputStream_Create(file_stream, 0, 0, stream);
+        ATX_RELEASE_OBJECT(file_stream);
+    } else {
+        result = StdcFileInputStream_Create(self->file, stream);
+    }
+    if (ATX_FAILED(result)) return result;
+
+    /* record statistics if enabled for the process */
+    return ATX_StreamInstrumentation_WrapInputStream(stream);
 }
 
 /*----------------------------------------------------------------------
@@ -670,7 +859,8 @@ ATX_METHOD
 StdcFile_GetOutputStream(ATX_File*          _self, 
                          ATX_OutputStream** stream)
 {
-    StdcFile* self = ATX_SELF(StdcFile, ATX_File);
+    StdcFile*  self = ATX_SELF(StdcFile, ATX_File);
+    ATX_Result result;
 
     /* check that the file is open */
     if (self->file == NULL) return ATX_ERROR_FILE_NOT_OPEN;
@@ -680,7 +870,19 @@ StdcFile_GetOutputStream(ATX_File*          _self,
         return ATX_ERROR_FILE_NOT_WRITABLE;
     }
 
-    return StdcFileOutputStream_Create(self->file, stream);
+    /* wrap the stream in a buffer if requested */
+    if (self->mode & ATX_FILE_OPEN_MODE_BUFFERED_OUTPUT) {
+        ATX_OutputStream* file_stream = NULL;
+        ATX_CHECK(StdcFileOutputStream_Create(self->file, &file_stream));
+        result = ATX_BufferedOutputStream_Create(file_stream, 0, stream);
+        ATX_RELEASE_OBJECT(file_stream);
+    } else {
+        result = StdcFileOutputStream_Create(self->file, stream);
+    }
+    if (ATX_FAILED(result)) return result;
+
+    /* record statistics if enabled for the process */
+    return ATX_StreamInstrumentation_WrapOutputStream(stream);
 }
 
 /*----------------------------------------------------------------------
@@ -40,8 +40,10 @@
 #include "AtxResults.h"
 #include "AtxStreams.h"
 #include "AtxFile.h"
+#include "AtxInstrumentedStreams.h"
 #include "AtxReferenceable.h"
 #include "AtxDestroyable.h"
+#include "AtxAtomic.h"
 #include "AtxLogging.h"
 
 /*----------------------------------------------------------------------
@@ -158,7 +160,7 @@ Win32FileHandleWrapper_Destroy(Win32FileHandleWrapper* self)
 static void
 Win32FileHandleWrapper_AddReference(Win32FileHandleWrapper* self)
 {
-    ++self->reference_count;
+    ATX_Atomic_Add(&self->reference_count, 1, ATX_ATOMIC_RELAXED);
 }
 
 /*----------------------------------------------------------------------
@@ -168,7 +170,7 @@ static void
 Win32FileHandleWrapper_Release(Win32FileHandleWrapper* self)
 {
     if (self == NULL) return;
-    if (--self->reference_count == 0) {
+    if (ATX_Atomic_Add(&self->reference_count, -1, ATX_ATOMIC_ACQ_REL) == 0) {
         Win32FileHandleWrapper_Destroy(self);
     }
 }
@@ -533,6 +535,24 @@ ATX_File_Create(const char* filename, ATX_File** object)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_File_DeleteFile
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_File_DeleteFile(const char* filename)
+{
+    BOOL         deleted;
+    unsigned int filename_length = ATX_StringLength(filename);
+    WCHAR*       filename_w = ATX_AllocateMemory(2*(filename_length+1));
+    if (filename_w == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+    MultiByteToWideChar(CP_UTF8, 0, filename, -1, filename_w, filename_length+1);
+    deleted = DeleteFileW(filename_w);
+    ATX_FreeMemory(filename_w);
+    if (!deleted) return MapError(GetLastError());
+
+    return ATX_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
 |   Win32File_Destroy
 +---------------------------------------------------------------------*/
@@ -662,6 +682,7 @@ Win32File_GetInputStream(ATX_File*          _self,
                          ATX_InputStream**  stream)
 {
     Win32File* self = ATX_SELF(Win32File, ATX_File);
+    ATX_Result result;
 
     /* check that the file is open */
     if (self->file == NULL) return ATX_ERROR_FILE_NOT_OPEN;
@@ -671,7 +692,19 @@ Win32File_GetInputStream(ATX_File*          _self,
         return ATX_ERROR_FILE_NOT_READABLE;
     }
 
-    return Win32FileInputStream_Create(self->file, stream);
+    /* read ahead on a helper thread if requested */
+    if (self->mode & ATX_FILE_OPEN_MODE_READ_AHEAD) {
+        ATX_InputStream* file_stream = NULL;
+        ATX_CHECK(Win32FileInputStream_Create(self->file, &file_stream));
+        result = ATX_ReadAheadInputStream_Create(file_stream, 0, 0, stream);
+        ATX_RELEASE_OBJECT(file_stream);
+    } else {
+        result = Win32FileInputStream_Create(self->file, stream);
+    }
+    if (ATX_FAILED(result)) return result;
+
+    /* record statistics if enabled for the process */
+    return ATX_StreamInstrumentation_WrapInputStream(stream);
 }
 
 /*----------------------------------------------------------------------
@@ -682,6 +715,7 @@ Win32File_GetOutputStream(ATX_File*          _self,
                           ATX_OutputStream** stream)
 {
     Win32File* self = ATX_SELF(Win32File, ATX_File);
+    ATX_Result result;
 
     /* check that the file is open */
     if (self->file == NULL) return ATX_ERROR_FILE_NOT_OPEN;
@@ -691,7 +725,19 @@ Win32File_GetOutputStream(ATX_File*          _self,
         return ATX_ERROR_FILE_NOT_WRITABLE;
     }
 
-    return Win32FileOutputStream_Create(self->file, stream);
+    /* wrap the stream in a buffer if requested */
+    if (self->mode & ATX_FILE_OPEN_MODE_BUFFERED_OUTPUT) {
+        ATX_OutputStream* file_stream = NULL;
+        ATX_CHECK(Win32FileOutputStream_Create(self->file, &file_stream));
+        result = ATX_BufferedOutputStream_Create(file_stream, 0, stream);
+        ATX_RELEASE_OBJECT(file_stream);
+    } else {
+        result = Win32FileOutputStream_Create(self->file, stream);
+    }
+    if (ATX_FAILED(result)) return result;
+
+    /* record statistics if enabled for the process */
+    return ATX_StreamInstrumentation_WrapOutputStream(stream);
 }
 
 /*----------------------------------------------------------------------
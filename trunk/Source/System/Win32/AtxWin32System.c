@@ -92,6 +92,30 @@ ATX_System_GetCurrentTimeStamp(ATX_TimeStamp* now)
 }
 #endif
 
+/*----------------------------------------------------------------------
+|   ATX_System_GetMonotonicTimeStamp
+|
+|   Time elapsed since an arbitrary origin, unaffected by changes to
+|   the wall clock. Use this for measuring durations.
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_System_GetMonotonicTimeStamp(ATX_TimeStamp* now)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (!QueryPerformanceFrequency(&frequency) || 
+        !QueryPerformanceCounter(&counter)     ||
+        frequency.QuadPart == 0) {
+        return ATX_System_GetCurrentTimeStamp(now);
+    }
+    now->seconds     = (ATX_Int32)(counter.QuadPart/frequency.QuadPart);
+    now->nanoseconds = (ATX_Int32)(((counter.QuadPart%frequency.QuadPart)*1000000000)/
+                                   frequency.QuadPart);
+
+    return ATX_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
 |   ATX_System_Sleep
 +---------------------------------------------------------------------*/
@@ -147,3 +171,13 @@ ATX_System_GetRandomInteger()
     return rand();
 }
 
+/*----------------------------------------------------------------------
+|   ATX_System_GetProcessorCount
++---------------------------------------------------------------------*/
+ATX_Cardinal
+ATX_System_GetProcessorCount(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (ATX_Cardinal)info.dwNumberOfProcessors : 1;
+}
@@ -36,6 +36,7 @@
 #include "AtxThreads.h"
 #include "AtxLogging.h"
 #include "AtxUtils.h"
+#include "AtxAtomic.h"
 
 /*----------------------------------------------------------------------
 |   logger
@@ -49,6 +50,36 @@ struct ATX_Mutex {
     CRITICAL_SECTION mutex;
 };
 
+struct ATX_Condition {
+    CONDITION_VARIABLE condition;
+};
+
+struct ATX_Semaphore {
+    HANDLE handle;
+};
+
+struct ATX_Thread {
+    HANDLE             handle;
+    ATX_ThreadFunction function;
+    void*              argument;
+    char               name[64];
+};
+
+/* fiber local storage callbacks only get the value, so each thread
+   stores a small record that points back to the thread local */
+struct ATX_ThreadLocal {
+    DWORD                     index;
+    ATX_ThreadLocalDestructor destructor;
+    BOOL                      destroying; /* FlsFree calls the callbacks */
+};
+
+typedef struct {
+    ATX_ThreadLocal* local;
+    void*            value;
+} ATX_ThreadLocalValue;
+
+typedef HRESULT (WINAPI *ATX_SetThreadDescriptionProc)(HANDLE thread, PCWSTR description);
+
 /*----------------------------------------------------------------------
 |   ATX_Mutex_Create
 +---------------------------------------------------------------------*/
@@ -72,23 +103,24 @@ ATX_Mutex_Create(ATX_Mutex** mutex)
 ATX_Result
 ATX_Mutex_LockAutoCreate(ATX_Mutex** mutex)
 {
-    ATX_Mutex* tmp_mutex;
-    void*      old_mutex;
+    ATX_Mutex* self;
     if (mutex == NULL) {
         ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
     }
 
-    ATX_CHECK_WARNING(ATX_Mutex_Create(&tmp_mutex));
-    old_mutex = InterlockedCompareExchangePointer((void**)mutex, 
-                                                  (void*)tmp_mutex, 
-                                                  NULL);
-    if (old_mutex != NULL) {
-        /* *mutex was not NULL: no exchange has been performed */
-        ATX_Mutex_Destroy(tmp_mutex);
+    /* only create a mutex the first time, not on every call */
+    self = (ATX_Mutex*)ATX_Atomic_LoadPointer((ATX_AtomicPointer*)mutex, ATX_ATOMIC_ACQUIRE);
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_Mutex_Create(&self));
+        if (!ATX_Atomic_CompareAndSwapPointer((ATX_AtomicPointer*)mutex, NULL, (void*)self)) {
+            /* another thread published its mutex first */
+            ATX_Mutex_Destroy(self);
+            self = (ATX_Mutex*)ATX_Atomic_LoadPointer((ATX_AtomicPointer*)mutex, ATX_ATOMIC_ACQUIRE);
+        }
     }
 
     /* lock */
-    EnterCriticalSection(&(*mutex)->mutex);
+    EnterCriticalSection(&self->mutex);
     return ATX_SUCCESS;
 }
 
@@ -130,6 +162,280 @@ ATX_Mutex_Destroy(ATX_Mutex* self)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   ATX_Condition_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Create(ATX_Condition** condition)
+{
+    if (condition == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *condition = ATX_AllocateZeroMemory(sizeof(ATX_Condition));
+    if (*condition == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+    InitializeConditionVariable(&(*condition)->condition);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Wait
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Wait(ATX_Condition* self, ATX_Mutex* mutex)
+{
+    if (self == NULL || mutex == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (!SleepConditionVariableCS(&self->condition, &mutex->mutex, INFINITE)) {
+        ATX_LOG_SEVERE_1("SleepConditionVariableCS failed with error %d", GetLastError());
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_TimedWait
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_TimedWait(ATX_Condition* self, ATX_Mutex* mutex, ATX_Timeout timeout)
+{
+    if (self == NULL || mutex == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (!SleepConditionVariableCS(&self->condition, 
+                                  &mutex->mutex, 
+                                  timeout < 0 ? INFINITE : (DWORD)timeout)) {
+        if (GetLastError() == ERROR_TIMEOUT) return ATX_ERROR_TIMEOUT;
+        ATX_LOG_SEVERE_1("SleepConditionVariableCS failed with error %d", GetLastError());
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Signal
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Signal(ATX_Condition* self)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    WakeConditionVariable(&self->condition);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Broadcast
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Broadcast(ATX_Condition* self)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    WakeAllConditionVariable(&self->condition);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Condition_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Condition_Destroy(ATX_Condition* self)
+{
+    /* condition variables don't need to be deleted */
+    if (self) ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Create(ATX_Cardinal initial_count, ATX_Semaphore** semaphore)
+{
+    if (semaphore == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *semaphore = ATX_AllocateZeroMemory(sizeof(ATX_Semaphore));
+    if (*semaphore == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+    (*semaphore)->handle = CreateSemaphore(NULL, (LONG)initial_count, MAXLONG, NULL);
+    if ((*semaphore)->handle == NULL) {
+        ATX_LOG_SEVERE_1("CreateSemaphore failed with error %d", GetLastError());
+        ATX_FreeMemory(*semaphore);
+        *semaphore = NULL;
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Acquire
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Acquire(ATX_Semaphore* self)
+{
+    return ATX_Semaphore_TimedAcquire(self, ATX_TIMEOUT_INFINITE);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_TimedAcquire
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_TimedAcquire(ATX_Semaphore* self, ATX_Timeout timeout)
+{
+    DWORD result;
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    result = WaitForSingleObject(self->handle, timeout < 0 ? INFINITE : (DWORD)timeout);
+    if (result == WAIT_OBJECT_0) return ATX_SUCCESS;
+    if (result == WAIT_TIMEOUT)  return ATX_ERROR_TIMEOUT;
+    ATX_LOG_SEVERE_1("WaitForSingleObject failed with error %d", GetLastError());
+    return ATX_FAILURE;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Release
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Release(ATX_Semaphore* self, ATX_Cardinal count)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (count == 0) return ATX_SUCCESS;
+    if (!ReleaseSemaphore(self->handle, (LONG)count, NULL)) {
+        ATX_LOG_SEVERE_1("ReleaseSemaphore failed with error %d", GetLastError());
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Semaphore_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Semaphore_Destroy(ATX_Semaphore* self)
+{
+    if (self == NULL) return ATX_SUCCESS;
+    CloseHandle(self->handle);
+    ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_SetCurrentName
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_SetCurrentName(const char* name)
+{
+    ATX_SetThreadDescriptionProc set_description;
+    WCHAR                        wide_name[64];
+
+    if (name == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+
+    /* SetThreadDescription only exists on Windows 10 and later */
+    set_description = (ATX_SetThreadDescriptionProc)GetProcAddress(GetModuleHandleA("kernel32.dll"), 
+                                                                   "SetThreadDescription");
+    if (set_description == NULL) return ATX_ERROR_NOT_SUPPORTED;
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64) == 0) {
+        wide_name[63] = 0;
+    }
+    if (FAILED(set_description(GetCurrentThread(), wide_name))) return ATX_FAILURE;
+
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_Run
++---------------------------------------------------------------------*/
+static DWORD WINAPI
+ATX_Thread_Run(LPVOID argument)
+{
+    ATX_Thread* thread = (ATX_Thread*)argument;
+    if (thread->name[0]) ATX_Thread_SetCurrentName(thread->name);
+    thread->function(thread->argument);
+    return 0;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_Create(ATX_ThreadFunction function, 
+                  void*              argument, 
+                  ATX_Thread**       thread)
+{
+    return ATX_Thread_CreateEx(function, argument, NULL, thread);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_CreateEx
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_CreateEx(ATX_ThreadFunction       function, 
+                    void*                    argument, 
+                    const ATX_ThreadOptions* options,
+                    ATX_Thread**             thread)
+{
+    SIZE_T stack_size = 0;
+    
+    if (function == NULL || thread == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *thread = ATX_AllocateZeroMemory(sizeof(ATX_Thread));
+    if (*thread == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+    (*thread)->function = function;
+    (*thread)->argument = argument;
+    if (options) {
+        if (options->name) {
+            ATX_CopyStringN((*thread)->name, options->name, sizeof((*thread)->name)-1);
+        }
+        stack_size = options->stack_size;
+    }
+    (*thread)->handle = CreateThread(NULL, 
+                                     stack_size, 
+                                     ATX_Thread_Run, 
+                                     *thread, 
+                                     stack_size ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0, 
+                                     NULL);
+    if ((*thread)->handle == NULL) {
+        ATX_LOG_SEVERE_1("CreateThread failed with error %d", GetLastError());
+        ATX_FreeMemory(*thread);
+        *thread = NULL;
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_Thread_Join
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_Thread_Join(ATX_Thread* self)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    if (WaitForSingleObject(self->handle, INFINITE) != WAIT_OBJECT_0) {
+        ATX_LOG_SEVERE_1("WaitForSingleObject failed with error %d", GetLastError());
+        return ATX_FAILURE;
+    }
+    CloseHandle(self->handle);
+    ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
 |   ATX_GetCurrentThreadId
 +---------------------------------------------------------------------*/
@@ -138,3 +444,90 @@ ATX_GetCurrentThreadId(void)
 {
     return GetCurrentThreadId();
 }
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Cleanup
++---------------------------------------------------------------------*/
+static VOID WINAPI
+ATX_ThreadLocal_Cleanup(PVOID data)
+{
+    ATX_ThreadLocalValue* value = (ATX_ThreadLocalValue*)data;
+    
+    if (value == NULL) return;
+    if (!value->local->destroying && value->local->destructor && value->value) {
+        value->local->destructor(value->value);
+    }
+    ATX_FreeMemory(value);
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Create
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ThreadLocal_Create(ATX_ThreadLocalDestructor destructor, ATX_ThreadLocal** local)
+{
+    if (local == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    *local = ATX_AllocateZeroMemory(sizeof(ATX_ThreadLocal));
+    if (*local == NULL) {
+        ATX_CHECK_SEVERE(ATX_ERROR_OUT_OF_MEMORY);
+    }
+    (*local)->destructor = destructor;
+    (*local)->index = FlsAlloc(ATX_ThreadLocal_Cleanup);
+    if ((*local)->index == FLS_OUT_OF_INDEXES) {
+        ATX_LOG_SEVERE_1("FlsAlloc failed with error %d", GetLastError());
+        ATX_FreeMemory(*local);
+        *local = NULL;
+        return ATX_FAILURE;
+    }
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Destroy
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ThreadLocal_Destroy(ATX_ThreadLocal* self)
+{
+    if (self == NULL) {
+        ATX_CHECK_WARNING(ATX_ERROR_INVALID_PARAMETERS);
+    }
+    self->destroying = TRUE;
+    FlsFree(self->index);
+    ATX_FreeMemory(self);
+    return ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Get
++---------------------------------------------------------------------*/
+void*
+ATX_ThreadLocal_Get(ATX_ThreadLocal* self)
+{
+    ATX_ThreadLocalValue* value = (ATX_ThreadLocalValue*)FlsGetValue(self->index);
+    return value ? value->value : NULL;
+}
+
+/*----------------------------------------------------------------------
+|   ATX_ThreadLocal_Set
++---------------------------------------------------------------------*/
+ATX_Result
+ATX_ThreadLocal_Set(ATX_ThreadLocal* self, void* value)
+{
+    ATX_ThreadLocalValue* record = (ATX_ThreadLocalValue*)FlsGetValue(self->index);
+    
+    if (record == NULL) {
+        if (value == NULL) return ATX_SUCCESS;
+        record = ATX_AllocateZeroMemory(sizeof(ATX_ThreadLocalValue));
+        if (record == NULL) return ATX_ERROR_OUT_OF_MEMORY;
+        record->local = self;
+        if (!FlsSetValue(self->index, record)) {
+            ATX_LOG_SEVERE_1("FlsSetValue failed with error %d", GetLastError());
+            ATX_FreeMemory(record);
+            return ATX_FAILURE;
+        }
+    }
+    record->value = value;
+    return ATX_SUCCESS;
+}
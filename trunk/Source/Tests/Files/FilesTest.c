@@ -136,6 +136,183 @@ main(int argc, char** argv)
     SHOULD_SUCCEED(ATX_InputStream_Seek(input2, 20));
     SHOULD_SUCCEED(ATX_InputStream_Read(input2, buffer, 4, NULL));
 
+    /* mapped views */
+    {
+        ATX_FileView*          view;
+        ATX_InputStream*       mapped;
+        ATX_MappedInputStream* pointers;
+        const ATX_Byte*        data;
+        ATX_Size               bytes_read;
+
+        SHOULD_FAIL(ATX_File_Map(file2, 30, 0, &view));
+        SHOULD_SUCCEED(ATX_File_Map(file2, 4, 0, &view));
+        SHOULD_EQUAL_I(ATX_FileView_GetSize(view), 20);
+        SHOULD_EQUAL_I(ATX_FileView_GetData(view)[0], 4);
+        SHOULD_EQUAL_I(ATX_FileView_GetData(view)[4], 0);
+        SHOULD_SUCCEED(ATX_FileView_Advise(view, ATX_FILE_VIEW_ADVICE_RANDOM));
+
+        SHOULD_SUCCEED(ATX_FileView_GetInputStream(view, &mapped));
+        ATX_FileView_Destroy(view);
+        pointers = ATX_CAST(mapped, ATX_MappedInputStream);
+        SHOULD_SUCCEED(pointers?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_MappedInputStream_ReadPointer(pointers, 8, &data, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 8);
+        SHOULD_EQUAL_I(data[3], 7);
+        SHOULD_EQUAL_I(data[4], 0);
+        SHOULD_SUCCEED(ATX_InputStream_Read(mapped, buffer, 16, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 12);
+        SHOULD_EQUAL_I(buffer[11], 15);
+        SHOULD_FAIL(ATX_InputStream_Read(mapped, buffer, 16, &bytes_read));
+        ATX_RELEASE_OBJECT(mapped);
+
+        SHOULD_SUCCEED(ATX_MapFile(filename, &view));
+        SHOULD_EQUAL_I(ATX_FileView_GetSize(view), 24);
+        SHOULD_EQUAL_I(ATX_FileView_GetData(view)[23], 15);
+        ATX_FileView_Destroy(view);
+    }
+
+    /* read ahead */
+    {
+        ATX_File*        file3;
+        ATX_InputStream* source;
+        ATX_InputStream* ahead;
+        ATX_Size         bytes_read;
+
+        SHOULD_SUCCEED(ATX_File_Create(filename, &file3));
+        SHOULD_SUCCEED(ATX_File_Open(file3, ATX_FILE_OPEN_MODE_READ | ATX_FILE_OPEN_MODE_READ_AHEAD));
+        SHOULD_SUCCEED(ATX_File_GetInputStream(file3, &ahead));
+        SHOULD_SUCCEED(ATX_InputStream_GetSize(ahead, &size));
+        SHOULD_EQUAL_I(size, 24);
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(ahead, buffer, 16));
+        SHOULD_EQUAL_I(buffer[7], 7);
+        SHOULD_EQUAL_I(buffer[8], 0);
+        SHOULD_SUCCEED(ATX_InputStream_Read(ahead, buffer, 16, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 8);
+        SHOULD_EQUAL_I(ATX_InputStream_Read(ahead, buffer, 16, &bytes_read), ATX_ERROR_EOS);
+        ATX_RELEASE_OBJECT(ahead);
+        ATX_File_Close(file3);
+
+        /* small buffers, seeking forward within them and backward */
+        SHOULD_SUCCEED(ATX_File_Open(file3, ATX_FILE_OPEN_MODE_READ));
+        SHOULD_SUCCEED(ATX_File_GetInputStream(file3, &source));
+        SHOULD_SUCCEED(ATX_ReadAheadInputStream_Create(source, 5, 2, &ahead));
+        ATX_RELEASE_OBJECT(source);
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(ahead, buffer, 3));
+        SHOULD_SUCCEED(ATX_InputStream_Seek(ahead, 6));
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(ahead, buffer, 4));
+        SHOULD_EQUAL_I(buffer[0], 6);
+        SHOULD_EQUAL_I(buffer[3], 1);
+        SHOULD_SUCCEED(ATX_InputStream_Seek(ahead, 1));
+        SHOULD_SUCCEED(ATX_InputStream_Tell(ahead, &position));
+        SHOULD_EQUAL_I(position, 1);
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(ahead, buffer, 1));
+        SHOULD_EQUAL_I(buffer[0], 1);
+        SHOULD_SUCCEED(ATX_InputStream_Seek(ahead, 20));
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(ahead, buffer, 4));
+        SHOULD_EQUAL_I(buffer[3], 15);
+        SHOULD_EQUAL_I(ATX_InputStream_Read(ahead, buffer, 1, &bytes_read), ATX_ERROR_EOS);
+        ATX_RELEASE_OBJECT(ahead);
+        ATX_File_Close(file3);
+        ATX_DESTROY_OBJECT(file3);
+    }
+
+    /* vectored writes to an unbuffered file in append mode */
+    {
+        ATX_File*         file3;
+        ATX_OutputStream* appender;
+        ATX_FileView*     view;
+        ATX_IoVec         parts[2];
+        ATX_Size          bytes_written;
+        const char*       append_filename = "append.test";
+
+        parts[0].buffer = "01";  parts[0].size = 2;
+        parts[1].buffer = "234"; parts[1].size = 3;
+
+        SHOULD_SUCCEED(ATX_File_Create(append_filename, &file3));
+        SHOULD_SUCCEED(ATX_File_Open(file3, ATX_FILE_OPEN_MODE_CREATE | ATX_FILE_OPEN_MODE_WRITE | ATX_FILE_OPEN_MODE_TRUNCATE));
+        SHOULD_SUCCEED(ATX_File_GetOutputStream(file3, &appender));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(appender, "abcd", 4));
+        ATX_RELEASE_OBJECT(appender);
+        ATX_File_Close(file3);
+
+        SHOULD_SUCCEED(ATX_File_Open(file3, ATX_FILE_OPEN_MODE_CREATE | ATX_FILE_OPEN_MODE_WRITE | ATX_FILE_OPEN_MODE_APPEND | ATX_FILE_OPEN_MODE_UNBUFFERED));
+        SHOULD_SUCCEED(ATX_File_GetOutputStream(file3, &appender));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteV(appender, parts, 2, &bytes_written));
+        SHOULD_EQUAL_I(bytes_written, 5);
+        SHOULD_SUCCEED(ATX_OutputStream_Tell(appender, &position));
+        SHOULD_EQUAL_I(position, 9);
+        ATX_RELEASE_OBJECT(appender);
+        ATX_File_Close(file3);
+        ATX_DESTROY_OBJECT(file3);
+
+        SHOULD_SUCCEED(ATX_MapFile(append_filename, &view));
+        SHOULD_EQUAL_I(ATX_FileView_GetSize(view), 9);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_FileView_GetData(view), "abcd01234", 9)?ATX_SUCCESS:ATX_FAILURE);
+        ATX_FileView_Destroy(view);
+        SHOULD_SUCCEED(ATX_File_DeleteFile(append_filename));
+        SHOULD_FAIL(ATX_File_DeleteFile(append_filename));
+    }
+
+    /* pumping from a socket into files */
+    {
+        ATX_ServerSocket* server;
+        ATX_Socket*       client;
+        ATX_Socket*       connection;
+        ATX_SocketAddress address;
+        ATX_IpAddress     loopback;
+        ATX_SocketInfo    info;
+        ATX_OutputStream* sender;
+        ATX_InputStream*  source;
+        ATX_OutputStream* sink;
+        ATX_File*         file3;
+        ATX_FileView*     view;
+        ATX_LargeSize     copied;
+        const char*       pump_filename = "pump.test";
+
+        SHOULD_SUCCEED(ATX_TcpServerSocket_Create(&server));
+        SHOULD_SUCCEED(ATX_IpAddress_Parse(&loopback, "127.0.0.1"));
+        ATX_SocketAddress_Set(&address, &loopback, 0);
+        SHOULD_SUCCEED(ATX_Socket_Bind(ATX_CAST(server, ATX_Socket), &address));
+        SHOULD_SUCCEED(ATX_ServerSocket_Listen(server, 1));
+        SHOULD_SUCCEED(ATX_Socket_GetInfo(ATX_CAST(server, ATX_Socket), &info));
+        SHOULD_SUCCEED(ATX_TcpClientSocket_Create(&client));
+        SHOULD_SUCCEED(ATX_Socket_Connect(client, &info.local_address, ATX_SOCKET_TIMEOUT_INFINITE));
+        SHOULD_SUCCEED(ATX_ServerSocket_WaitForNewClient(server, &connection));
+        SHOULD_SUCCEED(ATX_Socket_GetInputStream(connection, &source));
+        SHOULD_SUCCEED(ATX_Socket_GetOutputStream(client, &sender));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(sender, "0123456789", 10));
+        ATX_RELEASE_OBJECT(sender);
+        ATX_DESTROY_OBJECT(client);
+
+        /* into a plain file, where the kernel can splice the data */
+        SHOULD_SUCCEED(ATX_File_Create(pump_filename, &file3));
+        SHOULD_SUCCEED(ATX_File_Open(file3, ATX_FILE_OPEN_MODE_CREATE | ATX_FILE_OPEN_MODE_WRITE | ATX_FILE_OPEN_MODE_TRUNCATE));
+        SHOULD_SUCCEED(ATX_File_GetOutputStream(file3, &sink));
+        SHOULD_SUCCEED(ATX_Stream_Pump(source, sink, 4, &copied));
+        SHOULD_EQUAL_I(copied, 4);
+        ATX_RELEASE_OBJECT(sink);
+        ATX_File_Close(file3);
+
+        /* into a file in append mode, which splice can't write to */
+        SHOULD_SUCCEED(ATX_File_Open(file3, ATX_FILE_OPEN_MODE_CREATE | ATX_FILE_OPEN_MODE_WRITE | ATX_FILE_OPEN_MODE_APPEND));
+        SHOULD_SUCCEED(ATX_File_GetOutputStream(file3, &sink));
+        SHOULD_SUCCEED(ATX_Stream_Pump(source, sink, 0, &copied));
+        SHOULD_EQUAL_I(copied, 6);
+        ATX_RELEASE_OBJECT(sink);
+        ATX_File_Close(file3);
+        ATX_DESTROY_OBJECT(file3);
+
+        SHOULD_SUCCEED(ATX_MapFile(pump_filename, &view));
+        SHOULD_EQUAL_I(ATX_FileView_GetSize(view), 10);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_FileView_GetData(view), "0123456789", 10)?ATX_SUCCESS:ATX_FAILURE);
+        ATX_FileView_Destroy(view);
+        SHOULD_SUCCEED(ATX_File_DeleteFile(pump_filename));
+
+        ATX_RELEASE_OBJECT(source);
+        ATX_DESTROY_OBJECT(connection);
+        ATX_DESTROY_OBJECT(server);
+    }
+
     ATX_File_Close(file);
     ATX_RELEASE_OBJECT(input);
     ATX_RELEASE_OBJECT(output);
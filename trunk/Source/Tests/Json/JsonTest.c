@@ -248,6 +248,213 @@ static char pass1_json[] = {
 };
 unsigned int pass1_json_len = 1441;
 
+/*----------------------------------------------------------------------
+|       TapeTest
++---------------------------------------------------------------------*/
+static void
+TapeTest(void)
+{
+    ATX_JsonTape*      tape = NULL;
+    ATX_JsonTapeCursor root;
+    ATX_JsonTapeCursor child;
+    ATX_JsonTapeCursor member;
+    ATX_Size           length = 0;
+    unsigned int       i;
+    
+    SHOULD_FAIL(ATX_JsonTape_Parse("[1,]", &tape));
+    SHOULD_FAIL(ATX_JsonTape_Parse("{\"a\":1", &tape));
+    SHOULD_FAIL(ATX_JsonTape_Parse("[\"mismatch\"}", &tape));
+
+    SHOULD_SUCCEED(ATX_JsonTape_ParseBuffer(pass1_json, pass1_json_len, &tape));
+    CHECK(tape != NULL);
+    SHOULD_SUCCEED(ATX_JsonTape_Get(tape, &root));
+    CHECK(ATX_JsonTape_GetType(&root) == ATX_JSON_TYPE_ARRAY);
+    CHECK(ATX_JsonTape_GetChildCount(&root) == 20);
+    CHECK(ATX_JsonTape_GetName(&root) == NULL);
+    SHOULD_FAIL(ATX_JsonTape_Next(&root));
+
+    /* children are in document order */
+    SHOULD_SUCCEED(ATX_JsonTape_GetFirstChild(&root, &child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_STRING);
+    CHECK(ATX_StringsEqual(ATX_JsonTape_AsString(&child, &length), "JSON Test Pattern pass1"));
+    CHECK(length == 23);
+    
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_OBJECT);
+    CHECK(ATX_JsonTape_GetChildCount(&child) == 1);
+    SHOULD_SUCCEED(ATX_JsonTape_Find(&child, "object with 1 member", &member));
+    CHECK(ATX_StringsEqual(ATX_JsonTape_GetName(&member), "object with 1 member"));
+    CHECK(ATX_JsonTape_GetType(&member) == ATX_JSON_TYPE_ARRAY);
+    SHOULD_FAIL(ATX_JsonTape_Find(&child, "object", &member));
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_OBJECT);
+    CHECK(ATX_JsonTape_GetChildCount(&child) == 0);
+    SHOULD_FAIL(ATX_JsonTape_GetFirstChild(&child, &member));
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_ARRAY);
+    CHECK(ATX_JsonTape_GetChildCount(&child) == 0);
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_NUMBER);
+    CHECK(ATX_JsonTape_AsInteger(&child) == -42);
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_BOOLEAN);
+    CHECK(ATX_JsonTape_AsBoolean(&child) == ATX_TRUE);
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_BOOLEAN);
+    CHECK(ATX_JsonTape_AsBoolean(&child) == ATX_FALSE);
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_NULL);
+
+    SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    CHECK(ATX_JsonTape_GetType(&child) == ATX_JSON_TYPE_OBJECT);
+    CHECK(ATX_JsonTape_GetChildCount(&child) == 32);
+    SHOULD_SUCCEED(ATX_JsonTape_Find(&child, "integer", &member));
+    CHECK(ATX_JsonTape_GetType(&member) == ATX_JSON_TYPE_NUMBER);
+    CHECK(ATX_JsonTape_AsDouble(&member) == 1234567890.0);
+    SHOULD_SUCCEED(ATX_JsonTape_Find(&child, "quote", &member));
+    CHECK(ATX_StringsEqual(ATX_JsonTape_AsString(&member, NULL), "\""));
+    SHOULD_SUCCEED(ATX_JsonTape_Find(&child, "compact", &member));
+    CHECK(ATX_JsonTape_GetChildCount(&member) == 7);
+    SHOULD_SUCCEED(ATX_JsonTape_GetFirstChild(&member, &member));
+    for (i=1; i<7; i++) {
+        CHECK(ATX_JsonTape_AsInteger(&member) == (ATX_Int32)i);
+        SHOULD_SUCCEED(ATX_JsonTape_Next(&member));
+    }
+    CHECK(ATX_JsonTape_AsInteger(&member) == 7);
+    SHOULD_FAIL(ATX_JsonTape_Next(&member));
+    SHOULD_SUCCEED(ATX_JsonTape_Find(&child, "", &member));
+    CHECK(ATX_JsonTape_AsDouble(&member) > 2.3456789011E76 &&
+          ATX_JsonTape_AsDouble(&member) < 2.3456789013E76);
+
+    /* skip to the last element */
+    for (i=9; i<20; i++) {
+        SHOULD_SUCCEED(ATX_JsonTape_Next(&child));
+    }
+    CHECK(ATX_StringsEqual(ATX_JsonTape_AsString(&child, NULL), "rosebud"));
+    SHOULD_FAIL(ATX_JsonTape_Next(&child));
+    ATX_JsonTape_Destroy(tape);
+    
+    SHOULD_SUCCEED(ATX_JsonTape_Parse("\"hello\\u03C0\"", &tape));
+    SHOULD_SUCCEED(ATX_JsonTape_Get(tape, &root));
+    CHECK(ATX_JsonTape_GetType(&root) == ATX_JSON_TYPE_STRING);
+    CHECK(ATX_StringsEqual(ATX_JsonTape_AsString(&root, &length), "hello\xCF\x80"));
+    CHECK(length == 7);
+    ATX_JsonTape_Destroy(tape);
+
+    SHOULD_SUCCEED(ATX_JsonTape_Parse("", &tape));
+    SHOULD_FAIL(ATX_JsonTape_Get(tape, &root));
+    ATX_JsonTape_Destroy(tape);
+}
+
+/*----------------------------------------------------------------------
+|       SchemaTest
++---------------------------------------------------------------------*/
+typedef struct {
+    ATX_Int32  x;
+    ATX_Int32  y;
+} TestPoint;
+
+typedef struct {
+    ATX_String  name;
+    ATX_Int32   count;
+    double      ratio;
+    ATX_Boolean enabled;
+    TestPoint   origin;
+} TestRecord;
+
+static const ATX_JsonField TestPointFields[] = {
+    ATX_JSON_FIELD("x", INTEGER, TestPoint, x),
+    ATX_JSON_FIELD("y", INTEGER, TestPoint, y),
+    ATX_JSON_FIELDS_END
+};
+
+static const ATX_JsonField TestRecordFields[] = {
+    ATX_JSON_FIELD("name",    STRING,  TestRecord, name),
+    ATX_JSON_FIELD("count",   INTEGER, TestRecord, count),
+    ATX_JSON_FIELD("ratio",   DOUBLE,  TestRecord, ratio),
+    ATX_JSON_FIELD("enabled", BOOLEAN, TestRecord, enabled),
+    ATX_JSON_OBJECT_FIELD("origin", TestRecord, origin, TestPointFields),
+    ATX_JSON_FIELDS_END
+};
+
+static void
+SchemaTest(void)
+{
+    ATX_JsonSchema* schema = NULL;
+    TestRecord      record;
+    TestRecord      copy;
+    ATX_String      encoded = ATX_EMPTY_STRING;
+    
+    SHOULD_SUCCEED(ATX_JsonSchema_Create(TestRecordFields, &schema));
+    
+    ATX_SetMemory(&record, 0, sizeof(record));
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, 
+        "{\"count\": 7, \"unknown\": [1, {\"x\": 3}], \"name\": \"hello\\n\","
+        " \"origin\": {\"y\": -2, \"x\": 5, \"z\": {}}, \"ratio\": 0.5,"
+        " \"enabled\": true, \"extra\": {\"count\": 9}}", &record));
+    CHECK(ATX_String_Equals(&record.name, "hello\n", ATX_FALSE));
+    CHECK(record.count    == 7);
+    CHECK(record.ratio    == 0.5);
+    CHECK(record.enabled  == ATX_TRUE);
+    CHECK(record.origin.x == 5);
+    CHECK(record.origin.y == -2);
+    
+    /* absent and null members leave the fields untouched */
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, "{\"count\": 8, \"name\": null}", &record));
+    CHECK(record.count == 8);
+    CHECK(ATX_String_Equals(&record.name, "hello\n", ATX_FALSE));
+
+    /* round trip */
+    SHOULD_SUCCEED(ATX_JsonSchema_Encode(schema, &record, &encoded));
+    CHECK(ATX_String_Equals(&encoded, 
+        "{\"name\": \"hello\\n\", \"count\": 8, \"ratio\": 0.5, "
+        "\"enabled\": true, \"origin\": {\"x\": 5, \"y\": -2}}", ATX_FALSE));
+    ATX_SetMemory(&copy, 0, sizeof(copy));
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, ATX_CSTR(encoded), &copy));
+    CHECK(ATX_String_Equals(&copy.name, ATX_CSTR(record.name), ATX_FALSE));
+    CHECK(copy.count    == record.count);
+    CHECK(copy.ratio    == record.ratio);
+    CHECK(copy.enabled  == record.enabled);
+    CHECK(copy.origin.x == record.origin.x);
+    CHECK(copy.origin.y == record.origin.y);
+    
+    /* type mismatches and invalid input */
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "{\"count\": \"7\"}", &copy));
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "{\"origin\": []}", &copy));
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "[]", &copy));
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "{\"count\": 1", &copy));
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "{\"count\": 3.7}", &copy));
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "{\"count\": 1e12}", &copy));
+    SHOULD_FAIL(ATX_JsonSchema_Decode(schema, "{\"count\": -2147483649}", &copy));
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, "{\"count\": -2147483648}", &copy));
+    CHECK(copy.count == (ATX_Int32)0x80000000);
+    
+    /* doubles survive an encode and decode unchanged */
+    record.ratio = 0.1;
+    SHOULD_SUCCEED(ATX_JsonSchema_Encode(schema, &record, &encoded));
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, ATX_CSTR(encoded), &copy));
+    CHECK(copy.ratio == 0.1);
+    record.ratio = 1e-7;
+    SHOULD_SUCCEED(ATX_JsonSchema_Encode(schema, &record, &encoded));
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, ATX_CSTR(encoded), &copy));
+    CHECK(copy.ratio == 1e-7);
+    record.ratio = -123456789.123456789;
+    SHOULD_SUCCEED(ATX_JsonSchema_Encode(schema, &record, &encoded));
+    SHOULD_SUCCEED(ATX_JsonSchema_Decode(schema, ATX_CSTR(encoded), &copy));
+    CHECK(copy.ratio == record.ratio);
+    
+    ATX_String_Destruct(&record.name);
+    ATX_String_Destruct(&copy.name);
+    ATX_String_Destruct(&encoded);
+    ATX_JsonSchema_Destroy(schema);
+}
+
 /*----------------------------------------------------------------------
 |       main
 +---------------------------------------------------------------------*/
@@ -402,6 +609,27 @@ main(int argc, char** argv)
     CHECK(ATX_String_Equals(ATX_Json_AsString(json), "hello\xCF\x80", ATX_FALSE));
     ATX_Json_Destroy(json);
 
+    /* surrogate pairs and unpaired surrogates */
+    SHOULD_SUCCEED(ATX_Json_Parse("\"\\uD83D\\uDE00 \\uD800x\\uDC00\\uD800\\n\\uDBFF\\uDFFF\"", &json));
+    CHECK(ATX_String_Equals(ATX_Json_AsString(json), 
+                            "\xF0\x9F\x98\x80 \xEF\xBF\xBDx\xEF\xBF\xBD\xEF\xBF\xBD\n\xF4\x8F\xBF\xBF", 
+                            ATX_FALSE));
+    ATX_Json_Destroy(json);
+    SHOULD_SUCCEED(ATX_Json_Parse("{\"\\uD834\\uDD1E\": \"\\uD834\"}", &json));
+    CHECK(ATX_Json_GetChild(json, "\xF0\x9D\x84\x9E") != NULL);
+    CHECK(ATX_String_Equals(ATX_Json_AsString(ATX_Json_GetChild(json, "\xF0\x9D\x84\x9E")), "\xEF\xBF\xBD", ATX_FALSE));
+    ATX_Json_Destroy(json);
+
+    /* raw UTF-8 is copied as-is, but must be valid */
+    SHOULD_SUCCEED(ATX_Json_Parse("[\"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80, and some ASCII to make it long\"]", &json));
+    CHECK(ATX_String_Equals(ATX_Json_AsString(ATX_Json_GetChildAt(json, 0, NULL)), 
+                            "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80, and some ASCII to make it long", ATX_FALSE));
+    ATX_Json_Destroy(json);
+    SHOULD_FAIL(ATX_Json_Parse("\"caf\xC3\"", &json));
+    SHOULD_FAIL(ATX_Json_Parse("\"\xC0\xAF\"", &json));
+    SHOULD_FAIL(ATX_Json_Parse("\"\xED\xA0\x80\"", &json));
+    SHOULD_FAIL(ATX_Json_Parse("{\"a long enough name, with a bad byte \xFF\": 1}", &json));
+
     SHOULD_SUCCEED(ATX_Json_Parse("12345", &json));
     CHECK(json != NULL);
     CHECK(ATX_Json_GetType(json) == ATX_JSON_TYPE_NUMBER);
@@ -464,6 +692,9 @@ main(int argc, char** argv)
     CHECK(ATX_StringsEqual(name, ""));
     ATX_Json_Destroy(json);
     
+    TapeTest();
+    SchemaTest();
+    
     return 0;
 }
 
@@ -77,6 +77,235 @@
         }                                                              \
     } while(0)                                  
 
+/*----------------------------------------------------------------------
+|       SemaphoreTestThread
++---------------------------------------------------------------------*/
+#define SEMAPHORE_TEST_ROUNDS 1000
+static void
+SemaphoreTestThread(void* argument)
+{
+    ATX_Semaphore** semaphores = (ATX_Semaphore**)argument;
+    int             i;
+
+    /* pass each token from the first semaphore to the second one */
+    for (i=0; i<SEMAPHORE_TEST_ROUNDS; i++) {
+        ATX_Semaphore_Acquire(semaphores[0]);
+        ATX_Semaphore_Release(semaphores[1], 1);
+    }
+}
+
+/*----------------------------------------------------------------------
+|       AtomicTestThread
++---------------------------------------------------------------------*/
+#define ATOMIC_TEST_THREADS 4
+#define ATOMIC_TEST_ROUNDS  100000
+typedef struct {
+    ATX_AtomicInt    counter;
+    ATX_InputStream* streams[2];
+} AtomicTestContext;
+
+static void
+AtomicTestThread(void* argument)
+{
+    AtomicTestContext* context = (AtomicTestContext*)argument;
+    int                i;
+
+    for (i=0; i<ATOMIC_TEST_ROUNDS; i++) {
+        ATX_InputStream* stream = context->streams[i&1];
+        ATX_Atomic_Add(&context->counter, 1, ATX_ATOMIC_RELAXED);
+        ATX_REFERENCE_OBJECT(stream);
+        ATX_RELEASE_OBJECT(stream);
+    }
+}
+
+/*----------------------------------------------------------------------
+|       lock helpers
++---------------------------------------------------------------------*/
+#define LOCK_TEST_THREADS 4
+#define LOCK_TEST_ROUNDS  20000
+typedef struct {
+    ATX_RwLock*    rw_lock;
+    ATX_SpinMutex* spin_mutex;
+    int            counter;
+    int            values[2];  /* only changed together, by writers */
+    ATX_AtomicInt  mismatches;
+} LockTestContext;
+
+static void
+LockTestThread(void* argument)
+{
+    LockTestContext* context = (LockTestContext*)argument;
+    int              i;
+
+    for (i=0; i<LOCK_TEST_ROUNDS; i++) {
+        ATX_SpinMutex_Lock(context->spin_mutex);
+        ++context->counter;
+        ATX_SpinMutex_Unlock(context->spin_mutex);
+        
+        if (i%8 == 0) {
+            ATX_RwLock_LockWrite(context->rw_lock);
+            ++context->values[0];
+            ++context->values[1];
+            ATX_RwLock_UnlockWrite(context->rw_lock);
+        } else {
+            ATX_RwLock_LockRead(context->rw_lock);
+            if (context->values[0] != context->values[1]) {
+                ATX_Atomic_Add(&context->mismatches, 1, ATX_ATOMIC_RELAXED);
+            }
+            ATX_RwLock_UnlockRead(context->rw_lock);
+        }
+    }
+}
+
+static void
+LockTestWriter(void* argument)
+{
+    LockTestContext* context = (LockTestContext*)argument;
+
+    ATX_RwLock_LockWrite(context->rw_lock);
+    context->values[0] = -1;
+    ATX_RwLock_UnlockWrite(context->rw_lock);
+}
+
+/*----------------------------------------------------------------------
+|       thread local helpers
++---------------------------------------------------------------------*/
+#define THREAD_LOCAL_TEST_COUNT 80 /* more than the native slots */
+typedef struct {
+    ATX_ThreadLocal* local;
+    ATX_AtomicInt    destroyed;
+    ATX_DataBuffer*  scratch;
+    ATX_Result       result;
+} ThreadLocalTestContext;
+
+static void
+ThreadLocalTestDestructor(void* value)
+{
+    ATX_Atomic_Add((ATX_AtomicInt*)value, 1, ATX_ATOMIC_SEQ_CST);
+}
+
+static void
+ThreadLocalTestThread(void* argument)
+{
+    ThreadLocalTestContext* context = (ThreadLocalTestContext*)argument;
+    ATX_DataBuffer*         again;
+
+    context->result = ATX_FAILURE;
+    if (ATX_ThreadLocal_Get(context->local) != NULL) return;
+    if (ATX_FAILED(ATX_ThreadLocal_Set(context->local, (void*)&context->destroyed))) return;
+    if (ATX_ThreadLocal_Get(context->local) != (void*)&context->destroyed) return;
+    if (ATX_FAILED(ATX_DataBuffer_GetThreadScratch(16, &context->scratch))) return;
+    if (ATX_FAILED(ATX_DataBuffer_GetThreadScratch(16, &again))) return;
+    if (again != context->scratch) return;
+    context->result = ATX_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+|       PipeTestWriter
++---------------------------------------------------------------------*/
+#define PIPE_TEST_CAPACITY 16
+#define PIPE_TEST_SIZE     100000
+static void
+PipeTestWriter(void* argument)
+{
+    ATX_OutputStream* output = (ATX_OutputStream*)argument;
+    ATX_Byte          chunk[3*PIPE_TEST_CAPACITY];
+    unsigned int      written = 0;
+
+    /* chunks of 1 to 3 times the capacity of the pipe, so that the
+       writer has to wait for the reader, in a pattern that does not 
+       repeat every 256 bytes */
+    while (written < PIPE_TEST_SIZE) {
+        unsigned int size = 1+written%sizeof(chunk);
+        unsigned int i;
+        if (size > PIPE_TEST_SIZE-written) size = PIPE_TEST_SIZE-written;
+        for (i=0; i<size; i++) chunk[i] = (ATX_Byte)((written+i)%251);
+        if (ATX_FAILED(ATX_OutputStream_WriteFully(output, chunk, size))) break;
+        written += size;
+    }
+    ATX_RELEASE_OBJECT(output);
+}
+
+/*----------------------------------------------------------------------
+|       timer helpers
++---------------------------------------------------------------------*/
+#define TIMER_TEST_COUNT 6
+typedef struct {
+    ATX_TimerQueue* queue;
+    ATX_AtomicInt   count;
+    ATX_Semaphore*  fired;  /* released on each expiration, or NULL */
+    ATX_Boolean     cancel; /* the timer cancels itself */
+} TimerTestContext;
+
+static void
+TimerTestCallback(ATX_Timer* timer, void* argument)
+{
+    TimerTestContext* context = (TimerTestContext*)argument;
+
+    ATX_Atomic_Add(&context->count, 1, ATX_ATOMIC_SEQ_CST);
+    if (context->cancel) ATX_TimerQueue_Cancel(context->queue, timer);
+    if (context->fired) ATX_Semaphore_Release(context->fired, 1);
+}
+
+static void
+TimerTestAdvance(ATX_TimerQueue* queue, const ATX_TimeStamp* start, ATX_UInt32 offset)
+{
+    ATX_TimeInterval interval;
+    ATX_TimeStamp    now;
+
+    ATX_TimeStamp_Set(interval, offset/1000, (offset%1000)*1000000);
+    ATX_TimeStamp_Add(now, *start, interval);
+    ATX_TimerQueue_Advance(queue, &now);
+}
+
+/*----------------------------------------------------------------------
+|       task pool helpers
++---------------------------------------------------------------------*/
+#define TASK_POOL_TEST_SIZE 100000
+typedef struct {
+    ATX_TaskPool* pool;
+    int*          values;
+} TaskPoolTestContext;
+
+static ATX_Result
+TaskPoolTestSquare(void* argument)
+{
+    int* value = (int*)argument;
+    *value *= *value;
+    return ATX_SUCCESS;
+}
+
+static ATX_Result
+TaskPoolTestFail(void* argument)
+{
+    ATX_COMPILER_UNUSED(argument);
+    return ATX_ERROR_INTERNAL;
+}
+
+static ATX_Result
+TaskPoolTestRange(void* argument, ATX_Size begin, ATX_Size end)
+{
+    int* values = (int*)argument;
+    for (; begin<end; begin++) values[begin] += (int)begin;
+    return ATX_SUCCESS;
+}
+
+static ATX_Result
+TaskPoolTestNested(void* argument)
+{
+    TaskPoolTestContext* context = (TaskPoolTestContext*)argument;
+    return ATX_TaskPool_ParallelFor(context->pool, 0, TASK_POOL_TEST_SIZE, 16, 
+                                    TaskPoolTestRange, context->values);
+}
+
+static void
+TaskPoolTestThen(void* argument, ATX_Result result)
+{
+    if (result == ATX_ERROR_INTERNAL) {
+        ATX_Semaphore_Release((ATX_Semaphore*)argument, 1);
+    }
+}
+
 /*----------------------------------------------------------------------
 |       main
 +---------------------------------------------------------------------*/
@@ -193,6 +422,990 @@ main(int argc, char** argv)
     SHOULD_SUCCEED(ATX_FloatToString(12345E25f, buff, sizeof(buff)));
     /*SHOULD_EQUAL_S(buff, "123450017309192836793256378368.0");*/
 
+    /* UTF-8 validation */
+    SHOULD_SUCCEED(ATX_Utf8_Validate("", 0));
+    SHOULD_SUCCEED(ATX_Utf8_Validate("hello", 5));
+    SHOULD_SUCCEED(ATX_Utf8_Validate("\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xF4\x8F\xBF\xBF", 13));
+    SHOULD_SUCCEED(ATX_Utf8_Validate("The quick brown fox \xE2\x80\x94 jumps over the lazy dog \xF0\x9F\x90\x95", 52));
+    SHOULD_FAIL(ATX_Utf8_Validate("\x80", 1));
+    SHOULD_FAIL(ATX_Utf8_Validate("\xC3", 1));
+    SHOULD_FAIL(ATX_Utf8_Validate("\xC0\xAF", 2));
+    SHOULD_FAIL(ATX_Utf8_Validate("\xE0\x80\xAF", 3));
+    SHOULD_FAIL(ATX_Utf8_Validate("\xED\xA0\x80", 3));
+    SHOULD_FAIL(ATX_Utf8_Validate("\xF4\x90\x80\x80", 4));
+    SHOULD_FAIL(ATX_Utf8_Validate("\xF8\x88\x80\x80\x80", 5));
+    SHOULD_FAIL(ATX_Utf8_Validate("The quick brown fox jumps over the lazy dog \xE2\x80", 46));
+    SHOULD_FAIL(ATX_Utf8_Validate("The quick brown fox \xE2\x80 jumps over the lazy dog", 46));
+    SHOULD_FAIL(ATX_Utf8_Validate("The quick brown fox jumps over \xFF the lazy dog", 45));
+
+    /* buffered input streams */
+    {
+        static char       text[] = "first line\r\nsecond\n\nthird line is longer\nlast";
+        ATX_MemoryStream* memory;
+        ATX_InputStream*  source;
+        ATX_InputStream*  input;
+        ATX_BufferedInputStream* buffered;
+        ATX_String        line = ATX_EMPTY_STRING;
+        ATX_Size          bytes_read;
+        ATX_Position      position;
+
+        SHOULD_SUCCEED(ATX_MemoryStream_CreateFromBuffer((ATX_Byte*)text, sizeof(text)-1, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &source));
+        SHOULD_SUCCEED(ATX_BufferedInputStream_Create(source, 4, &input));
+        buffered = ATX_CAST(input, ATX_BufferedInputStream);
+        SHOULD_SUCCEED(buffered?ATX_SUCCESS:ATX_FAILURE);
+
+        SHOULD_SUCCEED(ATX_InputStream_ReadLine(input, buff, sizeof(buff), &bytes_read));
+        SHOULD_EQUAL_S(buff, "first line");
+        SHOULD_EQUAL_I(bytes_read, 10);
+        SHOULD_SUCCEED(ATX_InputStream_Tell(input, &position));
+        SHOULD_EQUAL_I((int)position, 12);
+        SHOULD_SUCCEED(ATX_BufferedInputStream_Peek(buffered, buff, 3, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 3);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "sec", 3)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_InputStream_ReadLineString(input, &line, 64));
+        SHOULD_EQUAL_S(ATX_CSTR(line), "second");
+        SHOULD_SUCCEED(ATX_InputStream_ReadLineString(input, &line, 64));
+        SHOULD_EQUAL_S(ATX_CSTR(line), "");
+        SHOULD_FAIL(ATX_InputStream_ReadLineString(input, &line, 5));
+        SHOULD_EQUAL_S(ATX_CSTR(line), "third");
+        SHOULD_SUCCEED(ATX_InputStream_ReadLine(input, buff, 6, &bytes_read));
+        SHOULD_EQUAL_S(buff, " line");
+        SHOULD_SUCCEED(ATX_InputStream_ReadLine(input, buff, sizeof(buff), &bytes_read));
+        SHOULD_EQUAL_S(buff, " is longer");
+
+        /* unread more than the buffer can hold */
+        SHOULD_SUCCEED(ATX_BufferedInputStream_Unread(buffered, "the end: ", 9));
+        SHOULD_SUCCEED(ATX_InputStream_ReadLineString(input, &line, 64));
+        SHOULD_EQUAL_S(ATX_CSTR(line), "the end: last");
+        SHOULD_FAIL(ATX_InputStream_ReadLine(input, buff, sizeof(buff), &bytes_read));
+        SHOULD_FAIL(ATX_BufferedInputStream_Peek(buffered, buff, 1, &bytes_read));
+
+        /* seek discards what is buffered */
+        SHOULD_SUCCEED(ATX_InputStream_Seek(input, 4));
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, 2, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 2);
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, 2, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 2);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "li", 2)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, 8, &bytes_read));
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "ne\r\nseco", 8)?ATX_SUCCESS:ATX_FAILURE);
+
+        ATX_String_Destruct(&line);
+        ATX_RELEASE_OBJECT(input);
+        ATX_RELEASE_OBJECT(source);
+        ATX_MemoryStream_Destroy(memory);
+    }
+
+    /* buffered output streams */
+    {
+        ATX_MemoryStream*     memory;
+        ATX_OutputStream*     sink;
+        ATX_OutputStream*     output;
+        const ATX_DataBuffer* data;
+        ATX_Position          position;
+
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetOutputStream(memory, &sink));
+        SHOULD_SUCCEED(ATX_BufferedOutputStream_Create(sink, 8, &output));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, "Host"));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, ": "));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetBuffer(memory, &data));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 0);
+        SHOULD_SUCCEED(ATX_OutputStream_Tell(output, &position));
+        SHOULD_EQUAL_I((int)position, 6);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, "abc"));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 8);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, "0123456789"));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 19);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteLine(output, ""));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 19);
+        SHOULD_SUCCEED(ATX_OutputStream_Flush(output));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 21);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, "!"));
+        ATX_RELEASE_OBJECT(output);
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 22);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(data), "Host: abc0123456789\r\n!", 22)?ATX_SUCCESS:ATX_FAILURE);
+
+        ATX_RELEASE_OBJECT(sink);
+        ATX_MemoryStream_Destroy(memory);
+    }
+
+    /* vectored writes */
+    {
+        ATX_MemoryStream*     memory;
+        ATX_OutputStream*     sink;
+        ATX_OutputStream*     output;
+        const ATX_DataBuffer* data;
+        ATX_IoVec             parts[4];
+        ATX_Size              bytes_written;
+
+        parts[0].buffer = "Host";   parts[0].size = 4;
+        parts[1].buffer = ": ";     parts[1].size = 2;
+        parts[2].buffer = "";       parts[2].size = 0;
+        parts[3].buffer = "a.b\r\n"; parts[3].size = 5;
+
+        /* a stream without native support */
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetOutputStream(memory, &sink));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteV(sink, parts, 4, &bytes_written));
+        SHOULD_EQUAL_I(bytes_written, 11);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteVFully(sink, parts+1, 3));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetBuffer(memory, &data));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 18);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(data), "Host: a.b\r\n: a.b\r\n", 18)?ATX_SUCCESS:ATX_FAILURE);
+
+        /* a stream with native support, small and large writes */
+        SHOULD_SUCCEED(ATX_BufferedOutputStream_Create(sink, 8, &output));
+        SHOULD_SUCCEED(ATX_CAST(output, ATX_VectoredOutputStream)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteVFully(output, parts, 2));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 18);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteVFully(output, parts, 4));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 35);
+        ATX_RELEASE_OBJECT(output);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(data)+18, "Host: Host: a.b\r\n", 17)?ATX_SUCCESS:ATX_FAILURE);
+
+        ATX_RELEASE_OBJECT(sink);
+        ATX_MemoryStream_Destroy(memory);
+    }
+
+    /* stream pump */
+    {
+        ATX_MemoryStream*     source;
+        ATX_MemoryStream*     sink;
+        ATX_InputStream*      input;
+        ATX_OutputStream*     output;
+        const ATX_DataBuffer* data;
+        ATX_LargeSize         copied;
+
+        SHOULD_SUCCEED(ATX_MemoryStream_CreateFromBuffer((ATX_Byte*)"0123456789abcdef", 16, &source));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(source, &input));
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &sink));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetOutputStream(sink, &output));
+
+        SHOULD_SUCCEED(ATX_Stream_Pump(input, output, 10, &copied));
+        SHOULD_EQUAL_I((int)copied, 10);
+        SHOULD_SUCCEED(ATX_Stream_Pump(input, output, 0, &copied));
+        SHOULD_EQUAL_I((int)copied, 6);
+        SHOULD_EQUAL_I(ATX_Stream_Pump(input, output, 0, &copied), ATX_ERROR_EOS);
+        SHOULD_EQUAL_I((int)copied, 0);
+        SHOULD_SUCCEED(ATX_MemoryStream_GetBuffer(sink, &data));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 16);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(data), "0123456789abcdef", 16)?ATX_SUCCESS:ATX_FAILURE);
+
+        ATX_RELEASE_OBJECT(input);
+        ATX_RELEASE_OBJECT(output);
+        ATX_MemoryStream_Destroy(source);
+        ATX_MemoryStream_Destroy(sink);
+    }
+
+    /* buffer chains */
+    {
+        ATX_BufferChain*  chain;
+        ATX_BufferChain*  clone;
+        ATX_ChainStream*  chain_stream;
+        ATX_MemoryStream* memory;
+        ATX_InputStream*  input;
+        ATX_OutputStream* output;
+        ATX_IoVec         parts[4];
+        ATX_Position      position;
+
+        SHOULD_SUCCEED(ATX_BufferChain_Create(8, &chain));
+        SHOULD_SUCCEED(ATX_BufferChain_Append(chain, "0123456789abcdefghij", 20));
+        SHOULD_EQUAL_I((int)ATX_BufferChain_GetDataSize(chain), 20);
+        SHOULD_EQUAL_I(ATX_BufferChain_GetIoVecs(chain, parts, 4), 3);
+        SHOULD_EQUAL_I(parts[2].size, 4);
+        SHOULD_EQUAL_I(ATX_BufferChain_Peek(chain, buff, 10), 10);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "0123456789", 10)?ATX_SUCCESS:ATX_FAILURE);
+
+        /* clones share the segments, but not the data that follows */
+        SHOULD_SUCCEED(ATX_BufferChain_Clone(chain, &clone));
+        SHOULD_SUCCEED(ATX_BufferChain_Consume(chain, 10));
+        SHOULD_FAIL(ATX_BufferChain_Consume(chain, 11));
+        SHOULD_SUCCEED(ATX_BufferChain_Append(chain, "XY", 2));
+        SHOULD_SUCCEED(ATX_BufferChain_Append(clone, "xy", 2));
+        SHOULD_EQUAL_I(ATX_BufferChain_Peek(chain, buff, sizeof(buff)), 12);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "abcdefghijXY", 12)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_BufferChain_Peek(clone, buff, sizeof(buff)), 22);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff+16, "ghijxy", 6)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_BufferChain_Consume(chain, 12));
+        SHOULD_EQUAL_I(ATX_BufferChain_GetIoVecs(chain, parts, 4), 0);
+        ATX_BufferChain_Destroy(clone);
+
+        /* load a stream into the chain */
+        SHOULD_SUCCEED(ATX_MemoryStream_CreateFromBuffer((ATX_Byte*)"hello, chain", 12, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &input));
+        SHOULD_SUCCEED(ATX_InputStream_LoadChain(input, 5, chain));
+        SHOULD_EQUAL_I((int)ATX_BufferChain_GetDataSize(chain), 5);
+        SHOULD_SUCCEED(ATX_InputStream_LoadChain(input, 0, chain));
+        SHOULD_EQUAL_I((int)ATX_BufferChain_GetDataSize(chain), 12);
+        SHOULD_EQUAL_I(ATX_BufferChain_Peek(chain, buff, sizeof(buff)), 12);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "hello, chain", 12)?ATX_SUCCESS:ATX_FAILURE);
+        ATX_RELEASE_OBJECT(input);
+        ATX_MemoryStream_Destroy(memory);
+        ATX_BufferChain_Destroy(chain);
+
+        /* chain-backed memory stream */
+        SHOULD_SUCCEED(ATX_ChainStream_Create(4, &chain_stream));
+        SHOULD_SUCCEED(ATX_ChainStream_GetInputStream(chain_stream, &input));
+        SHOULD_SUCCEED(ATX_ChainStream_GetOutputStream(chain_stream, &output));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, "first line\n"));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteString(output, "second"));
+        SHOULD_SUCCEED(ATX_InputStream_ReadLine(input, buff, sizeof(buff), NULL));
+        SHOULD_EQUAL_S(buff, "first line");
+        SHOULD_SUCCEED(ATX_InputStream_Seek(input, 13));
+        SHOULD_FAIL(ATX_InputStream_Seek(input, 12));
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(input, buff, 4));
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "cond", 4)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_InputStream_Read(input, buff, 4, NULL), ATX_ERROR_EOS);
+        SHOULD_SUCCEED(ATX_OutputStream_Tell(output, &position));
+        SHOULD_EQUAL_I((int)position, 17);
+        ATX_RELEASE_OBJECT(input);
+        ATX_RELEASE_OBJECT(output);
+        ATX_ChainStream_Destroy(chain_stream);
+    }
+
+    /* lz4 streams */
+    {
+        ATX_MemoryStream*     memory;
+        ATX_InputStream*      input;
+        ATX_OutputStream*     output;
+        ATX_OutputStream*     lz4_output;
+        ATX_InputStream*      lz4_input;
+        const ATX_DataBuffer* data;
+        ATX_Byte*             original;
+        ATX_Byte*             copy;
+        ATX_Size              size = 200000;
+        ATX_Size              compressed_size;
+        ATX_Size              copy_size;
+        ATX_UInt32            seed = 1;
+
+        /* half text, half noise */
+        original = (ATX_Byte*)ATX_AllocateMemory(size);
+        copy     = (ATX_Byte*)ATX_AllocateMemory(size+ATX_Lz4_GetMaxCompressedSize(size));
+        for (i=0; i<(int)size; i++) {
+            seed = seed*1103515245+12345;
+            original[i] = i < (int)size/2 ? "compressible text "[i%18] : (ATX_Byte)(seed >> 16);
+        }
+
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetOutputStream(memory, &output));
+        SHOULD_SUCCEED(ATX_Lz4OutputStream_Create(output, 0, &lz4_output));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetBuffer(memory, &data));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(data), 7);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(data), "\x04\x22\x4D\x18\x64\x40\xA7", 7)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(lz4_output, original, 1000));
+        SHOULD_SUCCEED(ATX_OutputStream_Flush(lz4_output));
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(lz4_output, original+1000, size-1000));
+        ATX_RELEASE_OBJECT(lz4_output);
+        ATX_RELEASE_OBJECT(output);
+        SHOULD_SUCCEED(ATX_DataBuffer_GetDataSize(data) < size/2+size/100 ? ATX_SUCCESS : ATX_FAILURE);
+
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &input));
+        SHOULD_SUCCEED(ATX_Lz4InputStream_Create(input, &lz4_input));
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(lz4_input, copy, size));
+        SHOULD_EQUAL_I(ATX_InputStream_Read(lz4_input, copy, 1, NULL), ATX_ERROR_EOS);
+        SHOULD_SUCCEED(ATX_MemoryEqual(copy, original, size)?ATX_SUCCESS:ATX_FAILURE);
+        ATX_RELEASE_OBJECT(lz4_input);
+
+        /* a corrupted frame fails its checksum */
+        ((ATX_Byte*)ATX_DataBuffer_GetData(data))[ATX_DataBuffer_GetDataSize(data)-1] ^= 1;
+        SHOULD_SUCCEED(ATX_InputStream_Seek(input, 0));
+        SHOULD_SUCCEED(ATX_Lz4InputStream_Create(input, &lz4_input));
+        SHOULD_EQUAL_I(ATX_InputStream_ReadFully(lz4_input, copy, size+1), ATX_ERROR_INVALID_FORMAT);
+        ATX_RELEASE_OBJECT(lz4_input);
+        ATX_RELEASE_OBJECT(input);
+        ATX_MemoryStream_Destroy(memory);
+
+        /* single blocks */
+        SHOULD_SUCCEED(ATX_Lz4_CompressBlock(original, size/2, copy, ATX_Lz4_GetMaxCompressedSize(size/2), &compressed_size));
+        SHOULD_SUCCEED(compressed_size < size/100 ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Lz4_DecompressBlock(copy, compressed_size, copy+compressed_size, size/2, &copy_size));
+        SHOULD_EQUAL_I(copy_size, size/2);
+        SHOULD_SUCCEED(ATX_MemoryEqual(copy+compressed_size, original, size/2)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_FAIL(ATX_Lz4_DecompressBlock(copy, compressed_size, copy+compressed_size, size/2-1, &copy_size));
+
+        ATX_FreeMemory((void*)original);
+        ATX_FreeMemory((void*)copy);
+    }
+
+    /* checksums */
+    {
+        ATX_MemoryStream*     memory;
+        ATX_OutputStream*     output;
+        ATX_OutputStream*     sub_output;
+        ATX_InputStream*      input;
+        ATX_InputStream*      sub_input;
+        ATX_Checksum*         checksum;
+        ATX_Byte              data[1280];
+        ATX_Size              bytes_written;
+
+        for (i=0; i<(int)sizeof(data); i++) data[i] = (ATX_Byte)i;
+
+        /* one-shot */
+        SHOULD_EQUAL_I(ATX_Crc32(0, "123456789", 9), 0xCBF43926);
+        SHOULD_EQUAL_I(ATX_Crc32c(0, "123456789", 9), 0xE3069283);
+        SHOULD_EQUAL_I(ATX_Crc32(ATX_Crc32(0, data, 100), data+100, 1180), 0x1E7A6D24);
+        SHOULD_EQUAL_I(ATX_Crc32c(0, data, sizeof(data)), 0x23B62C98);
+        SHOULD_SUCCEED(ATX_Xxh3_64("", 0) == (((ATX_UInt64)0x2D068005 << 32) | 0x38D394C2) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Xxh3_64("abc", 3) == (((ATX_UInt64)0x78AF5F94 << 32) | 0x892F3950) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Xxh3_64(data, sizeof(data)) == (((ATX_UInt64)0x4844B009 << 32) | 0xE164352E) ? ATX_SUCCESS : ATX_FAILURE);
+
+        /* incremental */
+        SHOULD_SUCCEED(ATX_Checksum_Create(ATX_CHECKSUM_TYPE_XXH3_64, &checksum));
+        for (i=0; i<(int)sizeof(data); i+=160) ATX_Checksum_Update(checksum, data+i, 160);
+        SHOULD_SUCCEED(ATX_Checksum_GetValue(checksum) == ATX_Xxh3_64(data, sizeof(data)) ? ATX_SUCCESS : ATX_FAILURE);
+        ATX_Checksum_Reset(checksum);
+        ATX_Checksum_Update(checksum, "abc", 3);
+        SHOULD_SUCCEED(ATX_Checksum_GetValue(checksum) == ATX_Xxh3_64("abc", 3) ? ATX_SUCCESS : ATX_FAILURE);
+        ATX_Checksum_Destroy(checksum);
+
+        /* inline with a sub output stream */
+        SHOULD_SUCCEED(ATX_Checksum_Create(ATX_CHECKSUM_TYPE_CRC32C, &checksum));
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetOutputStream(memory, &output));
+        SHOULD_SUCCEED(ATX_OutputStream_Write(output, "head", 4, NULL));
+        SHOULD_SUCCEED(ATX_SubOutputStream_Create(output, 4, 1000, ATX_Checksum_GetTransformer(checksum), &sub_output));
+        SHOULD_SUCCEED(ATX_OutputStream_Write(sub_output, data, sizeof(data), &bytes_written));
+        SHOULD_EQUAL_I(bytes_written, 1000);
+        SHOULD_EQUAL_I(ATX_OutputStream_Write(sub_output, data, 1, NULL), ATX_ERROR_OUT_OF_RANGE);
+        SHOULD_EQUAL_I((ATX_UInt32)ATX_Checksum_GetValue(checksum), ATX_Crc32c(0, data, 1000));
+        ATX_RELEASE_OBJECT(sub_output);
+        ATX_RELEASE_OBJECT(output);
+        ATX_Checksum_Destroy(checksum);
+
+        /* inline with a sub input stream */
+        SHOULD_SUCCEED(ATX_Checksum_Create(ATX_CHECKSUM_TYPE_XXH3_64, &checksum));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &input));
+        SHOULD_SUCCEED(ATX_SubInputStream_Create(input, 4, 0, ATX_Checksum_GetTransformer(checksum), &sub_input));
+        SHOULD_SUCCEED(ATX_InputStream_ReadFully(sub_input, data, 1000));
+        SHOULD_EQUAL_I(ATX_InputStream_Read(sub_input, data, 1, NULL), ATX_ERROR_EOS);
+        SHOULD_SUCCEED(ATX_Checksum_GetValue(checksum) == ATX_Xxh3_64(data, 1000) ? ATX_SUCCESS : ATX_FAILURE);
+        ATX_RELEASE_OBJECT(sub_input);
+        ATX_RELEASE_OBJECT(input);
+        ATX_MemoryStream_Destroy(memory);
+        ATX_Checksum_Destroy(checksum);
+    }
+
+    /* pipes */
+    {
+        ATX_InputStream*     input;
+        ATX_OutputStream*    output;
+        ATX_PipeInputStream* pipe_input;
+        const ATX_Byte*      region;
+        ATX_Size             region_size;
+        ATX_Size             bytes_read;
+
+        SHOULD_SUCCEED(ATX_Pipe_Create(16, &input, &output));
+        pipe_input = ATX_CAST(input, ATX_PipeInputStream);
+        SHOULD_SUCCEED(pipe_input ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(output, "0123456789", 10));
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, 4, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 4);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "0123", 4)?ATX_SUCCESS:ATX_FAILURE);
+
+        /* wrap around the end of the ring */
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(output, "abcdefghij", 10));
+        SHOULD_SUCCEED(ATX_PipeInputStream_GetReadRegion(pipe_input, &region, &region_size));
+        SHOULD_SUCCEED(region_size > 0 && region_size < 16 ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_MemoryEqual(region, "456789abcdefghij", region_size)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_PipeInputStream_CommitRead(pipe_input, region_size));
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, sizeof(buff), &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 16-region_size);
+        SHOULD_SUCCEED(ATX_MemoryEqual(buff, "456789abcdefghij"+region_size, bytes_read)?ATX_SUCCESS:ATX_FAILURE);
+
+        /* closing the output end gives EOS once everything was read */
+        SHOULD_SUCCEED(ATX_OutputStream_WriteFully(output, "xyz", 3));
+        ATX_RELEASE_OBJECT(output);
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, sizeof(buff), &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 3);
+        SHOULD_EQUAL_I(ATX_InputStream_Read(input, buff, sizeof(buff), &bytes_read), ATX_ERROR_EOS);
+        SHOULD_EQUAL_I(ATX_PipeInputStream_GetReadRegion(pipe_input, &region, &region_size), ATX_ERROR_EOS);
+        ATX_RELEASE_OBJECT(input);
+
+        /* a writer thread filling the pipe faster than it is read */
+        {
+            ATX_Thread*  thread;
+            unsigned int total = 0;
+            ATX_Result   result;
+
+            SHOULD_SUCCEED(ATX_Pipe_Create(PIPE_TEST_CAPACITY, &input, &output));
+            pipe_input = ATX_CAST(input, ATX_PipeInputStream);
+            SHOULD_SUCCEED(ATX_Thread_Create(PipeTestWriter, output, &thread));
+            for (;;) {
+                if (total%2) {
+                    result = ATX_PipeInputStream_GetReadRegion(pipe_input, &region, &region_size);
+                    if (result == ATX_ERROR_EOS) break;
+                    SHOULD_SUCCEED(result);
+                    for (i=0; i<(int)region_size; i++) {
+                        SHOULD_EQUAL_I(region[i], (total+i)%251);
+                    }
+                    SHOULD_SUCCEED(ATX_PipeInputStream_CommitRead(pipe_input, region_size));
+                    total += region_size;
+                } else {
+                    result = ATX_InputStream_Read(input, buff, 1+total%7, &bytes_read);
+                    if (result == ATX_ERROR_EOS) break;
+                    SHOULD_SUCCEED(result);
+                    for (i=0; i<(int)bytes_read; i++) {
+                        SHOULD_EQUAL_I((ATX_Byte)buff[i], (total+i)%251);
+                    }
+                    total += bytes_read;
+                }
+            }
+            SHOULD_EQUAL_I(total, PIPE_TEST_SIZE);
+            SHOULD_SUCCEED(ATX_Thread_Join(thread));
+            ATX_RELEASE_OBJECT(input);
+        }
+
+        /* closing the input end makes writes fail */
+        SHOULD_SUCCEED(ATX_Pipe_Create(0, &input, &output));
+        SHOULD_SUCCEED(ATX_PipeInputStream_Close(ATX_CAST(input, ATX_PipeInputStream)));
+        SHOULD_EQUAL_I(ATX_OutputStream_Write(output, "x", 1, NULL), ATX_ERROR_PIPE_CLOSED);
+        ATX_RELEASE_OBJECT(input);
+        ATX_RELEASE_OBJECT(output);
+    }
+
+    /* instrumented streams */
+    {
+        ATX_MemoryStream*  memory;
+        ATX_InputStream*   source;
+        ATX_OutputStream*  sink;
+        ATX_InputStream*   input;
+        ATX_OutputStream*  output;
+        ATX_Properties*    stats;
+        ATX_PropertyValue  value;
+        ATX_Size           bytes_read;
+
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &memory));
+        SHOULD_SUCCEED(ATX_MemoryStream_GetOutputStream(memory, &sink));
+        SHOULD_SUCCEED(ATX_InstrumentedOutputStream_Create(sink, &output));
+        for (i=0; i<10; i++) {
+            SHOULD_SUCCEED(ATX_OutputStream_WriteFully(output, "0123456789", 10));
+        }
+        SHOULD_SUCCEED(ATX_OutputStream_Flush(output));
+        stats = ATX_CAST(output, ATX_Properties);
+        SHOULD_SUCCEED(stats ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Write.Count", &value));
+        SHOULD_EQUAL_I(value.type, ATX_PROPERTY_VALUE_TYPE_INTEGER);
+        SHOULD_EQUAL_I(value.data.integer, 10);
+        SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Write.Bytes", &value));
+        SHOULD_EQUAL_I(value.type, ATX_PROPERTY_VALUE_TYPE_LARGE_INTEGER);
+        SHOULD_EQUAL_I(value.data.large_integer, 100);
+        SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Flush.Count", &value));
+        SHOULD_EQUAL_I(value.data.integer, 1);
+        SHOULD_EQUAL_I(ATX_Properties_GetProperty(stats, "Read.Count", &value), ATX_ERROR_NO_SUCH_PROPERTY);
+        SHOULD_EQUAL_I(ATX_Properties_GetProperty(stats, "Write.Nothing", &value), ATX_ERROR_NO_SUCH_PROPERTY);
+        ATX_RELEASE_OBJECT(output);
+        ATX_RELEASE_OBJECT(sink);
+
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &source));
+        SHOULD_SUCCEED(ATX_InstrumentedInputStream_Create(source, &input));
+        SHOULD_SUCCEED(ATX_InputStream_Seek(input, 90));
+        SHOULD_SUCCEED(ATX_InputStream_Read(input, buff, 20, &bytes_read));
+        SHOULD_EQUAL_I(bytes_read, 10);
+        SHOULD_EQUAL_I(ATX_InputStream_Read(input, buff, 20, &bytes_read), ATX_ERROR_EOS);
+        stats = ATX_CAST(input, ATX_Properties);
+        SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Read.Count", &value));
+        SHOULD_EQUAL_I(value.data.integer, 2);
+        SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Read.Bytes", &value));
+        SHOULD_EQUAL_I(value.data.large_integer, 10);
+        SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Seek.Count", &value));
+        SHOULD_EQUAL_I(value.data.integer, 1);
+        {
+            ATX_Float p50, p99, max;
+            SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Read.LatencyP50", &value));
+            p50 = value.data.fp;
+            SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Read.LatencyP99", &value));
+            p99 = value.data.fp;
+            SHOULD_SUCCEED(ATX_Properties_GetProperty(stats, "Read.LatencyMax", &value));
+            max = value.data.fp;
+            SHOULD_SUCCEED(p50 >= 0 && p50 <= p99 && p99 <= max ? ATX_SUCCESS : ATX_FAILURE);
+        }
+        ATX_RELEASE_OBJECT(input);
+        ATX_RELEASE_OBJECT(source);
+
+        /* the global switch */
+        ATX_StreamInstrumentation_SetEnabled(ATX_FALSE);
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &input));
+        source = input;
+        SHOULD_SUCCEED(ATX_StreamInstrumentation_WrapInputStream(&input));
+        SHOULD_SUCCEED(input == source ? ATX_SUCCESS : ATX_FAILURE);
+        ATX_StreamInstrumentation_SetEnabled(ATX_TRUE);
+        SHOULD_SUCCEED(ATX_StreamInstrumentation_WrapInputStream(&input));
+        SHOULD_SUCCEED(ATX_CAST(input, ATX_Properties) ? ATX_SUCCESS : ATX_FAILURE);
+        ATX_StreamInstrumentation_SetEnabled(ATX_FALSE);
+        ATX_RELEASE_OBJECT(input);
+        ATX_MemoryStream_Destroy(memory);
+    }
+
+    /* data buffer slices */
+    {
+        ATX_DataBuffer* buffer;
+        ATX_DataBuffer* slice;
+        ATX_DataBuffer* sub_slice;
+        ATX_DataBuffer* clone;
+        const ATX_Byte* data;
+
+        SHOULD_SUCCEED(ATX_DataBuffer_Create(0, &buffer));
+        SHOULD_SUCCEED(ATX_DataBuffer_SetData(buffer, (const ATX_Byte*)"0123456789", 10));
+        SHOULD_EQUAL_I(ATX_DataBuffer_CreateSlice(buffer, 5, 6, &slice), ATX_ERROR_OUT_OF_RANGE);
+        SHOULD_SUCCEED(ATX_DataBuffer_CreateSlice(buffer, 2, 6, &slice));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(slice), 6);
+        SHOULD_SUCCEED(ATX_DataBuffer_GetData(slice) == ATX_DataBuffer_GetData(buffer)+2 ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_DataBuffer_IsShared(buffer), ATX_TRUE);
+        SHOULD_SUCCEED(ATX_DataBuffer_CreateSlice(slice, 1, 2, &sub_slice));
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(sub_slice), "34", 2)?ATX_SUCCESS:ATX_FAILURE);
+
+        /* writing to the parent copies it, the slices keep the old data */
+        data = ATX_DataBuffer_GetData(buffer);
+        ATX_DataBuffer_UseData(buffer)[3] = 'x';
+        SHOULD_SUCCEED(ATX_DataBuffer_GetData(buffer) != data ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(buffer), "012x456789", 10)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(slice), "234567", 6)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_DataBuffer_IsShared(buffer), ATX_FALSE);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(buffer));
+
+        /* the slices outlive the parent, the last user writes in place */
+        SHOULD_EQUAL_I(ATX_DataBuffer_IsShared(slice), ATX_TRUE);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(sub_slice));
+        SHOULD_EQUAL_I(ATX_DataBuffer_IsShared(slice), ATX_FALSE);
+        data = ATX_DataBuffer_GetData(slice);
+        ATX_DataBuffer_UseData(slice)[0] = 'y';
+        SHOULD_SUCCEED(ATX_DataBuffer_GetData(slice) == data ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_DataBuffer_AppendData(slice, (const ATX_Byte*)"ab", 2));
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(slice), "y34567ab", 8)?ATX_SUCCESS:ATX_FAILURE);
+
+        /* clones share the memory until one of them is modified */
+        SHOULD_SUCCEED(ATX_DataBuffer_Clone(slice, &clone));
+        SHOULD_SUCCEED(ATX_DataBuffer_GetData(clone) == ATX_DataBuffer_GetData(slice) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_DataBuffer_SetData(clone, (const ATX_Byte*)"z", 1));
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(slice), "y34567ab", 8)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(clone), 1);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(clone));
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(slice));
+    }
+
+    /* data buffer pools */
+    {
+        ATX_DataBufferPool* pool;
+        ATX_DataBuffer*     buffer;
+        ATX_DataBuffer*     other;
+        ATX_DataBuffer*     slice;
+        ATX_DataBuffer*     first;
+
+        SHOULD_SUCCEED(ATX_DataBufferPool_Create(1000, 2, 0, &pool));
+
+        /* sizes are rounded up to a size class, and buffers are reused */
+        SHOULD_SUCCEED(ATX_DataBufferPool_Acquire(pool, 100, &buffer));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetBufferSize(buffer), 128);
+        SHOULD_SUCCEED(ATX_DataBuffer_SetData(buffer, (const ATX_Byte*)"hello", 5));
+        first = buffer;
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(buffer));
+        SHOULD_SUCCEED(ATX_DataBufferPool_Acquire(pool, 128, &buffer));
+        SHOULD_SUCCEED(buffer == first ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(buffer), 0);
+        SHOULD_SUCCEED(ATX_DataBufferPool_Acquire(pool, 65, &other));
+        SHOULD_SUCCEED(other != buffer ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(other));
+
+        /* large requests are not pooled */
+        SHOULD_SUCCEED(ATX_DataBufferPool_Acquire(pool, 5000, &other));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetBufferSize(other), 5000);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(other));
+
+        /* a buffer that was sliced is freed instead of recycled */
+        SHOULD_SUCCEED(ATX_DataBuffer_SetData(buffer, (const ATX_Byte*)"0123456789", 10));
+        SHOULD_SUCCEED(ATX_DataBuffer_CreateSlice(buffer, 2, 3, &slice));
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(buffer));
+        SHOULD_SUCCEED(ATX_MemoryEqual(ATX_DataBuffer_GetData(slice), "234", 3)?ATX_SUCCESS:ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(slice));
+
+        /* buffers may outlive their pool */
+        SHOULD_SUCCEED(ATX_DataBufferPool_Acquire(pool, 10, &buffer));
+        SHOULD_SUCCEED(ATX_DataBufferPool_Destroy(pool));
+        SHOULD_SUCCEED(ATX_DataBuffer_SetData(buffer, (const ATX_Byte*)"abc", 3));
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(buffer));
+
+        /* single-thread pools work the same way */
+        SHOULD_SUCCEED(ATX_DataBufferPool_Create(0, 0, ATX_DATA_BUFFER_POOL_FLAG_SINGLE_THREAD, &pool));
+        SHOULD_SUCCEED(ATX_DataBufferPool_Acquire(pool, 0, &buffer));
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetBufferSize(buffer), ATX_DATA_BUFFER_POOL_MIN_BUFFER_SIZE);
+        SHOULD_SUCCEED(ATX_DataBuffer_Destroy(buffer));
+        SHOULD_SUCCEED(ATX_DataBufferPool_Destroy(pool));
+    }
+
+    /* threads, conditions and semaphores */
+    {
+        ATX_Semaphore*    semaphores[2];
+        ATX_Thread*       thread;
+        ATX_ThreadOptions options;
+        ATX_Mutex*        mutex;
+        ATX_Condition*    condition;
+
+        SHOULD_SUCCEED(ATX_Semaphore_Create(0, &semaphores[0]));
+        SHOULD_SUCCEED(ATX_Semaphore_Create(0, &semaphores[1]));
+        SHOULD_EQUAL_I(ATX_Semaphore_TimedAcquire(semaphores[0], 0), ATX_ERROR_TIMEOUT);
+        SHOULD_EQUAL_I(ATX_Semaphore_TimedAcquire(semaphores[0], 10), ATX_ERROR_TIMEOUT);
+
+        /* ping-pong with another thread */
+        options.name       = "atx-misc-test";
+        options.stack_size = 256*1024;
+        SHOULD_SUCCEED(ATX_Thread_CreateEx(SemaphoreTestThread, semaphores, &options, &thread));
+        for (i=0; i<SEMAPHORE_TEST_ROUNDS; i++) {
+            SHOULD_SUCCEED(ATX_Semaphore_Release(semaphores[0], 1));
+            SHOULD_SUCCEED(ATX_Semaphore_Acquire(semaphores[1]));
+        }
+        SHOULD_SUCCEED(ATX_Thread_Join(thread));
+        SHOULD_EQUAL_I(ATX_Semaphore_TimedAcquire(semaphores[1], 0), ATX_ERROR_TIMEOUT);
+
+        /* counts */
+        SHOULD_SUCCEED(ATX_Semaphore_Release(semaphores[0], 2));
+        SHOULD_SUCCEED(ATX_Semaphore_TimedAcquire(semaphores[0], 0));
+        SHOULD_SUCCEED(ATX_Semaphore_TimedAcquire(semaphores[0], 10));
+        SHOULD_EQUAL_I(ATX_Semaphore_TimedAcquire(semaphores[0], 0), ATX_ERROR_TIMEOUT);
+        SHOULD_SUCCEED(ATX_Semaphore_Destroy(semaphores[0]));
+        SHOULD_SUCCEED(ATX_Semaphore_Destroy(semaphores[1]));
+
+        /* timed waits */
+        SHOULD_SUCCEED(ATX_Mutex_Create(&mutex));
+        SHOULD_SUCCEED(ATX_Condition_Create(&condition));
+        SHOULD_SUCCEED(ATX_Mutex_Lock(mutex));
+        SHOULD_EQUAL_I(ATX_Condition_TimedWait(condition, mutex, 10), ATX_ERROR_TIMEOUT);
+        SHOULD_SUCCEED(ATX_Mutex_Unlock(mutex));
+        SHOULD_SUCCEED(ATX_Condition_Destroy(condition));
+        SHOULD_SUCCEED(ATX_Mutex_Destroy(mutex));
+    }
+
+    /* atomics */
+    {
+        ATX_AtomicInt     value = 0;
+        ATX_AtomicInt64   value64 = 0;
+        ATX_AtomicPointer pointer = NULL;
+        ATX_Thread*       threads[ATOMIC_TEST_THREADS];
+        ATX_MemoryStream* memory;
+        AtomicTestContext context;
+
+        SHOULD_EQUAL_I(ATX_Atomic_Add(&value, 5, ATX_ATOMIC_RELAXED), 5);
+        SHOULD_EQUAL_I(ATX_Atomic_Add(&value, -2, ATX_ATOMIC_ACQ_REL), 3);
+        ATX_Atomic_Store(&value, 7, ATX_ATOMIC_RELEASE);
+        SHOULD_EQUAL_I(ATX_Atomic_Load(&value, ATX_ATOMIC_ACQUIRE), 7);
+        SHOULD_SUCCEED(ATX_Atomic_CompareAndSwap(&value, 7, 8) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_FAIL(ATX_Atomic_CompareAndSwap(&value, 7, 9) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_Atomic_Load(&value, ATX_ATOMIC_SEQ_CST), 8);
+        ATX_Atomic_Store64(&value64, (ATX_Int64)1 << 40, ATX_ATOMIC_SEQ_CST);
+        SHOULD_SUCCEED(ATX_Atomic_Add64(&value64, 1, ATX_ATOMIC_SEQ_CST) == ((ATX_Int64)1 << 40)+1 ?
+                       ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Atomic_CompareAndSwap64(&value64, ((ATX_Int64)1 << 40)+1, -1) ? 
+                       ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Atomic_Load64(&value64, ATX_ATOMIC_ACQUIRE) == -1 ? 
+                       ATX_SUCCESS : ATX_FAILURE);
+        ATX_Atomic_StorePointer(&pointer, (void*)&value, ATX_ATOMIC_RELEASE);
+        SHOULD_SUCCEED(ATX_Atomic_LoadPointer(&pointer, ATX_ATOMIC_ACQUIRE) == (void*)&value ?
+                       ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_FAIL(ATX_Atomic_CompareAndSwapPointer(&pointer, NULL, (void*)&value64) ? 
+                    ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Atomic_CompareAndSwapPointer(&pointer, (void*)&value, NULL) ? 
+                       ATX_SUCCESS : ATX_FAILURE);
+        ATX_Atomic_Fence(ATX_ATOMIC_SEQ_CST);
+
+        /* counters and references shared by several threads */
+        SHOULD_SUCCEED(ATX_MemoryStream_Create(0, &memory));
+        context.counter = 0;
+        SHOULD_SUCCEED(ATX_MemoryStream_GetInputStream(memory, &context.streams[0]));
+        SHOULD_SUCCEED(ATX_BufferedInputStream_Create(context.streams[0], 0, &context.streams[1]));
+        for (i=0; i<ATOMIC_TEST_THREADS; i++) {
+            SHOULD_SUCCEED(ATX_Thread_Create(AtomicTestThread, &context, &threads[i]));
+        }
+        for (i=0; i<ATOMIC_TEST_THREADS; i++) {
+            SHOULD_SUCCEED(ATX_Thread_Join(threads[i]));
+        }
+        SHOULD_EQUAL_I(ATX_Atomic_Load(&context.counter, ATX_ATOMIC_SEQ_CST), 
+                       ATOMIC_TEST_THREADS*ATOMIC_TEST_ROUNDS);
+        ATX_RELEASE_OBJECT(context.streams[1]);
+        ATX_RELEASE_OBJECT(context.streams[0]);
+        SHOULD_SUCCEED(ATX_MemoryStream_Destroy(memory));
+    }
+
+    /* locks */
+    {
+        ATX_Mutex*       mutex = NULL;
+        ATX_Mutex*       created;
+        ATX_Thread*      threads[LOCK_TEST_THREADS];
+        ATX_TimeInterval pause;
+        LockTestContext  context;
+
+        /* the first call creates the mutex, the next ones reuse it */
+        SHOULD_SUCCEED(ATX_Mutex_LockAutoCreate(&mutex));
+        SHOULD_SUCCEED(mutex != NULL ? ATX_SUCCESS : ATX_FAILURE);
+        created = mutex;
+        SHOULD_SUCCEED(ATX_Mutex_Unlock(mutex));
+        SHOULD_SUCCEED(ATX_Mutex_LockAutoCreate(&mutex));
+        SHOULD_SUCCEED(mutex == created ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Mutex_Unlock(mutex));
+        SHOULD_SUCCEED(ATX_Mutex_Destroy(mutex));
+
+        ATX_SetMemory(&context, 0, sizeof(context));
+        SHOULD_SUCCEED(ATX_RwLock_Create(ATX_RW_LOCK_FLAG_PREFER_WRITERS, &context.rw_lock));
+        SHOULD_SUCCEED(ATX_SpinMutex_Create(&context.spin_mutex));
+
+        /* readers share the lock, writers have it alone */
+        SHOULD_SUCCEED(ATX_RwLock_LockRead(context.rw_lock));
+        SHOULD_SUCCEED(ATX_RwLock_TryLockRead(context.rw_lock));
+        SHOULD_EQUAL_I(ATX_RwLock_TryLockWrite(context.rw_lock), ATX_ERROR_TIMEOUT);
+        SHOULD_EQUAL_I(ATX_RwLock_TimedLockWrite(context.rw_lock, 10), ATX_ERROR_TIMEOUT);
+        SHOULD_SUCCEED(ATX_RwLock_UnlockRead(context.rw_lock));
+        SHOULD_SUCCEED(ATX_RwLock_UnlockRead(context.rw_lock));
+        SHOULD_SUCCEED(ATX_RwLock_TryLockWrite(context.rw_lock));
+        SHOULD_EQUAL_I(ATX_RwLock_TryLockRead(context.rw_lock), ATX_ERROR_TIMEOUT);
+        SHOULD_EQUAL_I(ATX_RwLock_TimedLockRead(context.rw_lock, 10), ATX_ERROR_TIMEOUT);
+        SHOULD_EQUAL_I(ATX_RwLock_TryLockWrite(context.rw_lock), ATX_ERROR_TIMEOUT);
+        SHOULD_SUCCEED(ATX_RwLock_UnlockWrite(context.rw_lock));
+
+        /* new readers wait behind a waiting writer */
+        SHOULD_SUCCEED(ATX_RwLock_LockRead(context.rw_lock));
+        SHOULD_SUCCEED(ATX_Thread_Create(LockTestWriter, &context, &threads[0]));
+        ATX_TimeStamp_Set(pause, 0, 1000000);
+        for (i=0; i<5000; i++) {
+            if (ATX_FAILED(ATX_RwLock_TryLockRead(context.rw_lock))) break;
+            SHOULD_SUCCEED(ATX_RwLock_UnlockRead(context.rw_lock));
+            ATX_System_Sleep(&pause);
+        }
+        SHOULD_EQUAL_I(ATX_RwLock_TryLockRead(context.rw_lock), ATX_ERROR_TIMEOUT);
+        SHOULD_SUCCEED(ATX_RwLock_UnlockRead(context.rw_lock));
+        SHOULD_SUCCEED(ATX_Thread_Join(threads[0]));
+        SHOULD_SUCCEED(ATX_RwLock_TryLockRead(context.rw_lock));
+        SHOULD_EQUAL_I(context.values[0], -1);
+        SHOULD_SUCCEED(ATX_RwLock_UnlockRead(context.rw_lock));
+        context.values[0] = 0;
+
+        /* spin mutexes */
+        SHOULD_SUCCEED(ATX_SpinMutex_TryLock(context.spin_mutex));
+        SHOULD_EQUAL_I(ATX_SpinMutex_TryLock(context.spin_mutex), ATX_ERROR_TIMEOUT);
+        SHOULD_EQUAL_I(ATX_SpinMutex_TimedLock(context.spin_mutex, 10), ATX_ERROR_TIMEOUT);
+        SHOULD_SUCCEED(ATX_SpinMutex_Unlock(context.spin_mutex));
+        SHOULD_SUCCEED(ATX_SpinMutex_TimedLock(context.spin_mutex, 10));
+        SHOULD_SUCCEED(ATX_SpinMutex_Unlock(context.spin_mutex));
+
+        /* both locks shared by several threads */
+        for (i=0; i<LOCK_TEST_THREADS; i++) {
+            SHOULD_SUCCEED(ATX_Thread_Create(LockTestThread, &context, &threads[i]));
+        }
+        for (i=0; i<LOCK_TEST_THREADS; i++) {
+            SHOULD_SUCCEED(ATX_Thread_Join(threads[i]));
+        }
+        SHOULD_EQUAL_I(context.counter, LOCK_TEST_THREADS*LOCK_TEST_ROUNDS);
+        SHOULD_EQUAL_I(context.values[0], LOCK_TEST_THREADS*LOCK_TEST_ROUNDS/8);
+        SHOULD_EQUAL_I(context.values[1], context.values[0]);
+        SHOULD_EQUAL_I(ATX_Atomic_Load(&context.mismatches, ATX_ATOMIC_SEQ_CST), 0);
+        SHOULD_SUCCEED(ATX_SpinMutex_Destroy(context.spin_mutex));
+        SHOULD_SUCCEED(ATX_RwLock_Destroy(context.rw_lock));
+    }
+
+    /* thread locals */
+    {
+        ATX_ThreadLocal*       locals[THREAD_LOCAL_TEST_COUNT];
+        ATX_Thread*            thread;
+        ATX_DataBuffer*        scratch;
+        ATX_DataBuffer*        again;
+        ThreadLocalTestContext context;
+
+        ATX_SetMemory(&context, 0, sizeof(context));
+        SHOULD_SUCCEED(ATX_ThreadLocal_Create(ThreadLocalTestDestructor, &context.local));
+        SHOULD_SUCCEED(ATX_ThreadLocal_Get(context.local) == NULL ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_ThreadLocal_Set(context.local, (void*)&i));
+        SHOULD_SUCCEED(ATX_ThreadLocal_Get(context.local) == (void*)&i ? ATX_SUCCESS : ATX_FAILURE);
+
+        /* scratch buffers are reused by the same thread, and emptied */
+        SHOULD_SUCCEED(ATX_DataBuffer_GetThreadScratch(100, &scratch));
+        SHOULD_SUCCEED(ATX_DataBuffer_GetBufferSize(scratch) >= 100 ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_DataBuffer_SetData(scratch, (const ATX_Byte*)"hello", 5));
+        SHOULD_SUCCEED(ATX_DataBuffer_GetThreadScratch(1000, &again));
+        SHOULD_SUCCEED(again == scratch ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_DataBuffer_GetDataSize(again), 0);
+        SHOULD_SUCCEED(ATX_DataBuffer_GetBufferSize(again) >= 1000 ? ATX_SUCCESS : ATX_FAILURE);
+
+        /* other threads have their own values, destroyed when they exit */
+        SHOULD_SUCCEED(ATX_Thread_Create(ThreadLocalTestThread, &context, &thread));
+        SHOULD_SUCCEED(ATX_Thread_Join(thread));
+        SHOULD_SUCCEED(context.result);
+        SHOULD_EQUAL_I(ATX_Atomic_Load(&context.destroyed, ATX_ATOMIC_SEQ_CST), 1);
+        SHOULD_SUCCEED(context.scratch != scratch ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_ThreadLocal_Get(context.local) == (void*)&i ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_ThreadLocal_Set(context.local, NULL));
+        SHOULD_SUCCEED(ATX_ThreadLocal_Destroy(context.local));
+
+        /* many thread locals at once */
+        for (i=0; i<THREAD_LOCAL_TEST_COUNT; i++) {
+            SHOULD_SUCCEED(ATX_ThreadLocal_Create(NULL, &locals[i]));
+            SHOULD_SUCCEED(ATX_ThreadLocal_Get(locals[i]) == NULL ? ATX_SUCCESS : ATX_FAILURE);
+            SHOULD_SUCCEED(ATX_ThreadLocal_Set(locals[i], (void*)&locals[i]));
+        }
+        for (i=0; i<THREAD_LOCAL_TEST_COUNT; i++) {
+            SHOULD_SUCCEED(ATX_ThreadLocal_Get(locals[i]) == (void*)&locals[i] ? 
+                           ATX_SUCCESS : ATX_FAILURE);
+            SHOULD_SUCCEED(ATX_ThreadLocal_Destroy(locals[i]));
+        }
+        
+        /* values of destroyed thread locals are not inherited */
+        SHOULD_SUCCEED(ATX_ThreadLocal_Create(NULL, &locals[0]));
+        SHOULD_SUCCEED(ATX_ThreadLocal_Get(locals[0]) == NULL ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_ThreadLocal_Destroy(locals[0]));
+    }
+
+    /* timer queues */
+    {
+        ATX_TimerQueue*  queue;
+        ATX_Timer*       timers[TIMER_TEST_COUNT];
+        TimerTestContext contexts[TIMER_TEST_COUNT];
+        ATX_TimeStamp    start;
+        ATX_Timeout      timeout;
+
+        SHOULD_SUCCEED(ATX_TimerQueue_Create(0, 0, &queue));
+        SHOULD_EQUAL_I(ATX_TimerQueue_GetTimeout(queue), ATX_TIMEOUT_INFINITE);
+        ATX_SetMemory(contexts, 0, sizeof(contexts));
+        for (i=0; i<TIMER_TEST_COUNT; i++) {
+            contexts[i].queue = queue;
+            SHOULD_SUCCEED(ATX_Timer_Create(TimerTestCallback, &contexts[i], &timers[i]));
+        }
+        contexts[5].cancel = ATX_TRUE;
+
+        /* timers in every wheel, a periodic one, and one that cancels itself */
+        ATX_System_GetMonotonicTimeStamp(&start);
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[0], 100, 0));
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[1], 50, 20));
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[2], 10000, 0));
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[3], 3000000, 0));
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[4], 0xFFFF0000, 0));
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[5], 30, 30));
+        timeout = ATX_TimerQueue_GetTimeout(queue);
+        SHOULD_SUCCEED(timeout >= 0 && timeout <= 30 ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_EQUAL_I(ATX_Timer_Destroy(timers[0]), ATX_ERROR_INVALID_STATE);
+
+        /* timers never expire early */
+        TimerTestAdvance(queue, &start, 0);
+        TimerTestAdvance(queue, &start, 45);
+        SHOULD_EQUAL_I(contexts[1].count, 0);
+        SHOULD_EQUAL_I(contexts[5].count, 1);
+        TimerTestAdvance(queue, &start, 95);
+        SHOULD_EQUAL_I(contexts[0].count, 0);
+        SHOULD_SUCCEED(contexts[1].count >= 1 && contexts[1].count <= 3 ? 
+                       ATX_SUCCESS : ATX_FAILURE);
+        TimerTestAdvance(queue, &start, 400);
+        SHOULD_EQUAL_I(contexts[0].count, 1);
+        SHOULD_EQUAL_I(contexts[5].count, 1);
+
+        /* cancelled timers do not expire */
+        SHOULD_SUCCEED(ATX_TimerQueue_Cancel(queue, timers[1]));
+        SHOULD_SUCCEED(ATX_TimerQueue_Cancel(queue, timers[1]));
+        contexts[1].count = 0;
+
+        /* timers in the upper wheels move down until they expire */
+        TimerTestAdvance(queue, &start, 9990);
+        SHOULD_EQUAL_I(contexts[2].count, 0);
+        TimerTestAdvance(queue, &start, 10500);
+        SHOULD_EQUAL_I(contexts[2].count, 1);
+        TimerTestAdvance(queue, &start, 2999990);
+        SHOULD_EQUAL_I(contexts[3].count, 0);
+        TimerTestAdvance(queue, &start, 3000500);
+        SHOULD_EQUAL_I(contexts[3].count, 1);
+        TimerTestAdvance(queue, &start, 0xFFFF0000-1000);
+        SHOULD_EQUAL_I(contexts[4].count, 0);
+        TimerTestAdvance(queue, &start, 0xFFFFFFFF);
+        SHOULD_EQUAL_I(contexts[4].count, 1);
+        SHOULD_EQUAL_I(contexts[0].count+contexts[1].count+contexts[5].count, 2);
+        SHOULD_EQUAL_I(ATX_TimerQueue_GetTimeout(queue), ATX_TIMEOUT_INFINITE);
+        SHOULD_SUCCEED(ATX_TimerQueue_Destroy(queue));
+
+        /* callbacks on the thread of the queue */
+        SHOULD_SUCCEED(ATX_TimerQueue_Create(0, ATX_TIMER_QUEUE_FLAG_THREAD, &queue));
+        SHOULD_SUCCEED(ATX_Semaphore_Create(0, &contexts[0].fired));
+        contexts[0].queue = queue;
+        contexts[0].count = 0;
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[0], 5, 5));
+        for (i=0; i<3; i++) {
+            SHOULD_SUCCEED(ATX_Semaphore_TimedAcquire(contexts[0].fired, 10000));
+        }
+        SHOULD_SUCCEED(ATX_TimerQueue_Cancel(queue, timers[0]));
+        SHOULD_SUCCEED(ATX_TimerQueue_Schedule(queue, timers[1], 60000, 0));
+        SHOULD_SUCCEED(ATX_TimerQueue_Destroy(queue));
+        SHOULD_SUCCEED(ATX_Semaphore_Destroy(contexts[0].fired));
+        for (i=0; i<TIMER_TEST_COUNT; i++) {
+            SHOULD_SUCCEED(ATX_Timer_Destroy(timers[i]));
+        }
+    }
+
+    /* task pools */
+    {
+        ATX_TaskPool*       pool;
+        ATX_Future*         future;
+        ATX_Task            tasks[16];
+        int                 squares[16];
+        int*                values;
+        ATX_Semaphore*      semaphore;
+        ATX_Result          result;
+        TaskPoolTestContext context;
+
+        SHOULD_SUCCEED(ATX_TaskPool_Create(4, &pool));
+        SHOULD_EQUAL_I(ATX_TaskPool_GetWorkerCount(pool), 4);
+
+        /* single tasks and batches */
+        squares[0] = 7;
+        SHOULD_SUCCEED(ATX_TaskPool_Submit(pool, TaskPoolTestSquare, &squares[0], &future));
+        SHOULD_SUCCEED(ATX_Future_Wait(future, &result));
+        SHOULD_SUCCEED(result);
+        SHOULD_EQUAL_I(squares[0], 49);
+        SHOULD_SUCCEED(ATX_Future_Destroy(future));
+        for (i=0; i<16; i++) {
+            squares[i] = i;
+            tasks[i].function = TaskPoolTestSquare;
+            tasks[i].argument = &squares[i];
+        }
+        SHOULD_SUCCEED(ATX_TaskPool_SubmitBatch(pool, tasks, 16, &future));
+        SHOULD_SUCCEED(ATX_Future_Wait(future, &result));
+        SHOULD_SUCCEED(result);
+        for (i=0; i<16; i++) SHOULD_EQUAL_I(squares[i], i*i);
+        SHOULD_SUCCEED(ATX_Future_Destroy(future));
+        SHOULD_SUCCEED(ATX_TaskPool_SubmitBatch(pool, tasks, 0, &future));
+        SHOULD_SUCCEED(ATX_Future_IsDone(future) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Future_Destroy(future));
+
+        /* failures and callbacks */
+        SHOULD_SUCCEED(ATX_Semaphore_Create(0, &semaphore));
+        tasks[3].function = TaskPoolTestFail;
+        SHOULD_SUCCEED(ATX_TaskPool_SubmitBatch(pool, tasks, 16, &future));
+        SHOULD_SUCCEED(ATX_Future_Then(future, TaskPoolTestThen, semaphore));
+        SHOULD_SUCCEED(ATX_Future_Wait(future, &result));
+        SHOULD_EQUAL_I(result, ATX_ERROR_INTERNAL);
+        SHOULD_SUCCEED(ATX_Semaphore_TimedAcquire(semaphore, 0));
+        SHOULD_SUCCEED(ATX_Future_IsDone(future) ? ATX_SUCCESS : ATX_FAILURE);
+        SHOULD_SUCCEED(ATX_Future_Then(future, TaskPoolTestThen, semaphore));
+        SHOULD_SUCCEED(ATX_Semaphore_TimedAcquire(semaphore, 0));
+        SHOULD_SUCCEED(ATX_Future_Destroy(future));
+        SHOULD_SUCCEED(ATX_Semaphore_Destroy(semaphore));
+
+        /* parallel loops, from this thread and from a task */
+        values = (int*)ATX_AllocateZeroMemory(TASK_POOL_TEST_SIZE*sizeof(int));
+        SHOULD_SUCCEED(ATX_TaskPool_ParallelFor(pool, 0, TASK_POOL_TEST_SIZE, 0, 
+                                                TaskPoolTestRange, values));
+        context.pool   = pool;
+        context.values = values;
+        SHOULD_SUCCEED(ATX_TaskPool_Submit(pool, TaskPoolTestNested, &context, &future));
+        SHOULD_SUCCEED(ATX_Future_Wait(future, &result));
+        SHOULD_SUCCEED(result);
+        SHOULD_SUCCEED(ATX_Future_Destroy(future));
+        for (i=0; i<TASK_POOL_TEST_SIZE; i++) SHOULD_EQUAL_I(values[i], 2*i);
+        SHOULD_SUCCEED(ATX_TaskPool_ParallelFor(pool, 10, 10, 0, TaskPoolTestRange, NULL));
+        ATX_FreeMemory(values);
+
+        /* tasks without futures still run before the pool is destroyed */
+        for (i=0; i<16; i++) {
+            squares[i] = i;
+            SHOULD_SUCCEED(ATX_TaskPool_Submit(pool, TaskPoolTestSquare, &squares[i], NULL));
+        }
+        SHOULD_SUCCEED(ATX_TaskPool_Destroy(pool));
+        for (i=0; i<16; i++) SHOULD_EQUAL_I(squares[i], i*i);
+    }
+
     /* IP Address suff */
     {
         ATX_IpAddress ip;
@@ -40,8 +40,21 @@
 #include <crtdbg.h>
 #endif
 
+#if defined(ATX_CONFIG_HAVE_READV)
+#include <unistd.h>
+#endif
+
 #define BUFFER_SIZE 17
 
+/* unlike ATX_ASSERT, always evaluates its argument, even in release builds */
+#define CHECK(x)                                            \
+    do {                                                    \
+        if (!(x)) {                                         \
+            printf("CHECK failed line %d\n", __LINE__);     \
+            exit(1);                                        \
+        }                                                   \
+    } while(0)
+
 /*----------------------------------------------------------------------
 |       ReadChunk
 +---------------------------------------------------------------------*/
@@ -105,6 +118,124 @@ WriteChunk(ATX_RingBuffer* buffer)
     return ATX_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|       StreamTest
++---------------------------------------------------------------------*/
+static void
+StreamTest(void)
+{
+    ATX_RingBuffer*   buffer;
+    ATX_MemoryStream* memory;
+    ATX_InputStream*  input;
+    ATX_OutputStream* output;
+    ATX_Size          count = 0;
+    ATX_Byte          bytes[8];
+    const ATX_DataBuffer* data;
+    
+    ATX_RingBuffer_Create(8, &buffer);
+
+    /* fill across the end of the buffer */
+    ATX_RingBuffer_MoveIn(buffer, 5);
+    ATX_RingBuffer_MoveOut(buffer, 5);
+    ATX_MemoryStream_CreateFromBuffer((ATX_Byte*)"0123456789", 10, &memory);
+    ATX_MemoryStream_GetInputStream(memory, &input);
+    CHECK(ATX_RingBuffer_FillFromStream(buffer, input, &count) == ATX_SUCCESS);
+    CHECK(count == 3);
+    CHECK(ATX_RingBuffer_FillFromStream(buffer, input, &count) == ATX_SUCCESS);
+    CHECK(count == 4);
+    CHECK(ATX_RingBuffer_FillFromStream(buffer, input, &count) == ATX_SUCCESS);
+    CHECK(count == 0);
+    ATX_RELEASE_OBJECT(input);
+    ATX_MemoryStream_Destroy(memory);
+
+    /* drain both segments with one call */
+    ATX_MemoryStream_Create(0, &memory);
+    ATX_MemoryStream_GetOutputStream(memory, &output);
+    CHECK(ATX_RingBuffer_DrainToStream(buffer, output, &count) == ATX_SUCCESS);
+    CHECK(count == 7);
+    CHECK(ATX_RingBuffer_GetAvailable(buffer) == 0);
+    ATX_MemoryStream_GetBuffer(memory, &data);
+    CHECK(ATX_DataBuffer_GetDataSize(data) == 7);
+    CHECK(ATX_MemoryEqual(ATX_DataBuffer_GetData(data), "0123456", 7));
+    ATX_RELEASE_OBJECT(output);
+    ATX_MemoryStream_Destroy(memory);
+
+#if defined(ATX_CONFIG_HAVE_READV)
+    /* same thing through a pipe, both segments at once */
+    {
+        int fds[2];
+        CHECK(pipe(fds) == 0);
+        CHECK(write(fds[1], "abcdefg", 7) == 7);
+        CHECK(ATX_RingBuffer_FillFromDescriptor(buffer, fds[0], &count) == ATX_SUCCESS);
+        CHECK(count == 7);
+        CHECK(ATX_RingBuffer_PeekByte(buffer, 6) == 'g');
+        CHECK(ATX_RingBuffer_DrainToDescriptor(buffer, fds[1], &count) == ATX_SUCCESS);
+        CHECK(count == 7);
+        CHECK(read(fds[0], bytes, sizeof(bytes)) == 7);
+        CHECK(ATX_MemoryEqual(bytes, "abcdefg", 7));
+        close(fds[1]);
+        CHECK(ATX_RingBuffer_FillFromDescriptor(buffer, fds[0], &count) == ATX_ERROR_EOS);
+        close(fds[0]);
+    }
+#endif
+    ATX_COMPILER_UNUSED(bytes);
+
+    ATX_RingBuffer_Destroy(buffer);
+}
+
+/*----------------------------------------------------------------------
+|       FramingTest
++---------------------------------------------------------------------*/
+static void
+FramingTest(void)
+{
+    ATX_RingBuffer*     buffer;
+    ATX_RingBufferFrame frame;
+    ATX_Size            position = 0;
+    
+    ATX_RingBuffer_Create(16, &buffer);
+
+    /* lines, across the end of the buffer */
+    ATX_RingBuffer_MoveIn(buffer, 10);
+    ATX_RingBuffer_MoveOut(buffer, 10);
+    ATX_RingBuffer_Write(buffer, (ATX_ByteBuffer)"ab\r\ncdefg", 9);
+    CHECK(ATX_RingBuffer_FindByte(buffer, 'f', 0, &position) == ATX_SUCCESS);
+    CHECK(position == 7);
+    CHECK(ATX_RingBuffer_FindByte(buffer, 'a', 1, &position) == ATX_ERROR_NO_SUCH_ITEM);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 0, &frame) == ATX_SUCCESS);
+    CHECK(frame.size == 2 && frame.frame_size == 4 && frame.segment_count == 1);
+    CHECK(ATX_MemoryEqual(frame.segments[0].buffer, "ab", 2));
+    ATX_RingBuffer_MoveOut(buffer, frame.frame_size);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 0, &frame) == ATX_ERROR_NO_SUCH_ITEM);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 4, &frame) == ATX_ERROR_OVERFLOW);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 5, &frame) == ATX_ERROR_NO_SUCH_ITEM);
+    ATX_RingBuffer_Write(buffer, (ATX_ByteBuffer)"\r", 1);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 5, &frame) == ATX_ERROR_NO_SUCH_ITEM);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 4, &frame) == ATX_ERROR_OVERFLOW);
+    ATX_RingBuffer_Write(buffer, (ATX_ByteBuffer)"\n", 1);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LINE, 5, &frame) == ATX_SUCCESS);
+    CHECK(frame.size == 5 && frame.frame_size == 7 && frame.segment_count == 2);
+    CHECK(frame.segments[0].size == 2 && ATX_MemoryEqual(frame.segments[0].buffer, "cd", 2));
+    CHECK(frame.segments[1].size == 3 && ATX_MemoryEqual(frame.segments[1].buffer, "efg", 3));
+    ATX_RingBuffer_MoveOut(buffer, frame.frame_size);
+    CHECK(ATX_RingBuffer_GetAvailable(buffer) == 0);
+
+    /* length prefixes */
+    ATX_RingBuffer_Write(buffer, (ATX_ByteBuffer)"\0\0\0\3xyz\0\0", 9);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LENGTH_32, 2, &frame) == ATX_ERROR_OVERFLOW);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LENGTH_32, 0, &frame) == ATX_SUCCESS);
+    CHECK(frame.size == 3 && frame.frame_size == 7);
+    CHECK(ATX_MemoryEqual(frame.segments[0].buffer, "xyz", 3));
+    ATX_RingBuffer_MoveOut(buffer, frame.frame_size);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LENGTH_16, 0, &frame) == ATX_SUCCESS);
+    CHECK(frame.size == 0 && frame.frame_size == 2 && frame.segment_count == 0);
+    ATX_RingBuffer_MoveOut(buffer, frame.frame_size);
+    ATX_RingBuffer_Write(buffer, (ATX_ByteBuffer)"\1\0", 2);
+    CHECK(ATX_RingBuffer_PeekFrame(buffer, ATX_RING_BUFFER_FRAMING_LENGTH_16, 0, &frame) == ATX_ERROR_OVERFLOW);
+
+    ATX_RingBuffer_Destroy(buffer);
+}
+
 /*----------------------------------------------------------------------
 |       main
 +---------------------------------------------------------------------*/
@@ -153,6 +284,9 @@ main(int argc, char** argv)
     ATX_ASSERT(ATX_RingBuffer_GetSpace(buffer) == BUFFER_SIZE-1);
     ATX_ASSERT(ATX_RingBuffer_GetContiguousSpace(buffer) == BUFFER_SIZE-3);
 
+    StreamTest();
+    FramingTest();
+
     ATX_RingBuffer_Reset(buffer);
     for (i=0; i<100000000; i++) {
         if (ATX_FAILED(WriteChunk(buffer))) {
@@ -165,8 +299,51 @@ main(int argc, char** argv)
         }
     }
 
+    /* drain the buffer so that the next one starts in sync */
+    while (ATX_RingBuffer_GetAvailable(buffer)) {
+        if (ATX_FAILED(ReadChunk(buffer))) {
+            printf("ReadChunk failed\n");
+            return 1;
+        }
+    }
     ATX_RingBuffer_Destroy(buffer);
 
+    /* mirrored buffers */
+    result = ATX_RingBuffer_CreateMirrored(BUFFER_SIZE, &buffer);
+    if (result == ATX_ERROR_NOT_SUPPORTED) {
+        printf("mirrored ring buffers not supported\n");
+    } else if (ATX_FAILED(result)) {
+        fprintf(stderr, "ATX_RingBuffer_CreateMirrored failed (%d)\n", result);
+        return 1;
+    } else {
+        ATX_Size size = ATX_RingBuffer_GetSpace(buffer)+1;
+        
+        /* the space and the data are contiguous across the end */
+        ATX_RingBuffer_MoveIn(buffer, size-2);
+        ATX_RingBuffer_MoveOut(buffer, size-2);
+        ATX_ASSERT(ATX_RingBuffer_GetContiguousSpace(buffer) == size-1);
+        ATX_RingBuffer_Write(buffer, (ATX_ByteBuffer)"abcd", 4);
+        ATX_ASSERT(ATX_RingBuffer_GetContiguousAvailable(buffer) == 4);
+        ATX_ASSERT(ATX_MemoryEqual(ATX_RingBuffer_GetOut(buffer), "abcd", 4));
+        ATX_ASSERT(ATX_RingBuffer_GetIn(buffer) == ATX_RingBuffer_GetOut(buffer)+4-size);
+        ATX_ASSERT(ATX_RingBuffer_PeekByte(buffer, 3) == 'd');
+        ATX_RingBuffer_MoveOut(buffer, 4);
+        ATX_ASSERT(ATX_RingBuffer_GetAvailable(buffer) == 0);
+
+        ATX_RingBuffer_Reset(buffer);
+        for (i=0; i<10000000; i++) {
+            if (ATX_FAILED(WriteChunk(buffer))) {
+                printf("WriteChunk failed\n");
+                return 1;
+            }
+            if (ATX_FAILED(ReadChunk(buffer))) {
+                printf("ReadChunk failed\n");
+                return 1;
+            }
+        }
+        ATX_RingBuffer_Destroy(buffer);
+    }
+
     printf("RingBufferTest passed\n");
 
     return 0;